@@ -1,17 +1,34 @@
 #include "AssignmentApp.h"
-#include "Cube.h"
+#include "ArenaAllocator.h"
+#include "AssetWatcher.h"
+#include "Bitboard.h"
+#include "EntityWorld.h"
+#include "FrameArena.h"
+#include "FrameScheduler.h"
+#include "Framebuffer.h"
 #include "GeometricTools.h"
+#include "GeometryCache.h"
 #include "IndexBuffer.h"
+#include "JobSystem.h"
 #include "OrthographicCamera.h"
 #include "PerspectiveCamera.h"
+#include "Pieces.h"
 #include "RenderCommands.h"
 #include "Shader.h"
+#include "Skybox.h"
+#include "StartupOrchestrator.h"
+#include "Task.h"
 #include "TextureManager.h"
+#include "TransformHierarchy.h"
 #include "VertexArray.h"
 #include "VertexBuffer.h"
+#include "VirtualFileSystem.h"
 
+#include <cstdio>
 #include <iostream>
 #include <memory>
+#include <string>
+#include <vector>
 
 #define GLFW_INCLUDE_NONE
 #include <GLFW/glfw3.h>
@@ -115,9 +132,7 @@ bool tileIsSelected = false;
 bool usingAdvancedShaders = true;
 
 struct Tile {
-  std::shared_ptr<Cube> cube;
-
-  Tile() { cube = nullptr; }
+  Entity piece; // none if the tile is empty
 };
 
 GLuint CompileShader();
@@ -126,6 +141,7 @@ glm::vec3 calculateCameraPosition(float angle, float zoom,
 void updateDeltaTime();
 void key_callback(GLFWwindow *window, int key, int scancode, int action,
                   int mods);
+Task<void> showGpuFrameTime(GLFWwindow *window, std::string title);
 
 AssignmentApp::AssignmentApp(const std::string &name,
                              const std::string &version)
@@ -137,6 +153,14 @@ unsigned AssignmentApp::Run() {
   glfwSetKeyCallback(window, key_callback);
   gladLoadGLLoader((GLADloadproc)glfwGetProcAddress);
   glEnable(GL_DEPTH_TEST);
+  // this thread, which owns the GL context, becomes the jobs' main thread
+  JobSystem *jobs = JobSystem::GetInstance();
+
+  // between frames: main-thread jobs, coroutines waiting for the frame, and
+  // the frame arena last since both may still use it
+  AddFrameCallback([jobs]() { jobs->RunMainThreadJobs(); });
+  AddFrameCallback([]() { FrameScheduler::GetInstance()->Tick(); });
+  AddFrameCallback([]() { FrameArena::GetInstance()->Reset(); });
 
   float globalScaleMultiplier = 3;
 
@@ -151,109 +175,228 @@ unsigned AssignmentApp::Run() {
   auto camera = PerspectiveCamera({45.f, 800.f, 600.f, 0.1f, 1000.f},
                                   cameraPosition, cameraLookAt, cameraUpVector);
 
+  // Reverse-Z into a float depth buffer where the driver has
+  // glClipControl, the window's fixed point depth otherwise
+  std::unique_ptr<Framebuffer> sceneBuffer;
+  if (RenderCommands::EnableReverseDepth()) {
+    camera.SetDepthMode(PerspectiveCamera::DepthMode::ReverseZInfinite);
+    int width, height;
+    glfwGetFramebufferSize(window, &width, &height);
+    sceneBuffer = std::make_unique<Framebuffer>(width, height);
+  }
+
   auto viewProjection = camera.GetViewProjectionMatrix();
 
-  // -- Game Board Logic Array -- //
-  int boardSize = 8;
+  // -- Game Board Logic -- //
+  // the rules work on the bitboards, the tiles map back to the entities
+  const int boardSize = 8;
+  BoardState<boardSize> board;
   Tile gameboard[boardSize][boardSize];
 
-  // -- Chessboard -- //
-  GeometricTools::unitShape chessboard = GeometricTools::UnitGrid(boardSize);
-
-  auto chessVertexBuffer = std::make_shared<VertexBuffer>(
-      chessboard.vertices.data(), chessboard.vertices.size() * sizeof(GLfloat));
-
-  auto chessBufferLayout = BufferLayout({{ShaderDataType::Float3, "position"},
-                                         {ShaderDataType::Float2, "tcoords"},
-                                         {ShaderDataType::Float3, "normal"}});
-
-  chessVertexBuffer->SetLayout(chessBufferLayout);
-
-  auto chessVertexArray = std::make_shared<VertexArray>();
-  chessVertexArray->AddVertexBuffer(chessVertexBuffer);
-
-  auto chessIndexBuffer = std::make_shared<IndexBuffer>(
-      chessboard.indices.data(), chessboard.indices.size());
-  chessVertexArray->SetIndexBuffer(chessIndexBuffer);
-
-  auto chessboardShader =
-      std::make_shared<Shader>(VertexShader, chessFragmentShader, "Chessboard");
-
-  // -- chessboard transformation-matrix -- //
+  // the pieces, and the board scaling everything on it
+  EntityWorld pieces;
+  TransformHierarchy sceneTransforms;
+  auto boardTransform = sceneTransforms.AddNode(
+      TransformHierarchy::NoNode, glm::vec3(0.f),
+      glm::quat(1.f, 0.f, 0.f, 0.f), glm::vec3(globalScaleMultiplier));
+  sceneTransforms.Update();
 
-  auto scale = glm::scale(glm::mat4(1.0f), glm::vec3(globalScaleMultiplier));
-
-  auto rotate =
-      glm::rotate(glm::mat4(1.0f), glm::radians(0.f), glm::vec3(1, 0, 0));
-
-  auto translate = glm::translate(glm::mat4(1), glm::vec3(0));
+  GeometryCache *geometryCache = GeometryCache::GetInstance();
+  TextureManager *textureManager = TextureManager::GetInstance();
 
-  auto chessboardModelMatrix = translate * rotate * scale;
+  GeometricTools::shapeDescriptor boardShape = {
+      GeometricTools::ShapeType::Grid, {static_cast<float>(boardSize)}};
+  GeometricTools::shapeDescriptor cubeShape = {
+      GeometricTools::ShapeType::CubeWNormals};
+
+  std::shared_ptr<VertexArray> chessVertexArray, cubeVertexArray;
+  std::shared_ptr<Shader> chessboardShader, cubeShader;
+  bool cubeTextureLoaded = false;
+  std::unique_ptr<Skybox> skybox;
+
+  // ---- Startup ---- //
+  // Shapes are generated on worker threads while the main thread compiles
+  // the shaders; GL work stays on the main thread. The cube texture is
+  // only needed for the advanced shading and loads after the first frame.
+  StartupOrchestrator startup;
+  using Affinity = StartupOrchestrator::Affinity;
+
+  auto mountResources = startup.AddTask("mount resources", []() {
+    // the loose files are the fallback for anything the pack does not have
+    VirtualFileSystem *fileSystem = VirtualFileSystem::GetInstance();
+    fileSystem->MountDirectory(RESOURCES_DIR);
+    fileSystem->MountPack(std::string(RESOURCES_DIR) + "assignment.pak");
+#ifndef NDEBUG
+    // the source tree last, so edited resources override the pack and can
+    // be reloaded while the game runs
+    fileSystem->MountDirectory(RESOURCES_SOURCE_DIR);
+#endif
+  });
+
+  auto boardGeometry = startup.AddTask(
+      "board geometry", [&]() { geometryCache->GetShape(boardShape); });
+  auto cubeGeometry = startup.AddTask(
+      "cube geometry", [&]() { geometryCache->GetShape(cubeShape); });
 
-  chessboardShader->Bind();
-  chessboardShader->UploadUniformFloatM4("u_ViewProjection", viewProjection);
-  chessboardShader->UploadUniformFloatM4("u_Model", chessboardModelMatrix);
+  // -- Chessboard -- //
+  startup.AddTask(
+      "board mesh",
+      [&]() { chessVertexArray = geometryCache->GetMesh(boardShape); },
+      {boardGeometry}, Affinity::MainThread);
+
+  startup.AddTask(
+      "board shader",
+      [&]() {
+        chessboardShader = std::make_shared<Shader>(
+            VertexShader, chessFragmentShader, "Chessboard");
+
+        chessboardShader->Bind();
+        chessboardShader->UploadUniformFloatM4("u_ViewProjection",
+                                               viewProjection);
+        chessboardShader->UploadUniformFloatM4(
+            "u_Model", sceneTransforms.GetWorldMatrix(boardTransform));
+      },
+      {}, Affinity::MainThread);
 
   // ------- CUBES ------- //
-
-  GeometricTools::unitShape cube = GeometricTools::UnitCubeWNormals();
-
-  auto cubeVertexBuffer = std::make_shared<VertexBuffer>(
-      cube.vertices.data(), cube.vertices.size() * sizeof(GLfloat));
-  auto cubeBufferLayout = BufferLayout({{ShaderDataType::Float3, "position"},
-                                        {ShaderDataType::Float2, "tcoords"},
-                                        {ShaderDataType::Float3, "normal"}});
-
-  cubeVertexBuffer->SetLayout(cubeBufferLayout);
-
-  auto cubeVertexArray = std::make_shared<VertexArray>();
-  cubeVertexArray->AddVertexBuffer(cubeVertexBuffer);
-
-  auto cubeIndexBuffer =
-      std::make_shared<IndexBuffer>(cube.indices.data(), cube.indices.size());
-  cubeVertexArray->SetIndexBuffer(cubeIndexBuffer);
-
-  auto cubeShader =
-      std::make_shared<Shader>(VertexShader, cubeFragmentShader, "Cube");
-
-  for (int y = 0; y < boardSize; y++) {
-    for (int x = 0; x < boardSize; x++) {
-      Tile *tile = &gameboard[y][x];
-      // 3.f is the scaling factor on the chessboard
-      if (y <= 1) {
-        tile->cube = std::make_shared<Cube>(cubeVertexArray, cubeShader);
-        tile->cube->SetColor(glm::vec3(0, 0, 1));
-        tile->cube->team = Blue;
-
-        tile->cube->coords = glm::ivec2(x, y);
-        tile->cube->globalScale = globalScaleMultiplier;
-      }
-      if (y >= 6) {
-        tile->cube = std::make_shared<Cube>(cubeVertexArray, cubeShader);
-        tile->cube->SetColor(glm::vec3(1, 0, 0));
-        tile->cube->team = Red;
-
-        tile->cube->coords = glm::ivec2(x, y);
-        tile->cube->globalScale = globalScaleMultiplier;
-      }
-    }
-  }
+  auto cubeMesh = startup.AddTask(
+      "cube mesh",
+      [&]() { cubeVertexArray = geometryCache->GetMesh(cubeShape); },
+      {cubeGeometry}, Affinity::MainThread);
+
+  auto cubeProgram = startup.AddTask(
+      "cube shader",
+      [&]() {
+        cubeShader =
+            std::make_shared<Shader>(VertexShader, cubeFragmentShader, "Cube");
+      },
+      {}, Affinity::MainThread);
+
+  startup.AddTask(
+      "pieces",
+      [&]() {
+        for (int y = 0; y < boardSize; y++) {
+          for (int x = 0; x < boardSize; x++) {
+            if (y > 1 && y < 6)
+              continue;
+
+            glm::vec3 position, scaling;
+            glm::quat rotation;
+            GetBoardTransform({x, y}, boardSize, position, rotation, scaling);
+            auto node = sceneTransforms.AddNode(boardTransform, position,
+                                                rotation, scaling);
+
+            Team team = y <= 1 ? Blue : Red;
+            board.Place(team, {x, y});
+            gameboard[y][x].piece =
+                pieces.CreateEntity(boardPiece{team, {x, y}, false},
+                                    pieceTransform{node});
+          }
+        }
+      },
+      {cubeMesh, cubeProgram}, Affinity::MainThread);
 
   // ---- Textures ---- //
-  TextureManager *textureManager = TextureManager::GetInstance();
-
-  textureManager->LoadTexture2DRGBA(
-      "chessTex", std::string(TEXTURES_DIR) + std::string("floor_texture.png"),
-      0);
-
-  textureManager->LoadCubeMapRGBA(
-      "cubeTex", std::string(TEXTURES_DIR) + std::string("cube_texture.png"),
-      1);
+  // cooked with its mip levels, so loading it is a read and an upload;
+  // without the cooked file the PNG is decoded in the background and the
+  // board shows a placeholder until then
+  TextureManager::TextureHandle chessTexture;
+  auto floorTexture = startup.AddTask(
+      "floor texture",
+      [&]() {
+        if (textureManager->LoadCookedTexture2D(
+                "chessTex", "cooked/floor_texture.ctex", 0))
+          chessTexture = textureManager->GetHandle("chessTex");
+        else
+          chessTexture = textureManager->LoadTexture2DRGBAAsync(
+              "chessTex", "textures/floor_texture.png", 0);
+      },
+      {mountResources}, Affinity::MainThread);
+
+  // the cube map and the sky are decoded on workers and uploaded on the main
+  // thread; the cubes are drawn without their texture, and the background
+  // stays the clear color, until then
+  struct decodedImage {
+    unsigned char *pixels = nullptr;
+    int width = 0, height = 0;
+  };
+  decodedImage cubeImage, skyImage;
+  auto decode = [textureManager](const char *filePath, decodedImage &image) {
+    int bpp;
+    image.pixels = textureManager->LoadTextureImage(
+        filePath, image.width, image.height, bpp, STBI_rgb_alpha);
+    if (!image.pixels)
+      std::cerr << "Failed to load texture " << filePath << std::endl;
+  };
+
+  auto cubeDecode = startup.AddTask(
+      "cube texture decode",
+      [&]() { decode("textures/cube_texture.png", cubeImage); },
+      {mountResources}, Affinity::Worker, false);
+  auto cubeTexture = startup.AddTask(
+      "cube texture",
+      [&]() {
+        if (cubeImage.pixels)
+          cubeTextureLoaded = textureManager->CreateCubeMapRGBA(
+              "cubeTex", "textures/cube_texture.png", cubeImage.pixels,
+              cubeImage.width, cubeImage.height, 1);
+        textureManager->FreeTextureImage(cubeImage.pixels);
+      },
+      {cubeDecode}, Affinity::MainThread, false);
+
+  auto skyDecode = startup.AddTask(
+      "sky decode", [&]() { decode("textures/sky.png", skyImage); },
+      {mountResources}, Affinity::Worker, false);
+  auto skyTexture = startup.AddTask(
+      "sky",
+      [&]() {
+        if (skyImage.pixels &&
+            textureManager->CreateSkyBoxRGBA("skyTex", "textures/sky.png",
+                                             skyImage.pixels, skyImage.width,
+                                             skyImage.height, 2))
+          skybox = std::make_unique<Skybox>(2);
+        textureManager->FreeTextureImage(skyImage.pixels);
+      },
+      {skyDecode}, Affinity::MainThread, false);
+
+#ifndef NDEBUG
+  startup.AddTask(
+      "hot reload",
+      [&]() {
+        AssetWatcher *assetWatcher = AssetWatcher::GetInstance();
+        assetWatcher->WatchTexture(chessTexture);
+        assetWatcher->WatchTexture(textureManager->GetHandle("cubeTex"));
+        assetWatcher->WatchTexture(textureManager->GetHandle("skyTex"));
+        assetWatcher->Start();
+      },
+      {floorTexture, cubeTexture, skyTexture}, Affinity::MainThread, false);
+#else
+  (void)floorTexture;
+  (void)cubeTexture;
+  (void)skyTexture;
+#endif
+
+  startup.RunCritical();
+  bool loadingLazily = true;
+
+#ifndef NDEBUG
+  FrameScheduler::GetInstance()->Spawn(showGpuFrameTime(window, name));
+#endif
 
   RenderCommands::SetClearColor({1.3, 1.3, 1.3});
 
   while (!glfwWindowShouldClose(window)) {
     updateDeltaTime();
+    textureManager->ProcessAsyncUploads();
+#ifndef NDEBUG
+    AssetWatcher::GetInstance()->ApplyChanges();
+#endif
+    int windowWidth, windowHeight;
+    glfwGetFramebufferSize(window, &windowWidth, &windowHeight);
+    if (sceneBuffer) {
+      sceneBuffer->Resize(windowWidth, windowHeight);
+      sceneBuffer->Bind();
+    }
     RenderCommands::Clear();
 
     // == Camera control handling == //
@@ -287,73 +430,102 @@ unsigned AssignmentApp::Run() {
                                            camera.GetViewProjectionMatrix());
     RenderCommands::DrawIndex(chessVertexArray);
 
-    // == Pastes cube if tile is empty == //
+    // == Pastes piece if tile is empty == //
     if (selectorPressed && tileIsSelected) {
       selectorPressed = false;
       auto *tile = &gameboard[selector.y][selector.x];
       auto *selectedTile = &gameboard[selectedTileIndex.y][selectedTileIndex.x];
-      if (tile->cube) {
-        tileIsSelected = false;
-
-        // no need to check if cube exists because its done when selecting
-        selectedTile->cube->selected = false;
-      } else {
-        tileIsSelected = false;
-        // assign the selected cube to the new tile
-        tile->cube = selectedTile->cube;
-        selectedTile->cube = nullptr;
-
-        // update the cubes coordinates selected-status
-        tile->cube->coords = selector;
-        tile->cube->selected = false;
+      // no need to check if the piece exists because its done when selecting
+      auto *piece = pieces.GetComponent<boardPiece>(selectedTile->piece);
+      tileIsSelected = false;
+      piece->selected = false;
+      if (board.IsLegalMove(piece->team, selectedTileIndex, selector)) {
+        // assign the selected piece to the new tile
+        board.Move(piece->team, selectedTileIndex, selector);
+        tile->piece = selectedTile->piece;
+        selectedTile->piece = Entity();
+        piece->coords = selector;
+
+        glm::vec3 position, scaling;
+        glm::quat rotation;
+        GetBoardTransform(selector, boardSize, position, rotation, scaling);
+        sceneTransforms.SetPosition(
+            pieces.GetComponent<pieceTransform>(tile->piece)->node, position);
       }
     }
 
-    // == Copies tile index if cube is present == //
+    // == Copies tile index if piece is present == //
     if (selectorPressed) {
       selectorPressed = false;
-      auto &cube = gameboard[selector.y][selector.x].cube;
-      if (cube) {
-        cube->selected = true;
+      if (board.GetOccupied().Test(selector)) {
+        Entity selected = gameboard[selector.y][selector.x].piece;
+        pieces.GetComponent<boardPiece>(selected)->selected = true;
         selectedTileIndex = selector;
         tileIsSelected = true;
       }
     }
 
-    // == Rendering Each Cube == //
-    for (int y = 0; y < boardSize; y++) {
-      for (int x = 0; x < boardSize; x++) {
-        Tile *tile = &gameboard[y][x];
-
-        if (tile->cube) {
-          auto cube = tile->cube;
-          cube->advancedShaders = usingAdvancedShaders;
-          cube->GetVertexArray()->Bind();
-          cube->CalculatePosition(boardSize);
-
-          if (cube->team == Blue)
-            cube->SetColor(glm::vec3(0, 0, 1));
+    // == Piece model matrices, only the moved pieces are recomputed == //
+    sceneTransforms.Update();
+
+    // == What the pieces look like this frame, gone after EndFrame() == //
+    FrameVector<pieceAppearance> drawList;
+    drawList.reserve(pieces.Count<boardPiece, pieceTransform>());
+    pieces.Each<const boardPiece, const pieceTransform>(
+        [&](const boardPiece &piece, const pieceTransform &transform) {
+          pieceAppearance &appearance = drawList.emplace_back();
+          if (piece.team == Blue)
+            appearance.color = glm::vec3(0, 0, 1);
           else
-            cube->SetColor(glm::vec3(1, 0, 0));
-
-          if (selector == glm::ivec2(x, y))
-            cube->SetColor(glm::vec3(1, 1, 0));
-          if (cube->selected)
-            cube->SetColor(glm::vec3(1, 0.8, 0.7));
+            appearance.color = glm::vec3(1, 0, 0);
+
+          if (selector == piece.coords)
+            appearance.color = glm::vec3(1, 1, 0);
+          if (piece.selected)
+            appearance.color = glm::vec3(1, 0.8, 0.7);
+
+          appearance.modelMatrix =
+              sceneTransforms.GetWorldMatrix(transform.node);
+        });
+
+    // == Rendering the pieces, all with the same mesh and shader == //
+    cubeVertexArray->Bind();
+    cubeShader->Bind();
+    cubeShader->UploadUniformFloatM4("u_ViewProjection",
+                                     camera.GetViewProjectionMatrix());
+    cubeShader->UploadUniformInt("u_usingAdvancedShaders",
+                                 usingAdvancedShaders && cubeTextureLoaded);
+    for (const pieceAppearance &appearance : drawList) {
+      cubeShader->UploadUniformFloatM4("u_Model", appearance.modelMatrix);
+      cubeShader->UploadUniformFloat3("u_baseColor", appearance.color);
+      RenderCommands::DrawIndex(cubeVertexArray);
+    }
 
-          cube->SetUniforms(camera.GetViewProjectionMatrix());
+    // == The sky last, shaded only where nothing else was drawn == //
+    if (skybox)
+      skybox->Draw(camera.GetViewMatrix(), camera.GetProjectionMatrix());
 
-          RenderCommands::DrawIndex(cube->GetVertexArray());
-        }
-      }
+    if (sceneBuffer)
+      sceneBuffer->BlitToScreen(windowWidth, windowHeight);
+    glfwSwapBuffers(window);
+    EndFrame();
+
+    // the lazy part of the startup, a little of it every frame
+    if (loadingLazily) {
+      startup.FirstFramePresented();
+      loadingLazily = startup.RunLazy();
+      if (!loadingLazily)
+        startup.PrintReport(std::cout);
     }
 
-    glfwSwapBuffers(window);
     glfwPollEvents();
     if (pressedKey[GLFW_KEY_Q])
       glfwSetWindowShouldClose(window, GL_TRUE);
   }
 
+#ifndef NDEBUG
+  AssetWatcher::GetInstance()->Stop();
+#endif
   // glfwDestroyWindow(window);
   glfwSetKeyCallback(window, NULL);
   glfwTerminate();
@@ -403,3 +575,24 @@ void key_callback(GLFWwindow *window, int key, int scancode, int action,
     }
   }
 }
+
+// Shows how long the GPU took for a frame in the window title, about once a
+// second. The query result is read back once it is there instead of
+// stalling the frame for it.
+Task<void> showGpuFrameTime(GLFWwindow *window, std::string title) {
+  GLuint query;
+  glGenQueries(1, &query);
+  for (;;) {
+    glBeginQuery(GL_TIME_ELAPSED, query);
+    co_await NextFrame();
+    glEndQuery(GL_TIME_ELAPSED);
+
+    GLuint64 nanoseconds = co_await QueryResult(query);
+    char text[256];
+    std::snprintf(text, sizeof(text), "%s - GPU %.2f ms", title.c_str(),
+                  nanoseconds / 1e6);
+    glfwSetWindowTitle(window, text);
+
+    co_await Frames(60);
+  }
+}
@@ -0,0 +1,227 @@
+#ifndef BITBOARD_H
+#define BITBOARD_H
+
+#include <glm/glm.hpp>
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+
+// One bit per tile of a Width x Height board, tile (x, y) at bit
+// y * Width + x, in as many 64-bit words as the board needs: one for the
+// 8x8 board. Set operations are bitwise over the words, and iteration goes
+// from set bit to set bit, so queries neither branch on tiles nor touch
+// memory beyond the masks themselves.
+template <int Width, int Height> class Bitboard {
+public:
+  static constexpr int TileCount = Width * Height;
+  static constexpr int WordCount = (TileCount + 63) / 64;
+
+public:
+  constexpr Bitboard() = default;
+
+  static constexpr bool Contains(glm::ivec2 tile) {
+    return tile.x >= 0 && tile.x < Width && tile.y >= 0 && tile.y < Height;
+  }
+
+  // Every tile of the board.
+  static constexpr Bitboard All() {
+    Bitboard all;
+    for (int i = 0; i < WordCount; i++)
+      all.Words[i] = ~std::uint64_t(0);
+    all.ClearPadding();
+    return all;
+  }
+
+  // The tiles of the rectangle at `corner` of `size` tiles, clipped to the
+  // board.
+  static constexpr Bitboard Region(glm::ivec2 corner, glm::ivec2 size) {
+    Bitboard region;
+    for (int y = corner.y; y < corner.y + size.y; y++)
+      for (int x = corner.x; x < corner.x + size.x; x++)
+        if (Contains({x, y}))
+          region.Set({x, y});
+    return region;
+  }
+  static constexpr Bitboard Row(int y) { return Region({0, y}, {Width, 1}); }
+  static constexpr Bitboard Column(int x) {
+    return Region({x, 0}, {1, Height});
+  }
+
+  constexpr bool Test(glm::ivec2 tile) const {
+    int bit = tile.y * Width + tile.x;
+    return (this->Words[bit >> 6] >> (bit & 63)) & 1;
+  }
+  constexpr void Set(glm::ivec2 tile) {
+    int bit = tile.y * Width + tile.x;
+    this->Words[bit >> 6] |= std::uint64_t(1) << (bit & 63);
+  }
+  constexpr void Reset(glm::ivec2 tile) {
+    int bit = tile.y * Width + tile.x;
+    this->Words[bit >> 6] &= ~(std::uint64_t(1) << (bit & 63));
+  }
+
+  // Number of tiles set.
+  int Count() const {
+    int count = 0;
+    for (int i = 0; i < WordCount; i++)
+      count += std::popcount(this->Words[i]);
+    return count;
+  }
+  bool Any() const {
+    std::uint64_t any = 0;
+    for (int i = 0; i < WordCount; i++)
+      any |= this->Words[i];
+    return any != 0;
+  }
+  bool None() const { return !this->Any(); }
+
+  // Calls f(tile) for each tile set, by rows from (0, 0).
+  template <typename F> void Each(F &&f) const {
+    for (int i = 0; i < WordCount; i++) {
+      for (std::uint64_t bits = this->Words[i]; bits; bits &= bits - 1) {
+        int bit = i * 64 + std::countr_zero(bits);
+        f(glm::ivec2(bit % Width, bit / Width));
+      }
+    }
+  }
+
+  // The tiles one step away, in the direction of each axis given (-1, 0 or
+  // 1); those that would leave the board are dropped rather than wrapped.
+  Bitboard Shifted(glm::ivec2 step) const {
+    // off the side columns first, so that nothing wraps to the next row
+    static constexpr Bitboard notFirst = ~Column(0);
+    static constexpr Bitboard notLast = ~Column(Width - 1);
+    Bitboard shifted = *this;
+    if (step.x > 0)
+      shifted &= notLast;
+    else if (step.x < 0)
+      shifted &= notFirst;
+
+    int bits = step.y * Width + step.x;
+    if (bits > 0)
+      shifted.ShiftUp(bits);
+    else if (bits < 0)
+      shifted.ShiftDown(-bits);
+    shifted.ClearPadding();
+    return shifted;
+  }
+
+  // The eight neighbouring tiles of each tile set.
+  Bitboard Neighbours() const {
+    Bitboard rows = *this | this->Shifted({0, 1}) | this->Shifted({0, -1});
+    Bitboard around = rows | rows.Shifted({1, 0}) | rows.Shifted({-1, 0});
+    return around & ~*this;
+  }
+
+  constexpr Bitboard &operator&=(const Bitboard &other) {
+    for (int i = 0; i < WordCount; i++)
+      this->Words[i] &= other.Words[i];
+    return *this;
+  }
+  Bitboard &operator|=(const Bitboard &other) {
+    for (int i = 0; i < WordCount; i++)
+      this->Words[i] |= other.Words[i];
+    return *this;
+  }
+  Bitboard &operator^=(const Bitboard &other) {
+    for (int i = 0; i < WordCount; i++)
+      this->Words[i] ^= other.Words[i];
+    return *this;
+  }
+  friend Bitboard operator&(Bitboard a, const Bitboard &b) { return a &= b; }
+  friend Bitboard operator|(Bitboard a, const Bitboard &b) { return a |= b; }
+  friend Bitboard operator^(Bitboard a, const Bitboard &b) { return a ^= b; }
+  // the tiles of the board not set
+  constexpr Bitboard operator~() const {
+    Bitboard inverted;
+    for (int i = 0; i < WordCount; i++)
+      inverted.Words[i] = ~this->Words[i];
+    inverted.ClearPadding();
+    return inverted;
+  }
+  bool operator==(const Bitboard &other) const {
+    std::uint64_t difference = 0;
+    for (int i = 0; i < WordCount; i++)
+      difference |= this->Words[i] ^ other.Words[i];
+    return difference == 0;
+  }
+  bool operator!=(const Bitboard &other) const { return !(*this == other); }
+
+private:
+  // the bits past the last tile stay clear
+  constexpr void ClearPadding() {
+    if constexpr (TileCount % 64 != 0)
+      this->Words[WordCount - 1] &=
+          (std::uint64_t(1) << (TileCount % 64)) - 1;
+  }
+
+  // towards higher tiles, across words
+  void ShiftUp(int bits) {
+    int words = bits >> 6, offset = bits & 63;
+    for (int i = WordCount - 1; i >= 0; i--) {
+      std::uint64_t high = i - words >= 0 ? this->Words[i - words] : 0;
+      std::uint64_t low = i - words - 1 >= 0 ? this->Words[i - words - 1] : 0;
+      this->Words[i] =
+          offset ? (high << offset) | (low >> (64 - offset)) : high;
+    }
+  }
+  void ShiftDown(int bits) {
+    int words = bits >> 6, offset = bits & 63;
+    for (int i = 0; i < WordCount; i++) {
+      std::uint64_t low = i + words < WordCount ? this->Words[i + words] : 0;
+      std::uint64_t high =
+          i + words + 1 < WordCount ? this->Words[i + words + 1] : 0;
+      this->Words[i] =
+          offset ? (low >> offset) | (high << (64 - offset)) : low;
+    }
+  }
+
+private:
+  std::uint64_t Words[WordCount] = {};
+};
+
+// Where the pieces of each team are; the game's rules as set operations.
+template <int Size> class BoardState {
+public:
+  using Mask = Bitboard<Size, Size>;
+
+public:
+  const Mask &GetTeam(int team) const { return this->Teams[team]; }
+  Mask GetOccupied() const { return this->Teams[0] | this->Teams[1]; }
+  Mask GetEmpty() const { return ~this->GetOccupied(); }
+
+  void Place(int team, glm::ivec2 tile) { this->Teams[team].Set(tile); }
+  void Remove(int team, glm::ivec2 tile) { this->Teams[team].Reset(tile); }
+
+  // The team of the piece on `tile`, or -1 if it is empty.
+  int GetTeamAt(glm::ivec2 tile) const {
+    int red = this->Teams[1].Test(tile);
+    int occupied = red | this->Teams[0].Test(tile);
+    return red - !occupied;
+  }
+
+  // The tiles a piece of `team` on `from` may move to: any empty tile.
+  Mask GetMoves(int team, glm::ivec2 from) const {
+    Mask moves = this->GetEmpty();
+    return this->Teams[team].Test(from) ? moves : Mask();
+  }
+  bool IsLegalMove(int team, glm::ivec2 from, glm::ivec2 to) const {
+    return Mask::Contains(to) && this->GetMoves(team, from).Test(to);
+  }
+  // Moves the piece; the move has to be legal.
+  void Move(int team, glm::ivec2 from, glm::ivec2 to) {
+    this->Teams[team].Reset(from);
+    this->Teams[team].Set(to);
+  }
+
+  // Pieces of `team` within `region`.
+  int Count(int team, const Mask &region) const {
+    return (this->Teams[team] & region).Count();
+  }
+
+private:
+  Mask Teams[2];
+};
+
+#endif
@@ -0,0 +1,50 @@
+#ifndef PIECES_H
+#define PIECES_H
+
+#include "TransformHierarchy.h"
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+// Components of the game pieces. A piece is an entity in the game's
+// EntityWorld; the mesh and the shader are shared by all of them and owned
+// by the game.
+
+enum Team { Blue, Red };
+
+struct boardPiece {
+  Team team;
+  glm::ivec2 coords;
+  bool selected;
+};
+
+// The piece's node in the scene's transform hierarchy, below the board
+struct pieceTransform {
+  TransformHierarchy::NodeId node;
+};
+
+// What the renderer needs of a piece, extracted from the game state into a
+// per-frame draw list
+struct pieceAppearance {
+  glm::vec3 color;
+  glm::mat4 modelMatrix;
+};
+
+// Position, rotation and scale relative to the board, so that the board's
+// matrix * translate * rotate * scale gives the model matrix.
+inline void GetBoardTransform(glm::ivec2 coords, int boardResolutionInt,
+                              glm::vec3 &position, glm::quat &rotation,
+                              glm::vec3 &scaling) {
+  float boardResolution = static_cast<float>(boardResolutionInt);
+
+  float xCoord =
+      ((coords.x / (boardResolution)) + (0.5f / boardResolution)) - 0.5f;
+  float yCoord =
+      ((coords.y / (boardResolution)) + (0.5f / boardResolution)) - 0.5f;
+
+  position = glm::vec3(xCoord, yCoord, 0.08f);
+  rotation = glm::quat(1.f, 0.f, 0.f, 0.f);
+  scaling = glm::vec3(1.f / (boardResolution + 1));
+}
+
+#endif
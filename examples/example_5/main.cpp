@@ -1,26 +1,18 @@
 #include "shaders/shader.h"
+#include "CookedAssets.h"
+#include "MeshLoader.h"
 
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
-#include "tiny_obj_loader.h"
 
 #include <iostream>
 #include <set>
 #include <cmath>
-
-//------------------------------------------------------------------------------
-// VERTEX STRUCT
-//------------------------------------------------------------------------------
-struct Vertex
-{
-    glm::vec3 location;
-    glm::vec3 normals;
-    glm::vec2 texCoords;
-};
-
+#include <memory>
+#include <vector>
 
 // -----------------------------------------------------------------------------
 // FUNCTION PROTOTYPES
@@ -30,8 +22,6 @@ GLuint CompileShader(const std::string& vertexShader,
 
 GLuint CreateSquare();
 
-GLuint LoadModel(const std::string, int& size);
-
 void Camera(const float, const GLuint);
 
 void Transform(const float, const GLuint);
@@ -99,8 +89,21 @@ int main()
     glEnable(GL_DEPTH_TEST);
 
 
-    int size = 0;
-    auto potVAO = LoadModel(std::string(MODELS_DIR), size);
+    // The teacup cooked by the CookAssets target is a memory map and an
+    // upload away; MeshLoader parses the OBJ, one mesh per material, as the
+    // fallback.
+    std::vector<std::shared_ptr<VertexArray>> teacup;
+    if (auto cooked = CookedAssets::LoadMesh(std::string(COOKED_DIR) + "/teacup.cmesh"))
+    {
+        teacup.push_back(cooked);
+    }
+    else
+    {
+        for (const auto& part : MeshLoader::LoadObj(std::string(MODELS_DIR) + "/teacup.obj"))
+        {
+            teacup.push_back(part.vertexArray);
+        }
+    }
     auto ShaderProgram = CompileShader(VertexShaderSrc, directionalLightFragmentShaderSrc);
     ///auto ShaderProgram = CompileShader(VertexShaderSrc, pointLightFragmentShaderSrc); //Feel free to test with pointlights as well by un-commenting this.
     glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
@@ -119,12 +122,15 @@ int main()
         // Draw SQUARE
         auto vertexColorLocation = glGetUniformLocation(ShaderProgram, "u_Color");
         glUseProgram(ShaderProgram);
-        glBindVertexArray(potVAO);
         glUniform4f(vertexColorLocation, 0.4f, 0.4f, 0.45f, 1.0f);
         Camera(currentTime, ShaderProgram);
         Transform(currentTime, ShaderProgram);
         Light(currentTime, ShaderProgram);
-        glDrawArrays(GL_TRIANGLES, 0, size);
+        for (const auto& mesh : teacup)
+        {
+            mesh->Bind();
+            glDrawElements(GL_TRIANGLES, mesh->GetIndexBuffer()->GetCount(), GL_UNSIGNED_INT, nullptr);
+        }
 
         glfwSwapBuffers(window);
 
@@ -137,7 +143,7 @@ int main()
     glUseProgram(0);
     glDeleteProgram(ShaderProgram);
 
-    CleanVAO(potVAO);
+    teacup.clear();
 
     glfwTerminate();
 
@@ -264,88 +270,6 @@ void CleanVAO(GLuint& vao)
   vao = 0;
 }
 
-// -----------------------------------------------------------------------------
-// Code handling the camera
-// -----------------------------------------------------------------------------
-GLuint LoadModel(const std::string path, int& size)
-{
-
-    //We create a vector of Vertex structs. OpenGL can understand these, and so will accept them as input.
-    std::vector<Vertex> vertices;
-
-    //Some variables that we are going to use to store data from tinyObj
-    tinyobj::attrib_t attrib;
-    std::vector<tinyobj::shape_t> shapes;
-    std::vector<tinyobj::material_t> materials; //This one goes unused for now, seeing as we don't need materials for this model.
-    
-    //Some variables incase there is something wrong with our obj file
-    std::string warn;
-    std::string err;
-
-    //We use tinobj to load our models. Feel free to find other .obj files and see if you can load them.
-    tinyobj::LoadObj(&attrib, &shapes, &materials, &warn, &err, (path + "/teacup.obj").c_str(), path.c_str());
-
-    if (!warn.empty()) {
-        std::cout << warn << std::endl;
-    }
-
-    if (!err.empty()) {
-        std::cerr << err << std::endl;
-    }
-
-    //For each shape defined in the obj file
-    for (auto shape : shapes)
-    {
-        //We find each mesh
-        for (auto meshIndex : shape.mesh.indices)
-        {
-            //And store the data for each vertice, including normals
-            glm::vec3 vertice = {
-                attrib.vertices[meshIndex.vertex_index * 3],
-                attrib.vertices[(meshIndex.vertex_index * 3) + 1],
-                attrib.vertices[(meshIndex.vertex_index * 3) + 2]
-            };
-            glm::vec3 normal = {
-                attrib.normals[meshIndex.normal_index * 3],
-                attrib.normals[(meshIndex.normal_index * 3) + 1],
-                attrib.normals[(meshIndex.normal_index * 3) + 2]
-            };
-            glm::vec2 textureCoordinate = {                         //These go unnused, but if you want textures, you will need them.
-                attrib.texcoords[meshIndex.texcoord_index * 2],
-                attrib.texcoords[(meshIndex.texcoord_index * 2) + 1]
-            };
-
-            vertices.push_back({ vertice, normal, textureCoordinate }); //We add our new vertice struct to our vector
-
-        }
-    }
-
-    GLuint VAO;
-    glGenVertexArrays(1, &VAO);
-    glBindVertexArray(VAO);
-
-    GLuint VBO;
-    glGenBuffers(1, &VBO);
-    glBindBuffer(GL_ARRAY_BUFFER, VBO);
-
-    //As you can see, OpenGL will accept a vector of structs as a valid input here
-    glBufferData(GL_ARRAY_BUFFER, sizeof(Vertex) * vertices.size(), &vertices[0], GL_STATIC_DRAW);
-
-    glEnableVertexAttribArray(0);
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(float) * 8, nullptr);
-
-    glEnableVertexAttribArray(1);
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(float) * 8, (void*)(sizeof(float) * 3));
-
-    glEnableVertexAttribArray(2);
-    glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(float) * 8, (void*)(sizeof(float) * 6));
-    
-    //This will be needed later to specify how much we need to draw. Look at the main loop to find this variable again.
-    size = vertices.size();
-
-    return VAO;
-}
-
 void Transform(const float time, const GLuint shaderprogram)
 {
 
@@ -7,8 +7,8 @@ static const std::string VertexShaderSrc = R"(
 #version 430 core
 
 layout(location = 0) in vec3 a_Position;
-layout(location = 1) in vec3 a_normals;
-//layout(location = 2) in vec2 a_texture; Incase we want to add textures to our model later.
+//layout(location = 1) in vec2 a_texture; Incase we want to add textures to our model later.
+layout(location = 2) in vec3 a_normals;
 
 //We specify our uniforms. We do not need to specify locations manually, but it helps with knowing what is bound where.
 layout(location=0) uniform mat4 u_TransformationMat = mat4(1);
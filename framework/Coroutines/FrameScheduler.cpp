@@ -0,0 +1,140 @@
+#include "FrameScheduler.h"
+#include "TextureManager.h"
+
+#include <thread>
+
+FrameScheduler *FrameScheduler::GetInstance() {
+  static FrameScheduler scheduler;
+  return &scheduler;
+}
+
+FrameScheduler::FrameScheduler() {
+  // created first, so that it is destroyed after the scheduler, which
+  // waits for its jobs
+  JobSystem::GetInstance();
+}
+
+FrameScheduler::~FrameScheduler() {
+  // work for parked tasks may still be running
+  JobSystem::GetInstance()->Wait(this->BackgroundJobs);
+  while (this->PendingReads.load() > 0)
+    std::this_thread::yield();
+
+  // destroying a task destroys the tasks it awaits with it
+  for (Task<void>::Handle task : this->Tasks)
+    task.destroy();
+}
+
+void FrameScheduler::Spawn(Task<void> task) {
+  Task<void>::Handle coroutine = task.Release();
+  if (!coroutine)
+    return;
+  this->Tasks.push_back(coroutine);
+  coroutine.resume();
+}
+
+void FrameScheduler::Park(std::coroutine_handle<> coroutine, Poll poll,
+                          void *awaiter) {
+  this->Parked.push_back({coroutine, poll, awaiter});
+}
+
+void FrameScheduler::Tick() {
+  this->Frame++;
+
+  // coroutines resumed here park again in the fresh list
+  this->Polling.swap(this->Parked);
+  for (const parked &waiting : this->Polling) {
+    if (waiting.poll(waiting.awaiter))
+      waiting.coroutine.resume();
+    else
+      this->Parked.push_back(waiting);
+  }
+  this->Polling.clear();
+
+  for (std::size_t i = 0; i < this->Tasks.size();) {
+    if (this->Tasks[i].done()) {
+      this->Tasks[i].destroy();
+      this->Tasks[i] = this->Tasks.back();
+      this->Tasks.pop_back();
+    } else {
+      i++;
+    }
+  }
+}
+
+bool fenceAwaiter::IsReady(fenceAwaiter *self) {
+  GLenum status =
+      glClientWaitSync(self->fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+  return status != GL_TIMEOUT_EXPIRED;
+}
+
+fenceAwaiter::~fenceAwaiter() {
+  if (this->owned)
+    glDeleteSync(this->fence);
+}
+
+fenceAwaiter Fence(GLsync fence) {
+  fenceAwaiter awaiter;
+  awaiter.fence = fence;
+  awaiter.owned = false;
+  return awaiter;
+}
+
+fenceAwaiter GpuFinished() {
+  fenceAwaiter awaiter;
+  awaiter.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+  awaiter.owned = true;
+  return awaiter;
+}
+
+bool queryAwaiter::IsReady(queryAwaiter *self) {
+  GLuint available = GL_FALSE;
+  glGetQueryObjectuiv(self->query, GL_QUERY_RESULT_AVAILABLE, &available);
+  return available == GL_TRUE;
+}
+
+GLuint64 queryAwaiter::await_resume() {
+  GLuint64 result = 0;
+  glGetQueryObjectui64v(this->query, GL_QUERY_RESULT, &result);
+  return result;
+}
+
+queryAwaiter QueryResult(GLuint query) {
+  queryAwaiter awaiter;
+  awaiter.query = query;
+  return awaiter;
+}
+
+void fileReadAwaiter::Start() {
+  AsyncFileIO *fileIO = AsyncFileIO::GetInstance();
+  FrameScheduler *scheduler = FrameScheduler::GetInstance();
+  scheduler->ReadStarted();
+  // the callback runs on the I/O thread; the coroutine waits for the flag
+  fileIO->Read(this->file, this->offset, this->size, this->destination,
+               [this, scheduler](const AsyncFileIO::ReadResult &read) {
+                 this->result = read;
+                 this->done.store(true, std::memory_order_release);
+                 scheduler->ReadFinished();
+               });
+  fileIO->Submit();
+}
+
+fileReadAwaiter FileRead(AsyncFileIO::FileHandle file, std::uint64_t offset,
+                         std::size_t size, void *destination) {
+  fileReadAwaiter awaiter;
+  awaiter.file = file;
+  awaiter.offset = offset;
+  awaiter.size = size;
+  awaiter.destination = destination;
+  return awaiter;
+}
+
+bool textureAwaiter::IsReady(textureAwaiter *self) {
+  return TextureManager::GetInstance()->IsResident(self->name);
+}
+
+textureAwaiter TextureResident(std::string name) {
+  textureAwaiter awaiter;
+  awaiter.name = std::move(name);
+  return awaiter;
+}
@@ -0,0 +1,231 @@
+#ifndef FRAMESCHEDULER_H
+#define FRAMESCHEDULER_H
+
+#include "AsyncFileIO.h"
+#include "JobSystem.h"
+#include "Task.h"
+
+#include <glad/glad.h>
+
+#include <atomic>
+#include <coroutine>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// Resumes coroutines on the main thread, between frames. A coroutine that
+// awaits one of the awaitables below is parked here, and Tick(), called
+// once per frame (as a GLFWApplication frame callback, for example), checks
+// each parked coroutine and resumes those whose wait is over. Waiting costs
+// nothing on the render thread but that check, and the code after the
+// co_await may use GL since it runs on the main thread again.
+//
+//   Task<void> Screenshot(GLuint pixelBuffer) {
+//     co_await GpuFinished();     // the readback into pixelBuffer is done
+//     ...                         // map it without stalling
+//   }
+//   FrameScheduler::GetInstance()->Spawn(Screenshot(buffer));
+class FrameScheduler {
+public:
+  // Whether an awaiter's wait is over; gets the awaiter.
+  using Poll = bool (*)(void *awaiter);
+
+public:
+  static FrameScheduler *GetInstance();
+
+  ~FrameScheduler();
+  FrameScheduler(const FrameScheduler &) = delete;
+  void operator=(const FrameScheduler &) = delete;
+
+  // Starts the task, which runs up to its first co_await, and keeps it
+  // until it is done.
+  void Spawn(Task<void> task);
+
+  // Resumes the coroutines whose wait is over. Main thread only.
+  void Tick();
+
+  // Ticks so far.
+  std::uint64_t GetFrame() const { return this->Frame; }
+  // Spawned tasks that have not finished.
+  std::size_t GetTaskCount() const { return this->Tasks.size(); }
+
+  // For awaitables: parks `coroutine` until poll(awaiter) returns true.
+  void Park(std::coroutine_handle<> coroutine, Poll poll, void *awaiter);
+
+  // For awaitables that hand work to other threads. The jobs and reads
+  // write into the awaiter, and often into buffers next to it in the
+  // coroutine's frame, so the destructor waits for them before it destroys
+  // the tasks.
+  JobCounter &GetBackgroundJobs() { return this->BackgroundJobs; }
+  void ReadStarted() { this->PendingReads++; }
+  void ReadFinished() { this->PendingReads--; }
+
+private:
+  FrameScheduler();
+
+  struct parked {
+    std::coroutine_handle<> coroutine;
+    Poll poll;
+    void *awaiter;
+  };
+
+private:
+  std::vector<parked> Parked;
+  // last tick's Parked, kept for its memory
+  std::vector<parked> Polling;
+  std::vector<Task<void>::Handle> Tasks;
+  std::uint64_t Frame = 0;
+
+  JobCounter BackgroundJobs;
+  std::atomic<std::size_t> PendingReads{0};
+};
+
+// Awaiters park the coroutine with a poll function and resume it from
+// Tick(), on the main thread.
+template <typename Derived> struct parkingAwaiter {
+  bool await_ready() { return Derived::IsReady(static_cast<Derived *>(this)); }
+  void await_suspend(std::coroutine_handle<> coroutine) {
+    static_cast<Derived *>(this)->Start();
+    FrameScheduler::GetInstance()->Park(
+        coroutine,
+        [](void *awaiter) {
+          return Derived::IsReady(static_cast<Derived *>(awaiter));
+        },
+        this);
+  }
+  // what the awaiter does once it is suspended
+  void Start() {}
+};
+
+struct framesAwaiter : parkingAwaiter<framesAwaiter> {
+  std::uint64_t target;
+
+  static bool IsReady(framesAwaiter *self) {
+    return FrameScheduler::GetInstance()->GetFrame() >= self->target;
+  }
+  void await_resume() {}
+};
+
+// Resumes after `count` frames.
+inline framesAwaiter Frames(std::uint64_t count) {
+  framesAwaiter awaiter;
+  awaiter.target = FrameScheduler::GetInstance()->GetFrame() + count;
+  return awaiter;
+}
+inline framesAwaiter NextFrame() { return Frames(1); }
+
+struct fenceAwaiter : parkingAwaiter<fenceAwaiter> {
+  GLsync fence = nullptr;
+  // deleted with the awaiter, also when its coroutine is destroyed while
+  // it waits
+  bool owned = false;
+
+  fenceAwaiter() = default;
+  fenceAwaiter(fenceAwaiter &&other) : fence(other.fence), owned(other.owned) {
+    other.owned = false;
+  }
+  ~fenceAwaiter();
+
+  static bool IsReady(fenceAwaiter *self);
+  void await_resume() {}
+};
+
+// Resumes once the GPU has passed `fence`.
+fenceAwaiter Fence(GLsync fence);
+// Resumes once the GPU has finished the commands issued so far.
+fenceAwaiter GpuFinished();
+
+struct queryAwaiter : parkingAwaiter<queryAwaiter> {
+  GLuint query;
+
+  static bool IsReady(queryAwaiter *self);
+  GLuint64 await_resume();
+};
+
+// Resumes with the query's result once it is available, without stalling
+// for it like glGetQueryObject would.
+queryAwaiter QueryResult(GLuint query);
+
+struct fileReadAwaiter : parkingAwaiter<fileReadAwaiter> {
+  AsyncFileIO::FileHandle file;
+  std::uint64_t offset;
+  std::size_t size;
+  void *destination;
+  AsyncFileIO::ReadResult result;
+  std::atomic<bool> done{false};
+
+  fileReadAwaiter() = default;
+  // not moved once suspended, but returned from FileRead()
+  fileReadAwaiter(fileReadAwaiter &&other)
+      : file(other.file), offset(other.offset), size(other.size),
+        destination(other.destination) {}
+
+  static bool IsReady(fileReadAwaiter *self) {
+    return self->done.load(std::memory_order_acquire);
+  }
+  void Start();
+  AsyncFileIO::ReadResult await_resume() { return this->result; }
+};
+
+// Reads through AsyncFileIO and resumes with the result; see
+// AsyncFileIO::Read().
+fileReadAwaiter FileRead(AsyncFileIO::FileHandle file, std::uint64_t offset,
+                         std::size_t size, void *destination);
+
+struct textureAwaiter : parkingAwaiter<textureAwaiter> {
+  std::string name;
+
+  static bool IsReady(textureAwaiter *self);
+  void await_resume() {}
+};
+
+// Resumes once the texture, loaded with one of TextureManager's
+// asynchronous loads, is resident.
+textureAwaiter TextureResident(std::string name);
+
+template <typename F>
+struct backgroundAwaiter : parkingAwaiter<backgroundAwaiter<F>> {
+  using result = std::invoke_result_t<F &>;
+
+  F work;
+  std::optional<std::conditional_t<std::is_void<result>::value, char, result>>
+      value;
+  std::atomic<bool> done{false};
+
+  explicit backgroundAwaiter(F &&work) : work(std::forward<F>(work)) {}
+  backgroundAwaiter(backgroundAwaiter &&other)
+      : work(std::move(other.work)) {}
+
+  static bool IsReady(backgroundAwaiter *self) {
+    return self->done.load(std::memory_order_acquire);
+  }
+  void Start() {
+    JobSystem::GetInstance()->Submit(
+        [this]() {
+          if constexpr (std::is_void<result>::value)
+            this->work();
+          else
+            this->value.emplace(this->work());
+          this->done.store(true, std::memory_order_release);
+        },
+        &FrameScheduler::GetInstance()->GetBackgroundJobs());
+  }
+  result await_resume() {
+    if constexpr (!std::is_void<result>::value)
+      return std::move(*this->value);
+  }
+};
+
+// Runs `work` on a JobSystem worker and resumes with its result, back on
+// the main thread.
+template <typename F>
+backgroundAwaiter<std::decay_t<F>> Background(F &&work) {
+  using callable = std::decay_t<F>;
+  return backgroundAwaiter<callable>(callable(std::forward<F>(work)));
+}
+
+#endif
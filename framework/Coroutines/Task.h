@@ -0,0 +1,117 @@
+#ifndef TASK_H
+#define TASK_H
+
+#include <coroutine>
+#include <exception>
+#include <optional>
+#include <type_traits>
+#include <utility>
+
+// A coroutine that returns a T. It starts when it is first awaited, and the
+// awaiting coroutine continues as soon as it has returned:
+//
+//   Task<Mesh> LoadMesh(std::string path) {
+//     auto bytes = co_await Background([&]() { return ReadFile(path); });
+//     co_return ParseMesh(bytes);
+//   }
+//
+// Top-level tasks are handed to FrameScheduler::Spawn(), which starts them
+// and keeps them until they are done.
+template <typename T = void> class Task;
+
+namespace detail {
+
+struct taskPromiseBase {
+  // the coroutine that awaits this one, if any
+  std::coroutine_handle<> continuation;
+
+  std::suspend_always initial_suspend() noexcept { return {}; }
+
+  struct finalAwaiter {
+    bool await_ready() noexcept { return false; }
+    template <typename Promise>
+    std::coroutine_handle<>
+    await_suspend(std::coroutine_handle<Promise> finished) noexcept {
+      if (std::coroutine_handle<> next = finished.promise().continuation)
+        return next;
+      return std::noop_coroutine();
+    }
+    void await_resume() noexcept {}
+  };
+  finalAwaiter final_suspend() noexcept { return {}; }
+
+  // the framework does not use exceptions
+  void unhandled_exception() { std::terminate(); }
+};
+
+template <typename T> struct taskPromise : taskPromiseBase {
+  std::optional<T> value;
+
+  Task<T> get_return_object();
+  template <typename U> void return_value(U &&result) {
+    value.emplace(std::forward<U>(result));
+  }
+};
+
+template <> struct taskPromise<void> : taskPromiseBase {
+  Task<void> get_return_object();
+  void return_void() {}
+};
+
+} // namespace detail
+
+template <typename T> class Task {
+public:
+  using promise_type = detail::taskPromise<T>;
+  using Handle = std::coroutine_handle<promise_type>;
+
+public:
+  Task() = default;
+  explicit Task(Handle coroutine) : Coroutine(coroutine) {}
+  Task(Task &&other) noexcept : Coroutine(std::exchange(other.Coroutine, {})) {}
+  Task &operator=(Task &&other) noexcept {
+    if (this != &other) {
+      if (this->Coroutine)
+        this->Coroutine.destroy();
+      this->Coroutine = std::exchange(other.Coroutine, {});
+    }
+    return *this;
+  }
+  ~Task() {
+    if (this->Coroutine)
+      this->Coroutine.destroy();
+  }
+
+  bool IsDone() const { return !this->Coroutine || this->Coroutine.done(); }
+  // Hands the coroutine over to the caller, who has to destroy it.
+  Handle Release() { return std::exchange(this->Coroutine, {}); }
+
+  // co_await support
+  bool await_ready() const noexcept { return false; }
+  std::coroutine_handle<>
+  await_suspend(std::coroutine_handle<> awaiting) noexcept {
+    this->Coroutine.promise().continuation = awaiting;
+    return this->Coroutine;
+  }
+  T await_resume() {
+    if constexpr (!std::is_void<T>::value)
+      return std::move(*this->Coroutine.promise().value);
+  }
+
+private:
+  Handle Coroutine;
+};
+
+namespace detail {
+
+template <typename T> Task<T> taskPromise<T>::get_return_object() {
+  return Task<T>(Task<T>::Handle::from_promise(*this));
+}
+
+inline Task<void> taskPromise<void>::get_return_object() {
+  return Task<void>(Task<void>::Handle::from_promise(*this));
+}
+
+} // namespace detail
+
+#endif
@@ -0,0 +1,247 @@
+#include "EntityWorld.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <mutex>
+
+namespace {
+
+// ids may be handed out from any thread
+std::mutex ComponentMutex;
+
+std::size_t AlignUp(std::size_t offset, std::size_t alignment) {
+  return (offset + alignment - 1) / alignment * alignment;
+}
+
+} // namespace
+
+EntityWorld::componentInfo EntityWorld::ComponentInfos[MaxComponents];
+EntityWorld::ComponentId EntityWorld::ComponentCount = 0;
+
+EntityWorld::ComponentId
+EntityWorld::RegisterComponent(const componentInfo &info) {
+  std::lock_guard<std::mutex> lock(ComponentMutex);
+  if (ComponentCount == MaxComponents) {
+    std::cerr << "More than " << MaxComponents
+              << " component types are not supported" << std::endl;
+    std::abort();
+  }
+  ComponentInfos[ComponentCount] = info;
+  return ComponentCount++;
+}
+
+const EntityWorld::componentInfo &
+EntityWorld::GetComponentInfo(ComponentId id) {
+  // written before the id was handed out, and never again
+  return ComponentInfos[id];
+}
+
+EntityWorld::EntityWorld() = default;
+
+EntityWorld::~EntityWorld() {
+  for (archetype *owner : this->ArchetypeList)
+    for (auto &block : owner->chunks)
+      for (ComponentId component : owner->components)
+        for (std::size_t row = 0; row < block->count; row++)
+          GetComponentInfo(component).destroy(
+              block->data + owner->offsets[component] +
+              row * GetComponentInfo(component).size);
+}
+
+EntityWorld::archetype *EntityWorld::GetArchetype(ComponentMask mask) {
+  auto found = this->Archetypes.find(mask);
+  if (found != this->Archetypes.end())
+    return found->second.get();
+
+  auto owner = std::make_unique<archetype>();
+  owner->mask = mask;
+  std::size_t rowSize = sizeof(Entity);
+  for (ComponentId id = 0; id < MaxComponents; id++) {
+    if (mask & (ComponentMask(1) << id)) {
+      owner->components.push_back(id);
+      rowSize += GetComponentInfo(id).size;
+    }
+  }
+
+  // Largest alignment first, so that the arrays need little padding; the
+  // capacity shrinks until the padded arrays fit.
+  std::vector<ComponentId> layout = owner->components;
+  std::stable_sort(layout.begin(), layout.end(),
+                   [](ComponentId a, ComponentId b) {
+                     return GetComponentInfo(a).alignment >
+                            GetComponentInfo(b).alignment;
+                   });
+  for (std::size_t capacity = ChunkSize / rowSize; capacity > 0; capacity--) {
+    std::size_t end = sizeof(Entity) * capacity;
+    for (ComponentId id : layout) {
+      const componentInfo &info = GetComponentInfo(id);
+      owner->offsets[id] = AlignUp(end, info.alignment);
+      end = owner->offsets[id] + info.size * capacity;
+    }
+    if (end <= ChunkSize) {
+      owner->capacity = capacity;
+      break;
+    }
+  }
+  if (owner->capacity == 0) {
+    std::cerr << "Components of one entity do not fit in a chunk of "
+              << ChunkSize << " bytes" << std::endl;
+    std::abort();
+  }
+
+  archetype *result = owner.get();
+  this->ArchetypeList.push_back(result);
+  this->Archetypes.emplace(mask, std::move(owner));
+  return result;
+}
+
+EntityWorld::archetype *EntityWorld::GetArchetypeWith(archetype *from,
+                                                      ComponentId component) {
+  archetype *&to = from->withComponent[component];
+  if (!to) {
+    to = this->GetArchetype(from->mask | (ComponentMask(1) << component));
+    to->withoutComponent[component] = from;
+  }
+  return to;
+}
+
+EntityWorld::archetype *
+EntityWorld::GetArchetypeWithout(archetype *from, ComponentId component) {
+  archetype *&to = from->withoutComponent[component];
+  if (!to) {
+    to = this->GetArchetype(from->mask & ~(ComponentMask(1) << component));
+    to->withComponent[component] = from;
+  }
+  return to;
+}
+
+Entity EntityWorld::AllocateEntity(archetype *owner) {
+  Entity entity;
+  if (!this->FreeIndices.empty()) {
+    entity.index = this->FreeIndices.back();
+    this->FreeIndices.pop_back();
+  } else {
+    entity.index = static_cast<std::uint32_t>(this->Records.size());
+    this->Records.emplace_back();
+  }
+  entity.generation = this->Records[entity.index].generation;
+
+  location at = this->AllocateRow(owner, entity);
+  entityRecord &record = this->Records[entity.index];
+  record.owner = at.owner;
+  record.chunkIndex = at.chunkIndex;
+  record.row = at.row;
+  this->EntityCount++;
+  return entity;
+}
+
+EntityWorld::location EntityWorld::AllocateRow(archetype *owner,
+                                               Entity entity) {
+  if (owner->chunks.empty() || owner->chunks.back()->count == owner->capacity) {
+    PoolHandle<chunk> handle = this->Chunks.Create();
+    chunk *created = this->Chunks.Get(handle);
+    created->handle = handle;
+    owner->chunks.push_back(created);
+  }
+
+  chunk &block = *owner->chunks.back();
+  location at = {owner, owner->chunks.size() - 1, block.count};
+  GetEntities(block)[block.count++] = entity;
+  owner->entityCount++;
+  return at;
+}
+
+void EntityWorld::FreeRow(const location &at) {
+  archetype &owner = *at.owner;
+  chunk &block = *owner.chunks[at.chunkIndex];
+  chunk &last = *owner.chunks.back();
+  std::size_t lastRow = last.count - 1;
+
+  for (ComponentId component : owner.components) {
+    const componentInfo &info = GetComponentInfo(component);
+    unsigned char *array = block.data + owner.offsets[component];
+    unsigned char *lastArray = last.data + owner.offsets[component];
+    info.destroy(array + at.row * info.size);
+    if (&block != &last || at.row != lastRow) {
+      info.moveConstruct(array + at.row * info.size,
+                         lastArray + lastRow * info.size);
+      info.destroy(lastArray + lastRow * info.size);
+    }
+  }
+
+  if (&block != &last || at.row != lastRow) {
+    Entity moved = GetEntities(last)[lastRow];
+    GetEntities(block)[at.row] = moved;
+    this->Records[moved.index].chunkIndex = at.chunkIndex;
+    this->Records[moved.index].row = at.row;
+  }
+
+  last.count--;
+  owner.entityCount--;
+  if (last.count == 0) {
+    this->Chunks.Destroy(last.handle);
+    owner.chunks.pop_back();
+  }
+}
+
+EntityWorld::location EntityWorld::MoveEntity(Entity entity, archetype *to) {
+  entityRecord &record = this->Records[entity.index];
+  location from = {record.owner, record.chunkIndex, record.row};
+  location at = this->AllocateRow(to, entity);
+
+  // components both have move over; FreeRow destroys the moved-from ones
+  // together with those `to` does not have
+  for (ComponentId component : to->components)
+    if (from.owner->mask & (ComponentMask(1) << component))
+      GetComponentInfo(component).moveConstruct(
+          this->GetComponentData(at, component),
+          this->GetComponentData(from, component));
+  this->FreeRow(from);
+
+  entityRecord &moved = this->Records[entity.index];
+  moved.owner = at.owner;
+  moved.chunkIndex = at.chunkIndex;
+  moved.row = at.row;
+  return at;
+}
+
+void EntityWorld::DestroyEntity(Entity entity) {
+  const entityRecord *found = this->FindRecord(entity);
+  if (!found) {
+    ReportDeadEntity(entity);
+    return;
+  }
+
+  this->FreeRow({found->owner, found->chunkIndex, found->row});
+  entityRecord &record = this->Records[entity.index];
+  record.owner = nullptr;
+  record.generation++;
+  this->FreeIndices.push_back(entity.index);
+  this->EntityCount--;
+}
+
+bool EntityWorld::IsAlive(Entity entity) const {
+  return this->FindRecord(entity) != nullptr;
+}
+
+const EntityWorld::entityRecord *EntityWorld::FindRecord(Entity entity) const {
+  if (entity.index >= this->Records.size())
+    return nullptr;
+  const entityRecord &record = this->Records[entity.index];
+  if (!record.owner || record.generation != entity.generation)
+    return nullptr;
+  return &record;
+}
+
+void EntityWorld::ReportDeadEntity(Entity entity) {
+  std::cerr << "Entity " << entity.index << " (generation " << entity.generation
+            << ") does not exist" << std::endl;
+}
+
+void *EntityWorld::GetComponentData(const location &at,
+                                    ComponentId component) const {
+  chunk &block = *at.owner->chunks[at.chunkIndex];
+  return block.data + at.owner->offsets[component] +
+         at.row * GetComponentInfo(component).size;
+}
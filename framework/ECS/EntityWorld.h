@@ -0,0 +1,296 @@
+#ifndef ENTITYWORLD_H
+#define ENTITYWORLD_H
+
+#include "ObjectPool.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// An entity is an id; its data are components, plain structs of any type.
+// Entities with the same set of component types form an archetype, and an
+// archetype stores its entities in fixed size chunks, one array per
+// component type in each chunk. Queries visit every archetype that has the
+// requested components and walk the arrays of its chunks front to back,
+// so the loops over many entities read memory linearly instead of chasing
+// a pointer per object.
+//
+// Adding or removing a component moves the entity to another archetype,
+// and destroying one moves the last entity of its archetype into the gap.
+// Component references and pointers therefore only stay valid until the
+// next structural change, which must not happen while a query runs.
+// Queries only read the entity layout, so several can run at once, from
+// SystemScheduler for example, as long as they do not write the same
+// component types.
+
+struct Entity {
+  std::uint32_t index = UINT32_MAX;
+  std::uint32_t generation = 0;
+
+  bool operator==(const Entity &other) const {
+    return index == other.index && generation == other.generation;
+  }
+  bool operator!=(const Entity &other) const { return !(*this == other); }
+};
+
+// One bit per component type.
+using ComponentMask = std::uint64_t;
+
+class EntityWorld {
+public:
+  using ComponentId = std::uint32_t;
+  static constexpr ComponentId MaxComponents = 64;
+  static constexpr std::size_t ChunkSize = 16 * 1024;
+
+public:
+  EntityWorld();
+  ~EntityWorld();
+  EntityWorld(const EntityWorld &) = delete;
+  void operator=(const EntityWorld &) = delete;
+
+  // Ids are assigned on first use, per type and for the whole program.
+  template <typename T> static ComponentId GetComponentId();
+  // The mask of the given component types; const is ignored.
+  template <typename... Ts> static ComponentMask GetMask();
+
+  template <typename... Ts> Entity CreateEntity(Ts &&...components);
+  void DestroyEntity(Entity entity);
+  bool IsAlive(Entity entity) const;
+  std::size_t GetEntityCount() const { return this->EntityCount; }
+
+  // Replaces the component if the entity has one already. nullptr if the
+  // entity was destroyed.
+  template <typename T> T *AddComponent(Entity entity, T component);
+  template <typename T> void RemoveComponent(Entity entity);
+  template <typename T> bool HasComponent(Entity entity) const;
+  // nullptr if the entity does not have one.
+  template <typename T> T *GetComponent(Entity entity);
+  template <typename T> const T *GetComponent(Entity entity) const;
+
+  // Calls f(Ts &...) or f(Entity, Ts &...) for every entity that has all
+  // of Ts. Const component types are passed as const references.
+  template <typename... Ts, typename F> void Each(F &&f);
+  // Calls f(count, const Entity *, Ts *...) for every chunk with entities
+  // that have all of Ts, for loops that want the arrays themselves.
+  template <typename... Ts, typename F> void EachChunk(F &&f);
+  // Number of entities that have all of Ts.
+  template <typename... Ts> std::size_t Count() const;
+
+  // Occupancy of the chunk pool all archetypes share.
+  PoolStats GetChunkStats() const { return this->Chunks.GetStats(); }
+
+private:
+  struct componentInfo {
+    std::size_t size;
+    std::size_t alignment;
+    void (*moveConstruct)(void *destination, void *source);
+    void (*destroy)(void *component);
+  };
+
+  struct chunk {
+    alignas(64) unsigned char data[ChunkSize];
+    std::size_t count = 0;
+    PoolHandle<chunk> handle;
+  };
+
+  struct archetype {
+    ComponentMask mask = 0;
+    std::vector<ComponentId> components;
+    // byte offset of each component's array in a chunk, by component id;
+    // the entity array is at 0
+    std::size_t offsets[MaxComponents];
+    std::size_t capacity = 0; // entities per chunk
+    std::size_t entityCount = 0;
+    // only the last chunk may be partly filled, and none is empty
+    std::vector<chunk *> chunks;
+    // archetypes with one component more or less, as they come up
+    std::unordered_map<ComponentId, archetype *> withComponent;
+    std::unordered_map<ComponentId, archetype *> withoutComponent;
+  };
+
+  struct entityRecord {
+    archetype *owner = nullptr;
+    std::size_t chunkIndex = 0;
+    std::size_t row = 0;
+    std::uint32_t generation = 0;
+  };
+
+  struct location {
+    archetype *owner;
+    std::size_t chunkIndex;
+    std::size_t row;
+  };
+
+private:
+  static ComponentId RegisterComponent(const componentInfo &info);
+  static const componentInfo &GetComponentInfo(ComponentId id);
+
+  template <typename T> static componentInfo MakeComponentInfo();
+
+  archetype *GetArchetype(ComponentMask mask);
+  archetype *GetArchetypeWith(archetype *from, ComponentId component);
+  archetype *GetArchetypeWithout(archetype *from, ComponentId component);
+
+  Entity AllocateEntity(archetype *owner);
+  // Appends a row whose components are not constructed yet.
+  location AllocateRow(archetype *owner, Entity entity);
+  // Destroys the row's components and fills the gap with the last row.
+  void FreeRow(const location &at);
+  // Moves the entity to `to`; components `to` does not have are destroyed,
+  // components only `to` has are left unconstructed.
+  location MoveEntity(Entity entity, archetype *to);
+
+  // nullptr for destroyed entities
+  const entityRecord *FindRecord(Entity entity) const;
+  static void ReportDeadEntity(Entity entity);
+  void *GetComponentData(const location &at, ComponentId component) const;
+  static Entity *GetEntities(chunk &block) {
+    return reinterpret_cast<Entity *>(block.data);
+  }
+
+  template <typename T>
+  static T *GetArray(const archetype &owner, chunk &block) {
+    return reinterpret_cast<T *>(block.data +
+                                 owner.offsets[GetComponentId<T>()]);
+  }
+
+private:
+  // of the whole program, filled as types are first used
+  static componentInfo ComponentInfos[MaxComponents];
+  static ComponentId ComponentCount;
+
+  std::vector<entityRecord> Records;
+  std::vector<std::uint32_t> FreeIndices;
+  std::size_t EntityCount = 0;
+  std::unordered_map<ComponentMask, std::unique_ptr<archetype>> Archetypes;
+  // in creation order, for the queries
+  std::vector<archetype *> ArchetypeList;
+  // Emptied chunks go back here and are reused by any archetype, so that
+  // entities coming and going do not allocate.
+  ObjectPool<chunk, 16> Chunks;
+};
+
+template <typename T>
+EntityWorld::componentInfo EntityWorld::MakeComponentInfo() {
+  static_assert(std::is_move_constructible<T>::value,
+                "components have to be move constructible");
+  static_assert(alignof(T) <= 64, "components may be aligned to 64 at most");
+  return {sizeof(T), alignof(T),
+          [](void *destination, void *source) {
+            new (destination) T(std::move(*static_cast<T *>(source)));
+          },
+          [](void *component) { static_cast<T *>(component)->~T(); }};
+}
+
+template <typename T> EntityWorld::ComponentId EntityWorld::GetComponentId() {
+  using component = std::remove_cv_t<std::remove_reference_t<T>>;
+  // one id for T and const T
+  if constexpr (!std::is_same<T, component>::value) {
+    return GetComponentId<component>();
+  } else {
+    static const ComponentId id = RegisterComponent(MakeComponentInfo<T>());
+    return id;
+  }
+}
+
+template <typename... Ts> ComponentMask EntityWorld::GetMask() {
+  ComponentMask mask = 0;
+  ((mask |= ComponentMask(1) << GetComponentId<Ts>()), ...);
+  return mask;
+}
+
+template <typename... Ts> Entity EntityWorld::CreateEntity(Ts &&...components) {
+  archetype *owner = this->GetArchetype(GetMask<std::decay_t<Ts>...>());
+  Entity entity = this->AllocateEntity(owner);
+  if constexpr (sizeof...(Ts) > 0) {
+    const entityRecord &record = this->Records[entity.index];
+    location at = {owner, record.chunkIndex, record.row};
+    (new (this->GetComponentData(at, GetComponentId<std::decay_t<Ts>>()))
+         std::decay_t<Ts>(std::forward<Ts>(components)),
+     ...);
+  }
+  return entity;
+}
+
+template <typename T> T *EntityWorld::AddComponent(Entity entity, T component) {
+  ComponentId id = GetComponentId<T>();
+  const entityRecord *record = this->FindRecord(entity);
+  if (!record) {
+    ReportDeadEntity(entity);
+    return nullptr;
+  }
+  if (record->owner->mask & (ComponentMask(1) << id)) {
+    T *existing = static_cast<T *>(this->GetComponentData(
+        {record->owner, record->chunkIndex, record->row}, id));
+    *existing = std::move(component);
+    return existing;
+  }
+  location at =
+      this->MoveEntity(entity, this->GetArchetypeWith(record->owner, id));
+  return new (this->GetComponentData(at, id)) T(std::move(component));
+}
+
+template <typename T> void EntityWorld::RemoveComponent(Entity entity) {
+  ComponentId id = GetComponentId<T>();
+  const entityRecord *record = this->FindRecord(entity);
+  if (record && (record->owner->mask & (ComponentMask(1) << id)))
+    this->MoveEntity(entity, this->GetArchetypeWithout(record->owner, id));
+}
+
+template <typename T> bool EntityWorld::HasComponent(Entity entity) const {
+  const entityRecord *record = this->FindRecord(entity);
+  return record && (record->owner->mask & GetMask<T>());
+}
+
+template <typename T> T *EntityWorld::GetComponent(Entity entity) {
+  const EntityWorld *world = this;
+  return const_cast<T *>(world->GetComponent<T>(entity));
+}
+
+template <typename T> const T *EntityWorld::GetComponent(Entity entity) const {
+  const entityRecord *record = this->FindRecord(entity);
+  if (!record || !(record->owner->mask & GetMask<T>()))
+    return nullptr;
+  return static_cast<const T *>(this->GetComponentData(
+      {record->owner, record->chunkIndex, record->row}, GetComponentId<T>()));
+}
+
+template <typename... Ts, typename F> void EntityWorld::EachChunk(F &&f) {
+  ComponentMask required = GetMask<Ts...>();
+  for (archetype *candidate : this->ArchetypeList) {
+    archetype &owner = *candidate;
+    if ((owner.mask & required) != required)
+      continue;
+    for (auto &block : owner.chunks)
+      f(block->count, const_cast<const Entity *>(GetEntities(*block)),
+        GetArray<Ts>(owner, *block)...);
+  }
+}
+
+template <typename... Ts, typename F> void EntityWorld::Each(F &&f) {
+  this->EachChunk<Ts...>(
+      [&f](std::size_t count, const Entity *entities, auto *...arrays) {
+        for (std::size_t i = 0; i < count; i++) {
+          if constexpr (std::is_invocable<F &, Entity, Ts &...>::value)
+            f(entities[i], arrays[i]...);
+          else
+            f(arrays[i]...);
+        }
+      });
+}
+
+template <typename... Ts> std::size_t EntityWorld::Count() const {
+  ComponentMask required = GetMask<Ts...>();
+  std::size_t count = 0;
+  for (const archetype *owner : this->ArchetypeList)
+    if ((owner->mask & required) == required)
+      count += owner->entityCount;
+  return count;
+}
+
+#endif
@@ -0,0 +1,56 @@
+#include "SystemScheduler.h"
+#include "JobSystem.h"
+
+#include <algorithm>
+
+void SystemScheduler::AddSystem(const std::string &name, System system,
+                                ComponentMask reads, ComponentMask writes) {
+  std::size_t index = this->Systems.size();
+  this->Systems.push_back({name, std::move(system), reads, writes, false});
+
+  // one stage after the last system it has to wait for
+  std::size_t stage = 0;
+  for (std::size_t earlier = 0; earlier < index; earlier++) {
+    const auto &other = this->Systems[earlier];
+    bool conflict = other.exclusive ||
+                    (writes & (other.reads | other.writes)) ||
+                    (other.writes & reads);
+    if (conflict)
+      stage = std::max(stage, this->StageOf[earlier] + 1);
+  }
+
+  this->StageOf.push_back(stage);
+  if (stage == this->Stages.size())
+    this->Stages.emplace_back();
+  this->Stages[stage].push_back(index);
+}
+
+void SystemScheduler::AddExclusiveSystem(const std::string &name,
+                                         System system) {
+  std::size_t index = this->Systems.size();
+  this->Systems.push_back({name, std::move(system), 0, 0, true});
+
+  this->StageOf.push_back(this->Stages.size());
+  this->Stages.push_back({index});
+}
+
+void SystemScheduler::Run(EntityWorld &world) {
+  JobSystem *jobs = JobSystem::GetInstance();
+  for (const auto &stage : this->Stages) {
+    // one system per job
+    jobs->ParallelFor(stage.size(), 1,
+                      [this, &stage, &world](std::size_t begin, std::size_t) {
+                        this->Systems[stage[begin]].run(world);
+                      });
+  }
+}
+
+void SystemScheduler::PrintStages(std::ostream &stream) const {
+  for (std::size_t stage = 0; stage < this->Stages.size(); stage++) {
+    stream << "Stage " << stage << ':';
+    for (std::size_t index : this->Stages[stage])
+      stream << ' ' << this->Systems[index].name;
+    stream << '\n';
+  }
+  stream.flush();
+}
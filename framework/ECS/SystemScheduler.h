@@ -0,0 +1,73 @@
+#ifndef SYSTEMSCHEDULER_H
+#define SYSTEMSCHEDULER_H
+
+#include "EntityWorld.h"
+
+#include <cstddef>
+#include <functional>
+#include <ostream>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+// Runs the systems of an EntityWorld once per Run(), in parallel where they
+// do not get in each other's way. Each system declares the component types
+// it reads and writes; two systems conflict if one writes a type the other
+// reads or writes. A system starts after every earlier system it conflicts
+// with, so the result is the same as running them one by one in the order
+// they were added. Systems that create or destroy entities, or add and
+// remove components, change the layout for everyone and have to be added
+// as exclusive.
+//
+// The systems of a stage run as jobs on the JobSystem, with the calling
+// thread taking part until the stage is done.
+class SystemScheduler {
+public:
+  using System = std::function<void(EntityWorld &)>;
+
+public:
+  SystemScheduler() = default;
+  SystemScheduler(const SystemScheduler &) = delete;
+  void operator=(const SystemScheduler &) = delete;
+
+  // Access are the component types the system uses, const for those it
+  // only reads, e.g. AddSystem<Velocity, const Position>(...).
+  template <typename... Access>
+  void AddSystem(const std::string &name, System system);
+  void AddSystem(const std::string &name, System system, ComponentMask reads,
+                 ComponentMask writes);
+  // Runs alone, after everything added before it and before everything
+  // added after it.
+  void AddExclusiveSystem(const std::string &name, System system);
+
+  void Run(EntityWorld &world);
+
+  // Which systems run together.
+  void PrintStages(std::ostream &stream) const;
+
+private:
+  struct system {
+    std::string name;
+    System run;
+    ComponentMask reads;
+    ComponentMask writes;
+    bool exclusive;
+  };
+
+private:
+  std::vector<system> Systems;
+  // indices into Systems, stage by stage
+  std::vector<std::vector<std::size_t>> Stages;
+  std::vector<std::size_t> StageOf;
+};
+
+template <typename... Access>
+void SystemScheduler::AddSystem(const std::string &name, System system) {
+  ComponentMask reads = 0, writes = 0;
+  ((void)((std::is_const<Access>::value ? reads : writes) |=
+          EntityWorld::GetMask<Access>()),
+   ...);
+  this->AddSystem(name, std::move(system), reads, writes);
+}
+
+#endif
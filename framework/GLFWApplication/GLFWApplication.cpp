@@ -4,6 +4,7 @@
 
 #include <GLFW/glfw3.h>
 #include <iostream>
+#include <utility>
 
 void error_callback(int error, const char *description) {
   fprintf(stderr, "Error: %s\n", description);
@@ -33,3 +34,12 @@ unsigned GLFWApplication::Init() {
 
   return 0;
 }
+
+void GLFWApplication::AddFrameCallback(std::function<void()> callback) {
+  FrameCallbacks.push_back(std::move(callback));
+}
+
+void GLFWApplication::EndFrame() {
+  for (auto &callback : FrameCallbacks)
+    callback();
+}
@@ -1,7 +1,9 @@
 #ifndef GLFWAPPLICATION_H
 #define GLFWAPPLICATION_H
 
+#include <functional>
 #include <string> //unsure if this is needed...
+#include <vector>
 
 class GLFWwindow;
 class GLFWApplication {
@@ -14,7 +16,14 @@ public:
 
 	virtual unsigned Init(); 
 	virtual unsigned Run() = 0; 
-	
+
+	// Work to do once per frame, run by EndFrame() in the order added.
+	void AddFrameCallback(std::function<void()> callback);
+	// Call once per frame from Run(), after the buffers are swapped.
+	void EndFrame();
+
+private:
+	std::vector<std::function<void()>> FrameCallbacks;
 };
 
 #endif
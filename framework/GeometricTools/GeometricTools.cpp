@@ -1,4 +1,9 @@
 #include "GeometricTools.h"
+#include "ParallelFor.h"
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
 #include <vector>
 
 #include <GLFW/glfw3.h>
@@ -34,46 +39,138 @@ unitShape UnitSquare() {
   return shape;
 }
 
-unitShape UnitGrid(GLuint partitions) {
+namespace {
+
+bool CheckGridSize(unsigned partitions) {
+  if (partitions <= MaxGridPartitions)
+    return true;
+  std::cerr << "Grid of " << partitions << " partitions has more vertices "
+            << "than 32-bit indices can address (at most "
+            << MaxGridPartitions << ")" << std::endl;
+  return false;
+}
 
+} // namespace
+
+unitShape UnitGrid(GLuint partitions) {
   unitShape shape;
-  // ==== making the vectors ====
+  if (!CheckGridSize(partitions))
+    return shape;
+  shape.vertices.resize(GridVertexCount(partitions) * GridVertexStride);
+  shape.indices.resize(GridIndexCount(partitions));
 
-  partitions = static_cast<GLfloat>(partitions);
+  UnitGridInto(partitions, shape.vertices.data(), shape.indices.data(), false,
+               1);
+
+  return shape;
+}
 
-  GLfloat squareSize = 1.f / partitions;
-  for (int i = 0; i <= partitions; i++) {
-    for (int j = 0; j <= partitions; j++) {
-      // position coordinates
-      shape.vertices.push_back(-0.5f + i * squareSize); // x coordinate
-      shape.vertices.push_back(-0.5f + j * squareSize); // y coordinate
-      shape.vertices.push_back(0.f);                    // z coordinate
+std::size_t GridVertexCount(unsigned partitions) {
+  std::size_t side = std::size_t(partitions) + 1;
+  return side * side;
+}
 
-      // texture coordinates
-      shape.vertices.push_back(i * squareSize);
-      shape.vertices.push_back(j * squareSize);
+std::size_t GridIndexCount(unsigned partitions, bool strip) {
+  std::size_t rows = partitions;
+  if (rows == 0)
+    return 0;
+  if (strip)
+    // every row is a strip of 2 * (partitions + 1) indices, with a restart
+    // index between consecutive rows
+    return rows * 2 * (rows + 1) + (rows - 1);
+  return rows * rows * 6;
+}
 
-      shape.vertices.push_back(0.0f);
-      shape.vertices.push_back(0.0f);
-      shape.vertices.push_back(1.0f);
+gridStats UnitGridInto(unsigned partitions, GLfloat *vertices,
+                       GLuint *indices, bool strip, unsigned threads) {
+  auto startTime = std::chrono::steady_clock::now();
+
+  gridStats stats;
+  if (!CheckGridSize(partitions))
+    return stats;
+  stats.vertexCount = GridVertexCount(partitions);
+  stats.indexCount = GridIndexCount(partitions, strip);
+
+  const std::size_t side = std::size_t(partitions) + 1;
+  const GLfloat squareSize =
+      partitions ? 1.f / static_cast<GLfloat>(partitions) : 0.f;
+  const std::size_t stripRowLength = 2 * side + 1;
+
+  // A "row" is one value of i: the vertex column at x = i and, for i below
+  // partitions, the cells between x = i and x = i + 1.
+  auto generateRows = [&](std::size_t rowBegin, std::size_t rowEnd) {
+    // ==== making the vectors ====
+    for (std::size_t i = rowBegin; i < rowEnd; i++) {
+      GLfloat *vertex = vertices + i * side * GridVertexStride;
+      GLfloat u = i * squareSize;
+      for (std::size_t j = 0; j < side; j++) {
+        GLfloat v = j * squareSize;
+        vertex[0] = -0.5f + u; // x coordinate
+        vertex[1] = -0.5f + v; // y coordinate
+        vertex[2] = 0.f;       // z coordinate
+        vertex[3] = u;         // texture coordinates
+        vertex[4] = v;
+        vertex[5] = 0.f; // normal
+        vertex[6] = 0.f;
+        vertex[7] = 1.f;
+        vertex += GridVertexStride;
+      }
     }
-  }
 
-  // ==== making the topology ====
+    // ==== making the topology ====
+    // triangles wind counter-clockwise seen from +z, agreeing with the normal
+    std::size_t lastCellRow = std::min<std::size_t>(rowEnd, partitions);
+    for (std::size_t i = rowBegin; i < lastCellRow; i++) {
+      GLuint rowVertex = static_cast<GLuint>(i * side);
+
+      if (strip) {
+        GLuint *index = indices + i * stripRowLength;
+        for (std::size_t j = 0; j < side; j++) {
+          GLuint currentVertex = rowVertex + static_cast<GLuint>(j);
+          *index++ = currentVertex;
+          *index++ = currentVertex + static_cast<GLuint>(side);
+        }
+        if (i + 1 < partitions)
+          *index = PrimitiveRestartIndex;
+      } else {
+        GLuint *index = indices + i * std::size_t(partitions) * 6;
+        for (std::size_t j = 0; j < partitions; j++) {
+          GLuint currentVertex = rowVertex + static_cast<GLuint>(j);
+          GLuint nextRowVertex = currentVertex + static_cast<GLuint>(side);
+
+          index[0] = currentVertex;
+          index[1] = nextRowVertex;
+          index[2] = nextRowVertex + 1;
+
+          index[3] = currentVertex;
+          index[4] = nextRowVertex + 1;
+          index[5] = currentVertex + 1;
+          index += 6;
+        }
+      }
+    }
+  };
 
-  for (GLuint i = 0; i < partitions; i++) {
-    for (GLuint j = 0; j < partitions; j++) {
-      GLuint currentVertex = i * (partitions + 1) + j;
+  stats.threads = detail::ParallelFor(side, threads, generateRows);
 
-      shape.indices.push_back(currentVertex);
-      shape.indices.push_back(currentVertex + 1);
-      shape.indices.push_back(currentVertex + 1 + (partitions + 1));
+  stats.milliseconds = std::chrono::duration<double, std::milli>(
+                           std::chrono::steady_clock::now() - startTime)
+                           .count();
+  return stats;
+}
 
-      shape.indices.push_back(currentVertex);
-      shape.indices.push_back(currentVertex + (partitions + 1));
-      shape.indices.push_back(currentVertex + 1 + (partitions + 1));
-    }
-  }
+unitShape UnitGridLarge(unsigned partitions, bool strip, unsigned threads,
+                        gridStats *stats) {
+  unitShape shape;
+  if (!CheckGridSize(partitions))
+    return shape;
+  shape.vertices.resize(GridVertexCount(partitions) * GridVertexStride);
+  shape.indices.resize(GridIndexCount(partitions, strip));
+
+  gridStats result = UnitGridInto(partitions, shape.vertices.data(),
+                                  shape.indices.data(), strip, threads);
+  if (stats)
+    *stats = result;
 
   return shape;
 }
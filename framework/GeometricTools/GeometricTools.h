@@ -6,6 +6,7 @@
 #include <glad/glad.h>
 
 #include <array>
+#include <cstddef>
 #include <vector>
 
 namespace GeometricTools {
@@ -13,11 +14,94 @@ struct unitShape {
   std::vector<GLfloat> vertices;
   std::vector<GLuint> indices;
 };
+
+// Timing and size report filled in by the grid generators.
+struct gridStats {
+  std::size_t vertexCount = 0;
+  std::size_t indexCount = 0;
+  unsigned threads = 0;
+  double milliseconds = 0.0;
+};
+
+// Index written between rows of a strip grid. Draw such grids as
+// GL_TRIANGLE_STRIP with RenderCommands::EnablePrimitiveRestart().
+constexpr GLuint PrimitiveRestartIndex = 0xFFFFFFFF;
+
+// Number of floats per grid vertex: position(3), texture(2), normal(3).
+constexpr std::size_t GridVertexStride = 8;
+
+// Largest grid whose vertex indices fit in a GLuint below
+// PrimitiveRestartIndex. The grid generators refuse anything larger.
+constexpr unsigned MaxGridPartitions = 65534;
+
 extern unitShape UnitTriangle();
 extern unitShape UnitSquare();
 extern unitShape UnitGrid(unsigned partitions);
+
+// Sizes of the buffers UnitGridInto() writes, in vertices and indices.
+extern std::size_t GridVertexCount(unsigned partitions);
+extern std::size_t GridIndexCount(unsigned partitions, bool strip = false);
+
+// Writes a grid into caller-provided memory. `vertices` must hold
+// GridVertexCount() * GridVertexStride floats and `indices` must hold
+// GridIndexCount() entries. Rows are split across `threads` threads
+// (0 uses every hardware thread). Grids over MaxGridPartitions are not
+// written, and their stats are all zero.
+extern gridStats UnitGridInto(unsigned partitions, GLfloat *vertices,
+                              GLuint *indices, bool strip = false,
+                              unsigned threads = 0);
+
+// High-resolution variant of UnitGrid() for grids with millions of cells.
+// `stats`, if given, gets the sizes and the generation time.
+extern unitShape UnitGridLarge(unsigned partitions, bool strip = false,
+                               unsigned threads = 0,
+                               gridStats *stats = nullptr);
 extern unitShape UnitCube();
 extern unitShape UnitCubeWNormals();
+
+// ==== Procedural shapes ====
+// All of these fit inside the unit cube centred on the origin, use Z as the
+// up axis, share vertices between neighbouring triangles and use the
+// UnitCubeWNormals() layout: position(3), texture(2), normal(3).
+
+extern unitShape UVSphere(unsigned segments, unsigned rings);
+extern unitShape IcoSphere(unsigned subdivisions);
+extern unitShape Cylinder(unsigned segments, unsigned stacks = 1);
+extern unitShape Cone(unsigned segments);
+// `thickness` is the tube diameter relative to the torus radius, in (0, 1].
+extern unitShape Torus(float thickness, unsigned majorSegments,
+                       unsigned minorSegments);
+// `radius` is the radius of the end caps, at most 0.5.
+extern unitShape Capsule(float radius, unsigned segments, unsigned rings);
+// `radius` is the edge rounding radius, at most 0.5.
+extern unitShape RoundedBox(float radius, unsigned segments);
+
+enum class ShapeType {
+  Grid,
+  CubeWNormals,
+  UVSphere,
+  IcoSphere,
+  Cylinder,
+  Cone,
+  Torus,
+  Capsule,
+  RoundedBox
+};
+
+// Describes one procedural shape by its generator and the generator's
+// arguments, in declaration order (integer arguments are stored as floats).
+// Used as the key of the GeometryCache.
+struct shapeDescriptor {
+  ShapeType type;
+  std::array<float, 3> params = {0.f, 0.f, 0.f};
+
+  bool operator==(const shapeDescriptor &other) const {
+    return type == other.type && params == other.params;
+  }
+};
+
+// Calls the generator described by `descriptor`.
+extern unitShape GenerateShape(const shapeDescriptor &descriptor);
 } // namespace GeometricTools
 
 #endif
@@ -0,0 +1,197 @@
+#include "MeshAttributes.h"
+#include "ParallelFor.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include <glm/glm.hpp>
+
+namespace GeometricTools {
+
+namespace {
+
+// Triangle corners of every vertex, in corner order, stored as one flat
+// array with per-vertex offsets. Walking a vertex's corners in this fixed
+// order is what makes the accumulated sums independent of the threading.
+struct cornerAdjacency {
+  std::vector<std::size_t> offsets;
+  std::vector<std::size_t> corners;
+};
+
+cornerAdjacency BuildAdjacency(const std::vector<GLuint> &indices,
+                               std::size_t vertexCount) {
+  cornerAdjacency adjacency;
+  adjacency.offsets.assign(vertexCount + 1, 0);
+  for (GLuint index : indices)
+    adjacency.offsets[index + 1]++;
+  for (std::size_t v = 0; v < vertexCount; v++)
+    adjacency.offsets[v + 1] += adjacency.offsets[v];
+
+  adjacency.corners.resize(indices.size());
+  std::vector<std::size_t> cursor(adjacency.offsets.begin(),
+                                  adjacency.offsets.end() - 1);
+  for (std::size_t corner = 0; corner < indices.size(); corner++)
+    adjacency.corners[cursor[indices[corner]]++] = corner;
+  return adjacency;
+}
+
+glm::vec3 ReadVec3(const std::vector<GLfloat> &vertices, std::size_t vertex,
+                   std::size_t stride, std::size_t offset) {
+  const GLfloat *data = vertices.data() + vertex * stride + offset;
+  return glm::vec3(data[0], data[1], data[2]);
+}
+
+glm::vec2 ReadVec2(const std::vector<GLfloat> &vertices, std::size_t vertex,
+                   std::size_t stride, std::size_t offset) {
+  const GLfloat *data = vertices.data() + vertex * stride + offset;
+  return glm::vec2(data[0], data[1]);
+}
+
+float CornerAngle(const glm::vec3 &toNext, const glm::vec3 &toPrevious) {
+  float lengths = glm::length(toNext) * glm::length(toPrevious);
+  if (lengths <= 0.f)
+    return 0.f;
+  return std::acos(
+      std::clamp(glm::dot(toNext, toPrevious) / lengths, -1.f, 1.f));
+}
+
+// Removes the component of `v` along the unit vector `n` and normalizes.
+glm::vec3 Orthogonalize(const glm::vec3 &v, const glm::vec3 &n) {
+  glm::vec3 projected = v - n * glm::dot(n, v);
+  float length = glm::length(projected);
+  return length > 0.f ? projected / length : glm::vec3(0.f);
+}
+
+} // namespace
+
+void GenerateNormals(unitShape &shape, NormalWeighting weighting,
+                     unsigned threads, const vertexFormat &format) {
+  const auto &indices = shape.indices;
+  const std::size_t vertexCount = shape.vertices.size() / format.stride;
+  const std::size_t triangleCount = indices.size() / 3;
+
+  // ==== weighted face normal of every corner, in parallel by triangle ====
+  std::vector<glm::vec3> cornerNormals(triangleCount * 3);
+  detail::ParallelFor(
+      triangleCount, threads, [&](std::size_t begin, std::size_t end) {
+        for (std::size_t t = begin; t < end; t++) {
+          glm::vec3 p[3];
+          for (int k = 0; k < 3; k++)
+            p[k] = ReadVec3(shape.vertices, indices[3 * t + k], format.stride,
+                            format.position);
+
+          // the cross product's length is twice the triangle's area
+          glm::vec3 faceNormal = glm::cross(p[1] - p[0], p[2] - p[0]);
+          float doubleArea = glm::length(faceNormal);
+          if (doubleArea > 0.f && weighting == NormalWeighting::Angle)
+            faceNormal /= doubleArea;
+
+          for (int k = 0; k < 3; k++) {
+            float weight = 1.f;
+            if (weighting != NormalWeighting::Area)
+              weight = CornerAngle(p[(k + 1) % 3] - p[k], p[(k + 2) % 3] - p[k]);
+            cornerNormals[3 * t + k] = faceNormal * weight;
+          }
+        }
+      });
+
+  // ==== summed per vertex, in parallel by vertex ====
+  cornerAdjacency adjacency = BuildAdjacency(indices, vertexCount);
+  detail::ParallelFor(
+      vertexCount, threads, [&](std::size_t begin, std::size_t end) {
+        for (std::size_t v = begin; v < end; v++) {
+          glm::vec3 sum(0.f);
+          for (std::size_t c = adjacency.offsets[v];
+               c < adjacency.offsets[v + 1]; c++)
+            sum += cornerNormals[adjacency.corners[c]];
+
+          float length = glm::length(sum);
+          glm::vec3 normal = length > 0.f ? sum / length : glm::vec3(0.f);
+
+          GLfloat *out =
+              shape.vertices.data() + v * format.stride + format.normal;
+          out[0] = normal.x;
+          out[1] = normal.y;
+          out[2] = normal.z;
+        }
+      });
+}
+
+std::vector<GLfloat> GenerateTangents(const unitShape &shape, unsigned threads,
+                                      const vertexFormat &format) {
+  const auto &indices = shape.indices;
+  const std::size_t vertexCount = shape.vertices.size() / format.stride;
+  const std::size_t triangleCount = indices.size() / 3;
+
+  // ==== angle weighted tangent and bitangent of every corner ====
+  std::vector<glm::vec3> cornerTangents(triangleCount * 3);
+  std::vector<glm::vec3> cornerBitangents(triangleCount * 3);
+  detail::ParallelFor(
+      triangleCount, threads, [&](std::size_t begin, std::size_t end) {
+        for (std::size_t t = begin; t < end; t++) {
+          glm::vec3 p[3];
+          glm::vec2 uv[3];
+          for (int k = 0; k < 3; k++) {
+            GLuint vertex = indices[3 * t + k];
+            p[k] = ReadVec3(shape.vertices, vertex, format.stride,
+                            format.position);
+            uv[k] = ReadVec2(shape.vertices, vertex, format.stride,
+                             format.tcoords);
+          }
+
+          glm::vec3 edge1 = p[1] - p[0], edge2 = p[2] - p[0];
+          glm::vec2 duv1 = uv[1] - uv[0], duv2 = uv[2] - uv[0];
+          float determinant = duv1.x * duv2.y - duv2.x * duv1.y;
+
+          glm::vec3 faceTangent(0.f), faceBitangent(0.f);
+          // triangles without a usable UV mapping contribute nothing
+          if (std::abs(determinant) > 1e-12f) {
+            faceTangent = (edge1 * duv2.y - edge2 * duv1.y) / determinant;
+            faceBitangent = (edge2 * duv1.x - edge1 * duv2.x) / determinant;
+          }
+
+          for (int k = 0; k < 3; k++) {
+            glm::vec3 normal = ReadVec3(shape.vertices, indices[3 * t + k],
+                                        format.stride, format.normal);
+            float angle =
+                CornerAngle(p[(k + 1) % 3] - p[k], p[(k + 2) % 3] - p[k]);
+            cornerTangents[3 * t + k] = Orthogonalize(faceTangent, normal) *
+                                        angle;
+            cornerBitangents[3 * t + k] =
+                Orthogonalize(faceBitangent, normal) * angle;
+          }
+        }
+      });
+
+  // ==== summed per vertex ====
+  std::vector<GLfloat> tangents(vertexCount * 4);
+  cornerAdjacency adjacency = BuildAdjacency(indices, vertexCount);
+  detail::ParallelFor(
+      vertexCount, threads, [&](std::size_t begin, std::size_t end) {
+        for (std::size_t v = begin; v < end; v++) {
+          glm::vec3 tangentSum(0.f), bitangentSum(0.f);
+          for (std::size_t c = adjacency.offsets[v];
+               c < adjacency.offsets[v + 1]; c++) {
+            tangentSum += cornerTangents[adjacency.corners[c]];
+            bitangentSum += cornerBitangents[adjacency.corners[c]];
+          }
+
+          glm::vec3 normal =
+              ReadVec3(shape.vertices, v, format.stride, format.normal);
+          glm::vec3 tangent = Orthogonalize(tangentSum, normal);
+          float handedness =
+              glm::dot(glm::cross(normal, tangent), bitangentSum) < 0.f ? -1.f
+                                                                        : 1.f;
+
+          GLfloat *out = tangents.data() + v * 4;
+          out[0] = tangent.x;
+          out[1] = tangent.y;
+          out[2] = tangent.z;
+          out[3] = handedness;
+        }
+      });
+
+  return tangents;
+}
+
+} // namespace GeometricTools
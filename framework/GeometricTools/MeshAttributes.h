@@ -0,0 +1,47 @@
+#ifndef GEOMETRICTOOLS_MESHATTRIBUTES_H
+#define GEOMETRICTOOLS_MESHATTRIBUTES_H
+
+#include "GeometricTools.h"
+
+#include <cstddef>
+#include <vector>
+
+namespace GeometricTools {
+
+// Offsets, in floats, of the attributes inside one interleaved vertex.
+// The defaults match the UnitCubeWNormals() layout.
+struct vertexFormat {
+  std::size_t stride = GridVertexStride;
+  std::size_t position = 0;
+  std::size_t tcoords = 3;
+  std::size_t normal = 5;
+};
+
+enum class NormalWeighting {
+  Area,     // larger triangles pull harder
+  Angle,    // each triangle counts by its angle at the vertex
+  AreaAngle // both
+};
+
+// Recomputes smooth vertex normals of an indexed triangle mesh in place.
+// Normals are only shared through shared vertices, so duplicated vertices
+// (hard edges, UV seams) keep separate normals. Triangles are split across
+// `threads` threads (0 uses every hardware thread); the result does not
+// depend on the thread count.
+extern void GenerateNormals(unitShape &shape,
+                            NormalWeighting weighting = NormalWeighting::Angle,
+                            unsigned threads = 0,
+                            const vertexFormat &format = vertexFormat());
+
+// Per-vertex tangents following the MikkTSpace conventions: angle weighted,
+// orthogonal to the vertex normal, pointing along increasing u, with the
+// bitangent sign in w (bitangent = w * cross(normal, tangent)). Returns four
+// floats per vertex. Vertices are not split, so shared vertices whose
+// triangles disagree on handedness get the majority sign.
+extern std::vector<GLfloat>
+GenerateTangents(const unitShape &shape, unsigned threads = 0,
+                 const vertexFormat &format = vertexFormat());
+
+} // namespace GeometricTools
+
+#endif
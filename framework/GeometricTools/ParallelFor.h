@@ -0,0 +1,43 @@
+#ifndef GEOMETRICTOOLS_PARALLELFOR_H
+#define GEOMETRICTOOLS_PARALLELFOR_H
+
+#include "JobSystem.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <thread>
+
+namespace GeometricTools {
+namespace detail {
+
+// Resolves a requested thread count, where 0 means "use every hardware
+// thread", and clamps it so that no thread is left without work.
+inline unsigned ResolveThreadCount(unsigned threads, std::size_t count) {
+  if (threads == 0)
+    threads = std::max(1u, std::thread::hardware_concurrency());
+  if (count < threads)
+    threads = static_cast<unsigned>(std::max<std::size_t>(count, 1));
+  return threads;
+}
+
+// Splits [0, count) into contiguous ranges, one per thread, and calls
+// task(begin, end) for each of them as a job on the JobSystem. The calling
+// thread takes the first range and runs jobs until all are done, so this
+// may be called from a job too. Returns the number of ranges.
+template <typename Task>
+unsigned ParallelFor(std::size_t count, unsigned threads, Task &&task) {
+  threads = ResolveThreadCount(threads, count);
+  if (threads <= 1) {
+    task(std::size_t(0), count);
+    return 1;
+  }
+
+  std::size_t grain = (count + threads - 1) / threads;
+  JobSystem::GetInstance()->ParallelFor(count, grain, task);
+  return static_cast<unsigned>((count + grain - 1) / grain);
+}
+
+} // namespace detail
+} // namespace GeometricTools
+
+#endif
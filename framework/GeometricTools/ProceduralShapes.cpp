@@ -0,0 +1,340 @@
+#include "GeometricTools.h"
+
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <utility>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/constants.hpp>
+
+namespace GeometricTools {
+
+namespace {
+
+void AddVertex(unitShape &shape, const glm::vec3 &position,
+               const glm::vec2 &tcoords, const glm::vec3 &normal) {
+  shape.vertices.insert(shape.vertices.end(),
+                        {position.x, position.y, position.z, tcoords.x,
+                         tcoords.y, normal.x, normal.y, normal.z});
+}
+
+GLuint VertexCount(const unitShape &shape) {
+  return static_cast<GLuint>(shape.vertices.size() / GridVertexStride);
+}
+
+// Connects a block of (rows + 1) x (columns + 1) vertices, stored row by row
+// from `first`, into two triangles per cell. Rows must advance along the
+// surface's "up" direction and columns counter-clockwise around it, so
+// triangles face outwards.
+void AddGridIndices(unitShape &shape, GLuint first, unsigned rows,
+                    unsigned columns) {
+  GLuint rowLength = columns + 1;
+  for (GLuint row = 0; row < rows; row++) {
+    for (GLuint column = 0; column < columns; column++) {
+      GLuint a = first + row * rowLength + column;
+      GLuint b = a + rowLength;
+
+      shape.indices.insert(shape.indices.end(),
+                           {a, a + 1, b + 1, a, b + 1, b});
+    }
+  }
+}
+
+// Adds a flat disc of radius 0.5 at height z, facing +z or -z.
+void AddCap(unitShape &shape, unsigned segments, float z, bool facingUp) {
+  glm::vec3 normal(0.f, 0.f, facingUp ? 1.f : -1.f);
+  GLuint center = VertexCount(shape);
+  AddVertex(shape, {0.f, 0.f, z}, {0.5f, 0.5f}, normal);
+
+  for (unsigned k = 0; k <= segments; k++) {
+    float angle = glm::two_pi<float>() * k / segments;
+    glm::vec2 direction(std::cos(angle), std::sin(angle));
+    AddVertex(shape, {0.5f * direction, z}, 0.5f + 0.5f * direction, normal);
+  }
+
+  for (GLuint k = 0; k < segments; k++) {
+    GLuint current = center + 1 + k;
+    if (facingUp)
+      shape.indices.insert(shape.indices.end(), {center, current, current + 1});
+    else
+      shape.indices.insert(shape.indices.end(), {center, current + 1, current});
+  }
+}
+
+// Shared by UVSphere() and Capsule(): latitude rings around two centres on
+// the z axis, the lower hemisphere around -halfLength and the upper one
+// around +halfLength.
+unitShape SphericalShape(float radius, float halfLength, unsigned segments,
+                         unsigned rings) {
+  // (latitude, centre z) of every vertex row, bottom to top; a sphere shares
+  // its equator row between the hemispheres
+  std::vector<std::pair<float, float>> rows;
+  for (unsigned ring = 0; ring <= rings; ring++)
+    rows.emplace_back(glm::half_pi<float>() * ring / rings -
+                          glm::half_pi<float>(),
+                      -halfLength);
+  for (unsigned ring = halfLength > 0.f ? 0 : 1; ring <= rings; ring++)
+    rows.emplace_back(glm::half_pi<float>() * ring / rings, halfLength);
+
+  unitShape shape;
+  shape.vertices.reserve(rows.size() * (segments + 1) * GridVertexStride);
+  shape.indices.reserve((rows.size() - 1) * segments * 6);
+
+  for (const auto &[latitude, centerZ] : rows) {
+    for (unsigned k = 0; k <= segments; k++) {
+      float angle = glm::two_pi<float>() * k / segments;
+      glm::vec3 normal(std::cos(latitude) * std::cos(angle),
+                       std::cos(latitude) * std::sin(angle),
+                       std::sin(latitude));
+      glm::vec3 position = radius * normal + glm::vec3(0.f, 0.f, centerZ);
+      AddVertex(shape, position,
+                {static_cast<float>(k) / segments, position.z + 0.5f}, normal);
+    }
+  }
+
+  // like AddGridIndices(), minus the zero-area triangles at the poles
+  GLuint rowLength = segments + 1;
+  GLuint lastRow = static_cast<GLuint>(rows.size()) - 2;
+  for (GLuint row = 0; row <= lastRow; row++) {
+    for (GLuint column = 0; column < segments; column++) {
+      GLuint a = row * rowLength + column;
+      GLuint b = a + rowLength;
+
+      if (row != 0)
+        shape.indices.insert(shape.indices.end(), {a, a + 1, b + 1});
+      if (row != lastRow)
+        shape.indices.insert(shape.indices.end(), {a, b + 1, b});
+    }
+  }
+  return shape;
+}
+
+} // namespace
+
+unitShape UVSphere(unsigned segments, unsigned rings) {
+  segments = std::max(segments, 3u);
+  // each hemisphere gets half of the rings
+  return SphericalShape(0.5f, 0.f, segments, std::max(rings / 2, 1u));
+}
+
+unitShape IcoSphere(unsigned subdivisions) {
+  const float t = (1.f + std::sqrt(5.f)) / 2.f;
+  std::vector<glm::vec3> points = {
+      {-1, t, 0}, {1, t, 0}, {-1, -t, 0}, {1, -t, 0},
+      {0, -1, t}, {0, 1, t}, {0, -1, -t}, {0, 1, -t},
+      {t, 0, -1}, {t, 0, 1}, {-t, 0, -1}, {-t, 0, 1},
+  };
+  for (auto &point : points)
+    point = glm::normalize(point);
+
+  std::vector<GLuint> faces = {
+      0, 11, 5, 0, 5,  1,  0,  1, 7, 0, 7,  10, 0, 10, 11,
+      1, 5,  9, 5, 11, 4,  11, 10, 2, 10, 7, 6,  7, 1,  8,
+      3, 9,  4, 3, 4,  2,  3,  2, 6, 3, 6,  8,  3, 8,  9,
+      4, 9,  5, 2, 4,  11, 6,  2, 10, 8, 6, 7,  9, 8,  1,
+  };
+
+  for (unsigned level = 0; level < subdivisions; level++) {
+    // midpoints are shared between the two triangles of an edge
+    std::map<std::pair<GLuint, GLuint>, GLuint> midpoints;
+    auto midpoint = [&](GLuint a, GLuint b) {
+      auto key = std::minmax(a, b);
+      auto found = midpoints.find(key);
+      if (found != midpoints.end())
+        return found->second;
+      GLuint index = static_cast<GLuint>(points.size());
+      points.push_back(glm::normalize(points[a] + points[b]));
+      midpoints.emplace(key, index);
+      return index;
+    };
+
+    std::vector<GLuint> subdivided;
+    subdivided.reserve(faces.size() * 4);
+    for (std::size_t f = 0; f < faces.size(); f += 3) {
+      GLuint a = faces[f], b = faces[f + 1], c = faces[f + 2];
+      GLuint ab = midpoint(a, b), bc = midpoint(b, c), ca = midpoint(c, a);
+      subdivided.insert(subdivided.end(),
+                        {a, ab, ca, b, bc, ab, c, ca, bc, ab, bc, ca});
+    }
+    faces = std::move(subdivided);
+  }
+
+  unitShape shape;
+  shape.vertices.reserve(points.size() * GridVertexStride);
+  for (const auto &normal : points) {
+    // spherical mapping; the seam at u = 0 is not split
+    glm::vec2 tcoords(std::atan2(normal.y, normal.x) / glm::two_pi<float>() +
+                          0.5f,
+                      std::asin(normal.z) / glm::pi<float>() + 0.5f);
+    AddVertex(shape, 0.5f * normal, tcoords, normal);
+  }
+  shape.indices = std::move(faces);
+  return shape;
+}
+
+unitShape Cylinder(unsigned segments, unsigned stacks) {
+  segments = std::max(segments, 3u);
+  stacks = std::max(stacks, 1u);
+
+  unitShape shape;
+  shape.vertices.reserve(((stacks + 1) * (segments + 1) + 2 * (segments + 2)) *
+                         GridVertexStride);
+
+  for (unsigned stack = 0; stack <= stacks; stack++) {
+    float v = static_cast<float>(stack) / stacks;
+    for (unsigned k = 0; k <= segments; k++) {
+      float angle = glm::two_pi<float>() * k / segments;
+      glm::vec3 normal(std::cos(angle), std::sin(angle), 0.f);
+      AddVertex(shape, {0.5f * normal.x, 0.5f * normal.y, v - 0.5f},
+                {static_cast<float>(k) / segments, v}, normal);
+    }
+  }
+  AddGridIndices(shape, 0, stacks, segments);
+
+  AddCap(shape, segments, -0.5f, false);
+  AddCap(shape, segments, 0.5f, true);
+  return shape;
+}
+
+unitShape Cone(unsigned segments) {
+  segments = std::max(segments, 3u);
+
+  unitShape shape;
+  // the side normal leans up by radius / height = 0.5
+  auto sideNormal = [](float angle) {
+    return glm::normalize(glm::vec3(std::cos(angle), std::sin(angle), 0.5f));
+  };
+
+  for (unsigned k = 0; k <= segments; k++) {
+    float angle = glm::two_pi<float>() * k / segments;
+    AddVertex(shape, {0.5f * std::cos(angle), 0.5f * std::sin(angle), -0.5f},
+              {static_cast<float>(k) / segments, 0.f}, sideNormal(angle));
+  }
+  // one apex per segment so each side face gets its own normal
+  GLuint apex = VertexCount(shape);
+  for (unsigned k = 0; k < segments; k++) {
+    float angle = glm::two_pi<float>() * (k + 0.5f) / segments;
+    AddVertex(shape, {0.f, 0.f, 0.5f}, {(k + 0.5f) / segments, 1.f},
+              sideNormal(angle));
+  }
+  for (GLuint k = 0; k < segments; k++)
+    shape.indices.insert(shape.indices.end(), {k, k + 1, apex + k});
+
+  AddCap(shape, segments, -0.5f, false);
+  return shape;
+}
+
+unitShape Torus(float thickness, unsigned majorSegments,
+                unsigned minorSegments) {
+  majorSegments = std::max(majorSegments, 3u);
+  minorSegments = std::max(minorSegments, 3u);
+  thickness = std::clamp(thickness, 0.01f, 1.f);
+
+  // the outer edge of the tube touches the unit cube
+  float minorRadius = 0.25f * thickness;
+  float majorRadius = 0.5f - minorRadius;
+
+  unitShape shape;
+  shape.vertices.reserve((majorSegments + 1) * (minorSegments + 1) *
+                         GridVertexStride);
+
+  for (unsigned ring = 0; ring <= minorSegments; ring++) {
+    float tubeAngle = glm::two_pi<float>() * ring / minorSegments;
+    for (unsigned k = 0; k <= majorSegments; k++) {
+      float angle = glm::two_pi<float>() * k / majorSegments;
+      glm::vec3 radial(std::cos(angle), std::sin(angle), 0.f);
+      glm::vec3 normal = std::cos(tubeAngle) * radial +
+                         glm::vec3(0.f, 0.f, std::sin(tubeAngle));
+      AddVertex(shape, majorRadius * radial + minorRadius * normal,
+                {static_cast<float>(k) / majorSegments,
+                 static_cast<float>(ring) / minorSegments},
+                normal);
+    }
+  }
+  AddGridIndices(shape, 0, minorSegments, majorSegments);
+  return shape;
+}
+
+unitShape Capsule(float radius, unsigned segments, unsigned rings) {
+  segments = std::max(segments, 3u);
+  radius = std::clamp(radius, 0.01f, 0.5f);
+  return SphericalShape(radius, 0.5f - radius, segments, std::max(rings, 1u));
+}
+
+unitShape RoundedBox(float radius, unsigned segments) {
+  segments = std::max(segments, 1u);
+  radius = std::clamp(radius, 0.f, 0.5f);
+  float inner = 0.5f - radius;
+
+  // Coordinates along a face edge: `segments` steps across each rounded
+  // border and one step across the flat middle.
+  std::vector<float> steps = {-0.5f, 0.5f};
+  if (radius > 0.f) {
+    steps.clear();
+    for (unsigned k = 0; k <= segments; k++)
+      steps.push_back(-0.5f + radius * k / segments);
+    // a sphere (inner == 0) has no flat middle to step across
+    for (unsigned k = inner > 0.f ? 0 : 1; k <= segments; k++)
+      steps.push_back(inner + radius * k / segments);
+  }
+  unsigned cells = static_cast<unsigned>(steps.size()) - 1;
+
+  // normal, u and v axes of every face, with u x v = normal
+  const glm::vec3 faces[6][3] = {
+      {{1, 0, 0}, {0, 1, 0}, {0, 0, 1}},   {{-1, 0, 0}, {0, -1, 0}, {0, 0, 1}},
+      {{0, 1, 0}, {-1, 0, 0}, {0, 0, 1}},  {{0, -1, 0}, {1, 0, 0}, {0, 0, 1}},
+      {{0, 0, 1}, {1, 0, 0}, {0, 1, 0}},   {{0, 0, -1}, {1, 0, 0}, {0, -1, 0}},
+  };
+
+  unitShape shape;
+  shape.vertices.reserve(6 * steps.size() * steps.size() * GridVertexStride);
+  shape.indices.reserve(6 * cells * cells * 6);
+
+  for (const auto &face : faces) {
+    GLuint first = VertexCount(shape);
+    for (float v : steps) {
+      for (float u : steps) {
+        glm::vec3 onCube = 0.5f * face[0] + u * face[1] + v * face[2];
+        glm::vec3 core = glm::clamp(onCube, -inner, inner);
+        glm::vec3 normal = face[0];
+        if (radius > 0.f)
+          normal = glm::normalize(onCube - core);
+        AddVertex(shape, core + radius * normal, {u + 0.5f, v + 0.5f},
+                  normal);
+      }
+    }
+    AddGridIndices(shape, first, cells, cells);
+  }
+  return shape;
+}
+
+unitShape GenerateShape(const shapeDescriptor &descriptor) {
+  const auto &p = descriptor.params;
+  auto count = [](float value) { return static_cast<unsigned>(value); };
+
+  switch (descriptor.type) {
+  case ShapeType::Grid:
+    return UnitGrid(count(p[0]));
+  case ShapeType::CubeWNormals:
+    return UnitCubeWNormals();
+  case ShapeType::UVSphere:
+    return UVSphere(count(p[0]), count(p[1]));
+  case ShapeType::IcoSphere:
+    return IcoSphere(count(p[0]));
+  case ShapeType::Cylinder:
+    return Cylinder(count(p[0]), count(p[1]));
+  case ShapeType::Cone:
+    return Cone(count(p[0]));
+  case ShapeType::Torus:
+    return Torus(p[0], count(p[1]), count(p[2]));
+  case ShapeType::Capsule:
+    return Capsule(p[0], count(p[1]), count(p[2]));
+  case ShapeType::RoundedBox:
+    return RoundedBox(p[0], count(p[1]));
+  }
+
+  return unitShape();
+}
+
+} // namespace GeometricTools
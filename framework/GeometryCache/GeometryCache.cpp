@@ -0,0 +1,62 @@
+#include "GeometryCache.h"
+#include "IndexBuffer.h"
+#include "VertexBuffer.h"
+#include "VertexBufferLayout.h"
+
+std::shared_ptr<VertexArray>
+GeometryCache::GetMesh(const GeometricTools::shapeDescriptor &descriptor) {
+  auto found = this->Meshes.find(descriptor);
+  if (found != this->Meshes.end())
+    return found->second;
+
+  // reuse the CPU-side shape if someone asked for it already
+  GeometricTools::unitShape generated;
+  const GeometricTools::unitShape *shape = &generated;
+  {
+    std::lock_guard<std::mutex> lock(this->ShapeMutex);
+    auto cachedShape = this->Shapes.find(descriptor);
+    if (cachedShape != this->Shapes.end())
+      shape = &cachedShape->second;
+  }
+  if (shape == &generated)
+    generated = GeometricTools::GenerateShape(descriptor);
+
+  auto vertexBuffer = std::make_shared<VertexBuffer>(
+      shape->vertices.data(), shape->vertices.size() * sizeof(GLfloat));
+  vertexBuffer->SetLayout(BufferLayout({{ShaderDataType::Float3, "position"},
+                                        {ShaderDataType::Float2, "tcoords"},
+                                        {ShaderDataType::Float3, "normal"}}));
+
+  auto vertexArray = std::make_shared<VertexArray>();
+  vertexArray->AddVertexBuffer(vertexBuffer);
+
+  auto indexBuffer = std::make_shared<IndexBuffer>(
+      shape->indices.data(), shape->indices.size());
+  vertexArray->SetIndexBuffer(indexBuffer);
+  vertexArray->Unbind();
+
+  this->Meshes.emplace(descriptor, vertexArray);
+  return vertexArray;
+}
+
+const GeometricTools::unitShape &
+GeometryCache::GetShape(const GeometricTools::shapeDescriptor &descriptor) {
+  {
+    std::lock_guard<std::mutex> lock(this->ShapeMutex);
+    auto found = this->Shapes.find(descriptor);
+    if (found != this->Shapes.end())
+      return found->second;
+  }
+
+  // generated unlocked, so different shapes are built in parallel; if two
+  // threads race for the same one, the first to finish wins
+  GeometricTools::unitShape shape = GeometricTools::GenerateShape(descriptor);
+  std::lock_guard<std::mutex> lock(this->ShapeMutex);
+  return this->Shapes.emplace(descriptor, std::move(shape)).first->second;
+}
+
+void GeometryCache::Clear() {
+  std::lock_guard<std::mutex> lock(this->ShapeMutex);
+  this->Meshes.clear();
+  this->Shapes.clear();
+}
@@ -0,0 +1,79 @@
+#ifndef GEOMETRYCACHE_H
+#define GEOMETRYCACHE_H
+
+#include "GeometricTools.h"
+#include "VertexArray.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+// Memoizes procedural shapes so that every unique GeometricTools shape is
+// generated and uploaded to the GPU once. Identical requests share the same
+// vertex array.
+class GeometryCache {
+public:
+  struct DescriptorHash {
+    std::size_t operator()(const GeometricTools::shapeDescriptor &key) const {
+      std::size_t hash = std::hash<int>()(static_cast<int>(key.type));
+      for (float param : key.params) {
+        // -0 and 0 compare equal, so they have to hash the same; adding 0
+        // turns -0 into 0
+        float value = param + 0.0f;
+        std::uint32_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        hash ^= std::hash<std::uint32_t>()(bits) + 0x9e3779b9 + (hash << 6) +
+                (hash >> 2);
+      }
+      return hash;
+    }
+  };
+
+public:
+  static GeometryCache *GetInstance() {
+    return GeometryCache::Instance != nullptr
+               ? GeometryCache::Instance
+               : GeometryCache::Instance = new GeometryCache();
+  }
+
+public:
+  // Vertex array (position, tcoords, normal) of the described shape.
+  // Generated and uploaded on the first request only.
+  std::shared_ptr<VertexArray>
+  GetMesh(const GeometricTools::shapeDescriptor &descriptor);
+
+  // CPU-side vertices and indices of the described shape. Thread safe, so
+  // shapes can be generated on worker threads ahead of GetMesh(), which
+  // then only uploads them.
+  const GeometricTools::unitShape &
+  GetShape(const GeometricTools::shapeDescriptor &descriptor);
+
+  // Drops the cache's references. Meshes still held elsewhere stay alive.
+  void Clear();
+
+  std::size_t GetMeshCount() const { return this->Meshes.size(); }
+
+private:
+  GeometryCache(){};
+  ~GeometryCache() = default;
+  GeometryCache(const GeometryCache &) = delete;
+  void operator=(const GeometryCache &) = delete;
+
+private:
+  inline static GeometryCache *Instance = nullptr;
+
+private:
+  std::unordered_map<GeometricTools::shapeDescriptor,
+                     std::shared_ptr<VertexArray>, DescriptorHash>
+      Meshes;
+  std::unordered_map<GeometricTools::shapeDescriptor, GeometricTools::unitShape,
+                     DescriptorHash>
+      Shapes;
+  std::mutex ShapeMutex;
+};
+
+#endif
@@ -0,0 +1,250 @@
+#include "JobSystem.h"
+
+namespace {
+
+constexpr unsigned NoWorker = ~0u;
+// jobs move between a thread's cache and the shared one this many at a time
+constexpr std::size_t JobBatch = 128;
+
+// the deque of the calling thread, if it has one
+thread_local unsigned WorkerIndex = NoWorker;
+thread_local unsigned NextVictim = 0;
+
+struct jobList {
+  std::vector<job *> jobs;
+  ~jobList() {
+    for (job *cached : jobs)
+      delete cached;
+  }
+};
+
+// Finished jobs are kept for reuse instead of going back to the heap: each
+// thread has a few at hand, and the rest are shared, since jobs submitted
+// on one thread mostly finish on another.
+std::mutex SharedJobsMutex;
+jobList SharedJobs;
+
+struct jobCache : jobList {
+  jobCache() { jobs.reserve(2 * JobBatch + 1); }
+  ~jobCache() {
+    std::lock_guard<std::mutex> lock(SharedJobsMutex);
+    SharedJobs.jobs.insert(SharedJobs.jobs.end(), jobs.begin(), jobs.end());
+    jobs.clear();
+  }
+};
+thread_local jobCache LocalJobs;
+
+} // namespace
+
+JobSystem *JobSystem::GetInstance() {
+  static JobSystem system(std::max(2u, std::thread::hardware_concurrency()) -
+                          1);
+  return &system;
+}
+
+JobSystem::JobSystem(unsigned workers)
+    : MainThread(std::this_thread::get_id()) {
+  // one deque per worker, and the last for the main thread
+  for (unsigned i = 0; i <= workers; i++)
+    this->Deques.push_back(std::make_unique<WorkStealingDeque<job>>());
+  WorkerIndex = workers;
+
+  for (unsigned i = 0; i < workers; i++)
+    this->Workers.emplace_back(&JobSystem::WorkerLoop, this, i);
+}
+
+JobSystem::~JobSystem() {
+  this->Stop = true;
+  {
+    std::lock_guard<std::mutex> lock(this->SleepMutex);
+    this->Wake.notify_all();
+  }
+  for (auto &worker : this->Workers)
+    worker.join();
+
+  // jobs nobody ran any more
+  auto discard = [](job *left) {
+    left->destroy(*left);
+    delete left;
+  };
+  for (auto &deque : this->Deques)
+    while (job *left = deque->Steal())
+      discard(left);
+  for (job *left : this->Shared)
+    discard(left);
+  for (job *left : this->MainQueue)
+    discard(left);
+}
+
+job *JobSystem::AllocateJob() {
+  std::vector<job *> &cache = LocalJobs.jobs;
+  if (cache.empty()) {
+    std::lock_guard<std::mutex> lock(SharedJobsMutex);
+    std::vector<job *> &shared = SharedJobs.jobs;
+    std::size_t taken = std::min(JobBatch, shared.size());
+    cache.insert(cache.end(), shared.end() - taken, shared.end());
+    shared.resize(shared.size() - taken);
+  }
+  if (cache.empty())
+    return new job;
+
+  job *reused = cache.back();
+  cache.pop_back();
+  return reused;
+}
+
+void JobSystem::FreeJob(job *finished) {
+  std::vector<job *> &cache = LocalJobs.jobs;
+  cache.push_back(finished);
+  if (cache.size() > 2 * JobBatch) {
+    std::lock_guard<std::mutex> lock(SharedJobsMutex);
+    SharedJobs.jobs.insert(SharedJobs.jobs.end(), cache.end() - JobBatch,
+                           cache.end());
+    cache.resize(cache.size() - JobBatch);
+  }
+}
+
+void JobSystem::Enqueue(job *ready, JobCounter *counter,
+                        JobCounter *dependency) {
+  ready->counter = counter;
+  if (counter)
+    counter->Value.fetch_add(1, std::memory_order_relaxed);
+
+  if (dependency) {
+    std::lock_guard<std::mutex> lock(dependency->Mutex);
+    if (dependency->Value.load(std::memory_order_relaxed) != 0) {
+      dependency->Waiting.push_back(ready);
+      return;
+    }
+  }
+  this->Schedule(ready);
+}
+
+void JobSystem::Schedule(job *ready) {
+  if (ready->affinity == Affinity::MainThread) {
+    std::lock_guard<std::mutex> lock(this->MainMutex);
+    this->MainQueue.push_back(ready);
+    return;
+  }
+
+  if (WorkerIndex != NoWorker) {
+    this->Deques[WorkerIndex]->Push(ready);
+  } else {
+    std::lock_guard<std::mutex> lock(this->SharedMutex);
+    this->Shared.push_back(ready);
+  }
+
+  // a sleeping worker either sees the job counted or gets woken up
+  this->Queued.fetch_add(1);
+  if (this->Sleeping.load() > 0) {
+    std::lock_guard<std::mutex> lock(this->SleepMutex);
+    this->Wake.notify_one();
+  }
+}
+
+job *JobSystem::FindJob() {
+  job *found = nullptr;
+  if (WorkerIndex != NoWorker)
+    found = this->Deques[WorkerIndex]->Pop();
+
+  if (!found && this->Queued.load(std::memory_order_relaxed) > 0) {
+    {
+      std::lock_guard<std::mutex> lock(this->SharedMutex);
+      if (!this->Shared.empty()) {
+        found = this->Shared.front();
+        this->Shared.pop_front();
+      }
+    }
+    // steal from the others, each thread starting somewhere else
+    std::size_t count = this->Deques.size();
+    for (std::size_t i = 0; !found && i < count; i++) {
+      std::size_t victim = (NextVictim++) % count;
+      if (victim != WorkerIndex)
+        found = this->Deques[victim]->Steal();
+    }
+  }
+
+  if (found)
+    this->Queued.fetch_sub(1);
+  return found;
+}
+
+job *JobSystem::TakeMainThreadJob() {
+  std::lock_guard<std::mutex> lock(this->MainMutex);
+  if (this->MainQueue.empty())
+    return nullptr;
+  job *next = this->MainQueue.front();
+  this->MainQueue.pop_front();
+  return next;
+}
+
+void JobSystem::Run(job *next) {
+  next->run(*next);
+  JobCounter *counter = next->counter;
+  next->destroy(*next);
+  FreeJob(next);
+  if (!counter)
+    return;
+
+  // Under the lock, so that Wait() cannot return, and the counter go,
+  // while this still uses it. The jobs that waited for it are only
+  // scheduled after the counter is let go, since once they ran nothing
+  // keeps it alive.
+  thread_local std::vector<job *> ready;
+  {
+    std::lock_guard<std::mutex> lock(counter->Mutex);
+    if (counter->Value.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+      ready.insert(ready.end(), counter->Waiting.begin(),
+                   counter->Waiting.end());
+      counter->Waiting.clear();
+    }
+  }
+  for (job *waiting : ready)
+    this->Schedule(waiting);
+  ready.clear();
+}
+
+void JobSystem::Wait(JobCounter &counter) {
+  while (!counter.IsDone()) {
+    job *next = this->IsMainThread() ? this->TakeMainThreadJob() : nullptr;
+    if (!next)
+      next = this->FindJob();
+    if (next)
+      this->Run(next);
+    else
+      std::this_thread::yield();
+  }
+  std::lock_guard<std::mutex> lock(counter.Mutex);
+}
+
+std::size_t JobSystem::RunMainThreadJobs() {
+  std::size_t count;
+  {
+    std::lock_guard<std::mutex> lock(this->MainMutex);
+    count = this->MainQueue.size();
+  }
+  // not the ones these queue
+  for (std::size_t i = 0; i < count; i++)
+    this->Run(this->TakeMainThreadJob());
+  return count;
+}
+
+void JobSystem::WorkerLoop(unsigned index) {
+  WorkerIndex = index;
+  NextVictim = index + 1;
+  while (!this->Stop) {
+    if (job *next = this->FindJob()) {
+      this->Run(next);
+      continue;
+    }
+
+    this->Sleeping++;
+    {
+      std::unique_lock<std::mutex> lock(this->SleepMutex);
+      this->Wake.wait(lock, [this]() {
+        return this->Stop || this->Queued.load() > 0;
+      });
+    }
+    this->Sleeping--;
+  }
+}
@@ -0,0 +1,204 @@
+#ifndef JOBSYSTEM_H
+#define JOBSYSTEM_H
+
+#include "WorkStealingDeque.h"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+struct job;
+
+// Counts unfinished jobs. Submitting a job with a counter raises it, and
+// the job lowers it again when it has run. Other jobs can wait for a
+// counter to get to zero, as a dependency, and so can threads, with
+// JobSystem::Wait(). A counter must outlive the jobs that use it.
+class JobCounter {
+public:
+  JobCounter() = default;
+  JobCounter(const JobCounter &) = delete;
+  void operator=(const JobCounter &) = delete;
+
+  bool IsDone() const {
+    return this->Value.load(std::memory_order_acquire) == 0;
+  }
+
+private:
+  friend class JobSystem;
+
+  std::atomic<int> Value{0};
+  std::mutex Mutex;
+  // jobs that depend on the counter, submitted when it gets to zero
+  std::vector<job *> Waiting;
+};
+
+// Runs small jobs on one worker thread per core but one. Every worker has
+// a deque of its own: jobs submitted from a job go to the bottom of its
+// worker's deque, where that worker takes them first, and workers that
+// run out of work steal from the top of the others'. Jobs submitted from
+// other threads are shared out the same way.
+//
+// Jobs with MainThread affinity, those that touch GL for example, only run
+// on the main thread, in RunMainThreadJobs() or while it waits. The main
+// thread is the one that first calls GetInstance().
+//
+// A thread that waits for a counter runs jobs in the meantime, so jobs may
+// wait for jobs they submit, and parallel loops may be nested.
+class JobSystem {
+public:
+  enum class Affinity { Worker, MainThread };
+
+  // callables up to this size are stored in the job itself
+  static constexpr std::size_t InlineSize = 64;
+
+public:
+  // A function-local static instead of the `Instance` pointer the other
+  // singletons leak: the workers have to be stopped and joined at exit,
+  // before the job caches in JobSystem.cpp are destroyed, and a leaked
+  // instance would leave them running through static destruction.
+  static JobSystem *GetInstance();
+
+  ~JobSystem();
+  JobSystem(const JobSystem &) = delete;
+  void operator=(const JobSystem &) = delete;
+
+  // Runs `work` once `dependency`, if given, is done; `counter`, if given,
+  // stays raised until it has run.
+  template <typename F>
+  void Submit(F &&work, JobCounter *counter = nullptr,
+              JobCounter *dependency = nullptr,
+              Affinity affinity = Affinity::Worker);
+
+  // Runs jobs until the counter is done.
+  void Wait(JobCounter &counter);
+
+  // Calls f(begin, end) for ranges of [0, count) of `grain` indices each,
+  // in parallel, and returns when all are done. A grain of 0 makes a few
+  // ranges per thread.
+  template <typename F>
+  void ParallelFor(std::size_t count, std::size_t grain, F &&f);
+
+  // Runs the main-thread jobs queued so far. Main thread only; returns the
+  // number of jobs run.
+  std::size_t RunMainThreadJobs();
+
+  unsigned GetWorkerCount() const {
+    return static_cast<unsigned>(this->Workers.size());
+  }
+  bool IsMainThread() const {
+    return std::this_thread::get_id() == this->MainThread;
+  }
+
+private:
+  explicit JobSystem(unsigned workers);
+
+  template <typename F> static job *MakeJob(F &&work);
+  static job *AllocateJob();
+  static void FreeJob(job *finished);
+
+  // Queues a job whose dependency is done.
+  void Schedule(job *ready);
+  void Enqueue(job *ready, JobCounter *counter, JobCounter *dependency);
+  // A job for this thread from its own deque, the shared queue or another
+  // worker. nullptr if there is none.
+  job *FindJob();
+  job *TakeMainThreadJob();
+  void Run(job *next);
+  void WorkerLoop(unsigned index);
+
+private:
+  std::thread::id MainThread;
+  std::vector<std::unique_ptr<WorkStealingDeque<job>>> Deques;
+  std::vector<std::thread> Workers;
+
+  // jobs from threads that are not workers
+  std::mutex SharedMutex;
+  std::deque<job *> Shared;
+
+  std::mutex MainMutex;
+  std::deque<job *> MainQueue;
+
+  // jobs in the deques and the shared queue; for a moment below zero when
+  // a job is taken before its submitter counted it
+  std::atomic<std::int64_t> Queued{0};
+  std::atomic<unsigned> Sleeping{0};
+  std::mutex SleepMutex;
+  std::condition_variable Wake;
+  std::atomic<bool> Stop{false};
+};
+
+struct job {
+  void (*run)(job &);
+  void (*destroy)(job &);
+  JobCounter *counter;
+  JobSystem::Affinity affinity;
+  alignas(std::max_align_t) unsigned char storage[JobSystem::InlineSize];
+};
+
+template <typename F> job *JobSystem::MakeJob(F &&work) {
+  using callable = std::decay_t<F>;
+  job *created = AllocateJob();
+  if constexpr (sizeof(callable) <= InlineSize &&
+                alignof(callable) <= alignof(std::max_align_t)) {
+    new (created->storage) callable(std::forward<F>(work));
+    created->run = [](job &self) {
+      (*std::launder(reinterpret_cast<callable *>(self.storage)))();
+    };
+    created->destroy = [](job &self) {
+      std::launder(reinterpret_cast<callable *>(self.storage))->~callable();
+    };
+  } else {
+    // too large to store inline
+    new (created->storage) callable *(new callable(std::forward<F>(work)));
+    created->run = [](job &self) {
+      (**std::launder(reinterpret_cast<callable **>(self.storage)))();
+    };
+    created->destroy = [](job &self) {
+      delete *std::launder(reinterpret_cast<callable **>(self.storage));
+    };
+  }
+  return created;
+}
+
+template <typename F>
+void JobSystem::Submit(F &&work, JobCounter *counter, JobCounter *dependency,
+                       Affinity affinity) {
+  job *created = MakeJob(std::forward<F>(work));
+  created->affinity = affinity;
+  this->Enqueue(created, counter, dependency);
+}
+
+template <typename F>
+void JobSystem::ParallelFor(std::size_t count, std::size_t grain, F &&f) {
+  if (count == 0)
+    return;
+  if (grain == 0) {
+    std::size_t ranges = 4 * (std::size_t(this->Workers.size()) + 1);
+    grain = std::max<std::size_t>(1, (count + ranges - 1) / ranges);
+  }
+  if (grain >= count) {
+    f(std::size_t(0), count);
+    return;
+  }
+
+  JobCounter counter;
+  for (std::size_t begin = grain; begin < count; begin += grain) {
+    std::size_t end = std::min(begin + grain, count);
+    this->Submit([&f, begin, end]() { f(begin, end); }, &counter);
+  }
+  // the first range on this thread
+  f(std::size_t(0), grain);
+  this->Wait(counter);
+}
+
+#endif
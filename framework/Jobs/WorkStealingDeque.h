@@ -0,0 +1,121 @@
+#ifndef WORKSTEALINGDEQUE_H
+#define WORKSTEALINGDEQUE_H
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// The Chase-Lev deque: the thread that owns it pushes and pops at the
+// bottom, like a stack, and other threads steal from the top. Owner and
+// thieves only contend for the last item. Holds pointers; the array grows
+// as needed, and replaced arrays are kept until the deque goes, since a
+// thief may still be reading from one.
+template <typename T> class WorkStealingDeque {
+public:
+  explicit WorkStealingDeque(std::int64_t capacity = 256) {
+    this->Rings.push_back(std::make_unique<ring>(capacity));
+    this->Array.store(this->Rings.back().get(), std::memory_order_relaxed);
+  }
+  WorkStealingDeque(const WorkStealingDeque &) = delete;
+  void operator=(const WorkStealingDeque &) = delete;
+
+  // Owner only.
+  void Push(T *item);
+  // Owner only. nullptr if empty.
+  T *Pop();
+  // Any thread. nullptr if empty or another thread took the item first.
+  T *Steal();
+
+  bool IsEmpty() const {
+    return this->Bottom.load(std::memory_order_relaxed) <=
+           this->Top.load(std::memory_order_relaxed);
+  }
+
+private:
+  struct ring {
+    explicit ring(std::int64_t capacity)
+        : capacity(capacity), items(new std::atomic<T *>[capacity]) {}
+
+    T *get(std::int64_t index) const {
+      return items[index & (capacity - 1)].load(std::memory_order_relaxed);
+    }
+    void put(std::int64_t index, T *item) {
+      items[index & (capacity - 1)].store(item, std::memory_order_relaxed);
+    }
+
+    std::int64_t capacity; // a power of two
+    std::unique_ptr<std::atomic<T *>[]> items;
+  };
+
+private:
+  ring *Grow(ring *old, std::int64_t bottom, std::int64_t top);
+
+private:
+  std::atomic<std::int64_t> Top{0};
+  std::atomic<std::int64_t> Bottom{0};
+  std::atomic<ring *> Array;
+  std::vector<std::unique_ptr<ring>> Rings; // owner only
+};
+
+template <typename T> void WorkStealingDeque<T>::Push(T *item) {
+  std::int64_t bottom = this->Bottom.load(std::memory_order_relaxed);
+  std::int64_t top = this->Top.load(std::memory_order_acquire);
+  ring *array = this->Array.load(std::memory_order_relaxed);
+  if (bottom - top > array->capacity - 1)
+    array = this->Grow(array, bottom, top);
+  array->put(bottom, item);
+  this->Bottom.store(bottom + 1, std::memory_order_release);
+}
+
+template <typename T> T *WorkStealingDeque<T>::Pop() {
+  std::int64_t bottom = this->Bottom.load(std::memory_order_relaxed) - 1;
+  ring *array = this->Array.load(std::memory_order_relaxed);
+  // seq_cst so that a thief either sees the smaller bottom or we see its
+  // larger top
+  this->Bottom.store(bottom, std::memory_order_seq_cst);
+  std::int64_t top = this->Top.load(std::memory_order_seq_cst);
+
+  if (top > bottom) {
+    this->Bottom.store(bottom + 1, std::memory_order_relaxed);
+    return nullptr;
+  }
+  T *item = array->get(bottom);
+  if (top == bottom) {
+    // the last item: whoever moves top first gets it
+    if (!this->Top.compare_exchange_strong(top, top + 1,
+                                           std::memory_order_seq_cst,
+                                           std::memory_order_relaxed))
+      item = nullptr;
+    this->Bottom.store(bottom + 1, std::memory_order_relaxed);
+  }
+  return item;
+}
+
+template <typename T> T *WorkStealingDeque<T>::Steal() {
+  std::int64_t top = this->Top.load(std::memory_order_seq_cst);
+  std::int64_t bottom = this->Bottom.load(std::memory_order_seq_cst);
+  if (top >= bottom)
+    return nullptr;
+
+  ring *array = this->Array.load(std::memory_order_acquire);
+  T *item = array->get(top);
+  if (!this->Top.compare_exchange_strong(top, top + 1,
+                                         std::memory_order_seq_cst,
+                                         std::memory_order_relaxed))
+    return nullptr;
+  return item;
+}
+
+template <typename T>
+typename WorkStealingDeque<T>::ring *
+WorkStealingDeque<T>::Grow(ring *old, std::int64_t bottom, std::int64_t top) {
+  this->Rings.push_back(std::make_unique<ring>(old->capacity * 2));
+  ring *grown = this->Rings.back().get();
+  for (std::int64_t i = top; i < bottom; i++)
+    grown->put(i, old->get(i));
+  this->Array.store(grown, std::memory_order_release);
+  return grown;
+}
+
+#endif
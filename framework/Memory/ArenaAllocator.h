@@ -0,0 +1,59 @@
+#ifndef ARENAALLOCATOR_H
+#define ARENAALLOCATOR_H
+
+#include "FrameArena.h"
+#include "ScratchStack.h"
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+// Standard library allocator that takes its memory from an arena, either
+// FrameArena or ScratchStack. A container keeps the arena it was made
+// with, so a ScratchVector stays on the stack of the thread that made it.
+template <typename T, typename Arena> class ArenaAllocator {
+public:
+  using value_type = T;
+
+public:
+  ArenaAllocator() : Source(Arena::GetInstance()) {}
+  explicit ArenaAllocator(Arena *source) : Source(source) {}
+  template <typename U>
+  ArenaAllocator(const ArenaAllocator<U, Arena> &other)
+      : Source(other.GetArena()) {}
+
+  T *allocate(std::size_t count) {
+    return static_cast<T *>(
+        this->Source->Allocate(count * sizeof(T), alignof(T)));
+  }
+  void deallocate(T *memory, std::size_t count) {
+    this->Source->Free(memory, count * sizeof(T));
+  }
+
+  Arena *GetArena() const { return this->Source; }
+
+  template <typename U>
+  bool operator==(const ArenaAllocator<U, Arena> &other) const {
+    return this->Source == other.GetArena();
+  }
+  template <typename U>
+  bool operator!=(const ArenaAllocator<U, Arena> &other) const {
+    return this->Source != other.GetArena();
+  }
+
+private:
+  Arena *Source;
+};
+
+// Valid until the next FrameArena::Reset().
+template <typename T>
+using FrameVector = std::vector<T, ArenaAllocator<T, FrameArena>>;
+using FrameString =
+    std::basic_string<char, std::char_traits<char>,
+                      ArenaAllocator<char, FrameArena>>;
+
+// Valid until the enclosing ScratchScope ends.
+template <typename T>
+using ScratchVector = std::vector<T, ArenaAllocator<T, ScratchStack>>;
+
+#endif
@@ -0,0 +1,68 @@
+#include "FrameArena.h"
+
+#include <algorithm>
+#include <cstdint>
+
+namespace {
+
+std::uintptr_t AlignUp(std::uintptr_t address, std::size_t alignment) {
+  return (address + alignment - 1) / alignment * alignment;
+}
+
+} // namespace
+
+FrameArena *FrameArena::GetInstance() {
+  static FrameArena arena(DefaultCapacity);
+  return &arena;
+}
+
+FrameArena::FrameArena(std::size_t capacity)
+    : Block(new unsigned char[capacity]), Capacity(capacity) {}
+
+void *FrameArena::Allocate(std::size_t size, std::size_t alignment) {
+  std::uintptr_t base = reinterpret_cast<std::uintptr_t>(this->Block.get());
+  std::size_t offset = this->Offset.load(std::memory_order_relaxed);
+  for (;;) {
+    std::size_t start = AlignUp(base + offset, alignment) - base;
+    std::size_t end = start + size;
+    if (end > this->Capacity)
+      break;
+    if (this->Offset.compare_exchange_weak(offset, end,
+                                           std::memory_order_relaxed))
+      return this->Block.get() + start;
+  }
+
+  // full for this frame
+  std::lock_guard<std::mutex> lock(this->OverflowMutex);
+  this->Overflow.emplace_back(new unsigned char[size + alignment]);
+  this->OverflowBytes += size + alignment;
+  std::uintptr_t address =
+      reinterpret_cast<std::uintptr_t>(this->Overflow.back().get());
+  return reinterpret_cast<void *>(AlignUp(address, alignment));
+}
+
+void FrameArena::Reset() {
+  std::size_t used = this->GetUsed();
+  this->Peak = std::max(this->Peak, used);
+
+  if (!this->Overflow.empty()) {
+    std::size_t capacity = this->Capacity;
+    while (capacity < used)
+      capacity *= 2;
+    this->Block.reset(new unsigned char[capacity]);
+    this->Capacity = capacity;
+    this->Overflow.clear();
+    this->OverflowBytes = 0;
+  }
+  this->Offset.store(0, std::memory_order_relaxed);
+}
+
+std::size_t FrameArena::GetUsed() const {
+  std::lock_guard<std::mutex> lock(this->OverflowMutex);
+  return this->Offset.load(std::memory_order_relaxed) + this->OverflowBytes;
+}
+
+std::size_t FrameArena::GetOverflowCount() const {
+  std::lock_guard<std::mutex> lock(this->OverflowMutex);
+  return this->Overflow.size();
+}
@@ -0,0 +1,58 @@
+#ifndef FRAMEARENA_H
+#define FRAMEARENA_H
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+// Memory for data that lives until the end of the frame. Allocating bumps
+// an offset in one block and freeing does nothing; Reset() at the end of
+// the frame takes everything back at once. Any thread may allocate, but
+// nothing may use the memory, or allocate, while Reset() runs.
+//
+// When a frame needs more than the block holds, the rest comes from the
+// heap, and the next Reset() grows the block so that the following frames
+// fit again. After the first few frames the arena does not touch the heap.
+class FrameArena {
+public:
+  static constexpr std::size_t DefaultCapacity = 1 << 20;
+
+public:
+  static FrameArena *GetInstance();
+
+  FrameArena(const FrameArena &) = delete;
+  void operator=(const FrameArena &) = delete;
+
+  void *Allocate(std::size_t size,
+                 std::size_t alignment = alignof(std::max_align_t));
+  // Frame memory is freed by Reset(); here for the allocator adapters.
+  void Free(void *, std::size_t) {}
+
+  // Call once per frame, after the frame's last use of the memory.
+  void Reset();
+
+  // in bytes; used is since the last Reset(), peak over all frames
+  std::size_t GetUsed() const;
+  std::size_t GetCapacity() const { return this->Capacity; }
+  std::size_t GetPeak() const { return this->Peak; }
+  // allocations since the last Reset() that did not fit in the block
+  std::size_t GetOverflowCount() const;
+
+private:
+  explicit FrameArena(std::size_t capacity);
+
+private:
+  std::unique_ptr<unsigned char[]> Block;
+  std::size_t Capacity;
+  std::atomic<std::size_t> Offset{0};
+
+  mutable std::mutex OverflowMutex;
+  std::vector<std::unique_ptr<unsigned char[]>> Overflow;
+  std::size_t OverflowBytes = 0;
+
+  std::size_t Peak = 0;
+};
+
+#endif
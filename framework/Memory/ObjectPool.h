@@ -0,0 +1,174 @@
+#ifndef OBJECTPOOL_H
+#define OBJECTPOOL_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// Refers to an object in an ObjectPool<T>. The generation tells a handle to
+// a destroyed object apart from one to the object that reused its slot.
+template <typename T> struct PoolHandle {
+  std::uint32_t index = UINT32_MAX;
+  std::uint32_t generation = 0;
+
+  bool operator==(const PoolHandle &other) const {
+    return index == other.index && generation == other.generation;
+  }
+  bool operator!=(const PoolHandle &other) const { return !(*this == other); }
+};
+
+struct PoolStats {
+  std::size_t capacity = 0; // slots in all blocks
+  std::size_t live = 0;
+  std::size_t peak = 0; // most live objects at once
+  std::size_t blocks = 0;
+};
+
+// Objects of one type in blocks of BlockCapacity slots. Free slots are kept
+// in a list and reused before a new block is allocated, and blocks are
+// only given back when the pool goes, so creating and destroying objects
+// at a steady rate does not go to the heap, and objects never move.
+template <typename T, std::size_t BlockCapacity = 256> class ObjectPool {
+public:
+  using Handle = PoolHandle<T>;
+
+public:
+  ObjectPool() = default;
+  ~ObjectPool() { this->Clear(); }
+  ObjectPool(const ObjectPool &) = delete;
+  void operator=(const ObjectPool &) = delete;
+
+  // Without arguments the object is default-initialized, as by new T.
+  template <typename... Args> Handle Create(Args &&...args);
+  // False if the handle's object was destroyed already.
+  bool Destroy(Handle handle);
+  void Clear();
+
+  bool IsAlive(Handle handle) const { return this->Find(handle) != nullptr; }
+  // nullptr for destroyed objects
+  T *Get(Handle handle) { return const_cast<T *>(this->Find(handle)); }
+  const T *Get(Handle handle) const { return this->Find(handle); }
+
+  // Calls f(T &) or f(Handle, T &) for every live object.
+  template <typename F> void Each(F &&f);
+
+  // Allocates the blocks for `count` objects up front.
+  void Reserve(std::size_t count);
+  PoolStats GetStats() const { return this->Stats; }
+
+private:
+  static constexpr std::uint32_t NoSlot = UINT32_MAX;
+
+  struct slot {
+    alignas(T) unsigned char storage[sizeof(T)];
+    std::uint32_t generation = 0;
+    std::uint32_t nextFree = NoSlot;
+    bool live = false;
+
+    T *get() { return std::launder(reinterpret_cast<T *>(storage)); }
+  };
+
+private:
+  slot &GetSlot(std::uint32_t index) const {
+    return this->Blocks[index / BlockCapacity][index % BlockCapacity];
+  }
+  const T *Find(Handle handle) const;
+  void AddBlock();
+
+private:
+  std::vector<std::unique_ptr<slot[]>> Blocks;
+  std::uint32_t FirstFree = NoSlot;
+  PoolStats Stats;
+};
+
+template <typename T, std::size_t BlockCapacity>
+template <typename... Args>
+PoolHandle<T> ObjectPool<T, BlockCapacity>::Create(Args &&...args) {
+  if (this->FirstFree == NoSlot)
+    this->AddBlock();
+
+  std::uint32_t index = this->FirstFree;
+  slot &free = this->GetSlot(index);
+  if constexpr (sizeof...(Args) == 0)
+    new (free.storage) T;
+  else
+    new (free.storage) T(std::forward<Args>(args)...);
+  this->FirstFree = free.nextFree;
+  free.live = true;
+
+  this->Stats.live++;
+  if (this->Stats.live > this->Stats.peak)
+    this->Stats.peak = this->Stats.live;
+  return {index, free.generation};
+}
+
+template <typename T, std::size_t BlockCapacity>
+bool ObjectPool<T, BlockCapacity>::Destroy(Handle handle) {
+  if (!this->Find(handle))
+    return false;
+
+  slot &used = this->GetSlot(handle.index);
+  used.get()->~T();
+  used.live = false;
+  used.generation++;
+  used.nextFree = this->FirstFree;
+  this->FirstFree = handle.index;
+  this->Stats.live--;
+  return true;
+}
+
+template <typename T, std::size_t BlockCapacity>
+void ObjectPool<T, BlockCapacity>::Clear() {
+  this->Each([this](Handle handle, T &) { this->Destroy(handle); });
+}
+
+template <typename T, std::size_t BlockCapacity>
+const T *ObjectPool<T, BlockCapacity>::Find(Handle handle) const {
+  if (handle.index >= this->Stats.capacity)
+    return nullptr;
+  slot &found = this->GetSlot(handle.index);
+  if (!found.live || found.generation != handle.generation)
+    return nullptr;
+  return found.get();
+}
+
+template <typename T, std::size_t BlockCapacity>
+template <typename F>
+void ObjectPool<T, BlockCapacity>::Each(F &&f) {
+  for (std::uint32_t index = 0; index < this->Stats.capacity; index++) {
+    slot &current = this->GetSlot(index);
+    if (!current.live)
+      continue;
+    if constexpr (std::is_invocable<F &, Handle, T &>::value)
+      f(Handle{index, current.generation}, *current.get());
+    else
+      f(*current.get());
+  }
+}
+
+template <typename T, std::size_t BlockCapacity>
+void ObjectPool<T, BlockCapacity>::Reserve(std::size_t count) {
+  while (this->Stats.capacity < count)
+    this->AddBlock();
+}
+
+template <typename T, std::size_t BlockCapacity>
+void ObjectPool<T, BlockCapacity>::AddBlock() {
+  std::uint32_t first = static_cast<std::uint32_t>(this->Stats.capacity);
+  this->Blocks.emplace_back(new slot[BlockCapacity]);
+  this->Stats.capacity += BlockCapacity;
+  this->Stats.blocks++;
+
+  // lowest index first, so that a new pool fills its blocks in order
+  slot *block = this->Blocks.back().get();
+  for (std::size_t i = BlockCapacity; i-- > 0;) {
+    block[i].nextFree = this->FirstFree;
+    this->FirstFree = first + static_cast<std::uint32_t>(i);
+  }
+}
+
+#endif
@@ -0,0 +1,73 @@
+#include "ScratchStack.h"
+
+#include <algorithm>
+#include <cstdint>
+
+namespace {
+
+std::uintptr_t AlignUp(std::uintptr_t address, std::size_t alignment) {
+  return (address + alignment - 1) / alignment * alignment;
+}
+
+} // namespace
+
+ScratchStack *ScratchStack::GetInstance() {
+  thread_local ScratchStack stack;
+  return &stack;
+}
+
+void *ScratchStack::Allocate(std::size_t size, std::size_t alignment) {
+  std::size_t needed = size + alignment;
+  if (this->Blocks.empty())
+    this->Blocks.push_back(
+        {std::unique_ptr<unsigned char[]>(
+             new unsigned char[std::max(BlockSize, needed)]),
+         std::max(BlockSize, needed)});
+
+  for (;;) {
+    block &current = this->Blocks[this->Current];
+    std::uintptr_t base = reinterpret_cast<std::uintptr_t>(current.data.get());
+    std::size_t start = AlignUp(base + this->Offset, alignment) - base;
+    if (start + size <= current.size) {
+      this->Offset = start + size;
+      return current.data.get() + start;
+    }
+
+    // the blocks after the current one are unused, so one that is too
+    // small can be replaced
+    std::size_t next = this->Current + 1;
+    std::size_t blockSize = std::max(BlockSize, needed);
+    if (next == this->Blocks.size())
+      this->Blocks.push_back(
+          {std::unique_ptr<unsigned char[]>(new unsigned char[blockSize]),
+           blockSize});
+    else if (this->Blocks[next].size < needed)
+      this->Blocks[next] = {
+          std::unique_ptr<unsigned char[]>(new unsigned char[blockSize]),
+          blockSize};
+    this->Current = next;
+    this->Offset = 0;
+  }
+}
+
+void ScratchStack::Free(void *memory, std::size_t size) {
+  if (this->Blocks.empty())
+    return;
+  block &current = this->Blocks[this->Current];
+  std::uintptr_t base = reinterpret_cast<std::uintptr_t>(current.data.get());
+  std::uintptr_t address = reinterpret_cast<std::uintptr_t>(memory);
+  if (address >= base && address + size == base + this->Offset)
+    this->Offset = address - base;
+}
+
+void ScratchStack::Release(Marker marker) {
+  this->Current = marker.block;
+  this->Offset = marker.offset;
+}
+
+std::size_t ScratchStack::GetCapacity() const {
+  std::size_t capacity = 0;
+  for (const block &current : this->Blocks)
+    capacity += current.size;
+  return capacity;
+}
@@ -0,0 +1,79 @@
+#ifndef SCRATCHSTACK_H
+#define SCRATCHSTACK_H
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+// Temporary memory for one thread, taken and given back in stack order.
+// A ScratchScope marks the top of the stack and gives everything allocated
+// after it back when it goes out of scope:
+//
+//   {
+//     ScratchScope scope;
+//     ScratchVector<int> order; // memory from this thread's stack
+//     ...
+//   } // and back here
+//
+// The stack is made of blocks that are kept once allocated, so a function
+// that needs the same amount of scratch memory every time it runs only
+// allocates the first time.
+class ScratchStack {
+public:
+  static constexpr std::size_t BlockSize = 256 * 1024;
+
+  struct Marker {
+    std::size_t block;
+    std::size_t offset;
+  };
+
+public:
+  // The calling thread's stack.
+  static ScratchStack *GetInstance();
+
+  ScratchStack() = default;
+  ScratchStack(const ScratchStack &) = delete;
+  void operator=(const ScratchStack &) = delete;
+
+  void *Allocate(std::size_t size,
+                 std::size_t alignment = alignof(std::max_align_t));
+  // Only gives the memory back if it is the last allocation, which is
+  // enough for a vector growing at the top of the stack; everything else
+  // is given back by Release().
+  void Free(void *memory, std::size_t size);
+
+  Marker GetMarker() const { return {this->Current, this->Offset}; }
+  void Release(Marker marker);
+
+  // bytes in all blocks
+  std::size_t GetCapacity() const;
+
+private:
+  struct block {
+    std::unique_ptr<unsigned char[]> data;
+    std::size_t size;
+  };
+
+private:
+  std::vector<block> Blocks;
+  // the block allocations come from and the offset in it
+  std::size_t Current = 0;
+  std::size_t Offset = 0;
+};
+
+// Gives back everything allocated from the thread's ScratchStack during
+// its lifetime.
+class ScratchScope {
+public:
+  ScratchScope()
+      : Stack(ScratchStack::GetInstance()), Saved(Stack->GetMarker()) {}
+  ~ScratchScope() { this->Stack->Release(this->Saved); }
+  ScratchScope(const ScratchScope &) = delete;
+  void operator=(const ScratchScope &) = delete;
+
+private:
+  ScratchStack *Stack;
+  ScratchStack::Marker Saved;
+};
+
+#endif
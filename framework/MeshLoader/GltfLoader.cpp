@@ -0,0 +1,807 @@
+#include "GltfLoader.h"
+#include "IndexBuffer.h"
+#include "Json.h"
+#include "MappedFile.h"
+#include "ParallelFor.h"
+#include "TextureManager.h"
+#include "VertexBuffer.h"
+#include "VertexBufferLayout.h"
+
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <limits>
+
+namespace MeshLoader {
+
+namespace {
+
+constexpr std::uint32_t GlbMagic = 0x46546C67; // "glTF"
+constexpr std::uint32_t JsonChunk = 0x4E4F534A; // "JSON"
+constexpr std::uint32_t BinChunk = 0x004E4942;  // "BIN\0"
+
+// Conversions are cut into slices of this many elements, so one large
+// attribute is spread over several threads.
+constexpr std::size_t SliceSize = 1 << 16;
+
+enum ComponentType {
+  Byte = 5120,
+  UnsignedByte = 5121,
+  Short = 5122,
+  UnsignedShort = 5123,
+  UnsignedInt = 5125,
+  Float = 5126
+};
+
+struct bufferView {
+  const unsigned char *data = nullptr;
+  std::size_t length = 0;
+  std::size_t stride = 0; // 0: tightly packed
+};
+
+struct accessor {
+  int view = -1; // -1: every element is zero
+  std::size_t offset = 0;
+  int componentType = Float;
+  int components = 1;
+  bool normalized = false;
+  std::size_t count = 0;
+  bool sparse = false;
+
+  std::size_t ElementSize() const;
+  std::size_t Stride(const std::vector<bufferView> &views) const {
+    return this->view >= 0 && views[this->view].stride
+               ? views[this->view].stride
+               : this->ElementSize();
+  }
+  // Null for accessors without a buffer view.
+  const unsigned char *Element(const std::vector<bufferView> &views,
+                               std::size_t i) const {
+    if (this->view < 0)
+      return nullptr;
+    return views[this->view].data + this->offset + i * this->Stride(views);
+  }
+};
+
+std::size_t ComponentSize(int componentType) {
+  switch (componentType) {
+  case Byte:
+  case UnsignedByte:
+    return 1;
+  case Short:
+  case UnsignedShort:
+    return 2;
+  case UnsignedInt:
+  case Float:
+    return 4;
+  }
+  return 0;
+}
+
+int ComponentCount(const std::string &type) {
+  if (type == "SCALAR") return 1;
+  if (type == "VEC2") return 2;
+  if (type == "VEC3") return 3;
+  if (type == "VEC4") return 4;
+  if (type == "MAT2") return 4;
+  if (type == "MAT3") return 9;
+  if (type == "MAT4") return 16;
+  return 0;
+}
+
+std::size_t accessor::ElementSize() const {
+  return ComponentSize(this->componentType) * this->components;
+}
+
+template <typename T> T Load(const unsigned char *p) {
+  T value;
+  std::memcpy(&value, p, sizeof(T));
+  return value;
+}
+
+float ReadComponent(const unsigned char *p, int componentType,
+                    bool normalized) {
+  switch (componentType) {
+  case Byte: {
+    float c = Load<std::int8_t>(p);
+    return normalized ? std::max(c / 127.f, -1.f) : c;
+  }
+  case UnsignedByte: {
+    float c = Load<std::uint8_t>(p);
+    return normalized ? c / 255.f : c;
+  }
+  case Short: {
+    float c = Load<std::int16_t>(p);
+    return normalized ? std::max(c / 32767.f, -1.f) : c;
+  }
+  case UnsignedShort: {
+    float c = Load<std::uint16_t>(p);
+    return normalized ? c / 65535.f : c;
+  }
+  case UnsignedInt:
+    return float(Load<std::uint32_t>(p));
+  case Float:
+    return Load<float>(p);
+  }
+  return 0.f;
+}
+
+GLuint ReadIndex(const unsigned char *p, int componentType) {
+  switch (componentType) {
+  case UnsignedByte:
+    return Load<std::uint8_t>(p);
+  case UnsignedShort:
+    return Load<std::uint16_t>(p);
+  case UnsignedInt:
+    return Load<std::uint32_t>(p);
+  }
+  return 0;
+}
+
+bool IsIndexType(int componentType) {
+  return componentType == UnsignedByte || componentType == UnsignedShort ||
+         componentType == UnsignedInt;
+}
+
+// The largest index of an index accessor, 0 if it is empty.
+GLuint MaxIndex(const accessor &a, const std::vector<bufferView> &views) {
+  GLuint largest = 0;
+  for (std::size_t i = 0; i < a.count; i++) {
+    const unsigned char *element = a.Element(views, i);
+    if (!element)
+      break;
+    largest = std::max(largest, ReadIndex(element, a.componentType));
+  }
+  return largest;
+}
+
+// Engine attributes and the locations they are bound to.
+struct semantic {
+  const char *name;
+  GLuint location;
+  int components;
+  ShaderDataType type;
+};
+
+const semantic Semantics[] = {
+    {"POSITION", 0, 3, ShaderDataType::Float3},
+    {"TEXCOORD_0", 1, 2, ShaderDataType::Float2},
+    {"NORMAL", 2, 3, ShaderDataType::Float3},
+    {"TANGENT", 3, 4, ShaderDataType::Float4},
+};
+
+// An attribute read with float components, converted to `components` wide
+// elements on the CPU.
+struct attributeConversion {
+  int accessor;
+  int components;
+  std::vector<float> data;
+};
+
+// Indices widened to 32 bits; accessor -1 numbers the vertices instead.
+struct indexConversion {
+  int accessor;
+  std::size_t count;
+  std::vector<GLuint> data;
+};
+
+// Area weighted vertex normals of a triangle list without any.
+struct normalGeneration {
+  int positions;
+  int indices; // -1: non-indexed
+  std::vector<float> data;
+};
+
+struct attributeSource {
+  const semantic *target;
+  int view = -1;          // uploaded as it is: buffer view, offset and stride
+  std::size_t offset = 0;
+  GLsizei stride = 0;
+  int conversion = -1;    // or into attributeConversions
+  int normals = -1;       // or into normalGenerations
+};
+
+struct primitivePlan {
+  int mesh;
+  gltfPrimitive primitive;
+  std::vector<attributeSource> attributes;
+  const unsigned char *indices = nullptr; // 32 bit, straight from the file
+  int indexConversion = -1;
+  std::size_t indexCount = 0;
+};
+
+struct decodedImage {
+  std::string filePath;                      // external image, or
+  const unsigned char *encoded = nullptr;    // embedded one
+  std::size_t encodedSize = 0;
+  unsigned char *pixels = nullptr;
+  int width = 0, height = 0;
+};
+
+bool ParseAccessors(const jsonValue &root, const std::vector<bufferView> &views,
+                    std::vector<accessor> &accessors, std::string &error) {
+  const jsonValue &list = root["accessors"];
+  accessors.resize(list.Size());
+  for (std::size_t i = 0; i < accessors.size(); i++) {
+    const jsonValue &json = list[i];
+    accessor &a = accessors[i];
+    a.view = json["bufferView"].AsInt(-1);
+    a.componentType = json["componentType"].AsInt();
+    a.components = ComponentCount(json["type"].AsString());
+    a.normalized = json["normalized"].AsBool();
+    a.sparse = json.Has("sparse");
+
+    // indices and counts end up in GLuints
+    if (!json["byteOffset"].AsSize(a.offset) ||
+        !json["count"].AsSize(a.count) ||
+        a.count > std::numeric_limits<GLuint>::max()) {
+      error =
+          "accessor " + std::to_string(i) + " has an invalid offset or count";
+      return false;
+    }
+    if (!ComponentSize(a.componentType) || !a.components) {
+      error = "accessor " + std::to_string(i) + " has an unknown type";
+      return false;
+    }
+    if (a.view >= int(views.size())) {
+      error = "accessor " + std::to_string(i) + " refers to a missing view";
+      return false;
+    }
+    if (a.view >= 0 && a.count) {
+      // offset + stride * (count - 1) + element size <= length, without
+      // overflowing
+      std::size_t length = views[a.view].length;
+      std::size_t stride = a.Stride(views);
+      bool fits = a.offset <= length && a.ElementSize() <= length - a.offset &&
+                  a.count - 1 <= (length - a.offset - a.ElementSize()) / stride;
+      if (!fits) {
+        error = "accessor " + std::to_string(i) + " overruns its buffer view";
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+glm::mat4 NodeTransform(const jsonValue &node) {
+  const jsonValue &matrix = node["matrix"];
+  if (matrix.Size() == 16) {
+    glm::mat4 result;
+    for (int c = 0; c < 4; c++)
+      for (int r = 0; r < 4; r++)
+        result[c][r] = float(matrix[std::size_t(c * 4 + r)].AsNumber());
+    return result;
+  }
+
+  const jsonValue &t = node["translation"];
+  const jsonValue &r = node["rotation"];
+  const jsonValue &s = node["scale"];
+  glm::vec3 translation(t[0].AsNumber(0), t[1].AsNumber(0), t[2].AsNumber(0));
+  glm::quat rotation(float(r[3].AsNumber(1)), float(r[0].AsNumber(0)),
+                     float(r[1].AsNumber(0)), float(r[2].AsNumber(0)));
+  glm::vec3 scale(s[0].AsNumber(1), s[1].AsNumber(1), s[2].AsNumber(1));
+  return glm::translate(glm::mat4(1.f), translation) *
+         glm::mat4_cast(rotation) * glm::scale(glm::mat4(1.f), scale);
+}
+
+void ParseNodes(const jsonValue &root, gltfScene &scene) {
+  const jsonValue &list = root["nodes"];
+  scene.nodes.resize(list.Size());
+  for (std::size_t i = 0; i < scene.nodes.size(); i++) {
+    gltfNode &node = scene.nodes[i];
+    node.name = list[i]["name"].AsString();
+    node.mesh = list[i]["mesh"].AsInt(-1);
+    if (node.mesh >= int(scene.meshes.size()))
+      node.mesh = -1;
+    node.local = NodeTransform(list[i]);
+  }
+
+  for (std::size_t i = 0; i < scene.nodes.size(); i++) {
+    const jsonValue &children = list[i]["children"];
+    for (std::size_t c = 0; c < children.Size(); c++) {
+      int child = children[c].AsInt(-1);
+      // a node has one parent; anything else would make the hierarchy a graph
+      if (child < 0 || child >= int(scene.nodes.size()) || child == int(i) ||
+          scene.nodes[child].parent >= 0) {
+        std::cerr << "glTF node " << i << " has an invalid child " << child
+                  << std::endl;
+        continue;
+      }
+      scene.nodes[child].parent = int(i);
+      scene.nodes[i].children.push_back(child);
+    }
+  }
+
+  const jsonValue &scenes = root["scenes"];
+  if (scenes.Size()) {
+    const jsonValue &nodes = scenes[std::size_t(root["scene"].AsInt(0))]["nodes"];
+    for (std::size_t i = 0; i < nodes.Size(); i++) {
+      int node = nodes[i].AsInt(-1);
+      if (node >= 0 && node < int(scene.nodes.size()) &&
+          scene.nodes[node].parent < 0)
+        scene.roots.push_back(node);
+    }
+  } else {
+    for (std::size_t i = 0; i < scene.nodes.size(); i++)
+      if (scene.nodes[i].parent < 0)
+        scene.roots.push_back(int(i));
+  }
+
+  // world matrices, parents before children; the parent checks above keep
+  // the walk free of cycles
+  std::vector<int> stack(scene.roots.rbegin(), scene.roots.rend());
+  while (!stack.empty()) {
+    gltfNode &node = scene.nodes[stack.back()];
+    stack.pop_back();
+    node.world = node.parent >= 0 ? scene.nodes[node.parent].world * node.local
+                                  : node.local;
+    stack.insert(stack.end(), node.children.rbegin(), node.children.rend());
+  }
+}
+
+std::string TextureName(const std::string &filePath, int image) {
+  return filePath + "#" + std::to_string(image);
+}
+
+void ParseMaterials(const jsonValue &root, const std::string &filePath,
+                    gltfScene &scene) {
+  const jsonValue &textures = root["textures"];
+  auto texture = [&](const jsonValue &info) {
+    int source = textures[std::size_t(info["index"].AsInt(-1))]["source"].AsInt(-1);
+    return source >= 0 && source < int(root["images"].Size())
+               ? TextureName(filePath, source)
+               : std::string();
+  };
+
+  const jsonValue &list = root["materials"];
+  scene.materials.resize(list.Size());
+  for (std::size_t i = 0; i < scene.materials.size(); i++) {
+    const jsonValue &json = list[i];
+    const jsonValue &pbr = json["pbrMetallicRoughness"];
+    gltfMaterial &material = scene.materials[i];
+    material.name = json["name"].AsString();
+    const jsonValue &color = pbr["baseColorFactor"];
+    for (int c = 0; c < 4 && color.Size() == 4; c++)
+      material.baseColor[c] = float(color[std::size_t(c)].AsNumber(1));
+    material.metallic = float(pbr["metallicFactor"].AsNumber(1));
+    material.roughness = float(pbr["roughnessFactor"].AsNumber(1));
+    material.baseColorTexture = texture(pbr["baseColorTexture"]);
+    material.metallicRoughnessTexture = texture(pbr["metallicRoughnessTexture"]);
+    material.normalTexture = texture(json["normalTexture"]);
+  }
+}
+
+} // namespace
+
+bool LoadGlb(const std::string &filePath, gltfScene &scene, std::string &error,
+             GLuint firstTextureUnit, unsigned threads, gltfStats *stats) {
+  using clock = std::chrono::steady_clock;
+  auto start = clock::now();
+  scene = gltfScene();
+
+  MappedFile file(filePath);
+  if (!file.IsOpen()) {
+    error = "cannot open " + filePath;
+    return false;
+  }
+
+  // header and chunks
+  const unsigned char *data = file.GetData();
+  std::size_t size = file.GetSize();
+  if (size < 20 || Load<std::uint32_t>(data) != GlbMagic) {
+    error = filePath + " is not a binary glTF file";
+    return false;
+  }
+  if (Load<std::uint32_t>(data + 4) != 2) {
+    error = filePath + " is not glTF 2.0";
+    return false;
+  }
+  size = std::min<std::size_t>(size, Load<std::uint32_t>(data + 8));
+
+  const char *json = nullptr;
+  std::size_t jsonSize = 0;
+  const unsigned char *bin = nullptr;
+  std::size_t binSize = 0;
+  for (std::size_t offset = 12; offset + 8 <= size;) {
+    std::size_t length = Load<std::uint32_t>(data + offset);
+    std::uint32_t type = Load<std::uint32_t>(data + offset + 4);
+    offset += 8;
+    if (length > size - offset) {
+      error = filePath + " has a truncated chunk";
+      return false;
+    }
+    if (type == JsonChunk && !json) {
+      json = reinterpret_cast<const char *>(data + offset);
+      jsonSize = length;
+    } else if (type == BinChunk && !bin) {
+      bin = data + offset;
+      binSize = length;
+    }
+    offset += length;
+  }
+  if (!json) {
+    error = filePath + " has no JSON chunk";
+    return false;
+  }
+
+  jsonValue root;
+  if (!ParseJson(json, json + jsonSize, root, error)) {
+    error = filePath + ": " + error;
+    return false;
+  }
+  const jsonValue &required = root["extensionsRequired"];
+  if (required.Size()) {
+    error = filePath + " requires the unsupported extension " +
+            required[0].AsString();
+    return false;
+  }
+
+  // buffers: the BIN chunk, or files next to the .glb
+  std::string directory = filePath.substr(0, filePath.find_last_of("/\\") + 1);
+  std::vector<MappedFile> externalBuffers;
+  std::vector<std::pair<const unsigned char *, std::size_t>> buffers;
+  const jsonValue &bufferList = root["buffers"];
+  for (std::size_t i = 0; i < bufferList.Size(); i++) {
+    const std::string &uri = bufferList[i]["uri"].AsString();
+    std::size_t length;
+    if (!bufferList[i]["byteLength"].AsSize(length)) {
+      error = filePath + ": buffer " + std::to_string(i) +
+              " has an invalid length";
+      return false;
+    }
+    if (uri.empty()) {
+      buffers.emplace_back(bin, std::min(length, binSize));
+    } else if (uri.compare(0, 5, "data:") == 0) {
+      error = filePath + ": data URIs are not supported";
+      return false;
+    } else {
+      externalBuffers.emplace_back(directory + uri);
+      if (!externalBuffers.back().IsOpen()) {
+        error = "cannot open " + directory + uri;
+        return false;
+      }
+      buffers.emplace_back(externalBuffers.back().GetData(),
+                           std::min(length, externalBuffers.back().GetSize()));
+    }
+    if (!buffers.back().first || buffers.back().second < length) {
+      error = filePath + ": buffer " + std::to_string(i) + " is too short";
+      return false;
+    }
+  }
+
+  std::vector<bufferView> views(root["bufferViews"].Size());
+  for (std::size_t i = 0; i < views.size(); i++) {
+    const jsonValue &view = root["bufferViews"][i];
+    int buffer = view["buffer"].AsInt(-1);
+    std::size_t offset;
+    bool valid = view["byteOffset"].AsSize(offset) &&
+                 view["byteLength"].AsSize(views[i].length) &&
+                 view["byteStride"].AsSize(views[i].stride);
+    // strides are 4 to 252 bytes; 0 is the default, tightly packed
+    std::size_t stride = views[i].stride;
+    if (!valid || (stride && (stride < 4 || stride > 252)) || buffer < 0 ||
+        buffer >= int(buffers.size()) || offset > buffers[buffer].second ||
+        views[i].length > buffers[buffer].second - offset) {
+      error = filePath + ": buffer view " + std::to_string(i) + " is out of range";
+      return false;
+    }
+    views[i].data = buffers[buffer].first + offset;
+  }
+
+  std::vector<accessor> accessors;
+  if (!ParseAccessors(root, views, accessors, error)) {
+    error = filePath + ": " + error;
+    return false;
+  }
+
+  // plan every primitive: what is uploaded as it is and what is converted
+  std::vector<attributeConversion> attributeConversions;
+  std::vector<indexConversion> indexConversions;
+  std::vector<normalGeneration> normalGenerations;
+  std::vector<primitivePlan> plans;
+  auto valid = [&](int index) {
+    return index >= 0 && index < int(accessors.size()) && !accessors[index].sparse;
+  };
+
+  const jsonValue &meshList = root["meshes"];
+  scene.meshes.resize(meshList.Size());
+  for (std::size_t m = 0; m < scene.meshes.size(); m++) {
+    scene.meshes[m].name = meshList[m]["name"].AsString();
+    const jsonValue &primitives = meshList[m]["primitives"];
+    for (std::size_t p = 0; p < primitives.Size(); p++) {
+      const jsonValue &json = primitives[p];
+      const jsonValue &attributes = json["attributes"];
+      int position = attributes["POSITION"].AsInt(-1);
+      int indices = json["indices"].AsInt(-1);
+      if (!valid(position) || (json.Has("indices") && !valid(indices)) ||
+          json["extensions"].Size()) {
+        std::cerr << "Skipping unsupported primitive " << p << " of glTF mesh "
+                  << m << " in " << filePath << std::endl;
+        continue;
+      }
+
+      primitivePlan plan;
+      plan.mesh = int(m);
+      plan.primitive.mode = GLenum(json["mode"].AsInt(GL_TRIANGLES));
+      plan.primitive.material = json["material"].AsInt(-1);
+      if (plan.primitive.material >= int(root["materials"].Size()))
+        plan.primitive.material = -1;
+
+      for (const semantic &target : Semantics) {
+        int index = attributes[target.name].AsInt(-1);
+        if (!valid(index) || accessors[index].count != accessors[position].count) {
+          if (target.location == 2 && plan.primitive.mode == GL_TRIANGLES) {
+            attributeSource source;
+            source.target = &target;
+            source.normals = int(normalGenerations.size());
+            normalGenerations.push_back({position, indices, {}});
+            plan.attributes.push_back(source);
+          }
+          continue;
+        }
+
+        const accessor &a = accessors[index];
+        attributeSource source;
+        source.target = &target;
+        std::size_t stride = a.Stride(views);
+        if (a.view >= 0 && a.componentType == Float && !a.normalized &&
+            a.components == target.components && a.offset % 4 == 0 &&
+            stride % 4 == 0 && stride <= 2048) {
+          source.view = a.view;
+          source.offset = a.offset;
+          source.stride = GLsizei(stride);
+        } else {
+          source.conversion = int(attributeConversions.size());
+          attributeConversions.push_back({index, target.components, {}});
+        }
+        plan.attributes.push_back(source);
+      }
+
+      if (indices >= 0) {
+        const accessor &a = accessors[indices];
+        if (!IsIndexType(a.componentType) || a.components != 1) {
+          error = filePath + ": accessor " + std::to_string(indices) +
+                  " is not an unsigned integer index accessor";
+          return false;
+        }
+        // every index is checked, also those uploaded as they are: the GPU
+        // would read past the vertex buffers
+        if (a.count && MaxIndex(a, views) >= accessors[position].count) {
+          error = filePath + ": mesh " + std::to_string(m) +
+                  " has an index past its last vertex";
+          return false;
+        }
+        plan.indexCount = a.count;
+        if (a.view >= 0 && a.componentType == UnsignedInt &&
+            a.Stride(views) == 4 && a.offset % 4 == 0) {
+          plan.indices = a.Element(views, 0);
+        } else {
+          plan.indexConversion = int(indexConversions.size());
+          indexConversions.push_back({indices, a.count, {}});
+        }
+      } else {
+        plan.indexCount = accessors[position].count;
+        plan.indexConversion = int(indexConversions.size());
+        indexConversions.push_back({-1, plan.indexCount, {}});
+      }
+      plans.push_back(std::move(plan));
+    }
+  }
+
+  ParseMaterials(root, filePath, scene);
+  ParseNodes(root, scene);
+
+  std::vector<decodedImage> images(root["images"].Size());
+  for (std::size_t i = 0; i < images.size(); i++) {
+    const jsonValue &image = root["images"][i];
+    int view = image["bufferView"].AsInt(-1);
+    const std::string &uri = image["uri"].AsString();
+    if (view >= 0 && view < int(views.size())) {
+      images[i].encoded = views[view].data;
+      images[i].encodedSize = views[view].length;
+    } else if (!uri.empty() && uri.compare(0, 5, "data:") != 0) {
+      images[i].filePath = directory + uri;
+    }
+  }
+
+  auto parsed = clock::now();
+
+  // conversion jobs, claimed by the threads in turn
+  std::vector<std::function<void()>> jobs;
+  for (auto &conversion : attributeConversions) {
+    const accessor &a = accessors[conversion.accessor];
+    conversion.data.assign(a.count * conversion.components, 0.f);
+    for (std::size_t begin = 0; begin < a.count; begin += SliceSize) {
+      std::size_t end = std::min(a.count, begin + SliceSize);
+      jobs.push_back([&, begin, end]() {
+        const accessor &a = accessors[conversion.accessor];
+        std::size_t componentSize = ComponentSize(a.componentType);
+        int components = std::min(a.components, conversion.components);
+        for (std::size_t i = begin; i < end; i++) {
+          const unsigned char *element = a.Element(views, i);
+          if (!element)
+            break;
+          float *out = &conversion.data[i * conversion.components];
+          for (int c = 0; c < components; c++)
+            out[c] = ReadComponent(element + c * componentSize,
+                                   a.componentType, a.normalized);
+        }
+      });
+    }
+  }
+  for (auto &conversion : indexConversions) {
+    conversion.data.resize(conversion.count);
+    for (std::size_t begin = 0; begin < conversion.count; begin += SliceSize) {
+      std::size_t end = std::min(conversion.count, begin + SliceSize);
+      jobs.push_back([&, begin, end]() {
+        if (conversion.accessor < 0) {
+          for (std::size_t i = begin; i < end; i++)
+            conversion.data[i] = GLuint(i);
+          return;
+        }
+        const accessor &a = accessors[conversion.accessor];
+        for (std::size_t i = begin; i < end; i++) {
+          const unsigned char *element = a.Element(views, i);
+          conversion.data[i] = element ? ReadIndex(element, a.componentType) : 0;
+        }
+      });
+    }
+  }
+  for (auto &generation : normalGenerations) {
+    jobs.push_back([&]() {
+      const accessor &positions = accessors[generation.positions];
+      std::size_t count = positions.count;
+      generation.data.assign(count * 3, 0.f);
+      auto position = [&](std::size_t i) {
+        const unsigned char *p = positions.Element(views, i);
+        if (!p)
+          return glm::vec3(0.f);
+        std::size_t c = ComponentSize(positions.componentType);
+        return glm::vec3(
+            ReadComponent(p, positions.componentType, positions.normalized),
+            ReadComponent(p + c, positions.componentType, positions.normalized),
+            ReadComponent(p + 2 * c, positions.componentType, positions.normalized));
+      };
+      auto index = [&](std::size_t i) -> std::size_t {
+        if (generation.indices < 0)
+          return i;
+        const accessor &a = accessors[generation.indices];
+        const unsigned char *p = a.Element(views, i);
+        return p ? ReadIndex(p, a.componentType) : 0;
+      };
+
+      std::size_t corners = generation.indices >= 0
+                                ? accessors[generation.indices].count
+                                : count;
+      for (std::size_t t = 0; t + 2 < corners; t += 3) {
+        std::size_t v[3] = {index(t), index(t + 1), index(t + 2)};
+        if (v[0] >= count || v[1] >= count || v[2] >= count)
+          continue;
+        glm::vec3 p0 = position(v[0]);
+        // the cross product's length is twice the area: area weighting
+        glm::vec3 normal = glm::cross(position(v[1]) - p0, position(v[2]) - p0);
+        for (std::size_t corner : v)
+          for (int c = 0; c < 3; c++)
+            generation.data[corner * 3 + c] += normal[c];
+      }
+      for (std::size_t i = 0; i < count; i++) {
+        glm::vec3 n(generation.data[i * 3], generation.data[i * 3 + 1],
+                    generation.data[i * 3 + 2]);
+        float length = glm::length(n);
+        n = length > 0.f ? n / length : glm::vec3(0.f, 0.f, 1.f);
+        for (int c = 0; c < 3; c++)
+          generation.data[i * 3 + c] = n[c];
+      }
+    });
+  }
+  for (auto &image : images) {
+    if (!image.encoded && image.filePath.empty())
+      continue;
+    jobs.push_back([&]() {
+      int bpp;
+      image.pixels =
+          image.encoded
+              ? stbi_load_from_memory(image.encoded, int(image.encodedSize),
+                                      &image.width, &image.height, &bpp,
+                                      STBI_rgb_alpha)
+              : stbi_load(image.filePath.c_str(), &image.width, &image.height,
+                          &bpp, STBI_rgb_alpha);
+    });
+  }
+
+  std::atomic<std::size_t> nextJob{0};
+  threads = GeometricTools::detail::ResolveThreadCount(threads, jobs.size());
+  GeometricTools::detail::ParallelFor(
+      threads, threads, [&](std::size_t, std::size_t) {
+        for (std::size_t job; (job = nextJob++) < jobs.size();)
+          jobs[job]();
+      });
+
+  auto converted = clock::now();
+
+  // upload; every buffer view feeding vertices is uploaded once and shared
+  std::size_t uploadedBytes = 0, zeroCopyBuffers = 0;
+  std::vector<std::shared_ptr<VertexBuffer>> viewBuffers(views.size());
+  for (auto &plan : plans) {
+    auto vertexArray = std::make_shared<VertexArray>();
+    for (const auto &source : plan.attributes) {
+      BufferAttribute attribute(source.target->type, source.target->name);
+      std::shared_ptr<VertexBuffer> buffer;
+      GLsizei stride = 0;
+      if (source.view >= 0) {
+        auto &shared = viewBuffers[source.view];
+        if (!shared) {
+          shared = std::make_shared<VertexBuffer>(
+              views[source.view].data, GLsizei(views[source.view].length));
+          uploadedBytes += views[source.view].length;
+          zeroCopyBuffers++;
+        }
+        buffer = shared;
+        attribute.Offset = GLuint(source.offset);
+        stride = source.stride;
+      } else {
+        const std::vector<float> &floats =
+            source.conversion >= 0 ? attributeConversions[source.conversion].data
+                                   : normalGenerations[source.normals].data;
+        buffer = std::make_shared<VertexBuffer>(
+            floats.data(), GLsizei(floats.size() * sizeof(float)));
+        uploadedBytes += floats.size() * sizeof(float);
+        stride = GLsizei(attribute.Size);
+      }
+      vertexArray->AddVertexBuffer(buffer, BufferLayout({attribute}, stride),
+                                   source.target->location);
+    }
+
+    const GLuint *indices =
+        plan.indexConversion >= 0
+            ? indexConversions[plan.indexConversion].data.data()
+            : reinterpret_cast<const GLuint *>(plan.indices);
+    vertexArray->SetIndexBuffer(
+        std::make_shared<IndexBuffer>(indices, GLsizei(plan.indexCount)));
+    uploadedBytes += plan.indexCount * sizeof(GLuint);
+
+    plan.primitive.vertexArray = vertexArray;
+    scene.meshes[plan.mesh].primitives.push_back(plan.primitive);
+  }
+
+  std::size_t decodedImages = 0;
+  for (std::size_t i = 0; i < images.size(); i++) {
+    if (!images[i].pixels) {
+      std::cerr << "Failed to decode image " << i << " of " << filePath
+                << std::endl;
+      continue;
+    }
+    TextureManager::GetInstance()->CreateTexture2DRGBA(
+        TextureName(filePath, int(i)), images[i].pixels, images[i].width,
+        images[i].height, firstTextureUnit + GLuint(i));
+    uploadedBytes += std::size_t(images[i].width) * images[i].height * 4;
+    decodedImages++;
+    stbi_image_free(images[i].pixels);
+  }
+
+  auto uploaded = clock::now();
+  if (stats) {
+    stats->zeroCopyBuffers = zeroCopyBuffers;
+    stats->convertedAttributes = attributeConversions.size();
+    stats->convertedIndexBuffers = indexConversions.size();
+    stats->generatedNormals = normalGenerations.size();
+    stats->decodedImages = decodedImages;
+    stats->uploadedBytes = uploadedBytes;
+    stats->threads = threads;
+    stats->parseMilliseconds =
+        std::chrono::duration<double, std::milli>(parsed - start).count();
+    stats->convertMilliseconds =
+        std::chrono::duration<double, std::milli>(converted - parsed).count();
+    stats->uploadMilliseconds =
+        std::chrono::duration<double, std::milli>(uploaded - converted).count();
+  }
+  return true;
+}
+
+} // namespace MeshLoader
@@ -0,0 +1,93 @@
+#ifndef MESHLOADER_GLTFLOADER_H
+#define MESHLOADER_GLTFLOADER_H
+
+#include "VertexArray.h"
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+// Binary glTF 2.0 (.glb) import: meshes, the node hierarchy, metallic-
+// roughness materials and their textures.
+//
+// The file is memory mapped. Vertex attributes whose data already has a
+// layout OpenGL can read (float components, 4 byte aligned) are not touched
+// on the CPU: each such buffer view is uploaded once, straight from the
+// mapping, and the vertex arrays point into it with the view's own offsets
+// and stride. Only attributes in other formats, narrow index types, missing
+// normals and the embedded images are converted, as jobs spread over
+// `threads` threads.
+//
+// Attributes get fixed locations, matching the GeometricTools layout:
+// 0 POSITION, 1 TEXCOORD_0, 2 NORMAL, 3 TANGENT. Missing texture
+// coordinates and tangents leave their location disabled.
+namespace MeshLoader {
+
+struct gltfMaterial {
+  std::string name;
+  glm::vec4 baseColor = glm::vec4(1.f);
+  float metallic = 1.f;
+  float roughness = 1.f;
+  // TextureManager names, empty when the material has no such texture.
+  std::string baseColorTexture;
+  std::string metallicRoughnessTexture;
+  std::string normalTexture;
+};
+
+struct gltfPrimitive {
+  std::shared_ptr<VertexArray> vertexArray;
+  GLenum mode = GL_TRIANGLES; // for RenderCommands::DrawIndex
+  int material = -1;          // into gltfScene::materials
+};
+
+struct gltfMesh {
+  std::string name;
+  std::vector<gltfPrimitive> primitives;
+};
+
+struct gltfNode {
+  std::string name;
+  int mesh = -1;   // into gltfScene::meshes
+  int parent = -1; // into gltfScene::nodes
+  std::vector<int> children;
+  glm::mat4 local = glm::mat4(1.f);
+  glm::mat4 world = glm::mat4(1.f); // of the default scene
+};
+
+struct gltfScene {
+  std::vector<gltfNode> nodes;
+  std::vector<int> roots; // nodes of the default scene
+  std::vector<gltfMesh> meshes;
+  std::vector<gltfMaterial> materials;
+};
+
+struct gltfStats {
+  std::size_t zeroCopyBuffers = 0;    // buffer views uploaded as they are
+  std::size_t convertedAttributes = 0;
+  std::size_t convertedIndexBuffers = 0;
+  std::size_t generatedNormals = 0;   // primitives that had none
+  std::size_t decodedImages = 0;
+  std::size_t uploadedBytes = 0;
+  unsigned threads = 0;
+  double parseMilliseconds = 0.0;
+  double convertMilliseconds = 0.0;
+  double uploadMilliseconds = 0.0;
+};
+
+// Loads the file into `scene`. Image i is registered with the
+// TextureManager as "<file>#<i>", bound to unit firstTextureUnit + i.
+// `threads` 0 uses every hardware thread. Needs the GL context. Returns
+// false with `error` set when the file cannot be read or is malformed,
+// which includes index accessors that are not unsigned integers or name a
+// vertex past the end; primitives using unsupported features (sparse
+// accessors, draco) are skipped with a warning on std::cerr.
+extern bool LoadGlb(const std::string &filePath, gltfScene &scene,
+                    std::string &error, GLuint firstTextureUnit = 0,
+                    unsigned threads = 0, gltfStats *stats = nullptr);
+
+} // namespace MeshLoader
+
+#endif
@@ -0,0 +1,305 @@
+#include "Json.h"
+
+#include <charconv>
+#include <climits>
+#include <cmath>
+#include <cstdint>
+
+namespace MeshLoader {
+
+namespace {
+const jsonValue NullValue;
+} // namespace
+
+const jsonValue &jsonValue::operator[](const std::string &key) const {
+  for (const auto &member : this->ObjectMembers)
+    if (member.first == key)
+      return member.second;
+  return NullValue;
+}
+
+const jsonValue &jsonValue::operator[](std::size_t index) const {
+  return index < this->Elements.size() ? this->Elements[index] : NullValue;
+}
+
+std::size_t jsonValue::Size() const {
+  return this->ValueType == Type::Array ? this->Elements.size()
+                                        : this->ObjectMembers.size();
+}
+
+double jsonValue::AsNumber(double fallback) const {
+  return this->ValueType == Type::Number ? this->Number : fallback;
+}
+
+int jsonValue::AsInt(int fallback) const {
+  // out of range, the conversion would be undefined
+  if (this->ValueType != Type::Number || this->Number < INT_MIN ||
+      this->Number > INT_MAX || std::trunc(this->Number) != this->Number)
+    return fallback;
+  return static_cast<int>(this->Number);
+}
+
+bool jsonValue::AsSize(std::size_t &size, std::size_t fallback) const {
+  size = fallback;
+  if (this->ValueType == Type::Null)
+    return true;
+  const double largest = 9007199254740992.0; // 2^53
+  if (this->ValueType != Type::Number || !(this->Number >= 0.0) ||
+      this->Number > largest || std::trunc(this->Number) != this->Number)
+    return false;
+  size = static_cast<std::size_t>(this->Number);
+  return true;
+}
+
+bool jsonValue::AsBool(bool fallback) const {
+  return this->ValueType == Type::Bool ? this->Boolean : fallback;
+}
+
+// Recursive descent over the text; nesting deeper than MaxDepth is rejected
+// so hostile files cannot exhaust the stack.
+class jsonParser {
+public:
+  jsonParser(const char *begin, const char *end)
+      : Begin(begin), Current(begin), End(end) {}
+
+  bool Parse(jsonValue &root, std::string &error) {
+    this->SkipWhitespace();
+    if (!this->ParseValue(root, 0)) {
+      error = this->Error + " at byte " + std::to_string(this->Current - this->Begin);
+      return false;
+    }
+    this->SkipWhitespace();
+    if (this->Current != this->End) {
+      error = "trailing characters at byte " +
+              std::to_string(this->Current - this->Begin);
+      return false;
+    }
+    return true;
+  }
+
+private:
+  static constexpr int MaxDepth = 256;
+
+  bool Fail(const char *message) {
+    this->Error = message;
+    return false;
+  }
+
+  void SkipWhitespace() {
+    while (this->Current != this->End &&
+           (*this->Current == ' ' || *this->Current == '\t' ||
+            *this->Current == '\n' || *this->Current == '\r'))
+      this->Current++;
+  }
+
+  bool Literal(const char *word) {
+    const char *p = this->Current;
+    for (; *word; word++, p++)
+      if (p == this->End || *p != *word)
+        return this->Fail("invalid literal");
+    this->Current = p;
+    return true;
+  }
+
+  bool ParseValue(jsonValue &value, int depth) {
+    if (depth > MaxDepth)
+      return this->Fail("nesting too deep");
+    if (this->Current == this->End)
+      return this->Fail("unexpected end");
+
+    switch (*this->Current) {
+    case '{':
+      return this->ParseObject(value, depth);
+    case '[':
+      return this->ParseArray(value, depth);
+    case '"':
+      value.ValueType = jsonValue::Type::String;
+      return this->ParseString(value.Text);
+    case 't':
+      value.ValueType = jsonValue::Type::Bool;
+      value.Boolean = true;
+      return this->Literal("true");
+    case 'f':
+      value.ValueType = jsonValue::Type::Bool;
+      value.Boolean = false;
+      return this->Literal("false");
+    case 'n':
+      value.ValueType = jsonValue::Type::Null;
+      return this->Literal("null");
+    default:
+      return this->ParseNumber(value);
+    }
+  }
+
+  bool ParseObject(jsonValue &value, int depth) {
+    value.ValueType = jsonValue::Type::Object;
+    this->Current++; // {
+    this->SkipWhitespace();
+    if (this->Current != this->End && *this->Current == '}') {
+      this->Current++;
+      return true;
+    }
+    for (;;) {
+      this->SkipWhitespace();
+      if (this->Current == this->End || *this->Current != '"')
+        return this->Fail("expected member name");
+      value.ObjectMembers.emplace_back();
+      auto &member = value.ObjectMembers.back();
+      if (!this->ParseString(member.first))
+        return false;
+      this->SkipWhitespace();
+      if (this->Current == this->End || *this->Current != ':')
+        return this->Fail("expected ':'");
+      this->Current++;
+      this->SkipWhitespace();
+      if (!this->ParseValue(member.second, depth + 1))
+        return false;
+      this->SkipWhitespace();
+      if (this->Current == this->End)
+        return this->Fail("unterminated object");
+      if (*this->Current == '}') {
+        this->Current++;
+        return true;
+      }
+      if (*this->Current != ',')
+        return this->Fail("expected ',' or '}'");
+      this->Current++;
+    }
+  }
+
+  bool ParseArray(jsonValue &value, int depth) {
+    value.ValueType = jsonValue::Type::Array;
+    this->Current++; // [
+    this->SkipWhitespace();
+    if (this->Current != this->End && *this->Current == ']') {
+      this->Current++;
+      return true;
+    }
+    for (;;) {
+      this->SkipWhitespace();
+      value.Elements.emplace_back();
+      if (!this->ParseValue(value.Elements.back(), depth + 1))
+        return false;
+      this->SkipWhitespace();
+      if (this->Current == this->End)
+        return this->Fail("unterminated array");
+      if (*this->Current == ']') {
+        this->Current++;
+        return true;
+      }
+      if (*this->Current != ',')
+        return this->Fail("expected ',' or ']'");
+      this->Current++;
+    }
+  }
+
+  bool ParseHex4(std::uint32_t &code) {
+    if (this->End - this->Current < 4)
+      return this->Fail("truncated escape");
+    code = 0;
+    for (int i = 0; i < 4; i++) {
+      char c = *this->Current++;
+      code <<= 4;
+      if (c >= '0' && c <= '9')
+        code |= c - '0';
+      else if (c >= 'a' && c <= 'f')
+        code |= c - 'a' + 10;
+      else if (c >= 'A' && c <= 'F')
+        code |= c - 'A' + 10;
+      else
+        return this->Fail("invalid escape");
+    }
+    return true;
+  }
+
+  static void AppendUtf8(std::string &out, std::uint32_t code) {
+    if (code < 0x80) {
+      out += char(code);
+    } else if (code < 0x800) {
+      out += char(0xC0 | (code >> 6));
+      out += char(0x80 | (code & 0x3F));
+    } else if (code < 0x10000) {
+      out += char(0xE0 | (code >> 12));
+      out += char(0x80 | ((code >> 6) & 0x3F));
+      out += char(0x80 | (code & 0x3F));
+    } else {
+      out += char(0xF0 | (code >> 18));
+      out += char(0x80 | ((code >> 12) & 0x3F));
+      out += char(0x80 | ((code >> 6) & 0x3F));
+      out += char(0x80 | (code & 0x3F));
+    }
+  }
+
+  bool ParseString(std::string &out) {
+    this->Current++; // "
+    for (;;) {
+      // copy unescaped runs in one go
+      const char *run = this->Current;
+      while (this->Current != this->End && *this->Current != '"' &&
+             *this->Current != '\\')
+        this->Current++;
+      out.append(run, this->Current);
+      if (this->Current == this->End)
+        return this->Fail("unterminated string");
+      if (*this->Current++ == '"')
+        return true;
+
+      if (this->Current == this->End)
+        return this->Fail("unterminated string");
+      char escape = *this->Current++;
+      switch (escape) {
+      case '"': out += '"'; break;
+      case '\\': out += '\\'; break;
+      case '/': out += '/'; break;
+      case 'b': out += '\b'; break;
+      case 'f': out += '\f'; break;
+      case 'n': out += '\n'; break;
+      case 'r': out += '\r'; break;
+      case 't': out += '\t'; break;
+      case 'u': {
+        std::uint32_t code;
+        if (!this->ParseHex4(code))
+          return false;
+        // surrogate pair
+        if (code >= 0xD800 && code < 0xDC00 && this->End - this->Current >= 6 &&
+            this->Current[0] == '\\' && this->Current[1] == 'u') {
+          this->Current += 2;
+          std::uint32_t low;
+          if (!this->ParseHex4(low))
+            return false;
+          if (low < 0xDC00 || low >= 0xE000)
+            return this->Fail("invalid surrogate pair");
+          code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+        }
+        AppendUtf8(out, code);
+        break;
+      }
+      default:
+        return this->Fail("invalid escape");
+      }
+    }
+  }
+
+  bool ParseNumber(jsonValue &value) {
+    value.ValueType = jsonValue::Type::Number;
+    auto result = std::from_chars(this->Current, this->End, value.Number);
+    if (result.ec != std::errc() || !std::isfinite(value.Number))
+      return this->Fail("invalid number");
+    this->Current = result.ptr;
+    return true;
+  }
+
+  const char *Begin;
+  const char *Current;
+  const char *End;
+  std::string Error;
+};
+
+bool ParseJson(const char *begin, const char *end, jsonValue &root,
+               std::string &error) {
+  root = jsonValue();
+  jsonParser parser(begin, end);
+  return parser.Parse(root, error);
+}
+
+} // namespace MeshLoader
@@ -0,0 +1,65 @@
+#ifndef MESHLOADER_JSON_H
+#define MESHLOADER_JSON_H
+
+#include <cstddef>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace MeshLoader {
+
+// Small JSON document, enough for glTF. Lookups of missing members or
+// elements return a shared null value, so chains such as
+// root["meshes"][0]["name"] need no checks in between.
+class jsonValue {
+public:
+  enum class Type { Null, Bool, Number, String, Array, Object };
+
+  Type GetType() const { return this->ValueType; }
+  bool IsNull() const { return this->ValueType == Type::Null; }
+  bool IsNumber() const { return this->ValueType == Type::Number; }
+  bool IsString() const { return this->ValueType == Type::String; }
+  bool IsArray() const { return this->ValueType == Type::Array; }
+  bool IsObject() const { return this->ValueType == Type::Object; }
+
+  // Object member; null if this is not an object or has no such member.
+  const jsonValue &operator[](const std::string &key) const;
+  // Array element; null if this is not an array or the index is past its end.
+  const jsonValue &operator[](std::size_t index) const;
+  bool Has(const std::string &key) const { return !(*this)[key].IsNull(); }
+  // Elements of an array or members of an object.
+  std::size_t Size() const;
+
+  double AsNumber(double fallback = 0.0) const;
+  // The fallback too for numbers that are not integers or do not fit.
+  int AsInt(int fallback = 0) const;
+  // Sizes, offsets and counts from the file. Sets `size` to the fallback
+  // for null and returns false for anything but a non-negative integer up
+  // to 2^53, where doubles stop being exact.
+  bool AsSize(std::size_t &size, std::size_t fallback = 0) const;
+  bool AsBool(bool fallback = false) const;
+  // Empty if this is not a string.
+  const std::string &AsString() const { return this->Text; }
+  const std::vector<std::pair<std::string, jsonValue>> &Members() const {
+    return this->ObjectMembers;
+  }
+
+private:
+  friend class jsonParser;
+
+  Type ValueType = Type::Null;
+  bool Boolean = false;
+  double Number = 0.0;
+  std::string Text;
+  std::vector<jsonValue> Elements;
+  std::vector<std::pair<std::string, jsonValue>> ObjectMembers;
+};
+
+// Parses UTF-8 text. Returns false with `error` set, and the byte offset in
+// it, when the text is not valid JSON.
+extern bool ParseJson(const char *begin, const char *end, jsonValue &root,
+                      std::string &error);
+
+} // namespace MeshLoader
+
+#endif
@@ -0,0 +1,497 @@
+#include "MeshLoader.h"
+#include "IndexBuffer.h"
+#include "JobSystem.h"
+#include "MappedFile.h"
+#include "MeshAttributes.h"
+#include "ParallelFor.h"
+#include "VertexBuffer.h"
+#include "VertexBufferLayout.h"
+
+#include <tiny_obj_loader.h>
+
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <climits>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <unordered_map>
+
+namespace MeshLoader {
+
+namespace {
+
+constexpr int MissingIndex = INT_MIN;
+
+// Attribute indices of one face corner into the file-wide arrays. OBJ's
+// negative (relative) indices are first stored relative to the start of the
+// chunk, flagged in `relative`, until the chunk's offset into the file-wide
+// arrays is known. They may point into earlier chunks.
+struct corner {
+  enum { RelativePosition = 1, RelativeTcoords = 2, RelativeNormal = 4 };
+
+  int position;
+  int tcoords;
+  int normal;
+  int relative;
+
+  bool operator==(const corner &other) const {
+    return position == other.position && tcoords == other.tcoords &&
+           normal == other.normal;
+  }
+};
+
+struct cornerHash {
+  std::size_t operator()(const corner &c) const {
+    std::uint64_t hash = std::uint32_t(c.position) * 0x9E3779B97F4A7C15ull;
+    hash ^= std::uint32_t(c.tcoords) + 0x9E3779B9u + (hash << 6) + (hash >> 2);
+    hash ^= std::uint32_t(c.normal) + 0x9E3779B9u + (hash << 6) + (hash >> 2);
+    return std::size_t(hash);
+  }
+};
+
+// Material selected by usemtl from `firstTriangle` of the chunk on.
+struct materialRun {
+  std::size_t firstTriangle;
+  std::string name;
+};
+
+struct parsedChunk {
+  std::vector<float> positions; // 3 per vertex
+  std::vector<float> tcoords;   // 2 per vertex
+  std::vector<float> normals;   // 3 per vertex
+  std::vector<corner> corners;  // 3 per triangle
+  std::vector<materialRun> materials;
+  std::vector<std::string> libraries;
+  std::string error;
+};
+
+// ==== line parsing ====
+
+const char *SkipSpaces(const char *p, const char *end) {
+  while (p < end && (*p == ' ' || *p == '\t'))
+    p++;
+  return p;
+}
+
+bool ParseFloat(const char *&p, const char *end, float &value) {
+  p = SkipSpaces(p, end);
+  if (p < end && *p == '+')
+    p++;
+  auto result = std::from_chars(p, end, value);
+  if (result.ec != std::errc())
+    return false;
+  p = result.ptr;
+  return true;
+}
+
+bool ParseInt(const char *&p, const char *end, int &value) {
+  if (p < end && *p == '+')
+    p++;
+  auto result = std::from_chars(p, end, value);
+  if (result.ec != std::errc())
+    return false;
+  p = result.ptr;
+  return true;
+}
+
+// Turns a 1-based or negative OBJ index into a corner index, given how many
+// elements the chunk has defined so far.
+bool ResolveIndex(int raw, std::size_t stride, std::size_t localSize,
+                  int &index, int &relative, int flag) {
+  if (raw > 0) {
+    index = raw - 1;
+    return true;
+  }
+  if (raw == 0)
+    return false;
+  index = static_cast<int>(localSize / stride) + raw;
+  relative |= flag;
+  return true;
+}
+
+// "v", "v/vt", "v//vn" or "v/vt/vn"
+bool ParseCorner(const char *&p, const char *end, const parsedChunk &chunk,
+                 corner &c) {
+  int raw;
+  c.tcoords = c.normal = MissingIndex;
+  c.relative = 0;
+  if (!ParseInt(p, end, raw) ||
+      !ResolveIndex(raw, 3, chunk.positions.size(), c.position, c.relative,
+                    corner::RelativePosition))
+    return false;
+  if (p < end && *p == '/') {
+    p++;
+    if (p < end && *p != '/') {
+      if (!ParseInt(p, end, raw) ||
+          !ResolveIndex(raw, 2, chunk.tcoords.size(), c.tcoords, c.relative,
+                        corner::RelativeTcoords))
+        return false;
+    }
+    if (p < end && *p == '/') {
+      p++;
+      if (!ParseInt(p, end, raw) ||
+          !ResolveIndex(raw, 3, chunk.normals.size(), c.normal, c.relative,
+                        corner::RelativeNormal))
+        return false;
+    }
+  }
+  return true;
+}
+
+bool StartsWith(const char *p, const char *end, const char *keyword) {
+  std::size_t length = std::strlen(keyword);
+  return std::size_t(end - p) > length && !std::memcmp(p, keyword, length) &&
+         (p[length] == ' ' || p[length] == '\t');
+}
+
+std::string RestOfLine(const char *p, const char *end) {
+  p = SkipSpaces(p, end);
+  while (end > p && (end[-1] == ' ' || end[-1] == '\t'))
+    end--;
+  return std::string(p, end);
+}
+
+void ParseChunk(const char *begin, const char *end, parsedChunk &chunk) {
+  std::vector<corner> face;
+  for (const char *line = begin; line < end;) {
+    const char *lineEnd =
+        static_cast<const char *>(std::memchr(line, '\n', end - line));
+    if (!lineEnd)
+      lineEnd = end;
+    const char *next = lineEnd + (lineEnd < end ? 1 : 0);
+    if (lineEnd > line && lineEnd[-1] == '\r')
+      lineEnd--;
+
+    const char *p = SkipSpaces(line, lineEnd);
+    bool valid = true;
+    float values[3];
+
+    if (StartsWith(p, lineEnd, "v")) {
+      p += 1;
+      for (int k = 0; k < 3 && valid; k++)
+        valid = ParseFloat(p, lineEnd, values[k]);
+      chunk.positions.insert(chunk.positions.end(), values, values + 3);
+    } else if (StartsWith(p, lineEnd, "vt")) {
+      p += 2;
+      valid = ParseFloat(p, lineEnd, values[0]);
+      if (!ParseFloat(p, lineEnd, values[1]))
+        values[1] = 0.f;
+      chunk.tcoords.insert(chunk.tcoords.end(), values, values + 2);
+    } else if (StartsWith(p, lineEnd, "vn")) {
+      p += 2;
+      for (int k = 0; k < 3 && valid; k++)
+        valid = ParseFloat(p, lineEnd, values[k]);
+      chunk.normals.insert(chunk.normals.end(), values, values + 3);
+    } else if (StartsWith(p, lineEnd, "f")) {
+      p += 1;
+      face.clear();
+      for (p = SkipSpaces(p, lineEnd); valid && p < lineEnd;
+           p = SkipSpaces(p, lineEnd)) {
+        corner c;
+        valid = ParseCorner(p, lineEnd, chunk, c);
+        face.push_back(c);
+      }
+      valid = valid && face.size() >= 3;
+      // fan triangulation
+      for (std::size_t i = 1; valid && i + 1 < face.size(); i++) {
+        chunk.corners.push_back(face[0]);
+        chunk.corners.push_back(face[i]);
+        chunk.corners.push_back(face[i + 1]);
+      }
+    } else if (StartsWith(p, lineEnd, "usemtl")) {
+      chunk.materials.push_back(
+          {chunk.corners.size() / 3, RestOfLine(p + 6, lineEnd)});
+    } else if (StartsWith(p, lineEnd, "mtllib")) {
+      chunk.libraries.push_back(RestOfLine(p + 6, lineEnd));
+    }
+
+    if (!valid) {
+      chunk.error = "malformed line '" + std::string(line, lineEnd) + "'";
+      return;
+    }
+    line = next;
+  }
+}
+
+// ==== materials ====
+
+void LoadMaterialLibraries(const std::vector<parsedChunk> &chunks,
+                           const std::string &directory,
+                           std::vector<tinyobj::material_t> &materials,
+                           std::map<std::string, int> &materialIds) {
+  std::vector<std::string> loaded;
+  for (const auto &chunk : chunks)
+    for (const auto &library : chunk.libraries) {
+      if (std::find(loaded.begin(), loaded.end(), library) != loaded.end())
+        continue;
+      loaded.push_back(library);
+
+      std::ifstream stream(directory + library);
+      if (!stream) {
+        std::cerr << "Material library " << directory + library
+                  << " not found" << std::endl;
+        continue;
+      }
+      std::string warning, error;
+      tinyobj::LoadMtl(&materialIds, &materials, &stream, &warning, &error);
+      if (!error.empty())
+        std::cerr << error << std::endl;
+    }
+}
+
+material ToMaterial(const std::string &name,
+                    const std::vector<tinyobj::material_t> &materials,
+                    const std::map<std::string, int> &materialIds) {
+  material result;
+  result.name = name;
+  auto found = materialIds.find(name);
+  if (found != materialIds.end()) {
+    const auto &source = materials[found->second];
+    result.diffuse =
+        glm::vec3(source.diffuse[0], source.diffuse[1], source.diffuse[2]);
+    result.diffuseTexture = source.diffuse_texname;
+  }
+  return result;
+}
+
+// Triangles [begin, end) of one chunk that use the same material.
+struct triangleRange {
+  std::size_t chunk;
+  std::size_t begin;
+  std::size_t end;
+};
+
+} // namespace
+
+bool LoadObjParts(const std::string &filePath, std::vector<meshPart> &parts,
+                  std::string &error, unsigned threads, loadStats *stats) {
+  using clock = std::chrono::steady_clock;
+  auto start = clock::now();
+  parts.clear();
+
+  MappedFile file(filePath);
+  if (!file.IsOpen()) {
+    error = "cannot open " + filePath;
+    return false;
+  }
+  const char *data = reinterpret_cast<const char *>(file.GetData());
+  const char *dataEnd = data + file.GetSize();
+
+  // ==== parse line-aligned chunks in parallel ====
+  // chunks of at least 1 MiB, so small files stay on one thread
+  threads = GeometricTools::detail::ResolveThreadCount(
+      threads, std::max<std::size_t>(file.GetSize() >> 20, 1));
+  std::vector<parsedChunk> chunks(threads);
+  std::vector<const char *> bounds(threads + 1, dataEnd);
+  bounds[0] = data;
+  for (unsigned i = 1; i < threads; i++) {
+    const char *p = std::max(bounds[i - 1], data + file.GetSize() / threads * i);
+    const char *newline =
+        static_cast<const char *>(std::memchr(p, '\n', dataEnd - p));
+    bounds[i] = newline ? newline + 1 : dataEnd;
+  }
+
+  JobSystem *jobSystem = JobSystem::GetInstance();
+  // one job per chunk
+  jobSystem->ParallelFor(threads, 1, [&](std::size_t begin, std::size_t end) {
+    for (std::size_t i = begin; i < end; i++)
+      ParseChunk(bounds[i], bounds[i + 1], chunks[i]);
+  });
+  for (const auto &chunk : chunks)
+    if (!chunk.error.empty()) {
+      error = filePath + ": " + chunk.error;
+      return false;
+    }
+  auto parsed = clock::now();
+
+  // ==== concatenate attributes and resolve chunk-relative indices ====
+  std::vector<float> positions, tcoords, normals;
+  std::vector<int> positionBase(threads), tcoordsBase(threads),
+      normalBase(threads);
+  for (unsigned i = 0; i < threads; i++) {
+    positionBase[i] = int(positions.size() / 3);
+    tcoordsBase[i] = int(tcoords.size() / 2);
+    normalBase[i] = int(normals.size() / 3);
+    positions.insert(positions.end(), chunks[i].positions.begin(),
+                     chunks[i].positions.end());
+    tcoords.insert(tcoords.end(), chunks[i].tcoords.begin(),
+                   chunks[i].tcoords.end());
+    normals.insert(normals.end(), chunks[i].normals.begin(),
+                   chunks[i].normals.end());
+  }
+
+  std::vector<char> rangeErrors(threads, 0);
+  jobSystem->ParallelFor(threads, 1, [&](std::size_t begin, std::size_t end) {
+    auto resolve = [](int &index, bool relative, int base, std::size_t count) {
+      if (index == MissingIndex)
+        return true;
+      if (relative)
+        index += base;
+      return index >= 0 && std::size_t(index) < count;
+    };
+    for (std::size_t i = begin; i < end; i++)
+      for (auto &c : chunks[i].corners) {
+        if (!resolve(c.position, c.relative & corner::RelativePosition,
+                     positionBase[i], positions.size() / 3) ||
+            !resolve(c.tcoords, c.relative & corner::RelativeTcoords,
+                     tcoordsBase[i], tcoords.size() / 2) ||
+            !resolve(c.normal, c.relative & corner::RelativeNormal,
+                     normalBase[i], normals.size() / 3))
+          rangeErrors[i] = 1;
+        c.relative = 0;
+      }
+  });
+  if (std::find(rangeErrors.begin(), rangeErrors.end(), 1) !=
+      rangeErrors.end()) {
+    error = filePath + ": face index out of range";
+    return false;
+  }
+
+  // ==== group triangles by material, in file order ====
+  std::vector<tinyobj::material_t> libraryMaterials;
+  std::map<std::string, int> libraryIds;
+  std::string directory = filePath.substr(0, filePath.find_last_of("/\\") + 1);
+  LoadMaterialLibraries(chunks, directory, libraryMaterials, libraryIds);
+
+  std::vector<std::string> materialNames;
+  std::unordered_map<std::string, std::size_t> materialIndices;
+  std::vector<std::vector<triangleRange>> materialRanges;
+  auto addRange = [&](const std::string &name, std::size_t chunk,
+                      std::size_t begin, std::size_t end) {
+    if (begin == end)
+      return;
+    auto found = materialIndices.find(name);
+    if (found == materialIndices.end()) {
+      found = materialIndices.emplace(name, materialNames.size()).first;
+      materialNames.push_back(name);
+      materialRanges.emplace_back();
+    }
+    materialRanges[found->second].push_back({chunk, begin, end});
+  };
+
+  std::string current;
+  std::size_t cornerCount = 0;
+  for (std::size_t i = 0; i < chunks.size(); i++) {
+    std::size_t triangle = 0;
+    for (const auto &run : chunks[i].materials) {
+      addRange(current, i, triangle, run.firstTriangle);
+      current = run.name;
+      triangle = run.firstTriangle;
+    }
+    addRange(current, i, triangle, chunks[i].corners.size() / 3);
+    cornerCount += chunks[i].corners.size();
+  }
+
+  // ==== deduplicate every material's corners into an indexed mesh ====
+  const std::size_t stride = GeometricTools::GridVertexStride;
+  parts.resize(materialNames.size());
+  std::vector<char> generateNormals(parts.size(), 0);
+  // one job per material
+  jobSystem->ParallelFor(
+      parts.size(), 1, [&](std::size_t begin, std::size_t end) {
+        for (std::size_t m = begin; m < end; m++) {
+          meshPart &part = parts[m];
+          part.surface =
+              ToMaterial(materialNames[m], libraryMaterials, libraryIds);
+
+          std::size_t triangles = 0;
+          for (const auto &range : materialRanges[m])
+            triangles += range.end - range.begin;
+
+          std::unordered_map<corner, GLuint, cornerHash> unique;
+          unique.reserve(triangles * 3 / 2);
+          part.shape.indices.reserve(triangles * 3);
+
+          for (const auto &range : materialRanges[m]) {
+            const auto &corners = chunks[range.chunk].corners;
+            for (std::size_t c = range.begin * 3; c < range.end * 3; c++) {
+              const corner &key = corners[c];
+              GLuint next = GLuint(part.shape.vertices.size() / stride);
+              auto inserted = unique.emplace(key, next);
+              part.shape.indices.push_back(inserted.first->second);
+              if (!inserted.second)
+                continue;
+
+              auto &vertices = part.shape.vertices;
+              const float *p = &positions[std::size_t(key.position) * 3];
+              vertices.insert(vertices.end(), p, p + 3);
+              if (key.tcoords != MissingIndex) {
+                const float *t = &tcoords[std::size_t(key.tcoords) * 2];
+                vertices.insert(vertices.end(), t, t + 2);
+              } else
+                vertices.insert(vertices.end(), {0.f, 0.f});
+              if (key.normal != MissingIndex) {
+                const float *n = &normals[std::size_t(key.normal) * 3];
+                vertices.insert(vertices.end(), n, n + 3);
+              } else {
+                vertices.insert(vertices.end(), {0.f, 0.f, 0.f});
+                generateNormals[m] = 1;
+              }
+            }
+          }
+        }
+      });
+
+  // parts missing any normal get all of theirs generated
+  std::size_t vertexCount = 0, triangleCount = 0;
+  for (std::size_t m = 0; m < parts.size(); m++) {
+    if (generateNormals[m])
+      GeometricTools::GenerateNormals(parts[m].shape,
+                                      GeometricTools::NormalWeighting::Angle,
+                                      threads);
+    vertexCount += parts[m].shape.vertices.size() / stride;
+    triangleCount += parts[m].shape.indices.size() / 3;
+  }
+
+  if (stats) {
+    auto built = clock::now();
+    stats->vertexCount = vertexCount;
+    stats->triangleCount = triangleCount;
+    stats->cornerCount = cornerCount;
+    stats->threads = threads;
+    stats->parseMilliseconds =
+        std::chrono::duration<double, std::milli>(parsed - start).count();
+    stats->buildMilliseconds =
+        std::chrono::duration<double, std::milli>(built - parsed).count();
+  }
+  return true;
+}
+
+std::vector<mesh> UploadParts(const std::vector<meshPart> &parts) {
+  std::vector<mesh> meshes;
+  for (const auto &part : parts) {
+    auto vertexBuffer = std::make_shared<VertexBuffer>(
+        part.shape.vertices.data(),
+        part.shape.vertices.size() * sizeof(GLfloat));
+    vertexBuffer->SetLayout(BufferLayout({{ShaderDataType::Float3, "position"},
+                                          {ShaderDataType::Float2, "tcoords"},
+                                          {ShaderDataType::Float3, "normal"}}));
+
+    mesh result;
+    result.surface = part.surface;
+    result.triangleCount = part.shape.indices.size() / 3;
+    result.vertexArray = std::make_shared<VertexArray>();
+    result.vertexArray->AddVertexBuffer(vertexBuffer);
+    result.vertexArray->SetIndexBuffer(std::make_shared<IndexBuffer>(
+        part.shape.indices.data(), part.shape.indices.size()));
+    result.vertexArray->Unbind();
+    meshes.push_back(result);
+  }
+  return meshes;
+}
+
+std::vector<mesh> LoadObj(const std::string &filePath, unsigned threads,
+                          loadStats *stats) {
+  std::vector<meshPart> parts;
+  std::string error;
+  if (!LoadObjParts(filePath, parts, error, threads, stats)) {
+    std::cerr << "Failed to load mesh: " << error << std::endl;
+    return {};
+  }
+  return UploadParts(parts);
+}
+
+} // namespace MeshLoader
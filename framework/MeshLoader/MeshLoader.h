@@ -0,0 +1,70 @@
+#ifndef MESHLOADER_H
+#define MESHLOADER_H
+
+#include "GeometricTools.h"
+#include "VertexArray.h"
+
+#include <glm/glm.hpp>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+// Wavefront OBJ loading into indexed meshes, one per material.
+//
+// The file is memory mapped and cut into line-aligned chunks that are parsed
+// on separate threads. Face corners are then resolved against the global
+// attribute arrays, grouped by material and deduplicated per material with a
+// hash map, so shared vertices are stored once. Vertices use the
+// position(3) tcoords(2) normal(3) layout of GeometricTools.
+namespace MeshLoader {
+
+struct material {
+  std::string name;
+  glm::vec3 diffuse = glm::vec3(1.f);
+  std::string diffuseTexture; // map_Kd, relative to the OBJ file
+};
+
+// CPU side result: one indexed triangle mesh per material.
+struct meshPart {
+  material surface;
+  GeometricTools::unitShape shape;
+};
+
+// GPU side result, ready for RenderCommands::DrawIndex.
+struct mesh {
+  material surface;
+  std::shared_ptr<VertexArray> vertexArray;
+  std::size_t triangleCount = 0;
+};
+
+struct loadStats {
+  std::size_t vertexCount = 0;   // after deduplication
+  std::size_t triangleCount = 0;
+  std::size_t cornerCount = 0;   // vertices before deduplication
+  unsigned threads = 0;
+  double parseMilliseconds = 0.0;
+  double buildMilliseconds = 0.0; // resolving, deduplication and normals
+};
+
+// Parses the file into per-material meshes. Faces with more than three
+// corners are fanned into triangles, and parts without normals in the file
+// get generated ones. `threads` 0 uses every hardware thread. Does not touch
+// OpenGL, so it can run on any thread. Returns false with `error` set when
+// the file cannot be read or is malformed.
+extern bool LoadObjParts(const std::string &filePath,
+                         std::vector<meshPart> &parts, std::string &error,
+                         unsigned threads = 0, loadStats *stats = nullptr);
+
+// Uploads parts into vertex arrays. Needs the GL context.
+extern std::vector<mesh> UploadParts(const std::vector<meshPart> &parts);
+
+// LoadObjParts() followed by UploadParts(). Empty on failure, after
+// reporting the error on std::cerr.
+extern std::vector<mesh> LoadObj(const std::string &filePath,
+                                 unsigned threads = 0,
+                                 loadStats *stats = nullptr);
+
+} // namespace MeshLoader
+
+#endif
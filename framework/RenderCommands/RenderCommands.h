@@ -23,6 +23,13 @@ namespace RenderCommands
     glDrawElements(primitive, vao->GetIndexBuffer()->GetCount(), GL_UNSIGNED_INT, nullptr);
   }
 
+  inline void DrawIndexInstanced(const std::shared_ptr<VertexArray>& vao, GLsizei instances,
+                                 GLenum primitive = GL_TRIANGLES)
+  {
+    glDrawElementsInstanced(primitive, vao->GetIndexBuffer()->GetCount(), GL_UNSIGNED_INT, nullptr,
+                            instances);
+  }
+
   inline void SetClearColor(glm::vec3 color){
 	glClearColor(color.x, color.y, color.z, 1.0f);
   }
@@ -35,6 +42,35 @@ namespace RenderCommands
 	  glPolygonMode(face, GL_FILL);
   }	
 
+  // Restarts strips at the maximum index value (0xFFFFFFFF for GL_UNSIGNED_INT),
+  // which is what GeometricTools::PrimitiveRestartIndex writes.
+  inline void EnablePrimitiveRestart(){
+	  glEnable(GL_PRIMITIVE_RESTART_FIXED_INDEX);
+  }
+
+  inline void DisablePrimitiveRestart(){
+	  glDisable(GL_PRIMITIVE_RESTART_FIXED_INDEX);
+  }
+
+  // Depth state for reverse-Z (PerspectiveCamera::DepthMode::ReverseZInfinite):
+  // 0..1 clip space depth, cleared to 0, nearer is greater. Needs OpenGL 4.5
+  // for glClipControl; returns false and changes nothing without it.
+  inline bool EnableReverseDepth(){
+	  if (!GLAD_GL_VERSION_4_5)
+		  return false;
+	  glClipControl(GL_LOWER_LEFT, GL_ZERO_TO_ONE);
+	  glClearDepth(0.0);
+	  glDepthFunc(GL_GREATER);
+	  return true;
+  }
+
+  inline void DisableReverseDepth(){
+	  if (GLAD_GL_VERSION_4_5)
+		  glClipControl(GL_LOWER_LEFT, GL_NEGATIVE_ONE_TO_ONE);
+	  glClearDepth(1.0);
+	  glDepthFunc(GL_LESS);
+  }
+
 
 }
 
@@ -0,0 +1,347 @@
+#include "AssetWatcher.h"
+#include "Shader.h"
+#include "VirtualFileSystem.h"
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <unordered_set>
+
+#ifdef __linux__
+#include <cerrno>
+#include <cstdint>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+namespace fs = std::filesystem;
+
+namespace {
+
+// The file on disk behind a resource path, in the form the watcher thread
+// builds from inotify events.
+bool ResolveFile(const std::string &path, std::string &filePath) {
+  VirtualFileSystem *fileSystem = VirtualFileSystem::GetInstance();
+  std::string file = path;
+  if (fileSystem->HasMounts() && !fileSystem->ResolveLoosePath(path, file))
+    return false;
+
+  std::error_code error;
+  if (!fs::is_regular_file(file, error))
+    return false;
+  fs::path canonical = fs::weakly_canonical(file, error);
+  if (error)
+    return false;
+  filePath = canonical.string();
+  return true;
+}
+
+bool ReadSource(const std::string &path, std::string &source) {
+  VirtualFileSystem *fileSystem = VirtualFileSystem::GetInstance();
+  if (fileSystem->HasMounts()) {
+    VirtualFile file = fileSystem->Open(path);
+    if (!file)
+      return false;
+    source.assign(reinterpret_cast<const char *>(file.GetData()), file.GetSize());
+    return true;
+  }
+
+  std::ifstream stream(path, std::ios::binary);
+  if (!stream)
+    return false;
+  source.assign(std::istreambuf_iterator<char>(stream),
+                std::istreambuf_iterator<char>());
+  return true;
+}
+
+} // namespace
+
+bool AssetWatcher::Start() {
+#ifdef __linux__
+  if (this->IsRunning())
+    return true;
+
+  this->NotifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+  this->WakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  if (this->NotifyFd < 0 || this->WakeFd < 0) {
+    std::cerr << "Failed to start the asset watcher" << std::endl;
+    this->Stop();
+    return false;
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(this->AssetMutex);
+    for (const auto &asset : this->Assets)
+      this->WatchDirectories(asset.second.files);
+  }
+  this->Thread = std::thread(&AssetWatcher::WatchLoop, this);
+  return true;
+#else
+  std::cerr << "Asset hot reloading is only supported on Linux" << std::endl;
+  return false;
+#endif
+}
+
+void AssetWatcher::Stop() {
+#ifdef __linux__
+  if (this->Thread.joinable()) {
+    std::uint64_t wake = 1;
+    if (write(this->WakeFd, &wake, sizeof(wake)) < 0)
+      std::cerr << "Failed to wake the asset watcher" << std::endl;
+    this->Thread.join();
+  }
+  if (this->NotifyFd >= 0)
+    close(this->NotifyFd);
+  if (this->WakeFd >= 0)
+    close(this->WakeFd);
+#endif
+  this->NotifyFd = this->WakeFd = -1;
+
+  std::lock_guard<std::mutex> lock(this->AssetMutex);
+  this->Directories.clear();
+}
+
+AssetWatcher::~AssetWatcher() { this->Stop(); }
+
+AssetWatcher::AssetId AssetWatcher::Watch(const std::vector<std::string> &files,
+                                          Reimport reimport) {
+  std::vector<std::string> resolved;
+  for (const auto &path : files) {
+    std::string file;
+    if (ResolveFile(path, file) &&
+        std::find(resolved.begin(), resolved.end(), file) == resolved.end())
+      resolved.push_back(file);
+  }
+  if (resolved.empty() || !reimport)
+    return InvalidAsset;
+
+  std::lock_guard<std::mutex> lock(this->AssetMutex);
+  AssetId asset = this->NextAsset++;
+  for (const auto &file : resolved)
+    this->Dependents[file].push_back(asset);
+  if (this->NotifyFd >= 0)
+    this->WatchDirectories(resolved);
+  this->Assets[asset] = {std::move(resolved),
+                         std::make_shared<Reimport>(std::move(reimport))};
+  return asset;
+}
+
+void AssetWatcher::Unwatch(AssetId asset) {
+  {
+    std::lock_guard<std::mutex> lock(this->AssetMutex);
+    auto found = this->Assets.find(asset);
+    if (found == this->Assets.end())
+      return;
+    for (const auto &file : found->second.files) {
+      auto dependents = this->Dependents.find(file);
+      if (dependents == this->Dependents.end())
+        continue;
+      auto &ids = dependents->second;
+      ids.erase(std::remove(ids.begin(), ids.end(), asset), ids.end());
+      if (ids.empty())
+        this->Dependents.erase(dependents);
+    }
+    this->Assets.erase(found);
+  }
+
+  std::lock_guard<std::mutex> lock(this->ReadyMutex);
+  this->Ready.erase(std::remove_if(this->Ready.begin(), this->Ready.end(),
+                                   [asset](const std::pair<AssetId, Swap> &ready) {
+                                     return ready.first == asset;
+                                   }),
+                    this->Ready.end());
+}
+
+AssetWatcher::AssetId AssetWatcher::WatchTexture(TextureManager::TextureHandle handle) {
+  const TextureManager::Texture *texture =
+      TextureManager::GetInstance()->GetTexture(handle);
+  if (!texture)
+    return InvalidAsset;
+
+  std::vector<std::string> files;
+  if (!texture->filePath.empty())
+    files.push_back(texture->filePath);
+  for (const auto &source : texture->sources)
+    files.push_back(source.filePath);
+
+  if (texture->type != TextureManager::Texture2D || texture->compressed ||
+      texture->cooked)
+    return this->Watch(files, [handle]() -> Swap {
+      return [handle]() { TextureManager::GetInstance()->Reload(handle); };
+    });
+
+  std::string filePath = texture->filePath;
+  return this->Watch(files, [handle, filePath]() -> Swap {
+    int width, height, bpp;
+    unsigned char *data = TextureManager::GetInstance()->LoadTextureImage(
+        filePath, width, height, bpp, STBI_rgb_alpha);
+    if (!data)
+      return nullptr;
+    std::shared_ptr<unsigned char> pixels(data, [](unsigned char *pixels) {
+      TextureManager::GetInstance()->FreeTextureImage(pixels);
+    });
+    return [handle, pixels, width, height]() {
+      TextureManager::GetInstance()->Reload(handle, pixels.get(), width, height);
+    };
+  });
+}
+
+AssetWatcher::AssetId AssetWatcher::WatchShader(const std::shared_ptr<Shader> &shader,
+                                                const std::string &vertexPath,
+                                                const std::string &fragmentPath,
+                                                const std::string &elementName) {
+  std::weak_ptr<Shader> program = shader;
+  return this->Watch(
+      {vertexPath, fragmentPath},
+      [program, vertexPath, fragmentPath, elementName]() -> Swap {
+        std::string vertexSrc, fragmentSrc;
+        if (!ReadSource(vertexPath, vertexSrc) ||
+            !ReadSource(fragmentPath, fragmentSrc)) {
+          std::cerr << "Failed to read the sources of " << elementName << std::endl;
+          return nullptr;
+        }
+        return [program, vertexSrc, fragmentSrc, elementName]() {
+          if (auto shader = program.lock())
+            shader->Rebuild(vertexSrc, fragmentSrc, elementName);
+        };
+      });
+}
+
+std::size_t AssetWatcher::ApplyChanges() {
+  std::vector<std::pair<AssetId, Swap>> ready;
+  {
+    std::lock_guard<std::mutex> lock(this->ReadyMutex);
+    if (this->Ready.empty())
+      return 0;
+    ready.swap(this->Ready);
+  }
+
+  std::size_t applied = 0;
+  for (auto &change : ready) {
+    {
+      // reimports that finished after the asset was unwatched
+      std::lock_guard<std::mutex> lock(this->AssetMutex);
+      if (this->Assets.count(change.first) == 0)
+        continue;
+    }
+    change.second();
+    applied++;
+  }
+  return applied;
+}
+
+void AssetWatcher::WatchDirectories(const std::vector<std::string> &files) {
+#ifdef __linux__
+  for (const auto &file : files) {
+    std::string directory = fs::path(file).parent_path().string();
+    // watching a directory twice returns the same descriptor
+    int watch = inotify_add_watch(this->NotifyFd, directory.c_str(),
+                                  IN_CLOSE_WRITE | IN_MOVED_TO);
+    if (watch < 0) {
+      std::cerr << "Failed to watch " << directory << std::endl;
+      continue;
+    }
+    this->Directories[watch] = directory;
+  }
+#else
+  (void)files;
+#endif
+}
+
+void AssetWatcher::WatchLoop() {
+#ifdef __linux__
+  using Clock = std::chrono::steady_clock;
+  alignas(inotify_event) char buffer[16 * 1024];
+  std::unordered_set<std::string> changed;
+  Clock::time_point lastEvent;
+
+  for (;;) {
+    int timeout = -1;
+    if (!changed.empty()) {
+      auto settled = lastEvent + SettleTime - Clock::now();
+      timeout = int(std::max<std::chrono::milliseconds::rep>(
+          0, std::chrono::ceil<std::chrono::milliseconds>(settled).count()));
+    }
+
+    pollfd fds[2] = {{this->NotifyFd, POLLIN, 0}, {this->WakeFd, POLLIN, 0}};
+    int ready = poll(fds, 2, timeout);
+    if (ready < 0 && errno != EINTR) {
+      std::cerr << "The asset watcher stopped polling" << std::endl;
+      return;
+    }
+    if (ready > 0 && (fds[1].revents & POLLIN))
+      return;
+
+    if (ready > 0 && (fds[0].revents & POLLIN)) {
+      ssize_t length;
+      while ((length = read(this->NotifyFd, buffer, sizeof(buffer))) > 0) {
+        std::lock_guard<std::mutex> lock(this->AssetMutex);
+        for (char *next = buffer; next < buffer + length;) {
+          auto event = reinterpret_cast<const inotify_event *>(next);
+          next += sizeof(inotify_event) + event->len;
+          if (event->mask & IN_Q_OVERFLOW) {
+            // events were lost, so anything may have changed
+            for (const auto &dependents : this->Dependents)
+              changed.insert(dependents.first);
+            continue;
+          }
+          auto directory = this->Directories.find(event->wd);
+          if (event->len == 0 || directory == this->Directories.end())
+            continue;
+          std::string file = (fs::path(directory->second) / event->name).string();
+          if (this->Dependents.count(file))
+            changed.insert(file);
+        }
+      }
+      lastEvent = Clock::now();
+      continue;
+    }
+
+    // quiet for SettleTime, so the files are completely written
+    if (!changed.empty() && Clock::now() - lastEvent >= SettleTime) {
+      this->ReimportChanged({changed.begin(), changed.end()});
+      changed.clear();
+    }
+  }
+#endif
+}
+
+void AssetWatcher::ReimportChanged(const std::vector<std::string> &changedFiles) {
+  std::vector<std::pair<AssetId, std::shared_ptr<Reimport>>> reimports;
+  {
+    std::lock_guard<std::mutex> lock(this->AssetMutex);
+    for (const auto &file : changedFiles) {
+      auto dependents = this->Dependents.find(file);
+      if (dependents == this->Dependents.end())
+        continue;
+      for (AssetId asset : dependents->second) {
+        bool queued = std::any_of(
+            reimports.begin(), reimports.end(),
+            [asset](const auto &reimport) { return reimport.first == asset; });
+        if (!queued)
+          reimports.emplace_back(asset, this->Assets[asset].reimport);
+      }
+    }
+  }
+
+  for (const auto &reimport : reimports) {
+    Swap swap = (*reimport.second)();
+    if (!swap)
+      continue;
+
+    // a newer import replaces one that was not swapped in yet
+    std::lock_guard<std::mutex> lock(this->ReadyMutex);
+    auto pending = std::find_if(this->Ready.begin(), this->Ready.end(),
+                                [&](const std::pair<AssetId, Swap> &ready) {
+                                  return ready.first == reimport.first;
+                                });
+    if (pending != this->Ready.end())
+      pending->second = std::move(swap);
+    else
+      this->Ready.emplace_back(reimport.first, std::move(swap));
+  }
+}
@@ -0,0 +1,113 @@
+#ifndef ASSETWATCHER_H_
+#define ASSETWATCHER_H_
+
+#include "TextureManager.h"
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+class Shader;
+
+// Hot reloading of assets while the application runs. Every watched asset
+// names the source files it is built from; when one of them changes on
+// disk, only the assets depending on it are imported again.
+//
+// Changes are detected with inotify on Linux (the directories holding the
+// files are watched, so editors that save by renaming a new file over the
+// old one are seen too). A background thread waits for the burst of
+// events a save produces to settle and then runs the reimports, which do
+// the slow part such as decoding an image. What they produce is swapped in
+// by ApplyChanges(), called between frames on the thread that owns the GL
+// context, so nothing changes halfway through a frame.
+//
+// Only files that exist on disk can be watched; resources served from a
+// pack are skipped. Mount the source directory over the pack in
+// development builds to edit them.
+class AssetWatcher {
+public:
+  using AssetId = std::uint32_t;
+  // Runs on the GL thread.
+  using Swap = std::function<void()>;
+  // Runs on the watcher thread; returns the swap, or nothing on failure.
+  using Reimport = std::function<Swap()>;
+
+  static constexpr AssetId InvalidAsset = 0;
+  static constexpr std::chrono::milliseconds SettleTime{100};
+
+public:
+  static AssetWatcher *GetInstance() {
+    return AssetWatcher::Instance != nullptr
+               ? AssetWatcher::Instance
+               : AssetWatcher::Instance = new AssetWatcher();
+  }
+
+  // Starts the watcher thread. False where files cannot be watched.
+  bool Start();
+  void Stop();
+  bool IsRunning() const { return this->Thread.joinable(); }
+
+  // Calls `reimport` whenever one of `files` (resource paths, resolved
+  // through the VirtualFileSystem when anything is mounted) changes.
+  // InvalidAsset if none of them is a file on disk.
+  AssetId Watch(const std::vector<std::string> &files, Reimport reimport);
+  void Unwatch(AssetId asset);
+
+  // Plain 2D textures are decoded in the background and uploaded by the
+  // swap; the other kinds are read again by TextureManager::Reload().
+  AssetId WatchTexture(TextureManager::TextureHandle handle);
+  // Rebuilds the program from the two source files; a source that does not
+  // compile leaves the old program in place.
+  AssetId WatchShader(const std::shared_ptr<Shader> &shader,
+                      const std::string &vertexPath,
+                      const std::string &fragmentPath,
+                      const std::string &elementName);
+
+  // Swaps in everything reimported since the last call. Returns the number
+  // of assets that changed.
+  std::size_t ApplyChanges();
+
+private:
+  struct Asset {
+    std::vector<std::string> files;
+    std::shared_ptr<Reimport> reimport;
+  };
+
+private:
+  void WatchLoop();
+  // Adds inotify watches for the directories of `files`. Needs AssetMutex.
+  void WatchDirectories(const std::vector<std::string> &files);
+  void ReimportChanged(const std::vector<std::string> &changedFiles);
+
+private:
+  AssetWatcher() {}
+  ~AssetWatcher();
+  AssetWatcher(const AssetWatcher &) = delete;
+  void operator=(const AssetWatcher &) = delete;
+
+private:
+  inline static AssetWatcher *Instance = nullptr;
+
+  std::thread Thread;
+  int NotifyFd = -1;
+  int WakeFd = -1;
+
+  std::mutex AssetMutex;
+  AssetId NextAsset = 1;
+  std::unordered_map<AssetId, Asset> Assets;
+  // source file -> assets built from it
+  std::unordered_map<std::string, std::vector<AssetId>> Dependents;
+  // inotify watch descriptor -> directory
+  std::unordered_map<int, std::string> Directories;
+
+  std::mutex ReadyMutex;
+  std::vector<std::pair<AssetId, Swap>> Ready;
+};
+
+#endif // ASSETWATCHER_H_
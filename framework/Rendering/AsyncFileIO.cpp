@@ -0,0 +1,499 @@
+#include "AsyncFileIO.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <new>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#ifdef __linux__
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#endif
+
+namespace {
+
+// Submission queue size; the completion queue is twice as large.
+constexpr unsigned QueueDepth = 256;
+// Queued reads start on their own once this many are waiting.
+constexpr std::size_t BatchSize = 32;
+// Larger reads are split; the remainder is resubmitted like a short read.
+constexpr std::size_t MaxReadSize = std::size_t(1) << 30;
+constexpr std::size_t StagingAlignment = 4096;
+
+// Blocking read at an offset, for the fallback workers. -1 with errno set.
+long long PositionalRead(AsyncFileIO::FileHandle file, void *destination,
+                         std::size_t size, std::uint64_t offset) {
+  size = std::min(size, MaxReadSize);
+#ifdef _WIN32
+  OVERLAPPED overlapped = {};
+  overlapped.Offset = static_cast<DWORD>(offset);
+  overlapped.OffsetHigh = static_cast<DWORD>(offset >> 32);
+  DWORD read = 0;
+  if (!ReadFile(reinterpret_cast<HANDLE>(file), destination,
+                static_cast<DWORD>(size), &read, &overlapped)) {
+    if (GetLastError() == ERROR_HANDLE_EOF)
+      return 0;
+    errno = EIO;
+    return -1;
+  }
+  return read;
+#else
+  return pread(static_cast<int>(file), destination, size,
+               static_cast<off_t>(offset));
+#endif
+}
+
+} // namespace
+
+// ============================================================================
+// io_uring, through raw system calls
+// ============================================================================
+
+#ifdef __linux__
+
+struct AsyncFileIO::Uring {
+  int fd = -1;
+  unsigned entries = 0;
+  unsigned cqEntries = 0;
+  unsigned *sqHead, *sqTail, *sqMask, *sqArray;
+  unsigned *cqHead, *cqTail, *cqMask;
+  io_uring_sqe *sqes = nullptr;
+  io_uring_cqe *cqes = nullptr;
+  void *sqRing = MAP_FAILED, *cqRing = MAP_FAILED;
+  std::size_t sqRingSize = 0, cqRingSize = 0, sqesSize = 0;
+
+  bool Setup(unsigned depth) {
+    io_uring_params params;
+    std::memset(&params, 0, sizeof(params));
+    this->fd = static_cast<int>(syscall(__NR_io_uring_setup, depth, &params));
+    if (this->fd < 0)
+      return false;
+
+    this->entries = params.sq_entries;
+    this->cqEntries = params.cq_entries;
+    this->sqRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    this->cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+    bool singleMap = params.features & IORING_FEAT_SINGLE_MMAP;
+    if (singleMap)
+      this->sqRingSize = this->cqRingSize = std::max(this->sqRingSize, this->cqRingSize);
+
+    this->sqRing = mmap(nullptr, this->sqRingSize, PROT_READ | PROT_WRITE,
+                        MAP_SHARED | MAP_POPULATE, this->fd, IORING_OFF_SQ_RING);
+    if (this->sqRing == MAP_FAILED)
+      return false;
+    this->cqRing = singleMap ? this->sqRing
+                             : mmap(nullptr, this->cqRingSize, PROT_READ | PROT_WRITE,
+                                    MAP_SHARED | MAP_POPULATE, this->fd, IORING_OFF_CQ_RING);
+    if (this->cqRing == MAP_FAILED)
+      return false;
+    this->sqesSize = params.sq_entries * sizeof(io_uring_sqe);
+    void *sqes = mmap(nullptr, this->sqesSize, PROT_READ | PROT_WRITE,
+                      MAP_SHARED | MAP_POPULATE, this->fd, IORING_OFF_SQES);
+    if (sqes == MAP_FAILED)
+      return false;
+    this->sqes = static_cast<io_uring_sqe *>(sqes);
+
+    auto sq = static_cast<char *>(this->sqRing);
+    auto cq = static_cast<char *>(this->cqRing);
+    this->sqHead = reinterpret_cast<unsigned *>(sq + params.sq_off.head);
+    this->sqTail = reinterpret_cast<unsigned *>(sq + params.sq_off.tail);
+    this->sqMask = reinterpret_cast<unsigned *>(sq + params.sq_off.ring_mask);
+    this->sqArray = reinterpret_cast<unsigned *>(sq + params.sq_off.array);
+    this->cqHead = reinterpret_cast<unsigned *>(cq + params.cq_off.head);
+    this->cqTail = reinterpret_cast<unsigned *>(cq + params.cq_off.tail);
+    this->cqMask = reinterpret_cast<unsigned *>(cq + params.cq_off.ring_mask);
+    this->cqes = reinterpret_cast<io_uring_cqe *>(cq + params.cq_off.cqes);
+    return true;
+  }
+
+  ~Uring() {
+    if (this->sqes)
+      munmap(this->sqes, this->sqesSize);
+    if (this->cqRing != MAP_FAILED && this->cqRing != this->sqRing)
+      munmap(this->cqRing, this->cqRingSize);
+    if (this->sqRing != MAP_FAILED)
+      munmap(this->sqRing, this->sqRingSize);
+    if (this->fd >= 0)
+      close(this->fd);
+  }
+
+  // Whether the kernel implements the reads that are submitted. IORING_OP_READ
+  // came in 5.6, after io_uring itself; kernels without the probe (before
+  // 5.6) lack it too.
+  bool SupportsReads() const {
+    constexpr unsigned opcodeCount = 256;
+    std::vector<unsigned char> storage(sizeof(io_uring_probe) +
+                                      opcodeCount * sizeof(io_uring_probe_op));
+    auto probe = reinterpret_cast<io_uring_probe *>(storage.data());
+    if (syscall(__NR_io_uring_register, this->fd, IORING_REGISTER_PROBE, probe,
+                opcodeCount) < 0)
+      return false;
+    auto supported = [probe](unsigned opcode) {
+      return opcode < probe->ops_len &&
+             (probe->ops[opcode].flags & IO_URING_OP_SUPPORTED);
+    };
+    return supported(IORING_OP_READ) && supported(IORING_OP_READ_FIXED);
+  }
+
+  int Enter(unsigned toSubmit, unsigned minComplete, unsigned flags) {
+    return static_cast<int>(syscall(__NR_io_uring_enter, this->fd, toSubmit,
+                                    minComplete, flags, nullptr, 0));
+  }
+
+  // Next free submission entry, published by Publish(). Null when full.
+  io_uring_sqe *NextEntry(unsigned &tail) {
+    unsigned head = __atomic_load_n(this->sqHead, __ATOMIC_ACQUIRE);
+    if (tail - head >= this->entries)
+      return nullptr;
+    unsigned index = tail & *this->sqMask;
+    this->sqArray[index] = index;
+    io_uring_sqe *entry = &this->sqes[index];
+    std::memset(entry, 0, sizeof(*entry));
+    tail++;
+    return entry;
+  }
+
+  // Makes the entries up to `tail` visible and hands them to the kernel.
+  void Publish(unsigned tail) {
+    __atomic_store_n(this->sqTail, tail, __ATOMIC_RELEASE);
+    unsigned pending = tail - __atomic_load_n(this->sqHead, __ATOMIC_ACQUIRE);
+    while (pending > 0 && this->Enter(pending, 0, 0) < 0 && errno == EINTR) {
+    }
+  }
+};
+
+#else
+
+struct AsyncFileIO::Uring {};
+
+#endif
+
+// ============================================================================
+// Requests
+// ============================================================================
+
+AsyncFileIO::AsyncFileIO() {
+#ifdef __linux__
+  auto ring = std::make_unique<Uring>();
+  if (ring->Setup(QueueDepth) && ring->SupportsReads()) {
+    this->Ring = std::move(ring);
+    this->CompletionThread = std::thread(&AsyncFileIO::CompletionLoop, this);
+    return;
+  }
+#endif
+  unsigned count = std::clamp(std::thread::hardware_concurrency(), 2u, 8u);
+  for (unsigned i = 0; i < count; i++)
+    this->Workers.emplace_back(&AsyncFileIO::WorkerLoop, this);
+}
+
+AsyncFileIO::~AsyncFileIO() {
+  this->WaitIdle();
+  {
+    std::unique_lock<std::mutex> lock(this->QueueMutex);
+    this->Stop = true;
+#ifdef __linux__
+    // a no-op with no request behind it wakes the completion thread
+    if (this->Ring) {
+      unsigned tail = *this->Ring->sqTail;
+      if (io_uring_sqe *entry = this->Ring->NextEntry(tail)) {
+        entry->opcode = IORING_OP_NOP;
+        this->Ring->Publish(tail);
+      }
+    }
+#endif
+  }
+  this->WorkAvailable.notify_all();
+  if (this->CompletionThread.joinable())
+    this->CompletionThread.join();
+  for (auto &worker : this->Workers)
+    worker.join();
+  if (this->Staging)
+    ::operator delete(this->Staging, std::align_val_t(StagingAlignment));
+}
+
+AsyncFileIO::FileHandle AsyncFileIO::OpenFile(const std::string &filePath) {
+#ifdef _WIN32
+  HANDLE file = CreateFileA(filePath.c_str(), GENERIC_READ, FILE_SHARE_READ,
+                            nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+  return file == INVALID_HANDLE_VALUE ? InvalidFile
+                                      : reinterpret_cast<FileHandle>(file);
+#else
+  int file = open(filePath.c_str(), O_RDONLY | O_CLOEXEC);
+  return file < 0 ? InvalidFile : FileHandle(file);
+#endif
+}
+
+void AsyncFileIO::CloseFile(FileHandle file) {
+  if (file == InvalidFile)
+    return;
+#ifdef _WIN32
+  CloseHandle(reinterpret_cast<HANDLE>(file));
+#else
+  close(static_cast<int>(file));
+#endif
+}
+
+std::uint64_t AsyncFileIO::GetFileSize(FileHandle file) const {
+#ifdef _WIN32
+  LARGE_INTEGER size;
+  return GetFileSizeEx(reinterpret_cast<HANDLE>(file), &size)
+             ? std::uint64_t(size.QuadPart)
+             : 0;
+#else
+  struct stat status;
+  return fstat(static_cast<int>(file), &status) == 0
+             ? std::uint64_t(status.st_size)
+             : 0;
+#endif
+}
+
+void AsyncFileIO::Read(FileHandle file, std::uint64_t offset, std::size_t size,
+                       void *destination, Callback callback) {
+  if (file == InvalidFile || size == 0) {
+    if (callback)
+      callback({0, file == InvalidFile ? EBADF : 0});
+    return;
+  }
+
+  auto request = new Request{file, offset, size,
+                             static_cast<unsigned char *>(destination), 0,
+                             std::move(callback)};
+  std::unique_lock<std::mutex> lock(this->QueueMutex);
+  this->Queued.push_back(request);
+  this->Outstanding++;
+  if (this->Queued.size() >= BatchSize)
+    this->SubmitQueued(lock);
+}
+
+std::future<AsyncFileIO::ReadResult>
+AsyncFileIO::Read(FileHandle file, std::uint64_t offset, std::size_t size,
+                  void *destination) {
+  auto promise = std::make_shared<std::promise<ReadResult>>();
+  std::future<ReadResult> result = promise->get_future();
+  this->Read(file, offset, size, destination,
+             [promise](const ReadResult &read) { promise->set_value(read); });
+  return result;
+}
+
+void AsyncFileIO::Submit() {
+  std::unique_lock<std::mutex> lock(this->QueueMutex);
+  this->SubmitQueued(lock);
+}
+
+void AsyncFileIO::WaitIdle() {
+  std::unique_lock<std::mutex> lock(this->QueueMutex);
+  this->SubmitQueued(lock);
+  this->Idle.wait(lock, [this]() { return this->Outstanding == 0; });
+}
+
+std::size_t AsyncFileIO::GetPendingCount() const {
+  std::lock_guard<std::mutex> lock(this->QueueMutex);
+  return this->Outstanding;
+}
+
+void AsyncFileIO::SubmitQueued(std::unique_lock<std::mutex> &) {
+  if (this->Queued.empty())
+    return;
+
+  if (!this->Ring) {
+    this->Submitted.insert(this->Submitted.end(), this->Queued.begin(),
+                           this->Queued.end());
+    this->InFlight += this->Queued.size();
+    this->Queued.clear();
+    this->WorkAvailable.notify_all();
+    return;
+  }
+
+#ifdef __linux__
+  // reads beyond the completion queue's size wait for earlier ones, so
+  // completions are never dropped
+  std::size_t count = 0;
+  unsigned tail = *this->Ring->sqTail;
+  for (Request *request : this->Queued) {
+    if (this->InFlight >= this->Ring->cqEntries)
+      break;
+    io_uring_sqe *entry = this->Ring->NextEntry(tail);
+    if (!entry) {
+      // full: hand these over, then go on
+      this->Ring->Publish(tail);
+      if (!(entry = this->Ring->NextEntry(tail)))
+        break;
+    }
+
+    std::size_t length = std::min(request->size - request->done, MaxReadSize);
+    unsigned char *destination = request->destination + request->done;
+    bool fixed = this->StagingRegistered && this->IsStaging(destination, length);
+    entry->opcode = fixed ? IORING_OP_READ_FIXED : IORING_OP_READ;
+    entry->fd = static_cast<int>(request->file);
+    entry->off = request->offset + request->done;
+    entry->addr = reinterpret_cast<std::uint64_t>(destination);
+    entry->len = static_cast<unsigned>(length);
+    entry->buf_index = 0;
+    entry->user_data = reinterpret_cast<std::uint64_t>(request);
+    this->InFlight++;
+    count++;
+  }
+  this->Ring->Publish(tail);
+  this->Queued.erase(this->Queued.begin(), this->Queued.begin() + count);
+#endif
+}
+
+void AsyncFileIO::Complete(Request *request, int error) {
+  if (request->callback)
+    request->callback({request->done, error});
+  delete request;
+
+  std::lock_guard<std::mutex> lock(this->QueueMutex);
+  if (--this->Outstanding == 0)
+    this->Idle.notify_all();
+}
+
+void AsyncFileIO::CompletionLoop() {
+#ifdef __linux__
+  Uring &ring = *this->Ring;
+  for (bool stop = false; !stop;) {
+    if (ring.Enter(0, 1, IORING_ENTER_GETEVENTS) < 0 && errno != EINTR &&
+        errno != EAGAIN && errno != EBUSY) {
+      std::cerr << "io_uring_enter failed: " << std::strerror(errno) << std::endl;
+    }
+
+    struct finished {
+      Request *request;
+      int error;
+    };
+    std::vector<finished> done;
+    {
+      std::unique_lock<std::mutex> lock(this->QueueMutex);
+      unsigned head = *ring.cqHead;
+      unsigned tail = __atomic_load_n(ring.cqTail, __ATOMIC_ACQUIRE);
+      bool resubmit = false;
+      for (; head != tail; head++) {
+        const io_uring_cqe &entry = ring.cqes[head & *ring.cqMask];
+        auto request = reinterpret_cast<Request *>(entry.user_data);
+        if (!request) {
+          stop = this->Stop;
+          continue;
+        }
+        this->InFlight--;
+        int result = entry.res;
+        if (result == -EINTR || result == -EAGAIN) {
+          // try the same read again
+          this->Queued.insert(this->Queued.begin(), request);
+          resubmit = true;
+        } else if (result < 0) {
+          done.push_back({request, -result});
+        } else {
+          request->done += std::size_t(result);
+          if (result > 0 && request->done < request->size) {
+            // short read: continue where it stopped
+            this->Queued.insert(this->Queued.begin(), request);
+            resubmit = true;
+          } else {
+            done.push_back({request, 0});
+          }
+        }
+      }
+      __atomic_store_n(ring.cqHead, head, __ATOMIC_RELEASE);
+      // room in the completion queue again for reads that were held back
+      if (resubmit || !done.empty())
+        this->SubmitQueued(lock);
+    }
+
+    for (const auto &item : done)
+      this->Complete(item.request, item.error);
+  }
+#endif
+}
+
+void AsyncFileIO::WorkerLoop() {
+  for (;;) {
+    Request *request;
+    {
+      std::unique_lock<std::mutex> lock(this->QueueMutex);
+      this->WorkAvailable.wait(
+          lock, [this]() { return this->Stop || !this->Submitted.empty(); });
+      if (this->Submitted.empty())
+        return;
+      request = this->Submitted.front();
+      this->Submitted.pop_front();
+    }
+
+    int error = 0;
+    while (request->done < request->size) {
+      long long read = PositionalRead(
+          request->file, request->destination + request->done,
+          request->size - request->done, request->offset + request->done);
+      if (read < 0 && errno == EINTR)
+        continue;
+      if (read < 0)
+        error = errno;
+      if (read <= 0)
+        break;
+      request->done += std::size_t(read);
+    }
+
+    {
+      std::lock_guard<std::mutex> lock(this->QueueMutex);
+      this->InFlight--;
+    }
+    this->Complete(request, error);
+  }
+}
+
+// ============================================================================
+// Staging memory
+// ============================================================================
+
+void *AsyncFileIO::AcquireStaging() {
+  std::lock_guard<std::mutex> lock(this->StagingMutex);
+  if (!this->Staging) {
+    std::size_t size = StagingBlockSize * StagingBlockCount;
+    this->Staging = static_cast<unsigned char *>(
+        ::operator new(size, std::align_val_t(StagingAlignment)));
+    for (std::size_t i = StagingBlockCount; i-- > 0;)
+      this->FreeStaging.push_back(this->Staging + i * StagingBlockSize);
+
+#ifdef __linux__
+    // pin it once, so reads into it skip the per-request mapping
+    if (this->Ring) {
+      iovec buffer = {this->Staging, size};
+      bool registered = syscall(__NR_io_uring_register, this->Ring->fd,
+                                IORING_REGISTER_BUFFERS, &buffer, 1) == 0;
+      std::lock_guard<std::mutex> queueLock(this->QueueMutex);
+      this->StagingRegistered = registered;
+    }
+#endif
+  }
+
+  if (this->FreeStaging.empty())
+    return nullptr;
+  void *block = this->FreeStaging.back();
+  this->FreeStaging.pop_back();
+  return block;
+}
+
+void AsyncFileIO::ReleaseStaging(void *block) {
+  if (!block)
+    return;
+  std::lock_guard<std::mutex> lock(this->StagingMutex);
+  this->FreeStaging.push_back(block);
+}
+
+bool AsyncFileIO::IsStaging(const void *destination, std::size_t size) const {
+  auto address = static_cast<const unsigned char *>(destination);
+  return this->Staging && address >= this->Staging &&
+         address + size <= this->Staging + StagingBlockSize * StagingBlockCount;
+}
@@ -0,0 +1,122 @@
+#ifndef ASYNCFILEIO_H_
+#define ASYNCFILEIO_H_
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Asynchronous positional file reads for asset streaming. Many reads can be
+// outstanding at once without a thread blocked on each of them.
+//
+// On Linux the reads go through io_uring: queued reads are written to the
+// submission ring and handed to the kernel with one system call per batch,
+// and a completion thread reaps them. Where io_uring is not available (old
+// kernels, seccomp filters, other systems) or cannot do reads (checked with
+// IORING_REGISTER_PROBE) a small pool of threads issues pread() calls
+// instead; the interface is the same.
+//
+// Data is read straight into the destination given with the request, which
+// may be a block of the pinned staging memory (AcquireStaging()). The
+// staging memory is registered with the kernel once, so reads into it skip
+// the per-request page pinning.
+class AsyncFileIO {
+public:
+  struct ReadResult {
+    std::size_t bytesRead = 0; // less than requested at the end of the file
+    int error = 0;             // errno value, 0 on success
+  };
+  using Callback = std::function<void(const ReadResult &)>;
+  using FileHandle = std::intptr_t;
+
+  static constexpr FileHandle InvalidFile = -1;
+  static constexpr std::size_t StagingBlockSize = 4 * 1024 * 1024;
+  static constexpr std::size_t StagingBlockCount = 16;
+
+public:
+  static AsyncFileIO *GetInstance() {
+    return AsyncFileIO::Instance != nullptr
+               ? AsyncFileIO::Instance
+               : AsyncFileIO::Instance = new AsyncFileIO();
+  }
+
+  // InvalidFile if the file cannot be opened. Close a file only once no
+  // reads of it are pending.
+  FileHandle OpenFile(const std::string &filePath);
+  void CloseFile(FileHandle file);
+  std::uint64_t GetFileSize(FileHandle file) const;
+
+  // Queues a read of `size` bytes at `offset` into `destination`, which has
+  // to stay valid until the read completes. Queued reads start with the
+  // next Submit(), or as soon as a full batch is queued. Callbacks run on
+  // the I/O thread, so they should only hand the data on.
+  void Read(FileHandle file, std::uint64_t offset, std::size_t size,
+            void *destination, Callback callback);
+  std::future<ReadResult> Read(FileHandle file, std::uint64_t offset,
+                               std::size_t size, void *destination);
+  void Submit();
+  // Submits and blocks until every read has completed.
+  void WaitIdle();
+
+  // A StagingBlockSize block of pinned memory, null while all are in use.
+  void *AcquireStaging();
+  void ReleaseStaging(void *block);
+
+  bool UsesIoUring() const { return this->Ring != nullptr; }
+  std::size_t GetPendingCount() const;
+
+private:
+  struct Request {
+    FileHandle file;
+    std::uint64_t offset;
+    std::size_t size;
+    unsigned char *destination;
+    std::size_t done = 0;
+    Callback callback;
+  };
+  struct Uring;
+
+private:
+  // Hands queued requests to the kernel or the workers. Needs QueueMutex.
+  void SubmitQueued(std::unique_lock<std::mutex> &lock);
+  void Complete(Request *request, int error);
+  void CompletionLoop();
+  void WorkerLoop();
+  bool IsStaging(const void *destination, std::size_t size) const;
+
+private:
+  AsyncFileIO();
+  ~AsyncFileIO();
+  AsyncFileIO(const AsyncFileIO &) = delete;
+  void operator=(const AsyncFileIO &) = delete;
+
+private:
+  inline static AsyncFileIO *Instance = nullptr;
+
+  std::unique_ptr<Uring> Ring; // null: thread pool fallback
+  std::thread CompletionThread;
+  std::vector<std::thread> Workers;
+
+  mutable std::mutex QueueMutex;
+  std::condition_variable WorkAvailable;
+  std::condition_variable Idle;
+  std::vector<Request *> Queued;      // not yet submitted
+  std::deque<Request *> Submitted;    // fallback: waiting for a worker
+  std::size_t InFlight = 0;           // submitted and not completed
+  std::size_t Outstanding = 0;        // queued or in flight
+  bool Stop = false;
+
+  unsigned char *Staging = nullptr;
+  std::vector<void *> FreeStaging;
+  std::mutex StagingMutex;
+  bool StagingRegistered = false;
+};
+
+#endif // ASYNCFILEIO_H_
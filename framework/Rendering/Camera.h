@@ -1,47 +1,149 @@
 #ifndef CAMERA_H_
 #define CAMERA_H_
 
+#include "ViewFrustum.h"
+
 #include "glm/fwd.hpp"
 #include <glm/glm.hpp>
+#include <glm/gtc/matrix_inverse.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 
+// Matrices are computed lazily: setters only mark what they invalidate,
+// and each matrix is rebuilt the first time it is asked for afterwards. A
+// frame that moves the camera and turns it pays for one update, not one
+// per setter. The getters update caches, so a camera must not be read
+// from several threads while it changes.
 class Camera {
 public:
   Camera() = default;
-  ~Camera() = default;
+  virtual ~Camera() = default;
 
   // Get camera matrices
-  const glm::mat4 &GetProjectionMatrix() const {
-    return this->ProjectionMatrix;
-  }
-  const glm::mat4 &GetViewMatrix() const { return this->ViewMatrix; }
-  const glm::mat4 &GetViewProjectionMatrix() const {
-    return this->ViewProjectionMatrix;
-  }
+  const glm::mat4 &GetProjectionMatrix() const;
+  const glm::mat4 &GetViewMatrix() const;
+  const glm::mat4 &GetViewProjectionMatrix() const;
+
+  // Inverses, e.g. for reconstructing positions from depth
+  const glm::mat4 &GetInverseProjectionMatrix() const;
+  const glm::mat4 &GetInverseViewMatrix() const;
+  const glm::mat4 &GetInverseViewProjectionMatrix() const;
+
+  // Clipping planes of the view-projection matrix, for culling
+  const ViewFrustum &GetFrustum() const;
 
   // Set/Get position
   const glm::vec3 &GetPosition() const { return this->Position; }
   void SetPosition(const glm::vec3 &pos) {
     this->Position = pos;
-    this->RecalculateMatrix();
+    this->InvalidateView();
   }
 
 protected:
-  virtual void RecalculateMatrix() = 0;
+  virtual glm::mat4 CalculateProjectionMatrix() const = 0;
+  virtual glm::mat4 CalculateViewMatrix() const = 0;
+  // Clip space depth convention of the projection matrix
+  virtual ViewFrustum::DepthRange GetDepthRange() const {
+    return ViewFrustum::DepthRange::MinusOneToOne;
+  }
 
-protected:
-  Camera(const Camera &camera) {
-    this->ProjectionMatrix = camera.ProjectionMatrix;
-    this->ViewMatrix = camera.ViewMatrix;
-    this->Position = camera.Position;
-    this->ViewProjectionMatrix = camera.ViewProjectionMatrix;
+  // For setters of derived cameras
+  void InvalidateProjection() {
+    this->Dirty |= Projection | ViewProjection | InverseProjection |
+                   InverseViewProjection | Frustum;
   }
+  void InvalidateView() {
+    this->Dirty |= View | ViewProjection | InverseView |
+                   InverseViewProjection | Frustum;
+  }
+
+protected:
+  Camera(const Camera &camera) = default;
 
 protected:
-  glm::mat4 ProjectionMatrix = glm::mat4(1.0f);
-  glm::mat4 ViewMatrix = glm::mat4(1.0f);
-  glm::mat4 ViewProjectionMatrix = glm::mat4(1.0f);
   glm::vec3 Position = glm::vec3(0.0f);
+
+private:
+  enum : unsigned {
+    Projection = 1 << 0,
+    View = 1 << 1,
+    ViewProjection = 1 << 2,
+    InverseProjection = 1 << 3,
+    InverseView = 1 << 4,
+    InverseViewProjection = 1 << 5,
+    Frustum = 1 << 6,
+    Everything = (1 << 7) - 1
+  };
+
+  mutable unsigned Dirty = Everything;
+  mutable glm::mat4 ProjectionMatrix = glm::mat4(1.0f);
+  mutable glm::mat4 ViewMatrix = glm::mat4(1.0f);
+  mutable glm::mat4 ViewProjectionMatrix = glm::mat4(1.0f);
+  mutable glm::mat4 InverseProjectionMatrix = glm::mat4(1.0f);
+  mutable glm::mat4 InverseViewMatrix = glm::mat4(1.0f);
+  mutable glm::mat4 InverseViewProjectionMatrix = glm::mat4(1.0f);
+  mutable ViewFrustum CameraFrustum;
 };
 
+inline const glm::mat4 &Camera::GetProjectionMatrix() const {
+  if (this->Dirty & Projection) {
+    this->ProjectionMatrix = this->CalculateProjectionMatrix();
+    this->Dirty &= ~Projection;
+  }
+  return this->ProjectionMatrix;
+}
+
+inline const glm::mat4 &Camera::GetViewMatrix() const {
+  if (this->Dirty & View) {
+    this->ViewMatrix = this->CalculateViewMatrix();
+    this->Dirty &= ~View;
+  }
+  return this->ViewMatrix;
+}
+
+inline const glm::mat4 &Camera::GetViewProjectionMatrix() const {
+  if (this->Dirty & ViewProjection) {
+    this->ViewProjectionMatrix =
+        this->GetProjectionMatrix() * this->GetViewMatrix();
+    this->Dirty &= ~ViewProjection;
+  }
+  return this->ViewProjectionMatrix;
+}
+
+inline const glm::mat4 &Camera::GetInverseProjectionMatrix() const {
+  if (this->Dirty & InverseProjection) {
+    this->InverseProjectionMatrix = glm::inverse(this->GetProjectionMatrix());
+    this->Dirty &= ~InverseProjection;
+  }
+  return this->InverseProjectionMatrix;
+}
+
+inline const glm::mat4 &Camera::GetInverseViewMatrix() const {
+  if (this->Dirty & InverseView) {
+    // rotation and translation only, so the cheaper affine inverse does
+    this->InverseViewMatrix = glm::affineInverse(this->GetViewMatrix());
+    this->Dirty &= ~InverseView;
+  }
+  return this->InverseViewMatrix;
+}
+
+inline const glm::mat4 &Camera::GetInverseViewProjectionMatrix() const {
+  if (this->Dirty & InverseViewProjection) {
+    // from the two inverses rather than inverting the product, which
+    // loses precision with an infinite far plane
+    this->InverseViewProjectionMatrix =
+        this->GetInverseViewMatrix() * this->GetInverseProjectionMatrix();
+    this->Dirty &= ~InverseViewProjection;
+  }
+  return this->InverseViewProjectionMatrix;
+}
+
+inline const ViewFrustum &Camera::GetFrustum() const {
+  if (this->Dirty & Frustum) {
+    this->CameraFrustum.SetMatrix(this->GetViewProjectionMatrix(),
+                                  this->GetDepthRange());
+    this->Dirty &= ~Frustum;
+  }
+  return this->CameraFrustum;
+}
+
 #endif // CAMERA_H_
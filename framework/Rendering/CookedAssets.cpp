@@ -0,0 +1,134 @@
+#include "CookedAssets.h"
+#include "IndexBuffer.h"
+#include "VertexBuffer.h"
+#include "VertexBufferLayout.h"
+
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+namespace CookedAssets {
+
+namespace {
+
+bool InFile(const AssetFile &file, std::uint64_t offset, std::uint64_t size) {
+  return offset <= file.GetSize() && size <= file.GetSize() - offset;
+}
+
+const void *GetAssetHeader(const AssetFile &file, AssetType type,
+                           std::size_t headerSize, std::string &error) {
+  if (!file.IsOpen() || !InFile(file, 0, sizeof(FileHeader) + headerSize)) {
+    error = "not a cooked asset";
+    return nullptr;
+  }
+  auto header = reinterpret_cast<const FileHeader *>(file.GetData());
+  if (header->magic != Magic) {
+    error = "not a cooked asset";
+    return nullptr;
+  }
+  if (header->version != Version) {
+    error = "cooked with format version " + std::to_string(header->version) +
+            ", expected " + std::to_string(Version);
+    return nullptr;
+  }
+  if (header->type != type) {
+    error = "wrong asset type";
+    return nullptr;
+  }
+  return header + 1;
+}
+
+} // namespace
+
+AssetFile::AssetFile(const std::string &filePath) {
+  VirtualFileSystem *fileSystem = VirtualFileSystem::GetInstance();
+  if (fileSystem->HasMounts()) {
+    this->Resource = fileSystem->Open(filePath);
+    if (this->Resource) {
+      this->Data = this->Resource.GetData();
+      this->Size = this->Resource.GetSize();
+      return;
+    }
+  }
+  if (this->Mapping.Open(filePath)) {
+    this->Data = this->Mapping.GetData();
+    this->Size = this->Mapping.GetSize();
+  }
+}
+
+const TextureHeader *GetTexture(const AssetFile &file, std::string &error) {
+  auto header = static_cast<const TextureHeader *>(GetAssetHeader(
+      file, AssetType::Texture, sizeof(TextureHeader), error));
+  if (!header)
+    return nullptr;
+
+  std::uint64_t tableOffset = sizeof(FileHeader) + sizeof(TextureHeader);
+  if (header->levelCount == 0 ||
+      !InFile(file, tableOffset,
+              std::uint64_t(header->levelCount) * sizeof(TextureLevel))) {
+    error = "truncated level table";
+    return nullptr;
+  }
+  const TextureLevel *levels = GetTextureLevels(header);
+  for (std::uint32_t i = 0; i < header->levelCount; i++) {
+    if (!InFile(file, levels[i].offset, levels[i].size)) {
+      error = "truncated mip level";
+      return nullptr;
+    }
+  }
+  return header;
+}
+
+const MeshHeader *GetMesh(const AssetFile &file, std::string &error) {
+  auto header = static_cast<const MeshHeader *>(
+      GetAssetHeader(file, AssetType::Mesh, sizeof(MeshHeader), error));
+  if (!header)
+    return nullptr;
+
+  std::uint64_t tableOffset = sizeof(FileHeader) + sizeof(MeshHeader);
+  if (!InFile(file, tableOffset,
+              std::uint64_t(header->attributeCount) * sizeof(MeshAttribute)) ||
+      !InFile(file, header->vertexOffset,
+              std::uint64_t(header->vertexCount) * header->stride) ||
+      !InFile(file, header->indexOffset,
+              std::uint64_t(header->indexCount) * sizeof(GLuint))) {
+    error = "truncated mesh";
+    return nullptr;
+  }
+  return header;
+}
+
+std::shared_ptr<VertexArray> LoadMesh(const std::string &filePath) {
+  AssetFile file(filePath);
+  std::string error = "cannot open file";
+  const MeshHeader *header = file.IsOpen() ? GetMesh(file, error) : nullptr;
+  if (!header) {
+    std::cerr << "Failed to load mesh " << filePath << ": " << error
+              << std::endl;
+    return nullptr;
+  }
+
+  std::vector<BufferAttribute> attributes;
+  const MeshAttribute *attribute = GetMeshAttributes(header);
+  for (std::uint32_t i = 0; i < header->attributeCount; i++, attribute++)
+    attributes.emplace_back(static_cast<ShaderDataType>(attribute->type),
+                            std::string(attribute->name,
+                                        strnlen(attribute->name,
+                                                sizeof(attribute->name))),
+                            attribute->normalized != 0);
+
+  auto vertexBuffer = std::make_shared<VertexBuffer>(
+      file.GetData() + header->vertexOffset,
+      GLsizei(std::uint64_t(header->vertexCount) * header->stride));
+  vertexBuffer->SetLayout(BufferLayout(attributes));
+
+  auto vertexArray = std::make_shared<VertexArray>();
+  vertexArray->AddVertexBuffer(vertexBuffer);
+  vertexArray->SetIndexBuffer(std::make_shared<IndexBuffer>(
+      reinterpret_cast<const GLuint *>(file.GetData() + header->indexOffset),
+      GLsizei(header->indexCount)));
+  vertexArray->Unbind();
+  return vertexArray;
+}
+
+} // namespace CookedAssets
@@ -0,0 +1,109 @@
+#ifndef COOKEDASSETS_H_
+#define COOKEDASSETS_H_
+
+#include "VertexArray.h"
+#include "VirtualFileSystem.h"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+// Engine-native asset files written by tools/AssetCooker. Each file is a
+// FileHeader, an asset header and its tables, then the payload at 16 byte
+// aligned offsets: finished mip levels for textures, interleaved vertices in
+// their final BufferLayout and GLuint indices for meshes. Loading maps the
+// file and passes pointers into it straight to the GL upload calls.
+namespace CookedAssets {
+
+constexpr std::uint32_t Magic = 0x4B4F4F43; // "COOK"
+// Bump when a layout below changes; the cooker then re-cooks everything.
+constexpr std::uint32_t Version = 1;
+constexpr std::size_t PayloadAlignment = 16;
+
+enum class AssetType : std::uint32_t { Texture = 1, Mesh = 2 };
+
+struct FileHeader {
+  std::uint32_t magic;
+  std::uint32_t version;
+  AssetType type;
+  std::uint32_t reserved;
+  std::uint64_t sourceHash; // content hash of the cooked source file
+};
+
+// Followed by levelCount TextureLevel entries, largest first.
+struct TextureHeader {
+  std::uint32_t internalFormat; // e.g. GL_RGBA8
+  std::uint32_t format;         // e.g. GL_RGBA
+  std::uint32_t type;           // e.g. GL_UNSIGNED_BYTE
+  std::uint32_t width;
+  std::uint32_t height;
+  std::uint32_t levelCount;
+};
+
+struct TextureLevel {
+  std::uint64_t offset; // from the start of the file
+  std::uint64_t size;
+  std::uint32_t width;
+  std::uint32_t height;
+};
+
+// Followed by attributeCount MeshAttribute entries, in buffer order.
+struct MeshHeader {
+  std::uint32_t vertexCount;
+  std::uint32_t indexCount; // GL_TRIANGLES
+  std::uint32_t stride;     // bytes per vertex
+  std::uint32_t attributeCount;
+  std::uint64_t vertexOffset;
+  std::uint64_t indexOffset;
+};
+
+struct MeshAttribute {
+  std::uint32_t type; // ShaderDataType
+  std::uint32_t normalized;
+  char name[24];
+};
+
+static_assert(sizeof(FileHeader) == 24, "cooked layouts are written as is");
+static_assert(sizeof(TextureHeader) == 24, "cooked layouts are written as is");
+static_assert(sizeof(TextureLevel) == 24, "cooked layouts are written as is");
+static_assert(sizeof(MeshHeader) == 32, "cooked layouts are written as is");
+static_assert(sizeof(MeshAttribute) == 32, "cooked layouts are written as is");
+
+// The bytes of a cooked file. Read through the VirtualFileSystem when
+// anything is mounted, so cooked assets can come from packs; mapped directly
+// otherwise.
+class AssetFile {
+public:
+  explicit AssetFile(const std::string &filePath);
+
+  bool IsOpen() const { return this->Data != nullptr; }
+  const unsigned char *GetData() const { return this->Data; }
+  std::size_t GetSize() const { return this->Size; }
+
+private:
+  VirtualFile Resource;
+  MappedFile Mapping;
+  const unsigned char *Data = nullptr;
+  std::size_t Size = 0;
+};
+
+// Checks the file header and that every table and payload lies inside the
+// file, and returns the asset header that follows it. Null with `error` set
+// otherwise.
+const TextureHeader *GetTexture(const AssetFile &file, std::string &error);
+const MeshHeader *GetMesh(const AssetFile &file, std::string &error);
+
+inline const TextureLevel *GetTextureLevels(const TextureHeader *header) {
+  return reinterpret_cast<const TextureLevel *>(header + 1);
+}
+
+inline const MeshAttribute *GetMeshAttributes(const MeshHeader *header) {
+  return reinterpret_cast<const MeshAttribute *>(header + 1);
+}
+
+// Opens a cooked mesh and uploads it. Null on failure.
+std::shared_ptr<VertexArray> LoadMesh(const std::string &filePath);
+
+} // namespace CookedAssets
+
+#endif // COOKEDASSETS_H_
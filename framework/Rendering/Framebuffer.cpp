@@ -0,0 +1,72 @@
+#include "Framebuffer.h"
+
+#include <iostream>
+
+Framebuffer::Framebuffer(GLsizei width, GLsizei height)
+{
+	glGenFramebuffers(1, &FramebufferID);
+	glGenRenderbuffers(1, &ColorBufferID);
+	glGenRenderbuffers(1, &DepthBufferID);
+
+	glBindFramebuffer(GL_FRAMEBUFFER, FramebufferID);
+	glBindRenderbuffer(GL_RENDERBUFFER, ColorBufferID);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, ColorBufferID);
+	glBindRenderbuffer(GL_RENDERBUFFER, DepthBufferID);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, DepthBufferID);
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+	Resize(width, height);
+	if (!IsComplete())
+		std::cerr << "Framebuffer " << width << "x" << height << " is incomplete" << std::endl;
+}
+
+Framebuffer::~Framebuffer()
+{
+	glDeleteFramebuffers(1, &FramebufferID);
+	glDeleteRenderbuffers(1, &ColorBufferID);
+	glDeleteRenderbuffers(1, &DepthBufferID);
+}
+
+void Framebuffer::Bind() const
+{
+	glBindFramebuffer(GL_FRAMEBUFFER, FramebufferID);
+	glViewport(0, 0, Width, Height);
+}
+
+void Framebuffer::Unbind() const
+{
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+void Framebuffer::Resize(GLsizei width, GLsizei height)
+{
+	// a minimised window reports 0 x 0
+	width = width > 0 ? width : 1;
+	height = height > 0 ? height : 1;
+	if (width == Width && height == Height)
+		return;
+	Width = width;
+	Height = height;
+
+	glBindRenderbuffer(GL_RENDERBUFFER, ColorBufferID);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, Width, Height);
+	glBindRenderbuffer(GL_RENDERBUFFER, DepthBufferID);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT32F, Width, Height);
+	glBindRenderbuffer(GL_RENDERBUFFER, 0);
+}
+
+void Framebuffer::BlitToScreen(GLsizei width, GLsizei height) const
+{
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, FramebufferID);
+	glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+	glBlitFramebuffer(0, 0, Width, Height, 0, 0, width, height, GL_COLOR_BUFFER_BIT, GL_LINEAR);
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+bool Framebuffer::IsComplete() const
+{
+	glBindFramebuffer(GL_FRAMEBUFFER, FramebufferID);
+	GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	return status == GL_FRAMEBUFFER_COMPLETE;
+}
@@ -0,0 +1,45 @@
+#ifndef FRAMEBUFFER_H
+#define FRAMEBUFFER_H
+
+#include <glad/glad.h>
+
+// An offscreen render target with an RGBA8 colour buffer and a 32-bit
+// float depth buffer. The default framebuffer of a GLFW window only
+// offers fixed point depth, which throws away most of what reverse-Z
+// gains; render into this instead and blit the colour to the window.
+class Framebuffer
+{
+private:
+  GLuint FramebufferID = 0;
+  GLuint ColorBufferID = 0;
+  GLuint DepthBufferID = 0;
+  GLsizei Width = 0;
+  GLsizei Height = 0;
+
+public:
+  Framebuffer(GLsizei width, GLsizei height);
+  ~Framebuffer();
+  Framebuffer(const Framebuffer&) = delete;
+  void operator=(const Framebuffer&) = delete;
+
+  // Bind it for drawing and set the viewport to its size.
+  void Bind() const;
+
+  // Bind the window's framebuffer again.
+  void Unbind() const;
+
+  // Reallocate the buffers, e.g. when the window was resized. The
+  // contents are lost.
+  void Resize(GLsizei width, GLsizei height);
+
+  // Copy the colour buffer to the window's framebuffer, stretched to
+  // `width` x `height`.
+  void BlitToScreen(GLsizei width, GLsizei height) const;
+
+  bool IsComplete() const;
+
+  inline GLsizei GetWidth() const { return Width; }
+  inline GLsizei GetHeight() const { return Height; }
+};
+
+#endif
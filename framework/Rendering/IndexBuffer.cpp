@@ -1,7 +1,7 @@
 #include "IndexBuffer.h"
 #include <glad/glad.h>
 
-IndexBuffer::IndexBuffer(GLuint *indices, GLsizei count)
+IndexBuffer::IndexBuffer(const GLuint *indices, GLsizei count)
 	:Count(count){
 	glGenBuffers(1, &IndexBufferID);
 	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, IndexBufferID);
@@ -13,7 +13,7 @@ public:
   // Constructor. Initializes the class with a data buffer and its size.
   // Note: The buffer will be bound upon construction, and the size is
   // specified in the number of elements, not bytes.
-  IndexBuffer(GLuint *indices, GLsizei count);
+  IndexBuffer(const GLuint *indices, GLsizei count);
   ~IndexBuffer();
 
   // Bind the vertex buffer.
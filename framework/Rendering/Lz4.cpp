@@ -0,0 +1,174 @@
+#include "Lz4.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+namespace Lz4 {
+
+namespace {
+
+constexpr std::size_t MinMatch = 4;
+// The last five bytes are always literals, and the last match starts at
+// least twelve bytes before the end of the block.
+constexpr std::size_t LastLiterals = 5;
+constexpr std::size_t MatchFindLimit = 12;
+constexpr std::size_t MaxOffset = 65535;
+constexpr int HashBits = 16;
+
+std::uint32_t Read32(const unsigned char *p) {
+  std::uint32_t value;
+  std::memcpy(&value, p, sizeof(value));
+  return value;
+}
+
+std::uint32_t Hash(std::uint32_t sequence) {
+  return (sequence * 2654435761u) >> (32 - HashBits);
+}
+
+// Writes a length continuation: bytes of 255 and the remainder.
+bool WriteLength(std::size_t length, unsigned char *&out,
+                 const unsigned char *end) {
+  for (; length >= 255; length -= 255) {
+    if (out == end)
+      return false;
+    *out++ = 255;
+  }
+  if (out == end)
+    return false;
+  *out++ = static_cast<unsigned char>(length);
+  return true;
+}
+
+// One sequence: token, literals and, unless it is the last one, a match.
+bool WriteSequence(const unsigned char *literals, std::size_t literalLength,
+                   std::size_t offset, std::size_t matchLength,
+                   unsigned char *&out, const unsigned char *end) {
+  if (out == end)
+    return false;
+  unsigned char *token = out++;
+  *token = static_cast<unsigned char>(std::min<std::size_t>(literalLength, 15) << 4);
+  if (literalLength >= 15 && !WriteLength(literalLength - 15, out, end))
+    return false;
+  if (std::size_t(end - out) < literalLength)
+    return false;
+  if (literalLength)
+    std::memcpy(out, literals, literalLength);
+  out += literalLength;
+
+  if (matchLength == 0)
+    return true;
+  if (end - out < 2)
+    return false;
+  *out++ = static_cast<unsigned char>(offset);
+  *out++ = static_cast<unsigned char>(offset >> 8);
+  std::size_t length = matchLength - MinMatch;
+  *token |= static_cast<unsigned char>(std::min<std::size_t>(length, 15));
+  return length < 15 || WriteLength(length - 15, out, end);
+}
+
+} // namespace
+
+std::size_t CompressBound(std::size_t size) { return size + size / 255 + 16; }
+
+std::size_t Compress(const unsigned char *source, std::size_t size,
+                     unsigned char *destination, std::size_t capacity) {
+  unsigned char *out = destination;
+  const unsigned char *end = destination + capacity;
+  std::size_t anchor = 0;
+
+  if (size > MatchFindLimit) {
+    std::vector<std::uint32_t> table(std::size_t(1) << HashBits, 0);
+    std::size_t matchLimit = size - LastLiterals;
+    std::size_t position = 0;
+    while (position + MatchFindLimit <= size) {
+      std::uint32_t sequence = Read32(source + position);
+      std::uint32_t hash = Hash(sequence);
+      std::size_t candidate = table[hash];
+      table[hash] = static_cast<std::uint32_t>(position);
+
+      if (candidate >= position || position - candidate > MaxOffset ||
+          Read32(source + candidate) != sequence) {
+        // skip ahead faster through data that does not compress
+        position += 1 + ((position - anchor) >> 6);
+        continue;
+      }
+
+      std::size_t length = MinMatch;
+      while (position + length < matchLimit &&
+             source[candidate + length] == source[position + length])
+        length++;
+
+      if (!WriteSequence(source + anchor, position - anchor,
+                         position - candidate, length, out, end))
+        return 0;
+      position += length;
+      anchor = position;
+    }
+  }
+
+  if (!WriteSequence(source + anchor, size - anchor, 0, 0, out, end))
+    return 0;
+  return static_cast<std::size_t>(out - destination);
+}
+
+bool Decompress(const unsigned char *source, std::size_t sourceSize,
+                unsigned char *destination, std::size_t size) {
+  std::size_t in = 0, out = 0;
+  auto readLength = [&](std::size_t &length) {
+    unsigned char byte;
+    do {
+      if (in == sourceSize)
+        return false;
+      byte = source[in++];
+      length += byte;
+    } while (byte == 255);
+    return true;
+  };
+
+  while (in < sourceSize) {
+    unsigned char token = source[in++];
+
+    std::size_t literalLength = token >> 4;
+    if (literalLength == 15 && !readLength(literalLength))
+      return false;
+    if (literalLength > sourceSize - in || literalLength > size - out)
+      return false;
+    if (literalLength)
+      std::memcpy(destination + out, source + in, literalLength);
+    in += literalLength;
+    out += literalLength;
+
+    // the last sequence has no match
+    if (in == sourceSize)
+      break;
+
+    if (sourceSize - in < 2)
+      return false;
+    std::size_t offset = source[in] | (std::size_t(source[in + 1]) << 8);
+    in += 2;
+    if (offset == 0 || offset > out)
+      return false;
+
+    std::size_t matchLength = token & 15;
+    if (matchLength == 15 && !readLength(matchLength))
+      return false;
+    matchLength += MinMatch;
+    if (matchLength > size - out)
+      return false;
+
+    // matches may overlap their own output, copy forwards
+    const unsigned char *match = destination + out - offset;
+    if (offset >= matchLength) {
+      std::memcpy(destination + out, match, matchLength);
+    } else {
+      for (std::size_t i = 0; i < matchLength; i++)
+        destination[out + i] = match[i];
+    }
+    out += matchLength;
+  }
+  return out == size;
+}
+
+} // namespace Lz4
@@ -0,0 +1,26 @@
+#ifndef LZ4_H_
+#define LZ4_H_
+
+#include <cstddef>
+
+// LZ4 block format (no frame header), as used for the entries of pack
+// files. Decompression is the hot path: it runs at load time, checks every
+// length and offset against both buffers and never reads or writes outside
+// them. The compressor is a plain greedy one for offline tools.
+namespace Lz4 {
+
+// Largest compressed size of `size` input bytes.
+std::size_t CompressBound(std::size_t size);
+
+// Returns the compressed size, 0 if `capacity` is too small.
+std::size_t Compress(const unsigned char *source, std::size_t size,
+                     unsigned char *destination, std::size_t capacity);
+
+// Decompresses a whole block into exactly `size` bytes. False if the block
+// is malformed or does not decompress to that size.
+bool Decompress(const unsigned char *source, std::size_t sourceSize,
+                unsigned char *destination, std::size_t size);
+
+} // namespace Lz4
+
+#endif // LZ4_H_
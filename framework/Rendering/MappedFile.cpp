@@ -0,0 +1,113 @@
+#include "MappedFile.h"
+
+#include <utility>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::MappedFile(MappedFile &&other) noexcept { *this = std::move(other); }
+
+MappedFile &MappedFile::operator=(MappedFile &&other) noexcept {
+  if (this != &other) {
+    this->Close();
+    std::swap(this->Data, other.Data);
+    std::swap(this->Size, other.Size);
+#ifdef _WIN32
+    std::swap(this->FileHandle, other.FileHandle);
+    std::swap(this->MappingHandle, other.MappingHandle);
+#endif
+  }
+  return *this;
+}
+
+#ifdef _WIN32
+
+bool MappedFile::Open(const std::string &filePath) {
+  this->Close();
+
+  HANDLE file = CreateFileA(filePath.c_str(), GENERIC_READ, FILE_SHARE_READ,
+                            nullptr, OPEN_EXISTING,
+                            FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+  if (file == INVALID_HANDLE_VALUE)
+    return false;
+
+  LARGE_INTEGER size;
+  if (!GetFileSizeEx(file, &size) || size.QuadPart == 0) {
+    CloseHandle(file);
+    return false;
+  }
+
+  HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+  void *data = mapping ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+  if (!data) {
+    if (mapping)
+      CloseHandle(mapping);
+    CloseHandle(file);
+    return false;
+  }
+
+  this->FileHandle = file;
+  this->MappingHandle = mapping;
+  this->Data = static_cast<const unsigned char *>(data);
+  this->Size = static_cast<std::size_t>(size.QuadPart);
+  return true;
+}
+
+void MappedFile::Close() {
+  if (this->Data)
+    UnmapViewOfFile(this->Data);
+  if (this->MappingHandle)
+    CloseHandle(this->MappingHandle);
+  if (this->FileHandle)
+    CloseHandle(this->FileHandle);
+  this->Data = nullptr;
+  this->Size = 0;
+  this->FileHandle = nullptr;
+  this->MappingHandle = nullptr;
+}
+
+#else
+
+bool MappedFile::Open(const std::string &filePath) {
+  this->Close();
+
+  int file = open(filePath.c_str(), O_RDONLY);
+  if (file < 0)
+    return false;
+
+  struct stat status;
+  if (fstat(file, &status) != 0 || status.st_size == 0) {
+    close(file);
+    return false;
+  }
+
+  void *data = mmap(nullptr, status.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+  // the mapping keeps the file alive
+  close(file);
+  if (data == MAP_FAILED)
+    return false;
+
+  // the whole file is about to be uploaded, start reading it in now
+  madvise(data, status.st_size, MADV_WILLNEED);
+
+  this->Data = static_cast<const unsigned char *>(data);
+  this->Size = static_cast<std::size_t>(status.st_size);
+  return true;
+}
+
+void MappedFile::Close() {
+  if (this->Data)
+    munmap(const_cast<unsigned char *>(this->Data), this->Size);
+  this->Data = nullptr;
+  this->Size = 0;
+}
+
+#endif
@@ -0,0 +1,38 @@
+#ifndef MAPPEDFILE_H_
+#define MAPPEDFILE_H_
+
+#include <cstddef>
+#include <string>
+
+// Read-only memory mapping of a whole file. Pages are read in by the OS on
+// first touch, so mapping is cheap and the data can be handed to GL upload
+// calls without an intermediate copy.
+class MappedFile {
+public:
+  MappedFile() = default;
+  explicit MappedFile(const std::string &filePath) { this->Open(filePath); }
+  ~MappedFile() { this->Close(); }
+
+  MappedFile(MappedFile &&other) noexcept;
+  MappedFile &operator=(MappedFile &&other) noexcept;
+  MappedFile(const MappedFile &) = delete;
+  MappedFile &operator=(const MappedFile &) = delete;
+
+  // False if the file cannot be opened or is empty.
+  bool Open(const std::string &filePath);
+  void Close();
+
+  bool IsOpen() const { return this->Data != nullptr; }
+  const unsigned char *GetData() const { return this->Data; }
+  std::size_t GetSize() const { return this->Size; }
+
+private:
+  const unsigned char *Data = nullptr;
+  std::size_t Size = 0;
+#ifdef _WIN32
+  void *FileHandle = nullptr;
+  void *MappingHandle = nullptr;
+#endif
+};
+
+#endif // MAPPEDFILE_H_
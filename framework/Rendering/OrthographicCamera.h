@@ -26,20 +26,17 @@ public:
                      const glm::vec3& position = glm::vec3(0.0f), float rotation = 0.0f);
   ~OrthographicCamera() = default;
 
-  OrthographicCamera(const OrthographicCamera& camera) : Camera(camera)
-  {
-    this->Rotation = camera.Rotation;
-    this->CameraFrustrum = camera.CameraFrustrum;
-  }
+  OrthographicCamera(const OrthographicCamera& camera) = default;
 
   void SetRotation(float rotation)
-  { this->Rotation = rotation; this->RecalculateMatrix(); }
+  { this->Rotation = rotation; this->InvalidateView(); }
 
   void SetFrustrum(const Frustrum& frustrum)
-  { this->CameraFrustrum =frustrum; this->RecalculateMatrix(); }
+  { this->CameraFrustrum =frustrum; this->InvalidateProjection(); }
 
 protected:
-  void RecalculateMatrix();
+  glm::mat4 CalculateProjectionMatrix() const override;
+  glm::mat4 CalculateViewMatrix() const override;
 
 protected:
   float Rotation;
@@ -0,0 +1,62 @@
+#ifndef PACKFILE_H_
+#define PACKFILE_H_
+
+#include <cstdint>
+#include <string>
+
+// Pack files written by tools/ResourcePacker: many resources in one file,
+// so startup opens and maps one file instead of thousands, and resources
+// that are used together lie next to each other on disk.
+//
+// Layout: Header, entry data, the entry index and the path strings. Entries
+// are stored in path order. Each is either LZ4 compressed (see Lz4.h) or
+// stored as is; stored entries start on StoredAlignment boundaries, large
+// ones on LargeStoredAlignment (page) boundaries, so they can be used
+// straight from the mapping. The index is sorted by path hash, then path.
+namespace PackFile {
+
+constexpr std::uint32_t Magic = 0x4B434150; // "PACK"
+constexpr std::uint32_t Version = 1;
+constexpr std::uint64_t StoredAlignment = 16;
+constexpr std::uint64_t LargeStoredAlignment = 4096;
+constexpr std::uint64_t LargeEntrySize = 64 * 1024;
+
+enum class Compression : std::uint32_t { None = 0, Lz4 = 1 };
+
+struct Header {
+  std::uint32_t magic;
+  std::uint32_t version;
+  std::uint32_t entryCount;
+  std::uint32_t reserved;
+  std::uint64_t indexOffset; // entryCount Entry records
+  std::uint64_t pathsOffset; // path strings, not null terminated
+  std::uint64_t pathsSize;
+};
+
+struct Entry {
+  std::uint64_t pathHash;
+  std::uint64_t offset; // of the stored bytes, from the start of the file
+  std::uint64_t size;   // after decompression
+  std::uint64_t storedSize;
+  std::uint32_t pathOffset; // into the path strings
+  std::uint32_t pathLength;
+  Compression compression;
+  std::uint32_t reserved;
+};
+
+static_assert(sizeof(Header) == 40, "pack layouts are written as is");
+static_assert(sizeof(Entry) == 48, "pack layouts are written as is");
+
+// FNV-1a of a normalized path ('/' separated, no leading "./" or '/').
+inline std::uint64_t HashPath(const std::string &path) {
+  std::uint64_t hash = 14695981039346656037ull;
+  for (unsigned char c : path) {
+    hash ^= c;
+    hash *= 1099511628211ull;
+  }
+  return hash;
+}
+
+} // namespace PackFile
+
+#endif // PACKFILE_H_
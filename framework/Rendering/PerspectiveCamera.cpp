@@ -13,19 +13,38 @@ PerspectiveCamera::PerspectiveCamera(const Frustrum &frustrum,
   this->Position = position;
   this->LookAt = lookAt;
   this->UpVector = upVector;
-  PerspectiveCamera::RecalculateMatrix();
 }
 
-void PerspectiveCamera::RecalculateMatrix() {
-  this->ProjectionMatrix = glm::perspective(
-      glm::radians(CameraFrustrum.angle),           // FOV
-      CameraFrustrum.width / CameraFrustrum.height, // Aspect Ratio
-      CameraFrustrum.near,                          // Near clipping plane
-      CameraFrustrum.far                            // Far clipping plane
+glm::mat4 PerspectiveCamera::CalculateProjectionMatrix() const {
+  float fov = glm::radians(CameraFrustrum.angle);
+  float aspectRatio = CameraFrustrum.width / CameraFrustrum.height;
+
+  if (Depth == DepthMode::ReverseZInfinite) {
+    // clip z is the near distance and w the view depth, so depth = near / d
+    float focalLength = 1.0f / glm::tan(fov / 2.0f);
+    glm::mat4 projection(0.0f);
+    projection[0][0] = focalLength / aspectRatio;
+    projection[1][1] = focalLength;
+    projection[2][3] = -1.0f;
+    projection[3][2] = CameraFrustrum.near;
+    return projection;
+  }
+
+  return glm::perspective(fov,                 // FOV
+                          aspectRatio,         // Aspect Ratio
+                          CameraFrustrum.near, // Near clipping plane
+                          CameraFrustrum.far   // Far clipping plane
   );
+}
+
+glm::mat4 PerspectiveCamera::CalculateViewMatrix() const {
+  return glm::lookAt(Position, LookAt, UpVector);
+}
 
-  this->ViewMatrix = glm::lookAt(Position, LookAt, UpVector);
-  this->ViewProjectionMatrix = ProjectionMatrix * ViewMatrix;
+ViewFrustum::DepthRange PerspectiveCamera::GetDepthRange() const {
+  return Depth == DepthMode::ReverseZInfinite
+             ? ViewFrustum::DepthRange::ReversedZeroToOne
+             : ViewFrustum::DepthRange::MinusOneToOne;
 }
 
 void PerspectiveCamera::PrintAttributes() {
@@ -35,14 +54,14 @@ void PerspectiveCamera::PrintAttributes() {
   std::cout << "LOOKAT:   " << glm::to_string(this->LookAt) << std::endl;
 
   std::cout << "View Matrix: " << std::endl;
-  printMatrix(this->ViewMatrix);
+  printMatrix(this->GetViewMatrix());
   std::cout << "Projection Matrix" << std::endl;
-  printMatrix(this->ProjectionMatrix);
+  printMatrix(this->GetProjectionMatrix());
   std::cout << "View-Projection Matrix" << std::endl;
-  printMatrix(this->ViewProjectionMatrix);
+  printMatrix(this->GetViewProjectionMatrix());
 }
 
-void PerspectiveCamera::printMatrix(glm::mat4 &matrix) {
+void PerspectiveCamera::printMatrix(const glm::mat4 &matrix) {
   for (int i = 0; i < 4; i++) {
     for (int j = 0; j < 4; j++) {
       std::cout << std::setw(9) << matrix[i][j] << " ";
@@ -50,7 +69,7 @@ void PerspectiveCamera::printMatrix(glm::mat4 &matrix) {
     std::cout << std::endl;
   }
 }
-void PerspectiveCamera::printMatrix(glm::mat3 &matrix) {
+void PerspectiveCamera::printMatrix(const glm::mat3 &matrix) {
   for (int i = 0; i < 3; i++) {
     for (int j = 0; j < 3; j++) {
       std::cout << std::setw(9) << matrix[i][j] << " ";
@@ -15,6 +15,14 @@ public:
     float far;
   };
 
+  // ReverseZInfinite maps the near plane to depth 1 and infinity to depth
+  // 0, and ignores Frustrum::far. Floating point depth is densest near 0,
+  // which reverse-Z spends on the far distances, so with a float depth
+  // buffer the precision stays about even over any range and distant
+  // surfaces stop z-fighting. It needs the 0..1 clip space depth and the
+  // depth state set up by RenderCommands::EnableReverseDepth().
+  enum class DepthMode { Standard, ReverseZInfinite };
+
 public:
   PerspectiveCamera(const Frustrum &frustrum = {45.0f, 1.0f, 1.0f, 1.0f,
                                                 -10.0f},
@@ -23,39 +31,45 @@ public:
                     const glm::vec3 &upVector = glm::vec3(0.0f, 1.0f, 0.0f));
 
   ~PerspectiveCamera() = default;
-  PerspectiveCamera(const PerspectiveCamera &camera) : Camera(camera) {
-    this->LookAt = camera.LookAt;
-    this->UpVector = camera.UpVector;
-    this->CameraFrustrum = camera.CameraFrustrum;
-  }
+  PerspectiveCamera(const PerspectiveCamera &camera) = default;
 
   void SetFrustrum(const Frustrum &frustrum) {
     this->CameraFrustrum = frustrum;
-    this->RecalculateMatrix();
+    this->InvalidateProjection();
+  }
+  const Frustrum &GetFrustrum() const { return this->CameraFrustrum; }
+
+  void SetDepthMode(DepthMode depthMode) {
+    this->Depth = depthMode;
+    this->InvalidateProjection();
   }
+  DepthMode GetDepthMode() const { return this->Depth; }
 
   void SetLookAt(const glm::vec3 &lookAt) {
     this->LookAt = lookAt;
-    this->RecalculateMatrix();
+    this->InvalidateView();
   }
   const glm::vec3 &GetLookAt() { return this->LookAt; }
 
   void SetUpVector(const glm::vec3 &upVector) {
     this->UpVector = upVector;
-    this->RecalculateMatrix();
+    this->InvalidateView();
   }
 
   void PrintAttributes();
-  void printMatrix(glm::mat4 &matrix);
-  void printMatrix(glm::mat3 &matrix);
+  void printMatrix(const glm::mat4 &matrix);
+  void printMatrix(const glm::mat3 &matrix);
 
 protected:
-  void RecalculateMatrix();
+  glm::mat4 CalculateProjectionMatrix() const override;
+  glm::mat4 CalculateViewMatrix() const override;
+  ViewFrustum::DepthRange GetDepthRange() const override;
 
 protected:
   glm::vec3 LookAt;
   glm::vec3 UpVector;
   Frustrum CameraFrustrum;
+  DepthMode Depth = DepthMode::Standard;
 };
 
 #endif // PERSPECTIVECAMERA_H_
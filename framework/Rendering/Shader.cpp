@@ -4,75 +4,150 @@
 
 Shader::Shader(const std::string &vertexSrc, const std::string &fragmentSrc,
                const std::string &elementName) {
+  bool linked;
+  ShaderProgram = Shader::LinkProgram(vertexSrc, fragmentSrc, elementName, linked);
+  glUseProgram(ShaderProgram);
+}
+
+bool Shader::Rebuild(const std::string &vertexSrc,
+                     const std::string &fragmentSrc,
+                     const std::string &elementName) {
+  bool linked;
+  GLuint program =
+      Shader::LinkProgram(vertexSrc, fragmentSrc, elementName, linked);
+  if (!linked) {
+    glDeleteProgram(program);
+    return false;
+  }
+  glDeleteProgram(ShaderProgram);
+  ShaderProgram = program;
+  // the locations may have moved, and the new program starts at zero
+  glUseProgram(ShaderProgram);
+  for (auto &known : Uniforms) {
+    // the names are whole strings, so the views end in a null
+    known.second.Location =
+        glGetUniformLocation(ShaderProgram, known.first.data());
+    Apply(known.second);
+  }
+  return true;
+}
 
+GLuint Shader::LinkProgram(const std::string &vertexSrc,
+                           const std::string &fragmentSrc,
+                           const std::string &elementName, bool &linked) {
   GLuint VertexShader = Shader::CompileShader(GL_VERTEX_SHADER, vertexSrc);
   GLuint FragmentShader =
       Shader::CompileShader(GL_FRAGMENT_SHADER, fragmentSrc);
 
-  Shader::CheckForErrors(VertexShader, elementName + " VertexShader");
-  Shader::CheckForErrors(FragmentShader, elementName + "FragmentShader");
-  ShaderProgram = glCreateProgram();
-  glAttachShader(ShaderProgram, VertexShader);
-  glAttachShader(ShaderProgram, FragmentShader);
-  glLinkProgram(ShaderProgram);
+  linked = Shader::CheckForErrors(VertexShader, elementName + " VertexShader");
+  linked &= Shader::CheckForErrors(FragmentShader, elementName + "FragmentShader");
+  GLuint program = glCreateProgram();
+  glAttachShader(program, VertexShader);
+  glAttachShader(program, FragmentShader);
+  glLinkProgram(program);
 
   // Check for shader program linking errors
   GLint success = 0;
-  glGetProgramiv(ShaderProgram, GL_LINK_STATUS, &success);
+  glGetProgramiv(program, GL_LINK_STATUS, &success);
   if (!success) {
     GLchar infoLog[512];
-    glGetProgramInfoLog(ShaderProgram, 512, NULL, infoLog);
+    glGetProgramInfoLog(program, 512, NULL, infoLog);
     std::cerr << "Shader program linking failed:\n" << infoLog << std::endl;
+    linked = false;
   }
   glDeleteShader(VertexShader);
   glDeleteShader(FragmentShader);
-  glUseProgram(ShaderProgram);
+  return program;
 }
 
 Shader::~Shader() { glDeleteShader(ShaderProgram); }
 
+Shader::Uniform &Shader::GetUniform(const char *name) {
+  auto known = Uniforms.find(name);
+  if (known != Uniforms.end())
+    return known->second;
+  const std::string &key = UniformNames.emplace_back(name);
+  Uniform &uniform = Uniforms[key];
+  uniform.Location = glGetUniformLocation(ShaderProgram, name);
+  return uniform;
+}
+
+void Shader::Apply(const Uniform &uniform) {
+  const float *floats = glm::value_ptr(uniform.Floats);
+  switch (uniform.Type) {
+  case UniformType::Float:
+    glUniform1f(uniform.Location, floats[0]);
+    break;
+  case UniformType::Float2:
+    glUniform2f(uniform.Location, floats[0], floats[1]);
+    break;
+  case UniformType::Float3:
+    glUniform3f(uniform.Location, floats[0], floats[1], floats[2]);
+    break;
+  case UniformType::Int:
+    glUniform1i(uniform.Location, uniform.Ints.x);
+    break;
+  case UniformType::Int2:
+    glUniform2i(uniform.Location, uniform.Ints.x, uniform.Ints.y);
+    break;
+  case UniformType::FloatM4:
+    glUniformMatrix4fv(uniform.Location, 1, GL_FALSE, floats);
+    break;
+  case UniformType::None:
+    break;
+  }
+}
+
 void Shader::Bind() const { glUseProgram(ShaderProgram); }
 void Shader::Unbind() const { glUseProgram(0); }
 
-void Shader::UploadUniformFloat(const std::string &name, const float value) {
+void Shader::UploadUniformFloat(const char *name, const float value) {
   Bind();
-  GLuint uniform_location = glGetUniformLocation(ShaderProgram, name.c_str());
-  glUniform1f(uniform_location, value);
+  Uniform &uniform = GetUniform(name);
+  uniform.Type = UniformType::Float;
+  uniform.Floats[0][0] = value;
+  Apply(uniform);
 }
 
-void Shader::UploadUniformFloat2(const std::string &name,
-                                 const glm::vec2 &vector) {
+void Shader::UploadUniformFloat2(const char *name, const glm::vec2 &vector) {
   Bind();
-  GLuint uniform_location = glGetUniformLocation(ShaderProgram, name.c_str());
-  glUniform2f(uniform_location, vector.x, vector.y);
+  Uniform &uniform = GetUniform(name);
+  uniform.Type = UniformType::Float2;
+  uniform.Floats[0] = glm::vec4(vector, 0.0f, 0.0f);
+  Apply(uniform);
 }
 
-void Shader::UploadUniformFloat3(const std::string &name,
-                                 const glm::vec3 &vector) {
+void Shader::UploadUniformFloat3(const char *name, const glm::vec3 &vector) {
   Bind();
-  GLuint uniform_location = glGetUniformLocation(ShaderProgram, name.c_str());
-  glUniform3f(uniform_location, vector.x, vector.y, vector.z);
+  Uniform &uniform = GetUniform(name);
+  uniform.Type = UniformType::Float3;
+  uniform.Floats[0] = glm::vec4(vector, 0.0f);
+  Apply(uniform);
 }
 
-void Shader::UploadUniformInt(const std::string &name, const int value) {
+void Shader::UploadUniformInt(const char *name, const int value) {
   Bind();
-  GLuint uniform_location = glGetUniformLocation(ShaderProgram, name.c_str());
-  glUniform1i(uniform_location, value);
+  Uniform &uniform = GetUniform(name);
+  uniform.Type = UniformType::Int;
+  uniform.Ints.x = value;
+  Apply(uniform);
 }
 
 // Possible problem
-void Shader::UploadUniformInt2(const std::string &name,
-                               const glm::vec2 &vector) {
+void Shader::UploadUniformInt2(const char *name, const glm::vec2 &vector) {
   Bind();
-  GLuint uniform_location = glGetUniformLocation(ShaderProgram, name.c_str());
-  glUniform2i(uniform_location, vector.x, vector.y);
+  Uniform &uniform = GetUniform(name);
+  uniform.Type = UniformType::Int2;
+  uniform.Ints = glm::ivec2(vector);
+  Apply(uniform);
 }
 
-void Shader::UploadUniformFloatM4(const std::string &name,
-                                  const glm::mat4 &matrix) {
+void Shader::UploadUniformFloatM4(const char *name, const glm::mat4 &matrix) {
   Bind();
-  GLuint uniform_location = glGetUniformLocation(ShaderProgram, name.c_str());
-  glUniformMatrix4fv(uniform_location, 1, GL_FALSE, glm::value_ptr(matrix));
+  Uniform &uniform = GetUniform(name);
+  uniform.Type = UniformType::FloatM4;
+  uniform.Floats = matrix;
+  Apply(uniform);
 }
 
 GLuint Shader::CompileShader(GLenum shaderType, const std::string &shaderSrc) {
@@ -84,7 +159,7 @@ GLuint Shader::CompileShader(GLenum shaderType, const std::string &shaderSrc) {
   return (Shader);
 }
 
-void Shader::CheckForErrors(GLuint Shader, const std::string &shaderName) {
+bool Shader::CheckForErrors(GLuint Shader, const std::string &shaderName) {
   GLint success = 0;
   glGetShaderiv(Shader, GL_COMPILE_STATUS, &success);
   if (!success) {
@@ -92,4 +167,5 @@ void Shader::CheckForErrors(GLuint Shader, const std::string &shaderName) {
     glGetShaderInfoLog(Shader, 512, NULL, infoLog);
     std::cerr << shaderName << " compilation failed:\n" << infoLog << std::endl;
   }
+  return success;
 }
@@ -3,7 +3,10 @@
 
 #include <glad/glad.h>
 #include <glm/glm.hpp>
+#include <deque>
 #include <string>
+#include <string_view>
+#include <unordered_map>
 
 #include "glm/ext/matrix_clip_space.hpp"
 
@@ -13,19 +16,65 @@ public:
          const std::string &elementName);
   ~Shader();
 
+  // Compiles and links new sources into a fresh program, which replaces the
+  // current one only if it built; on errors the old program stays in use.
+  // The last value uploaded to each uniform is set again on the new program.
+  bool Rebuild(const std::string &vertexSrc, const std::string &fragmentSrc,
+               const std::string &elementName);
+
   void Bind() const;
   void Unbind() const;
-  void UploadUniformFloat(const std::string &name, const float value);
-  void UploadUniformFloat2(const std::string &name, const glm::vec2 &vector);
-  void UploadUniformFloat3(const std::string &name, const glm::vec3 &vector);
-  void UploadUniformInt(const std::string &name, const int value);
-  void UploadUniformInt2(const std::string &name, const glm::vec2 &vector);
-  void UploadUniformFloatM4(const std::string &name, const glm::mat4 &matrix);
+  // The names are looked up once per program and remembered; string
+  // literals go through the const char * versions without making a string.
+  void UploadUniformFloat(const char *name, const float value);
+  void UploadUniformFloat2(const char *name, const glm::vec2 &vector);
+  void UploadUniformFloat3(const char *name, const glm::vec3 &vector);
+  void UploadUniformInt(const char *name, const int value);
+  void UploadUniformInt2(const char *name, const glm::vec2 &vector);
+  void UploadUniformFloatM4(const char *name, const glm::mat4 &matrix);
+  void UploadUniformFloat(const std::string &name, const float value) {
+    UploadUniformFloat(name.c_str(), value);
+  }
+  void UploadUniformFloat2(const std::string &name, const glm::vec2 &vector) {
+    UploadUniformFloat2(name.c_str(), vector);
+  }
+  void UploadUniformFloat3(const std::string &name, const glm::vec3 &vector) {
+    UploadUniformFloat3(name.c_str(), vector);
+  }
+  void UploadUniformInt(const std::string &name, const int value) {
+    UploadUniformInt(name.c_str(), value);
+  }
+  void UploadUniformInt2(const std::string &name, const glm::vec2 &vector) {
+    UploadUniformInt2(name.c_str(), vector);
+  }
+  void UploadUniformFloatM4(const std::string &name, const glm::mat4 &matrix) {
+    UploadUniformFloatM4(name.c_str(), matrix);
+  }
 
 private:
+  enum class UniformType { None, Float, Float2, Float3, Int, Int2, FloatM4 };
+  struct Uniform {
+    GLint Location = -1;
+    // the last value uploaded, to set again after a rebuild
+    UniformType Type = UniformType::None;
+    glm::mat4 Floats{0.0f};
+    glm::ivec2 Ints{0};
+  };
+
   GLuint ShaderProgram;
+  // uniforms of ShaderProgram by name, location -1 for unknown names. The
+  // keys view into UniformNames, so a lookup does not make a string.
+  std::unordered_map<std::string_view, Uniform> Uniforms;
+  std::deque<std::string> UniformNames;
+
+  Uniform &GetUniform(const char *name);
+  // Sets the uniform's value on the bound program.
+  static void Apply(const Uniform &uniform);
 
+  GLuint LinkProgram(const std::string &vertexSrc,
+                     const std::string &fragmentSrc,
+                     const std::string &elementName, bool &linked);
   GLuint CompileShader(GLenum shaderType, const std::string &shaderSrc);
-  void CheckForErrors(GLuint Shader, const std::string &shaderName);
+  bool CheckForErrors(GLuint Shader, const std::string &shaderName);
 };
 #endif
@@ -0,0 +1,306 @@
+#include "TextureContainers.h"
+
+#include <algorithm>
+#include <climits>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+
+namespace TextureContainers {
+
+namespace {
+
+std::uint32_t ReadU32(const std::vector<unsigned char> &file,
+                      std::size_t offset) {
+  std::uint32_t value;
+  std::memcpy(&value, file.data() + offset, sizeof(value));
+  return value;
+}
+
+std::uint64_t ReadU64(const std::vector<unsigned char> &file,
+                      std::size_t offset) {
+  std::uint64_t value;
+  std::memcpy(&value, file.data() + offset, sizeof(value));
+  return value;
+}
+
+// A full mip chain of the largest image whose sides fit in an int
+constexpr std::uint32_t MaxLevels = 32;
+
+constexpr std::uint32_t FourCC(char a, char b, char c, char d) {
+  return std::uint32_t(a) | (std::uint32_t(b) << 8) |
+         (std::uint32_t(c) << 16) | (std::uint32_t(d) << 24);
+}
+
+std::size_t BlockBytes(GLenum format) {
+  switch (format) {
+  case GL_COMPRESSED_RGB_S3TC_DXT1_EXT:
+  case GL_COMPRESSED_RGBA_S3TC_DXT1_EXT:
+  case GL_COMPRESSED_SRGB_S3TC_DXT1_EXT:
+  case GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT1_EXT:
+  case GL_COMPRESSED_RGB8_ETC2:
+  case GL_COMPRESSED_SRGB8_ETC2:
+  case GL_COMPRESSED_RGB8_PUNCHTHROUGH_ALPHA1_ETC2:
+  case GL_COMPRESSED_SRGB8_PUNCHTHROUGH_ALPHA1_ETC2:
+    return 8;
+  case GL_COMPRESSED_RGBA_S3TC_DXT5_EXT:
+  case GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT:
+  case GL_COMPRESSED_RG_RGTC2:
+  case GL_COMPRESSED_RGBA_BPTC_UNORM:
+  case GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM:
+  case GL_COMPRESSED_RGBA8_ETC2_EAC:
+  case GL_COMPRESSED_SRGB8_ALPHA8_ETC2_EAC:
+    return 16;
+  }
+  return 0;
+}
+
+GLenum FormatFromDXGI(std::uint32_t dxgiFormat) {
+  switch (dxgiFormat) {
+  case 71: return GL_COMPRESSED_RGBA_S3TC_DXT1_EXT;        // BC1_UNORM
+  case 72: return GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT1_EXT;  // BC1_UNORM_SRGB
+  case 77: return GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;        // BC3_UNORM
+  case 78: return GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT;  // BC3_UNORM_SRGB
+  case 83: return GL_COMPRESSED_RG_RGTC2;                  // BC5_UNORM
+  case 98: return GL_COMPRESSED_RGBA_BPTC_UNORM;           // BC7_UNORM
+  case 99: return GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM;     // BC7_UNORM_SRGB
+  }
+  return 0;
+}
+
+GLenum FormatFromVulkan(std::uint32_t vkFormat) {
+  switch (vkFormat) {
+  case 131: return GL_COMPRESSED_RGB_S3TC_DXT1_EXT;        // BC1_RGB_UNORM
+  case 132: return GL_COMPRESSED_SRGB_S3TC_DXT1_EXT;       // BC1_RGB_SRGB
+  case 133: return GL_COMPRESSED_RGBA_S3TC_DXT1_EXT;       // BC1_RGBA_UNORM
+  case 134: return GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT1_EXT; // BC1_RGBA_SRGB
+  case 137: return GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;       // BC3_UNORM
+  case 138: return GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT; // BC3_SRGB
+  case 141: return GL_COMPRESSED_RG_RGTC2;                 // BC5_UNORM
+  case 145: return GL_COMPRESSED_RGBA_BPTC_UNORM;          // BC7_UNORM
+  case 146: return GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM;    // BC7_SRGB
+  case 147: return GL_COMPRESSED_RGB8_ETC2;                // ETC2_R8G8B8_UNORM
+  case 148: return GL_COMPRESSED_SRGB8_ETC2;               // ETC2_R8G8B8_SRGB
+  case 149: return GL_COMPRESSED_RGB8_PUNCHTHROUGH_ALPHA1_ETC2;
+  case 150: return GL_COMPRESSED_SRGB8_PUNCHTHROUGH_ALPHA1_ETC2;
+  case 151: return GL_COMPRESSED_RGBA8_ETC2_EAC;           // ETC2_R8G8B8A8_UNORM
+  case 152: return GL_COMPRESSED_SRGB8_ALPHA8_ETC2_EAC;    // ETC2_R8G8B8A8_SRGB
+  }
+  return 0;
+}
+
+// Sides come from the file as unsigned 32-bit values.
+bool IsValidSize(std::uint32_t width, std::uint32_t height) {
+  return width > 0 && height > 0 && width <= INT_MAX && height <= INT_MAX;
+}
+
+bool HasExtension(const char *name) {
+  GLint count = 0;
+  glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+  for (GLint i = 0; i < count; i++) {
+    auto extension =
+        reinterpret_cast<const char *>(glGetStringi(GL_EXTENSIONS, i));
+    if (extension && !std::strcmp(extension, name))
+      return true;
+  }
+  return false;
+}
+
+} // namespace
+
+std::size_t CompressedLevelSize(GLenum format, int width, int height) {
+  std::size_t blocksX = (std::size_t(std::max(width, 1)) + 3) / 4;
+  std::size_t blocksY = (std::size_t(std::max(height, 1)) + 3) / 4;
+  return blocksX * blocksY * BlockBytes(format);
+}
+
+bool LoadCompressedImage(const std::string &filePath, CompressedImage &image,
+                         std::string &error) {
+  std::ifstream stream(filePath, std::ios::binary);
+  if (!stream) {
+    error = "cannot open " + filePath;
+    return false;
+  }
+  std::vector<unsigned char> file((std::istreambuf_iterator<char>(stream)),
+                                  std::istreambuf_iterator<char>());
+
+  static const unsigned char ktx2Identifier[12] = {
+      0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n'};
+
+  if (file.size() >= 4 && !std::memcmp(file.data(), "DDS ", 4))
+    return ParseDDS(std::move(file), image, error);
+  if (file.size() >= 12 && !std::memcmp(file.data(), ktx2Identifier, 12))
+    return ParseKTX2(std::move(file), image, error);
+
+  error = filePath + " is neither a DDS nor a KTX2 file";
+  return false;
+}
+
+bool ParseDDS(std::vector<unsigned char> &&file, CompressedImage &image,
+              std::string &error) {
+  // "DDS " + DDS_HEADER (124 bytes), optionally followed by DDS_HEADER_DXT10
+  const std::size_t headerEnd = 4 + 124;
+  if (file.size() < headerEnd) {
+    error = "truncated DDS header";
+    return false;
+  }
+
+  std::uint32_t fileHeight = ReadU32(file, 4 + 8);
+  std::uint32_t fileWidth = ReadU32(file, 4 + 12);
+  std::uint32_t mipCount = std::max<std::uint32_t>(ReadU32(file, 4 + 24), 1);
+  std::uint32_t fourCC = ReadU32(file, 4 + 72 + 8); // DDS_PIXELFORMAT.dwFourCC
+  if (!IsValidSize(fileWidth, fileHeight) || mipCount > MaxLevels) {
+    error = "invalid DDS size or mip count";
+    return false;
+  }
+  int width = static_cast<int>(fileWidth);
+  int height = static_cast<int>(fileHeight);
+
+  std::size_t dataOffset = headerEnd;
+  GLenum format = 0;
+  if (fourCC == FourCC('D', 'X', 'T', '1'))
+    format = GL_COMPRESSED_RGBA_S3TC_DXT1_EXT;
+  else if (fourCC == FourCC('D', 'X', 'T', '5'))
+    format = GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+  else if (fourCC == FourCC('A', 'T', 'I', '2') ||
+           fourCC == FourCC('B', 'C', '5', 'U'))
+    format = GL_COMPRESSED_RG_RGTC2;
+  else if (fourCC == FourCC('D', 'X', '1', '0')) {
+    if (file.size() < headerEnd + 20) {
+      error = "truncated DDS DX10 header";
+      return false;
+    }
+    format = FormatFromDXGI(ReadU32(file, headerEnd));
+    if (ReadU32(file, headerEnd + 12) > 1) {
+      error = "DDS texture arrays are not supported";
+      return false;
+    }
+    dataOffset += 20;
+  }
+
+  if (!format) {
+    error = "unsupported DDS pixel format";
+    return false;
+  }
+
+  image.format = format;
+  image.width = width;
+  image.height = height;
+  image.levels.clear();
+
+  // mips follow each other, largest first
+  std::size_t offset = dataOffset;
+  for (std::uint32_t level = 0; level < mipCount; level++) {
+    int levelWidth = std::max(width >> level, 1);
+    int levelHeight = std::max(height >> level, 1);
+    std::size_t size = CompressedLevelSize(format, levelWidth, levelHeight);
+    if (size > file.size() - offset) {
+      error = "truncated DDS mip level";
+      return false;
+    }
+    image.levels.push_back({offset, size, levelWidth, levelHeight});
+    offset += size;
+  }
+
+  image.data = std::move(file);
+  return true;
+}
+
+bool ParseKTX2(std::vector<unsigned char> &&file, CompressedImage &image,
+               std::string &error) {
+  // identifier (12) + header (36) + index (32), then the level index
+  const std::size_t levelIndexOffset = 12 + 36 + 32;
+  if (file.size() < levelIndexOffset) {
+    error = "truncated KTX2 header";
+    return false;
+  }
+
+  std::uint32_t vkFormat = ReadU32(file, 12);
+  std::uint32_t fileWidth = ReadU32(file, 20);
+  std::uint32_t fileHeight = ReadU32(file, 24);
+  std::uint32_t depth = ReadU32(file, 28);
+  std::uint32_t layers = ReadU32(file, 32);
+  std::uint32_t faces = ReadU32(file, 36);
+  std::uint32_t levelCount = std::max<std::uint32_t>(ReadU32(file, 40), 1);
+  std::uint32_t supercompression = ReadU32(file, 44);
+
+  if (!IsValidSize(fileWidth, fileHeight) || levelCount > MaxLevels) {
+    error = "invalid KTX2 size or level count";
+    return false;
+  }
+  int width = static_cast<int>(fileWidth);
+  int height = static_cast<int>(fileHeight);
+  if (depth > 1 || layers > 1 || faces != 1) {
+    error = "only single 2D KTX2 images are supported";
+    return false;
+  }
+  if (supercompression != 0) {
+    error = "KTX2 supercompression is not supported";
+    return false;
+  }
+
+  GLenum format = FormatFromVulkan(vkFormat);
+  if (!format) {
+    error = "unsupported KTX2 vkFormat " + std::to_string(vkFormat);
+    return false;
+  }
+  if (file.size() - levelIndexOffset < std::size_t(levelCount) * 24) {
+    error = "truncated KTX2 level index";
+    return false;
+  }
+
+  image.format = format;
+  image.width = width;
+  image.height = height;
+  image.levels.clear();
+
+  // the level index lists level 0 first, whatever the order in the file
+  for (std::uint32_t level = 0; level < levelCount; level++) {
+    std::size_t entry = levelIndexOffset + std::size_t(level) * 24;
+    std::uint64_t offset = ReadU64(file, entry);
+    std::uint64_t size = ReadU64(file, entry + 8);
+    if (offset > file.size() || size > file.size() - offset) {
+      error = "truncated KTX2 mip level";
+      return false;
+    }
+    int levelWidth = std::max(width >> level, 1);
+    int levelHeight = std::max(height >> level, 1);
+    // glCompressedTexImage2D reads a whole level whatever size it is given
+    if (size != CompressedLevelSize(format, levelWidth, levelHeight)) {
+      error = "KTX2 mip level " + std::to_string(level) +
+              " does not match its size";
+      return false;
+    }
+    image.levels.push_back({static_cast<std::size_t>(offset),
+                            static_cast<std::size_t>(size), levelWidth,
+                            levelHeight});
+  }
+
+  image.data = std::move(file);
+  return true;
+}
+
+bool IsCompressedFormatSupported(GLenum format) {
+  switch (format) {
+  case GL_COMPRESSED_RGB_S3TC_DXT1_EXT:
+  case GL_COMPRESSED_RGBA_S3TC_DXT1_EXT:
+  case GL_COMPRESSED_RGBA_S3TC_DXT5_EXT: {
+    static const bool s3tc = HasExtension("GL_EXT_texture_compression_s3tc");
+    return s3tc;
+  }
+  case GL_COMPRESSED_SRGB_S3TC_DXT1_EXT:
+  case GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT1_EXT:
+  case GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT: {
+    static const bool s3tcSrgb =
+        HasExtension("GL_EXT_texture_compression_s3tc") &&
+        (HasExtension("GL_EXT_texture_sRGB") ||
+         HasExtension("GL_EXT_texture_compression_s3tc_srgb"));
+    return s3tcSrgb;
+  }
+  }
+  // RGTC and BPTC are core since 4.2, ETC2 since 4.3
+  return BlockBytes(format) != 0;
+}
+
+} // namespace TextureContainers
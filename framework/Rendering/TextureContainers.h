@@ -0,0 +1,62 @@
+#ifndef TEXTURECONTAINERS_H_
+#define TEXTURECONTAINERS_H_
+
+#include <glad/glad.h>
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+// S3TC is an extension on the GL versions we load; these enums are not part
+// of the generated glad header.
+#ifndef GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+#define GL_COMPRESSED_RGB_S3TC_DXT1_EXT 0x83F0
+#define GL_COMPRESSED_RGBA_S3TC_DXT1_EXT 0x83F1
+#define GL_COMPRESSED_RGBA_S3TC_DXT5_EXT 0x83F3
+#endif
+#ifndef GL_COMPRESSED_SRGB_S3TC_DXT1_EXT
+#define GL_COMPRESSED_SRGB_S3TC_DXT1_EXT 0x8C4C
+#define GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT1_EXT 0x8C4D
+#define GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT 0x8C4F
+#endif
+
+// Readers for precompressed texture containers (DDS and KTX2). The block
+// data is kept exactly as stored in the file and handed to
+// glCompressedTexImage2D level by level.
+namespace TextureContainers {
+
+struct MipLevel {
+  std::size_t offset; // into CompressedImage::data
+  std::size_t size;
+  int width;
+  int height;
+};
+
+struct CompressedImage {
+  GLenum format = 0;
+  int width = 0;
+  int height = 0;
+  std::vector<MipLevel> levels;
+  std::vector<unsigned char> data;
+};
+
+// Reads a .dds or .ktx2 file (told apart by their magic numbers). Supports
+// single 2D images in BC1, BC3, BC5, BC7 and ETC2 formats, without KTX2
+// supercompression. On failure `error` says why.
+bool LoadCompressedImage(const std::string &filePath, CompressedImage &image,
+                         std::string &error);
+
+bool ParseDDS(std::vector<unsigned char> &&file, CompressedImage &image,
+              std::string &error);
+bool ParseKTX2(std::vector<unsigned char> &&file, CompressedImage &image,
+               std::string &error);
+
+// Bytes of one mip level of the given size; 0 for unknown formats.
+std::size_t CompressedLevelSize(GLenum format, int width, int height);
+
+// Whether the current GL context can sample the format. Needs a context.
+bool IsCompressedFormatSupported(GLenum format);
+
+} // namespace TextureContainers
+
+#endif // TEXTURECONTAINERS_H_
@@ -1,10 +1,24 @@
 // This is the TextureManager.cpp
 #include "TextureManager.h"
+#include "ArenaAllocator.h"
+#include "CookedAssets.h"
+#include "VirtualFileSystem.h"
 
+#include <stb_image_resize.h>
+#include <stb_rect_pack.h>
+
+#include <algorithm>
+#include <cstring>
 #include <iostream>
+#include <thread>
 
 bool TextureManager::LoadTexture2DRGBA(const std::string& name, const std::string& filePath, GLuint unit, bool mipMap)
 {
+  if (this->Acquire(name).IsValid())
+    {
+    return true;
+    }
+
   int width, height, bpp;
   auto data = this->LoadTextureImage(filePath, width, height, bpp, STBI_rgb_alpha);
 
@@ -39,33 +53,33 @@ bool TextureManager::LoadTexture2DRGBA(const std::string& name, const std::strin
   texture.filePath = filePath;
   texture.unit = unit;
   texture.type = Texture2D;
+  texture.id = tex;
+  texture.resident = true;
 
-  this->Textures.push_back(texture);
+  this->Register(texture);
 
   this->FreeTextureImage(data);
 
   return true;
 }
 
-bool TextureManager::LoadCubeMapRGBA(const std::string& name, const std::string& filePath, GLuint unit, bool mipMap)
+bool TextureManager::CreateTexture2DRGBA(const std::string& name, const unsigned char* pixels, int width, int height, GLuint unit, bool mipMap)
 {
-  int width, height, bpp;
-  auto data = this->LoadTextureImage(filePath, width, height, bpp, STBI_rgb_alpha);
+  if (this->Acquire(name).IsValid())
+    {
+    return true;
+    }
 
-  if (!data)
+  if (!pixels || width <= 0 || height <= 0)
     {
     return false;
     }
 
-  /*Generate a texture object and upload the loaded image to it.*/
   GLuint tex;
   glGenTextures(1, &tex);
   glActiveTexture(GL_TEXTURE0 + unit); // Texture Unit
-  glBindTexture(GL_TEXTURE_CUBE_MAP, tex);
-
-  for (unsigned int i = 0; i < 6; i++) {
-    glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, data);
-  }
+  glBindTexture(GL_TEXTURE_2D, tex);
+  glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
 
   if (mipMap)
     {
@@ -73,43 +87,511 @@ bool TextureManager::LoadCubeMapRGBA(const std::string& name, const std::string&
     }
 
   // Wrapping
-  glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_REPEAT);
-  glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_REPEAT);
-  glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_REPEAT);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
   // Filtering
-  glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-  glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, mipMap ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
 
   Texture texture;
   texture.mipMap = mipMap;
   texture.width = width;
   texture.height = height;
+  texture.bpp = 4;
+  texture.name = name;
+  texture.unit = unit;
+  texture.type = Texture2D;
+  texture.id = tex;
+  texture.resident = true;
+
+  this->Register(texture);
+  return true;
+}
+
+bool TextureManager::LoadCubeMapRGBA(const std::string& name, const std::string& filePath, GLuint unit, bool mipMap)
+{
+  if (this->Acquire(name).IsValid())
+    {
+    return true;
+    }
+
+  Texture texture;
+  texture.mipMap = mipMap;
+  texture.width = 0;
+  texture.height = 0;
+  texture.bpp = 4;
   texture.name = name;
   texture.filePath = filePath;
   texture.unit = unit;
   texture.type = CubeMap;
+  texture.resident = true;
 
-  this->Textures.push_back(texture);
-  this->FreeTextureImage(data);
+  return this->RegisterCubeMap(texture);
+}
+
+bool TextureManager::LoadCubeMapRGBA(const std::string& name, const std::array<std::string, 6>& faces, GLuint unit, bool mipMap)
+{
+  if (this->Acquire(name).IsValid())
+    {
+    return true;
+    }
+
+  static const char* faceNames[6] = {"+X", "-X", "+Y", "-Y", "+Z", "-Z"};
+
+  Texture texture;
+  texture.mipMap = mipMap;
+  texture.width = 0;
+  texture.height = 0;
+  texture.bpp = 4;
+  texture.name = name;
+  texture.unit = unit;
+  texture.type = CubeMap;
+  texture.resident = true;
+  for (int i = 0; i < 6; i++)
+    {
+    texture.sources.push_back({faceNames[i], faces[i]});
+    }
+
+  return this->RegisterCubeMap(texture);
+}
 
+bool TextureManager::LoadSkyBoxRGBA(const std::string& name, const std::string& filePath, GLuint unit)
+{
+  if (this->Acquire(name).IsValid())
+    {
+    return true;
+    }
+
+  Texture texture;
+  texture.mipMap = false;
+  texture.width = 0;
+  texture.height = 0;
+  texture.bpp = 4;
+  texture.name = name;
+  texture.filePath = filePath;
+  texture.unit = unit;
+  texture.type = SkyBox;
+  texture.resident = true;
+
+  return this->RegisterCubeMap(texture);
+}
+
+bool TextureManager::CreateCubeMapRGBA(const std::string& name, const std::string& filePath, const unsigned char* pixels, int width, int height, GLuint unit, bool mipMap)
+{
+  if (this->Acquire(name).IsValid())
+    {
+    return true;
+    }
+
+  Texture texture;
+  texture.mipMap = mipMap;
+  texture.width = 0;
+  texture.height = 0;
+  texture.bpp = 4;
+  texture.name = name;
+  texture.filePath = filePath;
+  texture.unit = unit;
+  texture.type = CubeMap;
+  texture.resident = true;
+
+  return this->RegisterCubeMap(texture, pixels, width, height);
+}
+
+bool TextureManager::CreateSkyBoxRGBA(const std::string& name, const std::string& filePath, const unsigned char* pixels, int width, int height, GLuint unit)
+{
+  if (this->Acquire(name).IsValid())
+    {
+    return true;
+    }
+
+  Texture texture;
+  texture.mipMap = false;
+  texture.width = 0;
+  texture.height = 0;
+  texture.bpp = 4;
+  texture.name = name;
+  texture.filePath = filePath;
+  texture.unit = unit;
+  texture.type = SkyBox;
+  texture.resident = true;
+
+  return this->RegisterCubeMap(texture, pixels, width, height);
+}
+
+bool TextureManager::RegisterCubeMap(const Texture& texture, const unsigned char* pixels, int width, int height)
+{
+  TextureHandle handle = this->Register(texture);
+  Texture* registered = this->Resolve(handle);
+  glGenTextures(1, &registered->id);
+  bool filled = pixels ? this->FillCubeMap(*registered, pixels, width, height) : this->FillCubeMap(*registered);
+  if (!filled)
+    {
+    this->Unload(handle);
+    return false;
+    }
   return true;
 }
 
+namespace {
+
+// Top-left texel of every face inside the decoded image, with the image's
+// row length, so faces upload straight out of a cross or strip.
+struct CubeFace
+{
+  const unsigned char* pixels;
+  int rowLength;
+};
+
+// Returns the face size, 0 if the aspect ratio is not a known layout.
+int LocateCubeFaces(const unsigned char* data, int width, int height, std::array<CubeFace, 6>& faces, std::vector<unsigned char>& rotated)
+{
+  // (column, row) of +X, -X, +Y, -Y, +Z, -Z
+  static const int horizontalCross[6][2] = {{2, 1}, {0, 1}, {1, 0}, {1, 2}, {1, 1}, {3, 1}};
+  static const int verticalCross[6][2] = {{2, 1}, {0, 1}, {1, 0}, {1, 2}, {1, 1}, {1, 3}};
+
+  int size;
+  const int (*cells)[2] = nullptr;
+  if (width == height)
+    {
+    size = width;
+    }
+  else if (width * 3 == height * 4)
+    {
+    size = width / 4;
+    cells = horizontalCross;
+    }
+  else if (width * 4 == height * 3)
+    {
+    size = width / 3;
+    cells = verticalCross;
+    }
+  else if (width == height * 6 || height == width * 6)
+    {
+    size = std::min(width, height);
+    }
+  else
+    {
+    return 0;
+    }
+
+  for (int face = 0; face < 6; face++)
+    {
+    int column = 0, row = 0;
+    if (cells)
+      {
+      column = cells[face][0];
+      row = cells[face][1];
+      }
+    else if (width > height)
+      {
+      column = face;
+      }
+    else if (height > width)
+      {
+      row = face;
+      }
+    faces[face].pixels = data + (std::size_t(row) * size * width + std::size_t(column) * size) * 4;
+    faces[face].rowLength = width;
+    }
+
+  // the vertical cross stores -Z upside down below -Y
+  if (cells == verticalCross)
+    {
+    rotated.resize(std::size_t(size) * size * 4);
+    for (int y = 0; y < size; y++)
+      {
+      for (int x = 0; x < size; x++)
+        {
+        std::memcpy(&rotated[(std::size_t(y) * size + x) * 4],
+                    faces[5].pixels + (std::size_t(size - 1 - y) * width + (size - 1 - x)) * 4, 4);
+        }
+      }
+    faces[5].pixels = rotated.data();
+    faces[5].rowLength = size;
+    }
+  return size;
+}
+
+// Uploads the faces into the texture's cube map and records its size.
+void UploadCubeFaces(TextureManager::Texture& texture, const std::array<CubeFace, 6>& faces, int size)
+{
+  glActiveTexture(GL_TEXTURE0 + texture.unit); // Texture Unit
+  glBindTexture(GL_TEXTURE_CUBE_MAP, texture.id);
+  for (unsigned int i = 0; i < 6; i++)
+    {
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, faces[i].rowLength);
+    glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, GL_RGBA8, size, size, 0, GL_RGBA, GL_UNSIGNED_BYTE, faces[i].pixels);
+    }
+  glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+
+  if (texture.mipMap)
+    {
+    glGenerateMipmap(GL_TEXTURE_CUBE_MAP);
+    }
+
+  // Wrapping; only matters at face edges when seamless filtering is off
+  glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+  glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+  glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+  // Filtering
+  glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, texture.mipMap ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+  glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+  texture.width = size;
+  texture.height = size;
+}
+
+} // namespace
+
+bool TextureManager::FillCubeMap(Texture& texture)
+{
+  if (texture.sources.empty())
+    {
+    int width, height, bpp;
+    unsigned char* data = this->LoadTextureImage(texture.filePath, width, height, bpp, STBI_rgb_alpha);
+    if (!data)
+      {
+      std::cerr << "Failed to load texture " << texture.filePath << std::endl;
+      return false;
+      }
+    bool filled = this->FillCubeMap(texture, data, width, height);
+    this->FreeTextureImage(data);
+    return filled;
+    }
+
+  std::vector<std::string> filePaths;
+  for (const auto& source : texture.sources)
+    {
+    filePaths.push_back(source.filePath);
+    }
+  std::vector<DecodedImage> images = this->DecodeImages(filePaths);
+
+  std::array<CubeFace, 6> faces;
+  bool valid = true;
+  int size = images[0].data ? images[0].width : 0;
+  for (int face = 0; face < 6; face++)
+    {
+    if (!images[face].data || images[face].width != size || images[face].height != size)
+      {
+      std::cerr << "Cube map face " << images[face].name << " is missing or does not match the first face" << std::endl;
+      valid = false;
+      }
+    faces[face].pixels = images[face].data;
+    faces[face].rowLength = size;
+    }
+  if (valid)
+    {
+    UploadCubeFaces(texture, faces, size);
+    }
+
+  for (const auto& image : images)
+    {
+    this->FreeTextureImage(image.data);
+    }
+  return valid;
+}
+
+bool TextureManager::FillCubeMap(Texture& texture, const unsigned char* data, int width, int height)
+{
+  std::array<CubeFace, 6> faces;
+  std::vector<unsigned char> rotated;
+  int size = LocateCubeFaces(data, width, height, faces, rotated);
+  if (!size)
+    {
+    std::cerr << "Cube map " << texture.filePath << " is not a cross, strip or square image" << std::endl;
+    return false;
+    }
+  UploadCubeFaces(texture, faces, size);
+  return true;
+}
+
+std::vector<TextureManager::DecodedImage> TextureManager::DecodeImages(const std::vector<std::string>& filePaths)
+{
+  std::vector<DecodedImage> images(filePaths.size());
+  if (images.empty())
+    {
+    return images;
+    }
+
+  auto decode = [this, &filePaths, &images](std::size_t i)
+    {
+    int bpp;
+    images[i].name = filePaths[i];
+    images[i].data = this->LoadTextureImage(filePaths[i], images[i].width, images[i].height, bpp, STBI_rgb_alpha);
+    };
+
+  // one image per job, the calling thread taking its share
+  JobSystem::GetInstance()->ParallelFor(images.size(), 1, [&decode](std::size_t begin, std::size_t)
+    {
+    decode(begin);
+    });
+  return images;
+}
+
+bool TextureManager::LoadCompressedTexture2D(const std::string& name, const std::string& filePath, GLuint unit)
+{
+  return this->LoadCompressedTexture2D(name, std::vector<std::string>{filePath}, unit);
+}
+
+bool TextureManager::LoadCompressedTexture2D(const std::string& name, const std::vector<std::string>& candidates, GLuint unit)
+{
+  if (this->Acquire(name).IsValid())
+    {
+    return true;
+    }
+
+  TextureContainers::CompressedImage image;
+  std::string filePath;
+  for (const auto& candidate : candidates)
+    {
+    std::string error;
+    if (!TextureContainers::LoadCompressedImage(candidate, image, error))
+      {
+      std::cerr << "Failed to load texture " << candidate << ": " << error << std::endl;
+      continue;
+      }
+    if (TextureContainers::IsCompressedFormatSupported(image.format))
+      {
+      filePath = candidate;
+      break;
+      }
+    }
+
+  if (filePath.empty())
+    {
+    return false;
+    }
+
+  GLuint tex;
+  glGenTextures(1, &tex);
+  glActiveTexture(GL_TEXTURE0 + unit); // Texture Unit
+  glBindTexture(GL_TEXTURE_2D, tex);
+  this->UploadCompressedImage(image);
+
+  // Wrapping
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+
+  Texture texture;
+  texture.mipMap = image.levels.size() > 1;
+  texture.width = image.width;
+  texture.height = image.height;
+  texture.bpp = 0;
+  texture.name = name;
+  texture.filePath = filePath;
+  texture.unit = unit;
+  texture.type = Texture2D;
+  texture.id = tex;
+  texture.resident = true;
+  texture.compressed = true;
+
+  this->Register(texture);
+
+  return true;
+}
+
+void TextureManager::UploadCompressedImage(const TextureContainers::CompressedImage& image) const
+{
+  for (std::size_t level = 0; level < image.levels.size(); level++)
+    {
+    const auto& mip = image.levels[level];
+    glCompressedTexImage2D(GL_TEXTURE_2D, GLint(level), image.format, mip.width, mip.height, 0,
+                           GLsizei(mip.size), image.data.data() + mip.offset);
+    }
+
+  // only the levels shipped in the file exist
+  GLint maxLevel = GLint(image.levels.size()) - 1;
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, 0);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, maxLevel);
+  // Filtering
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, maxLevel > 0 ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+}
+
+
+bool TextureManager::LoadCookedTexture2D(const std::string& name, const std::string& filePath, GLuint unit)
+{
+  if (this->Acquire(name).IsValid())
+    {
+    return true;
+    }
+
+  Texture texture;
+  texture.bpp = 4;
+  texture.name = name;
+  texture.filePath = filePath;
+  texture.unit = unit;
+  texture.type = Texture2D;
+  texture.resident = true;
+  texture.cooked = true;
+  glGenTextures(1, &texture.id);
+
+  if (!this->UploadCookedTexture(texture, texture.width, texture.height))
+    {
+    glDeleteTextures(1, &texture.id);
+    return false;
+    }
+  texture.mipMap = true;
+
+  // Wrapping
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+
+  this->Register(texture);
+  return true;
+}
+
+bool TextureManager::UploadCookedTexture(const Texture& texture, int& width, int& height) const
+{
+  CookedAssets::AssetFile file(texture.filePath);
+  std::string error = "cannot open file";
+  const CookedAssets::TextureHeader* header = file.IsOpen() ? CookedAssets::GetTexture(file, error) : nullptr;
+  if (!header)
+    {
+    std::cerr << "Failed to load texture " << texture.filePath << ": " << error << std::endl;
+    return false;
+    }
+
+  glActiveTexture(GL_TEXTURE0 + texture.unit); // Texture Unit
+  glBindTexture(GL_TEXTURE_2D, texture.id);
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+  const CookedAssets::TextureLevel* levels = CookedAssets::GetTextureLevels(header);
+  for (std::uint32_t level = 0; level < header->levelCount; level++)
+    {
+    glTexImage2D(GL_TEXTURE_2D, GLint(level), GLint(header->internalFormat), levels[level].width, levels[level].height, 0,
+                 header->format, header->type, file.GetData() + levels[level].offset);
+    }
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+  GLint maxLevel = GLint(header->levelCount) - 1;
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, 0);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, maxLevel);
+  // Filtering
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, maxLevel > 0 ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+  width = int(header->width);
+  height = int(header->height);
+  return true;
+}
 
 GLuint TextureManager::GetUnitByName(const std::string& name) const
 {
- for(const auto& texture: this->Textures)
-   {
-   if (!texture.name.compare(name))
-     {
-     return texture.unit;
-     }
-   }
- return -1;
+  return this->GetUnit(this->GetHandle(name));
 }
 
 unsigned char* TextureManager::LoadTextureImage(const std::string& filepath, int& width, int& height, int& bpp, int format) const
 {
+  // resource paths go through the mounted packs and directories first
+  VirtualFileSystem* fileSystem = VirtualFileSystem::GetInstance();
+  if (fileSystem->HasMounts())
+    {
+    VirtualFile file = fileSystem->Open(filepath);
+    if (file)
+      {
+      return stbi_load_from_memory(file.GetData(), static_cast<int>(file.GetSize()), &width, &height, &bpp, format);
+      }
+    }
   return stbi_load(filepath.c_str(), &width, &height, &bpp, format);
 }
 
@@ -121,3 +603,682 @@ void TextureManager::FreeTextureImage(unsigned char* data) const
     stbi_image_free(data);
     }
 }
+
+// ============================================================================
+// Texture arrays and atlases
+// ============================================================================
+
+bool TextureManager::BuildTextureArray(const std::string& name, const std::vector<TextureSource>& layers, GLuint unit, bool mipMap)
+{
+  if (this->Acquire(name).IsValid())
+    {
+    return true;
+    }
+  if (layers.empty())
+    {
+    return false;
+    }
+
+  Texture texture;
+  texture.mipMap = mipMap;
+  texture.width = 0;
+  texture.height = 0;
+  texture.bpp = 4;
+  texture.name = name;
+  texture.unit = unit;
+  texture.type = Texture2DArray;
+  texture.resident = true;
+  texture.sources = layers;
+  glGenTextures(1, &texture.id);
+
+  TextureHandle handle = this->Register(texture);
+  if (!this->FillTextureArray(*this->Resolve(handle), handle))
+    {
+    this->Unload(handle);
+    return false;
+    }
+  return true;
+}
+
+bool TextureManager::BuildTextureAtlas(const std::string& name, const std::vector<TextureSource>& images, GLuint unit, int padding, bool mipMap)
+{
+  if (this->Acquire(name).IsValid())
+    {
+    return true;
+    }
+  if (images.empty())
+    {
+    return false;
+    }
+
+  Texture texture;
+  texture.mipMap = mipMap;
+  texture.width = 0;
+  texture.height = 0;
+  texture.bpp = 4;
+  texture.name = name;
+  texture.unit = unit;
+  texture.type = TextureAtlas;
+  texture.resident = true;
+  texture.sources = images;
+  texture.padding = std::max(padding, 0);
+  glGenTextures(1, &texture.id);
+
+  TextureHandle handle = this->Register(texture);
+  if (!this->FillTextureAtlas(*this->Resolve(handle), handle))
+    {
+    this->Unload(handle);
+    return false;
+    }
+  return true;
+}
+
+TextureManager::TextureRegion TextureManager::GetRegion(const std::string& sourceName) const
+{
+  auto found = this->Regions.find(sourceName);
+  return found != this->Regions.end() ? found->second : TextureRegion();
+}
+
+bool TextureManager::FillTextureArray(Texture& texture, TextureHandle handle)
+{
+  std::vector<unsigned char*> images;
+  std::vector<int> widths, heights;
+  for (const auto& source : texture.sources)
+    {
+    int width, height, bpp;
+    unsigned char* data = this->LoadTextureImage(source.filePath, width, height, bpp, STBI_rgb_alpha);
+    if (!data)
+      {
+      std::cerr << "Failed to load texture " << source.filePath << std::endl;
+      for (auto image : images)
+        {
+        this->FreeTextureImage(image);
+        }
+      return false;
+      }
+    images.push_back(data);
+    widths.push_back(width);
+    heights.push_back(height);
+    }
+
+  const int width = widths[0], height = heights[0];
+  const GLsizei layerCount = GLsizei(images.size());
+
+  glActiveTexture(GL_TEXTURE0 + texture.unit); // Texture Unit
+  glBindTexture(GL_TEXTURE_2D_ARRAY, texture.id);
+  glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_RGBA8, width, height, layerCount, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+
+  std::vector<unsigned char> resized;
+  for (GLsizei layer = 0; layer < layerCount; layer++)
+    {
+    const unsigned char* pixels = images[layer];
+    if (widths[layer] != width || heights[layer] != height)
+      {
+      resized.resize(std::size_t(width) * height * 4);
+      stbir_resize_uint8(images[layer], widths[layer], heights[layer], 0, resized.data(), width, height, 0, 4);
+      pixels = resized.data();
+      }
+    glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, layer, width, height, 1, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+    this->FreeTextureImage(images[layer]);
+
+    TextureRegion region;
+    region.texture = handle;
+    region.layer = GLuint(layer);
+    this->Regions[texture.sources[layer].name] = region;
+    }
+
+  if (texture.mipMap)
+    {
+    glGenerateMipmap(GL_TEXTURE_2D_ARRAY);
+    }
+
+  // Wrapping
+  glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_REPEAT);
+  glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_REPEAT);
+  // Filtering
+  glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, texture.mipMap ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+  glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+  texture.width = width;
+  texture.height = height;
+  return true;
+}
+
+bool TextureManager::FillTextureAtlas(Texture& texture, TextureHandle handle)
+{
+  struct SourceImage
+  {
+    unsigned char* data;
+    int width, height;
+  };
+
+  std::vector<SourceImage> images;
+  for (const auto& source : texture.sources)
+    {
+    SourceImage image;
+    int bpp;
+    image.data = this->LoadTextureImage(source.filePath, image.width, image.height, bpp, STBI_rgb_alpha);
+    if (!image.data)
+      {
+      std::cerr << "Failed to load texture " << source.filePath << std::endl;
+      for (const auto& loaded : images)
+        {
+        this->FreeTextureImage(loaded.data);
+        }
+      return false;
+      }
+    images.push_back(image);
+    }
+
+  // A level-n texel covers 2^n texels of level 0, so mip levels up to
+  // log2(padding) stay inside each image's gutter, provided every rectangle
+  // starts on a multiple of 2^n. Skyline packing places rectangles at sums of
+  // the other rectangles' sizes, so rounding the sizes up is enough.
+  const int padding = texture.padding;
+  int mipLevels = 0;
+  while (texture.mipMap && (2 << mipLevels) <= padding)
+    {
+    mipLevels++;
+    }
+  const int alignment = 1 << mipLevels;
+
+  std::vector<stbrp_rect> rects(images.size());
+  long long area = 0;
+  int largest = 1;
+  for (std::size_t i = 0; i < images.size(); i++)
+    {
+    rects[i].id = int(i);
+    rects[i].w = (images[i].width + 2 * padding + alignment - 1) / alignment * alignment;
+    rects[i].h = (images[i].height + 2 * padding + alignment - 1) / alignment * alignment;
+    area += (long long)rects[i].w * rects[i].h;
+    largest = std::max({largest, int(rects[i].w), int(rects[i].h)});
+    }
+
+  GLint maxSize;
+  glGetIntegerv(GL_MAX_TEXTURE_SIZE, &maxSize);
+
+  // the smallest power of two square that fits
+  int size = 1;
+  while (size < largest || (long long)size * size < area)
+    {
+    size *= 2;
+    }
+  std::vector<stbrp_node> nodes;
+  for (;; size *= 2)
+    {
+    if (size > maxSize)
+      {
+      std::cerr << "Texture atlas " << texture.name << " does not fit in " << maxSize << "x" << maxSize << std::endl;
+      for (const auto& image : images)
+        {
+        this->FreeTextureImage(image.data);
+        }
+      return false;
+      }
+    stbrp_context context;
+    nodes.resize(size);
+    stbrp_init_target(&context, size, size, nodes.data(), size);
+    if (stbrp_pack_rects(&context, rects.data(), int(rects.size())))
+      {
+      break;
+      }
+    }
+
+  // copy every image into its rectangle, repeating its edge texels into the
+  // gutter so filtering across the border picks up the image's own colour
+  std::vector<unsigned char> pixels(std::size_t(size) * size * 4, 0);
+  for (const auto& rect : rects)
+    {
+    const SourceImage& image = images[rect.id];
+    for (int y = -padding; y < image.height + padding; y++)
+      {
+      int sourceY = std::clamp(y, 0, image.height - 1);
+      for (int x = -padding; x < image.width + padding; x++)
+        {
+        int sourceX = std::clamp(x, 0, image.width - 1);
+        std::memcpy(&pixels[(std::size_t(rect.y + padding + y) * size + rect.x + padding + x) * 4],
+                    &image.data[(std::size_t(sourceY) * image.width + sourceX) * 4], 4);
+        }
+      }
+    this->FreeTextureImage(image.data);
+
+    TextureRegion region;
+    region.texture = handle;
+    region.offset = glm::vec2(rect.x + padding, rect.y + padding) / float(size);
+    region.scale = glm::vec2(image.width, image.height) / float(size);
+    this->Regions[texture.sources[rect.id].name] = region;
+    }
+
+  glActiveTexture(GL_TEXTURE0 + texture.unit); // Texture Unit
+  glBindTexture(GL_TEXTURE_2D, texture.id);
+  glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, size, size, 0, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, mipLevels);
+  if (mipLevels > 0)
+    {
+    glGenerateMipmap(GL_TEXTURE_2D);
+    }
+
+  // Wrapping; repeating would sample the neighbouring images
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+  // Filtering
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, mipLevels > 0 ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+  texture.width = size;
+  texture.height = size;
+  return true;
+}
+
+// ============================================================================
+// Registry
+// ============================================================================
+
+TextureManager::TextureHandle TextureManager::Register(const Texture& texture)
+{
+  std::uint32_t index;
+  if (!this->FreeSlots.empty())
+    {
+    index = this->FreeSlots.back();
+    this->FreeSlots.pop_back();
+    }
+  else
+    {
+    index = static_cast<std::uint32_t>(this->Slots.size());
+    this->Slots.emplace_back();
+    }
+
+  TextureSlot& slot = this->Slots[index];
+  slot.texture = texture;
+  slot.refCount = 1;
+  slot.used = true;
+
+  TextureHandle handle;
+  handle.index = index;
+  handle.generation = slot.generation;
+  this->Handles[texture.name] = handle;
+  return handle;
+}
+
+TextureManager::Texture* TextureManager::Resolve(TextureHandle handle)
+{
+  if (handle.index >= this->Slots.size())
+    {
+    return nullptr;
+    }
+  TextureSlot& slot = this->Slots[handle.index];
+  return slot.used && slot.generation == handle.generation ? &slot.texture : nullptr;
+}
+
+const TextureManager::Texture* TextureManager::Resolve(TextureHandle handle) const
+{
+  return const_cast<TextureManager*>(this)->Resolve(handle);
+}
+
+TextureManager::TextureHandle TextureManager::GetHandle(const std::string& name) const
+{
+  auto found = this->Handles.find(name);
+  return found != this->Handles.end() ? found->second : TextureHandle();
+}
+
+const TextureManager::Texture* TextureManager::GetTexture(TextureHandle handle) const
+{
+  return this->Resolve(handle);
+}
+
+GLuint TextureManager::GetUnit(TextureHandle handle) const
+{
+  const Texture* texture = this->Resolve(handle);
+  return texture ? texture->unit : -1;
+}
+
+std::uint32_t TextureManager::GetRefCount(TextureHandle handle) const
+{
+  return this->Resolve(handle) ? this->Slots[handle.index].refCount : 0;
+}
+
+TextureManager::TextureHandle TextureManager::Acquire(const std::string& name)
+{
+  return this->Acquire(this->GetHandle(name));
+}
+
+TextureManager::TextureHandle TextureManager::Acquire(TextureHandle handle)
+{
+  if (!this->Resolve(handle))
+    {
+    return TextureHandle();
+    }
+  this->Slots[handle.index].refCount++;
+  return handle;
+}
+
+void TextureManager::Release(TextureHandle handle)
+{
+  if (!this->Resolve(handle))
+    {
+    return;
+    }
+  if (--this->Slots[handle.index].refCount == 0)
+    {
+    this->Unload(handle);
+    }
+}
+
+bool TextureManager::Unload(TextureHandle handle)
+{
+  Texture* texture = this->Resolve(handle);
+  if (!texture)
+    {
+    return false;
+    }
+
+  glDeleteTextures(1, &texture->id);
+  this->Handles.erase(texture->name);
+  for (auto region = this->Regions.begin(); region != this->Regions.end();)
+    {
+    region = region->second.texture == handle ? this->Regions.erase(region) : std::next(region);
+    }
+
+  TextureSlot& slot = this->Slots[handle.index];
+  slot.texture = Texture();
+  slot.refCount = 0;
+  slot.used = false;
+  slot.generation++;
+  this->FreeSlots.push_back(handle.index);
+  return true;
+}
+
+bool TextureManager::Reload(TextureHandle handle)
+{
+  Texture* texture = this->Resolve(handle);
+  if (!texture)
+    {
+    return false;
+    }
+
+  if (texture->type == Texture2DArray)
+    {
+    return this->FillTextureArray(*texture, handle);
+    }
+  if (texture->type == TextureAtlas)
+    {
+    return this->FillTextureAtlas(*texture, handle);
+    }
+  if (texture->type == CubeMap || texture->type == SkyBox)
+    {
+    return this->FillCubeMap(*texture);
+    }
+
+  if (texture->cooked)
+    {
+    return this->UploadCookedTexture(*texture, texture->width, texture->height);
+    }
+
+  if (texture->compressed)
+    {
+    TextureContainers::CompressedImage image;
+    std::string error;
+    if (!TextureContainers::LoadCompressedImage(texture->filePath, image, error))
+      {
+      std::cerr << "Failed to reload texture " << texture->filePath << ": " << error << std::endl;
+      return false;
+      }
+    glActiveTexture(GL_TEXTURE0 + texture->unit); // Texture Unit
+    glBindTexture(GL_TEXTURE_2D, texture->id);
+    this->UploadCompressedImage(image);
+    texture->mipMap = image.levels.size() > 1;
+    texture->width = image.width;
+    texture->height = image.height;
+    return true;
+    }
+
+  // created from pixels in memory, there is nothing to read again
+  if (texture->filePath.empty())
+    {
+    return true;
+    }
+
+  int width, height, bpp;
+  auto data = this->LoadTextureImage(texture->filePath, width, height, bpp, STBI_rgb_alpha);
+  if (!data)
+    {
+    return false;
+    }
+
+  glActiveTexture(GL_TEXTURE0 + texture->unit); // Texture Unit
+  glBindTexture(GL_TEXTURE_2D, texture->id);
+  glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, data);
+  if (texture->mipMap)
+    {
+    glGenerateMipmap(GL_TEXTURE_2D);
+    }
+
+  texture->width = width;
+  texture->height = height;
+  texture->resident = true;
+
+  this->FreeTextureImage(data);
+  return true;
+}
+
+bool TextureManager::Reload(TextureHandle handle, const unsigned char* pixels, int width, int height)
+{
+  Texture* texture = this->Resolve(handle);
+  if (!texture || texture->type != Texture2D || texture->compressed || texture->cooked || !pixels)
+    {
+    return false;
+    }
+
+  glActiveTexture(GL_TEXTURE0 + texture->unit); // Texture Unit
+  glBindTexture(GL_TEXTURE_2D, texture->id);
+  glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+  if (texture->mipMap)
+    {
+    glGenerateMipmap(GL_TEXTURE_2D);
+    }
+
+  texture->width = width;
+  texture->height = height;
+  texture->resident = true;
+  return true;
+}
+
+TextureManager::~TextureManager()
+{
+  // the decode jobs push into DecodedImages
+  JobSystem::GetInstance()->Wait(this->DecodeJobs);
+}
+
+// ============================================================================
+// Asynchronous loading
+// ============================================================================
+
+TextureManager::TextureHandle TextureManager::LoadTexture2DRGBAAsync(const std::string& name, const std::string& filePath, GLuint unit, bool mipMap)
+{
+  TextureHandle existing = this->Acquire(name);
+  if (existing.IsValid())
+    {
+    return existing;
+    }
+
+  // 1x1 mid grey until the real image is resident
+  const unsigned char placeholder[4] = {128, 128, 128, 255};
+
+  GLuint tex;
+  glGenTextures(1, &tex);
+  glActiveTexture(GL_TEXTURE0 + unit); // Texture Unit
+  glBindTexture(GL_TEXTURE_2D, tex);
+  glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, placeholder);
+
+  // Wrapping
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+  // Filtering
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+  Texture texture;
+  texture.mipMap = mipMap;
+  texture.width = 1;
+  texture.height = 1;
+  texture.bpp = 4;
+  texture.name = name;
+  texture.filePath = filePath;
+  texture.unit = unit;
+  texture.type = Texture2D;
+  texture.id = tex;
+  texture.resident = false;
+  TextureHandle handle = this->Register(texture);
+
+  this->PendingLoads++;
+  JobSystem::GetInstance()->Submit([this, handle, name, filePath]()
+    {
+    DecodedImage image;
+    int bpp;
+    image.handle = handle;
+    image.name = name;
+    image.data = this->LoadTextureImage(filePath, image.width, image.height, bpp, STBI_rgb_alpha);
+
+    std::lock_guard<std::mutex> lock(this->DecodedMutex);
+    this->DecodedImages.push_back(image);
+    }, &this->DecodeJobs);
+
+  return handle;
+}
+
+void TextureManager::ProcessAsyncUploads(std::size_t byteBudget)
+{
+  // ==== retire uploads whose fence has signalled ====
+  for (auto upload = this->InFlightUploads.begin(); upload != this->InFlightUploads.end();)
+    {
+    if (glClientWaitSync(upload->fence, 0, 0) == GL_TIMEOUT_EXPIRED)
+      {
+      ++upload;
+      continue;
+      }
+
+    glDeleteSync(upload->fence);
+    glDeleteBuffers(1, &upload->pixelBuffer);
+    // the texture may have been unloaded while its upload was in flight
+    if (auto texture = this->Resolve(upload->handle))
+      {
+      texture->resident = true;
+      }
+    this->PendingLoads--;
+    upload = this->InFlightUploads.erase(upload);
+    }
+
+  // ==== start uploads of decoded images, within the budget ====
+  ScratchScope scratch;
+  ScratchVector<DecodedImage> ready;
+  {
+  std::lock_guard<std::mutex> lock(this->DecodedMutex);
+  std::size_t bytes = 0;
+  auto image = this->DecodedImages.begin();
+  // always take at least one image, however large
+  while (image != this->DecodedImages.end() && (ready.empty() || bytes < byteBudget))
+    {
+    bytes += std::size_t(image->width) * image->height * 4;
+    ready.push_back(std::move(*image));
+    ++image;
+    }
+  this->DecodedImages.erase(this->DecodedImages.begin(), image);
+  }
+
+  for (const auto& image : ready)
+    {
+    if (!image.data)
+      {
+      std::cerr << "Failed to load texture " << image.name << std::endl;
+      this->PendingLoads--;
+      continue;
+      }
+    this->StartUpload(image);
+    this->FreeTextureImage(image.data);
+    }
+}
+
+void TextureManager::FinishAsyncUploads()
+{
+  while (this->PendingLoads > 0)
+    {
+    this->ProcessAsyncUploads(static_cast<std::size_t>(-1));
+    for (const auto& upload : this->InFlightUploads)
+      {
+      glClientWaitSync(upload.fence, GL_SYNC_FLUSH_COMMANDS_BIT, GL_TIMEOUT_IGNORED);
+      }
+    if (this->InFlightUploads.empty())
+      {
+      std::this_thread::yield();
+      }
+    }
+}
+
+bool TextureManager::IsResident(const std::string& name) const
+{
+  const Texture* texture = this->Resolve(this->GetHandle(name));
+  return texture && texture->resident;
+}
+
+void TextureManager::StartUpload(const DecodedImage& image)
+{
+  Texture* texture = this->Resolve(image.handle);
+  if (!texture)
+    {
+    this->PendingLoads--;
+    return;
+    }
+
+  GLsizeiptr size = GLsizeiptr(image.width) * image.height * 4;
+
+  // copy into a pixel buffer; glTexImage2D then sources from it without
+  // stalling on the transfer
+  GLuint pixelBuffer;
+  glGenBuffers(1, &pixelBuffer);
+  glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pixelBuffer);
+  glBufferData(GL_PIXEL_UNPACK_BUFFER, size, nullptr, GL_STREAM_DRAW);
+  void* mapped = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, size,
+                                  GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+  // the mapping can fail, e.g. when the driver is out of memory; upload
+  // straight from the decoded image then
+  if (mapped)
+    {
+    std::memcpy(mapped, image.data, size);
+    glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+    }
+  else
+    {
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    glDeleteBuffers(1, &pixelBuffer);
+    pixelBuffer = 0;
+    }
+
+  glActiveTexture(GL_TEXTURE0 + texture->unit); // Texture Unit
+  glBindTexture(GL_TEXTURE_2D, texture->id);
+  glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, image.width, image.height, 0, GL_RGBA, GL_UNSIGNED_BYTE, mapped ? nullptr : image.data);
+  glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+  if (texture->mipMap)
+    {
+    glGenerateMipmap(GL_TEXTURE_2D);
+    // the placeholder had no mipmaps to filter between
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    }
+
+  texture->width = image.width;
+  texture->height = image.height;
+
+  if (!mapped)
+    {
+    // glTexImage2D has copied the pixels before returning
+    texture->resident = true;
+    this->PendingLoads--;
+    return;
+    }
+
+  InFlightUpload upload;
+  upload.handle = image.handle;
+  upload.pixelBuffer = pixelBuffer;
+  upload.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+  this->InFlightUploads.push_back(upload);
+}
@@ -4,17 +4,33 @@
 
 // External libraries
 #include <glad/glad.h>
+#include <glm/glm.hpp>
 #include <stb_image.h>
 
+#include "JobSystem.h"
+#include "TextureContainers.h"
+
 // STD includes
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 class TextureManager
 {
 public:
 
-  enum TextureType {Texture2D, Texture3D, CubeMap, SkyBox};
+  enum TextureType {Texture2D, Texture3D, CubeMap, SkyBox, Texture2DArray, TextureAtlas};
+
+  // Named image for the texture array and atlas builders.
+  struct TextureSource
+  {
+    std::string name;
+    std::string filePath;
+  };
 
   struct Texture
   {
@@ -24,6 +40,36 @@ public:
     std::string filePath;
     GLuint unit;
     TextureManager::TextureType type;
+    GLuint id;      // OpenGL texture object
+    bool resident;  // false while an asynchronous load is still in flight
+    bool compressed = false; // block compressed, loaded from a DDS/KTX2 file
+    bool cooked = false;     // loaded from an AssetCooker .ctex file
+    std::vector<TextureSource> sources; // images of an array or atlas
+    int padding = 0;                    // atlas gutter, in texels
+  };
+
+  // Refers to one registered texture. Unloading a texture moves its slot to
+  // the next generation, so handles that still point at it go stale and
+  // resolve to nothing instead of to whatever reuses the slot.
+  struct TextureHandle
+  {
+    std::uint32_t index = 0xFFFFFFFF;
+    std::uint32_t generation = 0;
+
+    bool IsValid() const { return index != 0xFFFFFFFF; }
+    bool operator==(const TextureHandle& other) const
+    { return index == other.index && generation == other.generation; }
+    bool operator!=(const TextureHandle& other) const { return !(*this == other); }
+  };
+
+  // Where a source image of an array or atlas ended up. Sample with
+  // (layer, offset + uv * scale); for arrays the offset is 0 and scale 1.
+  struct TextureRegion
+  {
+    TextureHandle texture;
+    GLuint layer = 0;
+    glm::vec2 offset = glm::vec2(0.f);
+    glm::vec2 scale = glm::vec2(1.f);
   };
 
 public:
@@ -31,14 +77,133 @@ public:
   {return TextureManager::Instance != nullptr?TextureManager::Instance: TextureManager::Instance = new TextureManager(); }
 
 public:
+  // The loaders register the texture with one reference. Loading a name that
+  // is already registered adds a reference to it instead of loading again.
   bool LoadTexture2DRGBA(const std::string& name, const std::string& filepath, GLuint unit, bool mipMap=true);
+  // From RGBA8 pixels already in memory, e.g. images embedded in a glTF
+  // file. Such textures have no file, so Reload() leaves them as they are.
+  bool CreateTexture2DRGBA(const std::string& name, const unsigned char* pixels, int width, int height, GLuint unit, bool mipMap=true);
+  // Cube maps. A single image holding every face is split by its aspect
+  // ratio: 4:3 horizontal cross, 3:4 vertical cross, 6:1 or 1:6 strip in
+  // +X, -X, +Y, -Y, +Z, -Z order. A square image is used for all six faces.
   bool LoadCubeMapRGBA(const std::string& name, const std::string& filePath, GLuint unit, bool mipMap=true);
+  // Six files in +X, -X, +Y, -Y, +Z, -Z order, decoded in parallel.
+  bool LoadCubeMapRGBA(const std::string& name, const std::array<std::string, 6>& faces, GLuint unit, bool mipMap=true);
+  // A cube map laid out like the single image above, registered as SkyBox.
+  // The sky is seen at about one texel per pixel, so it has no mip levels.
+  bool LoadSkyBoxRGBA(const std::string& name, const std::string& filePath, GLuint unit);
+  // The same from an image that is already decoded, e.g. by LoadTextureImage
+  // on a worker thread, so only the upload is left for the render thread.
+  // `filePath` is where the image came from, for Reload().
+  bool CreateCubeMapRGBA(const std::string& name, const std::string& filePath, const unsigned char* pixels, int width, int height, GLuint unit, bool mipMap=true);
+  bool CreateSkyBoxRGBA(const std::string& name, const std::string& filePath, const unsigned char* pixels, int width, int height, GLuint unit);
+  // Precompressed textures (.dds or .ktx2). The stored blocks and mip levels
+  // are uploaded as they are, nothing is decoded on the CPU.
+  bool LoadCompressedTexture2D(const std::string& name, const std::string& filePath, GLuint unit);
+  // Loads the first candidate whose format the context supports, e.g. a BC7
+  // file with an ETC2 fallback.
+  bool LoadCompressedTexture2D(const std::string& name, const std::vector<std::string>& candidates, GLuint unit);
+  // Textures cooked by tools/AssetCooker. The file is read through the
+  // VirtualFileSystem, or memory mapped when nothing is mounted, and its
+  // prebuilt mip levels are uploaded straight from it.
+  bool LoadCookedTexture2D(const std::string& name, const std::string& filePath, GLuint unit);
   GLuint GetUnitByName(const std::string& name) const;
 
-private:
+  // Texture arrays and atlases let many materials share one binding, so
+  // draws no longer have to be grouped by texture and one instanced draw can
+  // mix materials through per-instance region data.
+  // A GL_TEXTURE_2D_ARRAY with one layer per source, in order. Layers take
+  // the size of the first image; the others are resampled to it.
+  bool BuildTextureArray(const std::string& name, const std::vector<TextureSource>& layers, GLuint unit, bool mipMap=true);
+  // One GL_TEXTURE_2D with every source packed into it (skyline packing, the
+  // smallest power of two square that fits). Each image is surrounded by
+  // `padding` texels of its repeated edge, and only the mip levels that the
+  // gutter keeps from bleeding are generated.
+  bool BuildTextureAtlas(const std::string& name, const std::vector<TextureSource>& images, GLuint unit, int padding=4, bool mipMap=true);
+  // Lookup by source name. The region's handle is invalid if the name is
+  // unknown; it goes stale with the array or atlas.
+  TextureRegion GetRegion(const std::string& sourceName) const;
+
+  // Registry. Name lookups are hashed, handle lookups index a slot array.
+  TextureHandle GetHandle(const std::string& name) const;
+  // Null for stale or invalid handles.
+  const Texture* GetTexture(TextureHandle handle) const;
+  GLuint GetUnit(TextureHandle handle) const;
+  std::uint32_t GetRefCount(TextureHandle handle) const;
+  std::size_t GetTextureCount() const { return this->Handles.size(); }
+
+  // Adds a reference to a registered texture. Invalid handle if unknown.
+  TextureHandle Acquire(const std::string& name);
+  TextureHandle Acquire(TextureHandle handle);
+  // Drops a reference; the texture is unloaded when none are left.
+  void Release(TextureHandle handle);
+  // Deletes the texture from VRAM now, whatever its reference count.
+  bool Unload(TextureHandle handle);
+  bool Unload(const std::string& name) { return this->Unload(this->GetHandle(name)); }
+  // Reads the texture's file again into the same texture object, so handles
+  // and bindings stay valid.
+  bool Reload(TextureHandle handle);
+  // Replaces the image of a 2D texture with RGBA8 pixels that were decoded
+  // elsewhere, e.g. by a reimport on a background thread.
+  bool Reload(TextureHandle handle, const unsigned char* pixels, int width, int height);
+
+  // Image decoding, thread safe, for loaders that run off the render
+  // thread. Reads through the VirtualFileSystem when anything is mounted,
+  // so the paths may name resources in packs; plain files otherwise.
   unsigned char* LoadTextureImage(const std::string& filepath, int& width, int& height, int& bpp, int format)const;
   void FreeTextureImage(unsigned char* data) const;
 
+  // Asynchronous loading. The texture is created and bound to `unit` right
+  // away with a 1x1 placeholder, so it can be used immediately. The PNG is
+  // decoded on a worker thread and uploaded through a pixel buffer object by
+  // ProcessAsyncUploads(); it becomes resident once the upload's fence has
+  // signalled. Returns the texture's handle, which names the placeholder
+  // until then, or the existing texture's if `name` is already loaded.
+  TextureHandle LoadTexture2DRGBAAsync(const std::string& name, const std::string& filePath, GLuint unit, bool mipMap=true);
+  // Call once per frame on the render thread. Starts uploads of decoded
+  // images, up to `byteBudget` bytes, and retires finished ones.
+  void ProcessAsyncUploads(std::size_t byteBudget = 64 * 1024 * 1024);
+  // Blocks until every pending asynchronous load is resident.
+  void FinishAsyncUploads();
+  bool IsResident(const std::string& name) const;
+  std::size_t GetPendingLoadCount() const { return this->PendingLoads; }
+
+private:
+  // Image decoded by a worker, waiting for its upload.
+  struct DecodedImage
+  {
+    TextureHandle handle;
+    std::string name;
+    unsigned char* data;
+    int width, height;
+  };
+
+  // Upload started from a pixel buffer, waiting for its fence.
+  struct InFlightUpload
+  {
+    TextureHandle handle;
+    GLuint pixelBuffer;
+    GLsync fence;
+  };
+
+private:
+  void UploadCompressedImage(const TextureContainers::CompressedImage& image) const;
+  bool UploadCookedTexture(const Texture& texture, int& width, int& height) const;
+  bool FillTextureArray(Texture& texture, TextureHandle handle);
+  bool FillTextureAtlas(Texture& texture, TextureHandle handle);
+  bool FillCubeMap(Texture& texture);
+  bool FillCubeMap(Texture& texture, const unsigned char* data, int width, int height);
+  // Registers a CubeMap or SkyBox texture and fills it, from `pixels` if
+  // given, otherwise from its files.
+  bool RegisterCubeMap(const Texture& texture, const unsigned char* pixels = nullptr, int width = 0, int height = 0);
+  // Decodes the files as jobs, with the calling thread helping, and waits.
+  std::vector<DecodedImage> DecodeImages(const std::vector<std::string>& filePaths);
+  TextureHandle Register(const Texture& texture);
+  Texture* Resolve(TextureHandle handle);
+  const Texture* Resolve(TextureHandle handle) const;
+
+  void StartUpload(const DecodedImage& image);
+
 private:
   TextureManager(){};
   ~TextureManager();
@@ -49,7 +214,28 @@ private:
   inline static TextureManager* Instance = nullptr;
 
 private:
-  std::vector<TextureManager::Texture> Textures;
+  struct TextureSlot
+  {
+    Texture texture;
+    std::uint32_t generation = 0;
+    std::uint32_t refCount = 0;
+    bool used = false;
+  };
+
+  std::vector<TextureSlot> Slots;
+  std::vector<std::uint32_t> FreeSlots;
+  std::unordered_map<std::string, TextureHandle> Handles;
+  std::unordered_map<std::string, TextureRegion> Regions;
+
+  // asynchronous loads still decoding on the JobSystem
+  JobCounter DecodeJobs;
+
+  // handed from the workers to the render thread
+  std::vector<DecodedImage> DecodedImages;
+  std::mutex DecodedMutex;
+
+  std::vector<InFlightUpload> InFlightUploads;
+  std::size_t PendingLoads = 0;
 };
 
 #endif // TEXTUREMANAGER_H_
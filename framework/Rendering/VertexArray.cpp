@@ -1,6 +1,8 @@
 #include "VertexArray.h"
 #include "ShaderDataTypes.h"
 
+#include <algorithm>
+#include <cstdint>
 #include <memory>
 
 #include <glad/glad.h>
@@ -13,19 +15,29 @@ void VertexArray::Bind() const { glBindVertexArray(vertexArrayID); }
 
 void VertexArray::AddVertexBuffer(
     const std::shared_ptr<VertexBuffer> &vertexBuffer) {
+  // attributes of later buffers continue after those of earlier ones
+  AddVertexBuffer(vertexBuffer, vertexBuffer->GetLayout(), AttributeCount);
+}
+
+void VertexArray::AddVertexBuffer(
+    const std::shared_ptr<VertexBuffer> &vertexBuffer,
+    const BufferLayout &layout, GLuint location) {
   Bind();
   vertexBuffer->Bind();
 
-  const BufferLayout &layout = vertexBuffer->GetLayout();
-  unsigned attributeIndex = 0;
   for (const auto &attribute : layout) {
-    glEnableVertexAttribArray(attributeIndex);
+    glEnableVertexAttribArray(location);
     glVertexAttribPointer(
-        attributeIndex, ShaderDataTypeComponentCount(attribute.Type),
+        location, ShaderDataTypeComponentCount(attribute.Type),
         ShaderDataTypeToOpenGLBaseType(attribute.Type), attribute.Normalized,
-        layout.GetStride(), (const void *)attribute.Offset);
-    attributeIndex++;
+        layout.GetStride(),
+        reinterpret_cast<const void *>(std::uintptr_t(attribute.Offset)));
+    glVertexAttribDivisor(location, attribute.Divisor);
+    location++;
   }
+  AttributeCount = std::max(AttributeCount, location);
+
+  VertexBuffers.push_back(vertexBuffer);
 }
 
 void VertexArray::SetIndexBuffer(
@@ -19,7 +19,14 @@ public:
   // Add vertex buffer. This method utilizes the BufferLayout internal to
   // the vertex buffer to set up the vertex attributes. Notice that
   // this function opens for the definition of several vertex buffers.
+  // The vertex array keeps the buffer alive for as long as it exists.
   void AddVertexBuffer(const std::shared_ptr<VertexBuffer> &vertexBuffer);
+  // Adds the buffer with a layout other than its own, with its attributes
+  // at locations `location` on. One buffer can so feed several vertex
+  // arrays, each reading different attributes out of it. Locations left out
+  // keep the current generic attribute value.
+  void AddVertexBuffer(const std::shared_ptr<VertexBuffer> &vertexBuffer,
+                       const BufferLayout &layout, GLuint location);
   // Set index buffer
   void SetIndexBuffer(const std::shared_ptr<IndexBuffer> &indexBuffer);
 
@@ -30,6 +37,7 @@ public:
 
 private:
   GLuint vertexArrayID;
+  GLuint AttributeCount = 0;
   std::vector<std::shared_ptr<VertexBuffer>> VertexBuffers;
   std::shared_ptr<IndexBuffer> IdxBuffer;
 
@@ -2,10 +2,10 @@
 #include "iostream"
 #include <glad/glad.h>
 
-VertexBuffer::VertexBuffer(const void *data, GLsizei size) {
+VertexBuffer::VertexBuffer(const void *data, GLsizei size, GLenum usage) {
   glGenBuffers(1, &VertexBufferID);
   glBindBuffer(GL_ARRAY_BUFFER, VertexBufferID);
-  glBufferData(GL_ARRAY_BUFFER, size, data, GL_STATIC_DRAW);
+  glBufferData(GL_ARRAY_BUFFER, size, data, usage);
 }
 
 VertexBuffer::~VertexBuffer() {
@@ -10,8 +10,9 @@ private:
   BufferLayout Layout;
 public:
   // Constructor: initializes the VertexBuffer with a data buffer and its size.
-  // Note that the buffer is bound upon construction.
-  VertexBuffer(const void *vertices, GLsizei size);
+  // Note that the buffer is bound upon construction. Buffers refilled every
+  // frame should pass GL_DYNAMIC_DRAW or GL_STREAM_DRAW as usage.
+  VertexBuffer(const void *vertices, GLsizei size, GLenum usage = GL_STATIC_DRAW);
   ~VertexBuffer();
 
   // Bind the VertexBuffer
@@ -7,16 +7,19 @@
 #include <ShaderDataTypes.h>
 
 struct BufferAttribute {
-    // Constructor
-    BufferAttribute(ShaderDataType type, const std::string &name, GLboolean normalized = false)
+    // Constructor. A non-zero divisor makes the attribute advance once per
+    // `divisor` instances instead of once per vertex.
+    BufferAttribute(ShaderDataType type, const std::string &name, GLboolean normalized = false,
+                    GLuint divisor = 0)
         : Name(name), Type(type), Size(ShaderDataTypeSize(type)), Offset(0),
-            Normalized(normalized) {}
+            Normalized(normalized), Divisor(divisor) {}
 
     std::string Name;
     ShaderDataType Type;
     GLuint Size;
     GLuint Offset;
     GLboolean Normalized;
+    GLuint Divisor;
 };
 
 class BufferLayout {
@@ -26,6 +29,14 @@ public:
         : Attributes(attributes) {
         this->CalculateOffsetAndStride();
     }
+    explicit BufferLayout(const std::vector<BufferAttribute> &attributes)
+        : Attributes(attributes) {
+        this->CalculateOffsetAndStride();
+    }
+    // Keeps the offsets the attributes already carry, for data laid out by
+    // someone else, e.g. interleaved glTF buffer views with gaps.
+    BufferLayout(const std::vector<BufferAttribute> &attributes, GLsizei stride)
+        : Attributes(attributes), Stride(stride) {}
 
     inline const std::vector<BufferAttribute>& GetAttributes() const { return this->Attributes; }
     inline GLsizei GetStride() const { return this->Stride; }
@@ -0,0 +1,81 @@
+#ifndef VIEWFRUSTUM_H_
+#define VIEWFRUSTUM_H_
+
+#include <glm/glm.hpp>
+
+#include <array>
+
+// The six clipping planes of a view-projection matrix, used for culling.
+// Planes are stored as (normal, distance) with normals pointing inwards.
+class ViewFrustum {
+public:
+  enum Plane { Left, Right, Bottom, Top, Near, Far };
+
+  // Clip space depth of the projection: OpenGL's default, 0..1 as with
+  // glClipControl(..., GL_ZERO_TO_ONE), or 0..1 with the near plane at 1
+  // (reverse-Z).
+  enum class DepthRange { MinusOneToOne, ZeroToOne, ReversedZeroToOne };
+
+public:
+  ViewFrustum() = default;
+  explicit ViewFrustum(const glm::mat4 &viewProjection,
+                       DepthRange depthRange = DepthRange::MinusOneToOne) {
+    this->SetMatrix(viewProjection, depthRange);
+  }
+
+  // Extracts the planes from the rows of the matrix (Gribb & Hartmann).
+  void SetMatrix(const glm::mat4 &m,
+                 DepthRange depthRange = DepthRange::MinusOneToOne) {
+    glm::vec4 row0(m[0][0], m[1][0], m[2][0], m[3][0]);
+    glm::vec4 row1(m[0][1], m[1][1], m[2][1], m[3][1]);
+    glm::vec4 row2(m[0][2], m[1][2], m[2][2], m[3][2]);
+    glm::vec4 row3(m[0][3], m[1][3], m[2][3], m[3][3]);
+
+    this->Planes[Left] = row3 + row0;
+    this->Planes[Right] = row3 - row0;
+    this->Planes[Bottom] = row3 + row1;
+    this->Planes[Top] = row3 - row1;
+    // -w <= z <= w, or 0 <= z <= w
+    glm::vec4 lowerDepth =
+        depthRange == DepthRange::MinusOneToOne ? row3 + row2 : row2;
+    glm::vec4 upperDepth = row3 - row2;
+    bool reversed = depthRange == DepthRange::ReversedZeroToOne;
+    this->Planes[Near] = reversed ? upperDepth : lowerDepth;
+    this->Planes[Far] = reversed ? lowerDepth : upperDepth;
+
+    for (auto &plane : this->Planes) {
+      float length = glm::length(glm::vec3(plane));
+      if (length > 0.f)
+        plane /= length;
+    }
+  }
+
+  const glm::vec4 &GetPlane(Plane plane) const { return this->Planes[plane]; }
+
+  // False only when the box lies completely outside one of the planes.
+  // A plane with a zero normal (an infinite far plane) never rejects.
+  bool IntersectsBox(const glm::vec3 &min, const glm::vec3 &max) const {
+    for (const auto &plane : this->Planes) {
+      // the box corner furthest along the plane normal
+      glm::vec3 corner(plane.x >= 0.f ? max.x : min.x,
+                       plane.y >= 0.f ? max.y : min.y,
+                       plane.z >= 0.f ? max.z : min.z);
+      if (glm::dot(glm::vec3(plane), corner) + plane.w < 0.f)
+        return false;
+    }
+    return true;
+  }
+
+  bool IntersectsSphere(const glm::vec3 &center, float radius) const {
+    for (const auto &plane : this->Planes) {
+      if (glm::dot(glm::vec3(plane), center) + plane.w < -radius)
+        return false;
+    }
+    return true;
+  }
+
+private:
+  std::array<glm::vec4, 6> Planes = {};
+};
+
+#endif // VIEWFRUSTUM_H_
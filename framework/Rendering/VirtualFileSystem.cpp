@@ -0,0 +1,235 @@
+#include "VirtualFileSystem.h"
+#include "Lz4.h"
+#include "PackFile.h"
+
+#include <algorithm>
+#include <filesystem>
+#include <iostream>
+#include <mutex>
+
+namespace fs = std::filesystem;
+
+struct VirtualFileSystem::Pack {
+  MappedFile file;
+  const PackFile::Entry *entries = nullptr;
+  std::uint32_t entryCount = 0;
+  const char *paths = nullptr;
+
+  const PackFile::Entry *Find(const std::string &path) const {
+    std::uint64_t hash = PackFile::HashPath(path);
+    const PackFile::Entry *end = this->entries + this->entryCount;
+    const PackFile::Entry *entry = std::lower_bound(
+        this->entries, end, hash,
+        [](const PackFile::Entry &e, std::uint64_t h) { return e.pathHash < h; });
+    for (; entry != end && entry->pathHash == hash; entry++)
+      if (path.compare(0, std::string::npos, this->paths + entry->pathOffset,
+                       entry->pathLength) == 0)
+        return entry;
+    return nullptr;
+  }
+};
+
+std::string VirtualFileSystem::NormalizePath(const std::string &path) {
+  std::string result;
+  result.reserve(path.size());
+  std::size_t begin = 0;
+  while (begin <= path.size()) {
+    std::size_t end = path.find_first_of("/\\", begin);
+    if (end == std::string::npos)
+      end = path.size();
+    std::size_t length = end - begin;
+    if (length == 2 && path.compare(begin, 2, "..") == 0) {
+      // a resource path cannot leave the mounts' roots
+      if (result.empty())
+        return std::string();
+      std::size_t slash = result.find_last_of('/');
+      result.erase(slash == std::string::npos ? 0 : slash);
+    } else if (length > 0 && !(length == 1 && path[begin] == '.')) {
+      if (!result.empty())
+        result += '/';
+      result.append(path, begin, length);
+    }
+    begin = end + 1;
+  }
+  return result;
+}
+
+namespace {
+
+std::string NormalizeMountPoint(const std::string &mountPoint) {
+  std::string point = VirtualFileSystem::NormalizePath(mountPoint);
+  return point.empty() ? point : point + '/';
+}
+
+} // namespace
+
+bool VirtualFileSystem::MountPack(const std::string &packPath,
+                                  const std::string &mountPoint) {
+  auto pack = std::make_shared<Pack>();
+  if (!pack->file.Open(packPath)) {
+    std::cerr << "Failed to open pack " << packPath << std::endl;
+    return false;
+  }
+
+  // check every table and entry once here, so lookups can trust the file
+  const unsigned char *data = pack->file.GetData();
+  std::uint64_t size = pack->file.GetSize();
+  auto inFile = [size](std::uint64_t offset, std::uint64_t length) {
+    return offset <= size && length <= size - offset;
+  };
+  auto header = reinterpret_cast<const PackFile::Header *>(data);
+  bool valid = inFile(0, sizeof(PackFile::Header)) &&
+               header->magic == PackFile::Magic &&
+               header->version == PackFile::Version &&
+               header->indexOffset % alignof(PackFile::Entry) == 0 &&
+               inFile(header->indexOffset,
+                      std::uint64_t(header->entryCount) * sizeof(PackFile::Entry)) &&
+               inFile(header->pathsOffset, header->pathsSize);
+  if (valid) {
+    pack->entries =
+        reinterpret_cast<const PackFile::Entry *>(data + header->indexOffset);
+    pack->entryCount = header->entryCount;
+    pack->paths = reinterpret_cast<const char *>(data + header->pathsOffset);
+    for (std::uint32_t i = 0; valid && i < pack->entryCount; i++) {
+      const PackFile::Entry &entry = pack->entries[i];
+      valid = inFile(entry.offset, entry.storedSize) &&
+              std::uint64_t(entry.pathOffset) + entry.pathLength <= header->pathsSize &&
+              (entry.compression == PackFile::Compression::Lz4 ||
+               (entry.compression == PackFile::Compression::None &&
+                entry.storedSize == entry.size)) &&
+              (i == 0 || pack->entries[i - 1].pathHash <= entry.pathHash);
+    }
+  }
+  if (!valid) {
+    std::cerr << packPath << " is not a valid pack file" << std::endl;
+    return false;
+  }
+
+  std::unique_lock<std::shared_mutex> lock(this->MountMutex);
+  this->Mounts.push_back({NormalizeMountPoint(mountPoint), "", std::move(pack)});
+  return true;
+}
+
+bool VirtualFileSystem::MountDirectory(const std::string &directory,
+                                       const std::string &mountPoint) {
+  std::error_code error;
+  if (!fs::is_directory(directory, error)) {
+    std::cerr << "Failed to mount directory " << directory << std::endl;
+    return false;
+  }
+
+  std::unique_lock<std::shared_mutex> lock(this->MountMutex);
+  this->Mounts.push_back({NormalizeMountPoint(mountPoint), directory, nullptr});
+  return true;
+}
+
+void VirtualFileSystem::UnmountAll() {
+  std::unique_lock<std::shared_mutex> lock(this->MountMutex);
+  this->Mounts.clear();
+}
+
+bool VirtualFileSystem::HasMounts() const {
+  std::shared_lock<std::shared_mutex> lock(this->MountMutex);
+  return !this->Mounts.empty();
+}
+
+template <typename Visit>
+bool VirtualFileSystem::FindFile(const std::string &path, Visit &&visit) const {
+  std::string normalized = NormalizePath(path);
+  if (normalized.empty())
+    return false;
+  std::shared_lock<std::shared_mutex> lock(this->MountMutex);
+  for (auto mount = this->Mounts.rbegin(); mount != this->Mounts.rend(); mount++) {
+    if (normalized.compare(0, mount->point.size(), mount->point) != 0)
+      continue;
+    if (visit(*mount, normalized.substr(mount->point.size())))
+      return true;
+  }
+  return false;
+}
+
+bool VirtualFileSystem::Exists(const std::string &path) const {
+  FileInfo info;
+  return this->Stat(path, info);
+}
+
+bool VirtualFileSystem::Stat(const std::string &path, FileInfo &info) const {
+  return this->FindFile(path, [&](const Mount &mount, const std::string &relative) {
+    if (mount.pack) {
+      const PackFile::Entry *entry = mount.pack->Find(relative);
+      if (!entry)
+        return false;
+      info.size = entry->size;
+      info.storedSize = entry->storedSize;
+      info.packed = true;
+      info.compressed = entry->compression != PackFile::Compression::None;
+      return true;
+    }
+
+    std::error_code error;
+    fs::path file = fs::path(mount.directory) / relative;
+    if (!fs::is_regular_file(file, error))
+      return false;
+    info.size = info.storedSize = fs::file_size(file, error);
+    info.packed = false;
+    info.compressed = false;
+    return !error;
+  });
+}
+
+VirtualFile VirtualFileSystem::Open(const std::string &path) const {
+  VirtualFile result;
+  this->FindFile(path, [&](const Mount &mount, const std::string &relative) {
+    if (mount.pack) {
+      const PackFile::Entry *entry = mount.pack->Find(relative);
+      if (!entry)
+        return false;
+      const unsigned char *stored = mount.pack->file.GetData() + entry->offset;
+      if (entry->compression == PackFile::Compression::None) {
+        result.Data = stored;
+        result.Archive = mount.pack;
+      } else {
+        result.Buffer.resize(entry->size);
+        if (!Lz4::Decompress(stored, entry->storedSize, result.Buffer.data(),
+                             result.Buffer.size())) {
+          std::cerr << "Corrupt pack entry " << path << std::endl;
+          result.Buffer.clear();
+          return true; // found, but unreadable; do not fall back silently
+        }
+        result.Data = result.Buffer.data();
+      }
+      result.Size = entry->size;
+      result.Found = true;
+      return true;
+    }
+
+    std::error_code error;
+    fs::path file = fs::path(mount.directory) / relative;
+    if (!fs::is_regular_file(file, error))
+      return false;
+    // MappedFile refuses empty files; those are found with no data
+    result.Found = fs::file_size(file, error) == 0 || result.Mapping.Open(file.string());
+    result.Data = result.Mapping.GetData();
+    result.Size = result.Mapping.GetSize();
+    return true;
+  });
+  return result;
+}
+
+bool VirtualFileSystem::ResolveLoosePath(const std::string &path,
+                                         std::string &filePath) const {
+  bool loose = false;
+  this->FindFile(path, [&](const Mount &mount, const std::string &relative) {
+    if (mount.pack)
+      return mount.pack->Find(relative) != nullptr;
+
+    std::error_code error;
+    fs::path file = fs::path(mount.directory) / relative;
+    if (!fs::is_regular_file(file, error))
+      return false;
+    filePath = file.string();
+    loose = true;
+    return true;
+  });
+  return loose;
+}
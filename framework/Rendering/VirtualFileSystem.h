@@ -0,0 +1,107 @@
+#ifndef VIRTUALFILESYSTEM_H_
+#define VIRTUALFILESYSTEM_H_
+
+#include "MappedFile.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <shared_mutex>
+#include <string>
+#include <vector>
+
+// Contents of one file opened through the VirtualFileSystem. Stored pack
+// entries and loose files point into a memory mapping; compressed entries
+// own their decompressed bytes. Stays valid after the pack is unmounted.
+class VirtualFile {
+public:
+  VirtualFile() = default;
+  VirtualFile(VirtualFile &&) = default;
+  VirtualFile &operator=(VirtualFile &&) = default;
+  VirtualFile(const VirtualFile &) = delete;
+  VirtualFile &operator=(const VirtualFile &) = delete;
+
+  // False if the file was not found or could not be read.
+  explicit operator bool() const { return this->Found; }
+  const unsigned char *GetData() const { return this->Data; }
+  std::size_t GetSize() const { return this->Size; }
+
+private:
+  friend class VirtualFileSystem;
+
+  bool Found = false;
+  const unsigned char *Data = nullptr;
+  std::size_t Size = 0;
+  std::vector<unsigned char> Buffer;   // decompressed pack entry
+  MappedFile Mapping;                  // loose file
+  std::shared_ptr<const void> Archive; // keeps the pack mapped
+};
+
+// Resolves resource paths such as "textures/floor.png" against mounted
+// pack files (see PackFile.h) and directories. Mounts are searched newest
+// first, so a pack mounted after the development directory overrides it,
+// and files missing from the pack still come from the directory.
+//
+// Mounting is meant for startup; lookups and reads are thread safe and may
+// run on loader threads while other mounts are added.
+class VirtualFileSystem {
+public:
+  struct FileInfo {
+    std::uint64_t size = 0;
+    std::uint64_t storedSize = 0; // bytes on disk, less if compressed
+    bool packed = false;
+    bool compressed = false;
+  };
+
+public:
+  static VirtualFileSystem *GetInstance() {
+    return VirtualFileSystem::Instance != nullptr
+               ? VirtualFileSystem::Instance
+               : VirtualFileSystem::Instance = new VirtualFileSystem();
+  }
+
+  // Paths below `mountPoint` ("" for the root) come from the pack or
+  // directory. False if the pack is missing or malformed.
+  bool MountPack(const std::string &packPath, const std::string &mountPoint = "");
+  bool MountDirectory(const std::string &directory, const std::string &mountPoint = "");
+  void UnmountAll();
+  bool HasMounts() const;
+
+  bool Exists(const std::string &path) const;
+  bool Stat(const std::string &path, FileInfo &info) const;
+  VirtualFile Open(const std::string &path) const;
+  // The file on disk that `path` resolves to, for watching it. False if it
+  // comes from a pack or does not exist.
+  bool ResolveLoosePath(const std::string &path, std::string &filePath) const;
+
+  // '/' separators, no "." components, no leading "./" or '/'. ".."
+  // removes the component before it; a path that climbs above the root
+  // normalizes to "", which names no file, so lookups cannot reach outside
+  // the mounted directories.
+  static std::string NormalizePath(const std::string &path);
+
+private:
+  struct Pack;
+  struct Mount {
+    std::string point; // normalized, ends in '/' unless empty
+    std::string directory;
+    std::shared_ptr<const Pack> pack;
+  };
+
+  // The mount holding `path` and the path relative to it, newest first.
+  template <typename Visit>
+  bool FindFile(const std::string &path, Visit &&visit) const;
+
+private:
+  VirtualFileSystem() {}
+  VirtualFileSystem(const VirtualFileSystem &) = delete;
+  void operator=(const VirtualFileSystem &) = delete;
+
+private:
+  inline static VirtualFileSystem *Instance = nullptr;
+
+  std::vector<Mount> Mounts;
+  mutable std::shared_mutex MountMutex;
+};
+
+#endif // VIRTUALFILESYSTEM_H_
@@ -0,0 +1,73 @@
+#include "Skybox.h"
+#include "GeometricTools.h"
+#include "IndexBuffer.h"
+#include "RenderCommands.h"
+#include "SkyboxShaders.h"
+#include "VertexBuffer.h"
+#include "VertexBufferLayout.h"
+
+Skybox::Skybox(GLuint cubeMapUnit) {
+  GeometricTools::unitShape cube = GeometricTools::UnitCube();
+
+  auto cubeBuffer = std::make_shared<VertexBuffer>(
+      cube.vertices.data(), cube.vertices.size() * sizeof(GLfloat));
+  cubeBuffer->SetLayout(BufferLayout({{ShaderDataType::Float3, "position"},
+                                      {ShaderDataType::Float2, "tcoords"}}));
+
+  this->CubeArray = std::make_shared<VertexArray>();
+  this->CubeArray->AddVertexBuffer(cubeBuffer);
+  this->CubeArray->SetIndexBuffer(std::make_shared<IndexBuffer>(
+      cube.indices.data(), cube.indices.size()));
+  this->CubeArray->Unbind();
+
+  this->SkyboxShader = std::make_shared<Shader>(
+      skyboxVertexShader, skyboxFragmentShader, "Skybox");
+  this->SetCubeMapUnit(cubeMapUnit);
+  // (x, y, z) -> (x, z, -y)
+  this->SetOrientation(glm::mat3(1.f, 0.f, 0.f,   // world x
+                                 0.f, 0.f, -1.f,  // world y
+                                 0.f, 1.f, 0.f)); // world z
+
+  // filter across face edges instead of clamping at each face
+  glEnable(GL_TEXTURE_CUBE_MAP_SEAMLESS);
+}
+
+void Skybox::Draw(const glm::mat4 &view, const glm::mat4 &projection) {
+  // rotation only, the sky stays put as the camera moves
+  glm::mat4 rotation = glm::mat4(glm::mat3(view));
+
+  GLint depthFunc;
+  GLboolean depthMask;
+  glGetIntegerv(GL_DEPTH_FUNC, &depthFunc);
+  glGetBooleanv(GL_DEPTH_WRITEMASK, &depthMask);
+  GLboolean cullFace = glIsEnabled(GL_CULL_FACE);
+  // with reverse-Z the far plane is at depth 0 and nearer is greater
+  bool reverseDepth = depthFunc == GL_GREATER || depthFunc == GL_GEQUAL;
+
+  this->SkyboxShader->Bind();
+  this->SkyboxShader->UploadUniformFloatM4("u_ViewProjection",
+                                           projection * rotation);
+  this->SkyboxShader->UploadUniformInt("u_reverseDepth", reverseDepth);
+
+  // the camera is inside the cube, and the unit cube's winding is mixed
+  glDepthFunc(reverseDepth ? GL_GEQUAL : GL_LEQUAL);
+  glDepthMask(GL_FALSE);
+  glDisable(GL_CULL_FACE);
+
+  this->CubeArray->Bind();
+  RenderCommands::DrawIndex(this->CubeArray);
+
+  glDepthFunc(depthFunc);
+  glDepthMask(depthMask);
+  if (cullFace)
+    glEnable(GL_CULL_FACE);
+}
+
+void Skybox::SetCubeMapUnit(GLuint unit) {
+  this->SkyboxShader->UploadUniformInt("u_skybox", unit);
+}
+
+void Skybox::SetOrientation(const glm::mat3 &orientation) {
+  this->SkyboxShader->UploadUniformFloatM4("u_orientation",
+                                           glm::mat4(orientation));
+}
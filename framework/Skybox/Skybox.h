@@ -0,0 +1,35 @@
+#ifndef SKYBOX_H
+#define SKYBOX_H
+
+#include "Shader.h"
+#include "VertexArray.h"
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <memory>
+
+// Draws a cube map as the scene background. Draw it after all opaque
+// geometry: it is placed at maximum depth and tested with GL_LEQUAL
+// (GL_GEQUAL when the depth state is reversed) without writing depth, so
+// early-Z discards it wherever the scene already covers the pixel and only
+// the visible sky gets shaded.
+class Skybox {
+public:
+  // The cube map, e.g. from TextureManager::LoadCubeMapRGBA, must be bound to
+  // `cubeMapUnit`.
+  explicit Skybox(GLuint cubeMapUnit);
+
+  void Draw(const glm::mat4 &view, const glm::mat4 &projection);
+
+  void SetCubeMapUnit(GLuint unit);
+  // Maps world directions to cube map directions. The default turns the
+  // Z-up world into the Y-up convention of cube map faces.
+  void SetOrientation(const glm::mat3 &orientation);
+
+private:
+  std::shared_ptr<VertexArray> CubeArray;
+  std::shared_ptr<Shader> SkyboxShader;
+};
+
+#endif
@@ -0,0 +1,47 @@
+#ifndef SKYBOXSHADERS_H
+#define SKYBOXSHADERS_H
+
+#include <string>
+
+// The cube is drawn around the camera with the translation removed from the
+// view. Writing w into z puts every fragment on the far plane (depth 1), so
+// with GL_LEQUAL the sky only lands where nothing else was drawn. With
+// reverse-Z the far plane is at depth 0 instead, and the test GL_GEQUAL.
+const std::string skyboxVertexShader = R"(
+	#version 430 core
+
+	layout(location = 0) in vec3 i_position;
+
+	out vec3 vs_direction;
+
+	uniform mat4 u_ViewProjection;
+	uniform mat4 u_orientation;
+	uniform bool u_reverseDepth;
+
+	void main()
+	{
+		vs_direction = mat3(u_orientation) * i_position;
+		vec4 position = u_ViewProjection * vec4(i_position, 1.0);
+		if (u_reverseDepth)
+			gl_Position = vec4(position.xy, 0.0, position.w);
+		else
+			gl_Position = position.xyww;
+	}
+)";
+
+const std::string skyboxFragmentShader = R"(
+	#version 430 core
+
+	in vec3 vs_direction;
+
+	out vec4 color;
+
+	uniform samplerCube u_skybox;
+
+	void main()
+	{
+		color = texture(u_skybox, vs_direction);
+	}
+)";
+
+#endif
@@ -0,0 +1,212 @@
+#include "StartupOrchestrator.h"
+
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+
+namespace {
+
+double Milliseconds(StartupOrchestrator::Clock::duration duration) {
+  return std::chrono::duration<double, std::milli>(duration).count();
+}
+
+} // namespace
+
+StartupOrchestrator::StartupOrchestrator() : Begin(Clock::now()) {}
+
+StartupOrchestrator::~StartupOrchestrator() {
+  {
+    // queued lazy work is dropped, running tasks finish first
+    std::lock_guard<std::mutex> lock(this->TaskMutex);
+    this->Stop = true;
+  }
+  JobSystem::GetInstance()->Wait(this->Submitted);
+}
+
+StartupOrchestrator::TaskId
+StartupOrchestrator::AddTask(const std::string &name, std::function<void()> work,
+                             const std::vector<TaskId> &dependencies,
+                             Affinity affinity, bool critical) {
+  std::lock_guard<std::mutex> lock(this->TaskMutex);
+  TaskId id = this->Tasks.size();
+
+  Task task;
+  task.name = name;
+  task.work = std::move(work);
+  task.affinity = affinity;
+  task.critical = critical;
+  task.waitingFor = 0;
+  for (TaskId dependency : dependencies) {
+    if (dependency >= id) {
+      std::cerr << "Startup task " << name
+                << " depends on a task that was not added yet" << std::endl;
+      continue;
+    }
+    task.dependencies.push_back(dependency);
+    this->Tasks[dependency].dependents.push_back(id);
+    if (!this->Tasks[dependency].finished)
+      task.waitingFor++;
+  }
+  this->Tasks.push_back(std::move(task));
+  this->Unfinished++;
+
+  if (critical) {
+    this->CriticalLeft++;
+    // everything a critical task needs is critical too
+    std::vector<TaskId> promote = this->Tasks[id].dependencies;
+    while (!promote.empty()) {
+      TaskId next = promote.back();
+      promote.pop_back();
+      Task &dependency = this->Tasks[next];
+      if (dependency.critical)
+        continue;
+      dependency.critical = true;
+      if (!dependency.finished)
+        this->CriticalLeft++;
+      promote.insert(promote.end(), dependency.dependencies.begin(),
+                     dependency.dependencies.end());
+      this->QueueIfReady(next);
+    }
+  }
+  this->QueueIfReady(id);
+  return id;
+}
+
+void StartupOrchestrator::QueueIfReady(TaskId id) {
+  Task &task = this->Tasks[id];
+  if (task.queued || task.waitingFor > 0 || (!task.critical && !this->LazyReleased))
+    return;
+
+  task.queued = true;
+  if (task.affinity == Affinity::MainThread) {
+    this->MainQueue.push_back(id);
+    this->MainWake.notify_one();
+  } else if (this->Started) {
+    this->SubmitTask(id);
+  } else {
+    this->WorkerQueue.push_back(id);
+  }
+}
+
+void StartupOrchestrator::RunTask(TaskId id, std::unique_lock<std::mutex> &lock) {
+  this->Tasks[id].start = Clock::now();
+  std::function<void()> work = std::move(this->Tasks[id].work);
+  lock.unlock();
+  if (work)
+    work();
+  lock.lock();
+
+  // Tasks may grow while the lock was released, so index again
+  Task &task = this->Tasks[id];
+  task.end = Clock::now();
+  task.finished = true;
+  this->Unfinished--;
+  if (task.critical && --this->CriticalLeft == 0)
+    this->MainWake.notify_all();
+  for (TaskId dependent : std::vector<TaskId>(task.dependents)) {
+    this->Tasks[dependent].waitingFor--;
+    this->QueueIfReady(dependent);
+  }
+}
+
+void StartupOrchestrator::SubmitTask(TaskId id) {
+  JobSystem::GetInstance()->Submit(
+      [this, id]() {
+        std::unique_lock<std::mutex> lock(this->TaskMutex);
+        if (!this->Stop)
+          this->RunTask(id, lock);
+      },
+      &this->Submitted);
+}
+
+void StartupOrchestrator::RunCritical() {
+  std::unique_lock<std::mutex> lock(this->TaskMutex);
+  if (!this->Started) {
+    // the calling thread is busy with the main-thread tasks meanwhile
+    this->Started = true;
+    for (TaskId id : this->WorkerQueue)
+      this->SubmitTask(id);
+    this->WorkerQueue.clear();
+  }
+
+  for (;;) {
+    this->MainWake.wait(lock, [this]() {
+      return this->CriticalLeft == 0 || !this->MainQueue.empty();
+    });
+    if (this->CriticalLeft == 0)
+      return;
+    TaskId id = this->MainQueue.front();
+    this->MainQueue.pop_front();
+    this->RunTask(id, lock);
+  }
+}
+
+void StartupOrchestrator::FirstFramePresented() {
+  std::lock_guard<std::mutex> lock(this->TaskMutex);
+  if (this->LazyReleased)
+    return;
+  this->FirstFrame = Clock::now();
+  this->LazyReleased = true;
+  for (TaskId id = 0; id < this->Tasks.size(); id++)
+    this->QueueIfReady(id);
+}
+
+bool StartupOrchestrator::RunLazy(std::chrono::microseconds budget) {
+  Clock::time_point deadline = Clock::now() + budget;
+  std::unique_lock<std::mutex> lock(this->TaskMutex);
+  while (!this->MainQueue.empty() && Clock::now() < deadline) {
+    TaskId id = this->MainQueue.front();
+    this->MainQueue.pop_front();
+    this->RunTask(id, lock);
+  }
+  return this->Unfinished > 0;
+}
+
+void StartupOrchestrator::PrintReport(std::ostream &stream) const {
+  std::lock_guard<std::mutex> lock(this->TaskMutex);
+
+  std::vector<const Task *> order;
+  for (const auto &task : this->Tasks)
+    order.push_back(&task);
+  std::stable_sort(order.begin(), order.end(), [](const Task *a, const Task *b) {
+    return a->finished && (!b->finished || a->start < b->start);
+  });
+
+  std::ios::fmtflags flags = stream.flags();
+  std::streamsize precision = stream.precision();
+  stream << std::fixed << std::setprecision(1);
+
+  if (this->LazyReleased)
+    stream << "Startup: " << Milliseconds(this->FirstFrame - this->Begin)
+           << " ms to first frame\n";
+  else
+    stream << "Startup: first frame not presented yet\n";
+
+  std::size_t nameWidth = 4;
+  for (const Task *task : order)
+    nameWidth = std::max(nameWidth, task->name.size());
+
+  Clock::duration criticalWork{}, criticalEnd{};
+  for (const Task *task : order) {
+    stream << "  " << std::left << std::setw(int(nameWidth)) << task->name
+           << std::right;
+    if (task->finished) {
+      stream << "  at " << std::setw(8) << Milliseconds(task->start - this->Begin)
+             << " ms  took " << std::setw(8) << Milliseconds(task->end - task->start)
+             << " ms";
+      if (task->critical) {
+        criticalWork += task->end - task->start;
+        criticalEnd = std::max(criticalEnd, task->end - this->Begin);
+      }
+    } else {
+      stream << "  not run" << std::string(29, ' ');
+    }
+    stream << (task->affinity == Affinity::MainThread ? "  main  " : "  worker")
+           << (task->critical ? "" : "  lazy") << '\n';
+  }
+  stream << "  " << Milliseconds(criticalWork) << " ms of critical work done in "
+         << Milliseconds(criticalEnd) << " ms" << std::endl;
+
+  stream.flags(flags);
+  stream.precision(precision);
+}
@@ -0,0 +1,105 @@
+#ifndef STARTUPORCHESTRATOR_H
+#define STARTUPORCHESTRATOR_H
+
+#include "JobSystem.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// Runs application startup as a graph of tasks instead of one long
+// sequence. Each task names the tasks it depends on and starts as soon as
+// they have finished, so independent work overlaps: worker tasks (file
+// reads, decoding, geometry generation) run as jobs on the JobSystem while
+// the thread that owns the GL context runs the main-thread tasks (uploads,
+// shader compilation) in between.
+//
+// Critical tasks are everything the first frame needs; RunCritical()
+// returns once they are done. Lazy tasks are held back until the first
+// frame was presented (FirstFramePresented()) and then finish in the
+// background, with their main-thread parts run a few at a time by
+// RunLazy() between frames.
+//
+// Every task is timed, and PrintReport() breaks the startup down by task
+// together with the time to first frame.
+class StartupOrchestrator {
+public:
+  using TaskId = std::size_t;
+  using Clock = std::chrono::steady_clock;
+
+  enum class Affinity { Worker, MainThread };
+
+public:
+  // The clock for the report starts here.
+  StartupOrchestrator();
+  ~StartupOrchestrator();
+  StartupOrchestrator(const StartupOrchestrator &) = delete;
+  void operator=(const StartupOrchestrator &) = delete;
+
+  // Dependencies have to be added first, which also rules out cycles. A
+  // lazy task that a critical task depends on becomes critical itself.
+  TaskId AddTask(const std::string &name, std::function<void()> work,
+                 const std::vector<TaskId> &dependencies = {},
+                 Affinity affinity = Affinity::Worker, bool critical = true);
+
+  // Runs the critical tasks, the main-thread ones on the calling thread,
+  // and returns when all of them are done. Worker tasks wait for the first
+  // call to start.
+  void RunCritical();
+
+  // Records the time to first frame and releases the lazy tasks.
+  void FirstFramePresented();
+  // Runs ready main-thread lazy tasks for up to `budget`. False once every
+  // task has finished.
+  bool RunLazy(std::chrono::microseconds budget = std::chrono::milliseconds(2));
+
+  void PrintReport(std::ostream &stream) const;
+
+private:
+  struct Task {
+    std::string name;
+    std::function<void()> work;
+    std::vector<TaskId> dependencies;
+    std::vector<TaskId> dependents;
+    Affinity affinity;
+    bool critical;
+    std::size_t waitingFor; // unfinished dependencies
+    bool queued = false;
+    bool finished = false;
+    Clock::time_point start, end;
+  };
+
+private:
+  // Queues the task if it may run now. Needs TaskMutex.
+  void QueueIfReady(TaskId task);
+  void RunTask(TaskId task, std::unique_lock<std::mutex> &lock);
+  // Hands a worker task to the JobSystem.
+  void SubmitTask(TaskId task);
+
+private:
+  std::vector<Task> Tasks;
+
+  mutable std::mutex TaskMutex;
+  std::condition_variable MainWake;
+  // worker tasks ready before RunCritical()
+  std::deque<TaskId> WorkerQueue;
+  std::deque<TaskId> MainQueue;
+  // the worker tasks handed to the JobSystem and not run yet
+  JobCounter Submitted;
+  bool Started = false;
+  std::size_t CriticalLeft = 0;
+  std::size_t Unfinished = 0;
+  bool LazyReleased = false;
+  bool Stop = false;
+
+  Clock::time_point Begin;
+  Clock::time_point FirstFrame;
+};
+
+#endif
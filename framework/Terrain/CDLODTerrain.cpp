@@ -0,0 +1,163 @@
+#include "CDLODTerrain.h"
+#include "GeometricTools.h"
+#include "IndexBuffer.h"
+#include "RenderCommands.h"
+#include "TerrainShaders.h"
+#include "VertexBufferLayout.h"
+
+#include <algorithm>
+#include <string>
+
+CDLODTerrain::CDLODTerrain() : CDLODTerrain(Settings()) {}
+
+CDLODTerrain::CDLODTerrain(const Settings &settings)
+    : TerrainSettings(settings) {
+  this->TerrainSettings.levels = std::clamp(settings.levels, 1u, 32u);
+  this->TerrainSettings.patchResolution =
+      std::max(2u, settings.patchResolution & ~1u);
+  const Settings &s = this->TerrainSettings;
+
+  // ==== LOD ranges: each level reaches twice as far as the finer one ====
+  this->LodRanges.resize(s.levels);
+  this->LodRanges[s.levels - 1] = s.visibilityDistance;
+  for (unsigned level = s.levels - 1; level > 0; level--)
+    this->LodRanges[level - 1] = this->LodRanges[level] * 0.5f;
+
+  // ==== patch mesh and per-node instance buffer ====
+  GeometricTools::unitShape patch =
+      GeometricTools::UnitGrid(s.patchResolution);
+
+  auto patchBuffer = std::make_shared<VertexBuffer>(
+      patch.vertices.data(), patch.vertices.size() * sizeof(GLfloat));
+  patchBuffer->SetLayout(BufferLayout({{ShaderDataType::Float3, "position"},
+                                       {ShaderDataType::Float2, "tcoords"},
+                                       {ShaderDataType::Float3, "normal"}}));
+
+  this->NodeBuffer = std::make_shared<VertexBuffer>(
+      nullptr, s.maxNodes * sizeof(glm::vec4), GL_STREAM_DRAW);
+  this->NodeBuffer->SetLayout(
+      BufferLayout({{ShaderDataType::Float4, "node", false, 1}}));
+
+  this->PatchArray = std::make_shared<VertexArray>();
+  this->PatchArray->AddVertexBuffer(patchBuffer);
+  this->PatchArray->AddVertexBuffer(this->NodeBuffer);
+  this->PatchArray->SetIndexBuffer(std::make_shared<IndexBuffer>(
+      patch.indices.data(), patch.indices.size()));
+  this->PatchArray->Unbind();
+
+  this->SelectedNodes.reserve(s.maxNodes);
+
+  // ==== shader constants ====
+  this->TerrainShader = std::make_shared<Shader>(
+      terrainVertexShader, terrainFragmentShader, "Terrain");
+  this->TerrainShader->UploadUniformInt("u_heightmap", s.heightmapUnit);
+  this->TerrainShader->UploadUniformFloat2("u_terrainOrigin",
+                                           glm::vec2(-0.5f * s.size));
+  this->TerrainShader->UploadUniformFloat("u_terrainSize", s.size);
+  this->TerrainShader->UploadUniformFloat("u_heightScale", s.heightScale);
+  this->TerrainShader->UploadUniformFloat(
+      "u_patchResolution", static_cast<float>(s.patchResolution));
+
+  for (unsigned level = 0; level < s.levels; level++) {
+    float previous = level > 0 ? this->LodRanges[level - 1] : 0.f;
+    float end = this->LodRanges[level];
+    float start = previous + (end - previous) * s.morphStartRatio;
+    this->TerrainShader->UploadUniformFloat2(
+        "u_morphRanges[" + std::to_string(level) + "]", {start, end});
+  }
+
+  this->SetLightDirection({-0.4f, -0.3f, -1.f});
+  this->SetBaseColor({0.45f, 0.55f, 0.35f});
+}
+
+void CDLODTerrain::SetLightDirection(const glm::vec3 &direction) {
+  this->TerrainShader->UploadUniformFloat3("u_lightDirection", direction);
+}
+
+void CDLODTerrain::SetBaseColor(const glm::vec3 &color) {
+  this->TerrainShader->UploadUniformFloat3("u_baseColor", color);
+}
+
+void CDLODTerrain::Draw(const glm::mat4 &viewProjection,
+                        const glm::vec3 &cameraPosition) {
+  this->SelectNodes(ViewFrustum(viewProjection), cameraPosition);
+  if (this->SelectedNodes.empty())
+    return;
+
+  this->NodeBuffer->Bind();
+  this->NodeBuffer->BufferSubData(
+      0, this->SelectedNodes.size() * sizeof(glm::vec4),
+      this->SelectedNodes.data());
+
+  this->TerrainShader->Bind();
+  this->TerrainShader->UploadUniformFloatM4("u_ViewProjection",
+                                            viewProjection);
+  this->TerrainShader->UploadUniformFloat3("u_cameraPosition", cameraPosition);
+
+  this->PatchArray->Bind();
+  RenderCommands::DrawIndexInstanced(this->PatchArray,
+                                     this->SelectedNodes.size());
+}
+
+void CDLODTerrain::SelectNodes(const ViewFrustum &frustum,
+                               const glm::vec3 &cameraPosition) {
+  this->SelectedNodes.clear();
+
+  const Settings &s = this->TerrainSettings;
+  glm::vec2 origin(-0.5f * s.size);
+  // the root covers everything it can see, even beyond the visibility range
+  if (!this->SelectNode(origin, s.size, s.levels - 1, frustum, cameraPosition))
+    this->AddNode(origin, s.size, s.levels - 1, frustum);
+}
+
+bool CDLODTerrain::SelectNode(const glm::vec2 &origin, float size,
+                              unsigned level, const ViewFrustum &frustum,
+                              const glm::vec3 &cameraPosition) {
+  if (!this->InRange(origin, size, this->LodRanges[level], cameraPosition))
+    return false;
+
+  glm::vec3 min(origin, 0.f);
+  glm::vec3 max(origin + size, this->TerrainSettings.heightScale);
+  if (!frustum.IntersectsBox(min, max))
+    return true; // handled: nothing to draw
+
+  if (level == 0 ||
+      !this->InRange(origin, size, this->LodRanges[level - 1], cameraPosition)) {
+    this->AddNode(origin, size, level, frustum);
+    return true;
+  }
+
+  // Children out of their own range are still drawn at the child level. Their
+  // vertices are past the end of that level's morph range, so they render
+  // fully morphed to this level's density and meet this level without cracks.
+  float half = size * 0.5f;
+  for (int child = 0; child < 4; child++) {
+    glm::vec2 childOrigin = origin + glm::vec2(child % 2, child / 2) * half;
+    if (!this->SelectNode(childOrigin, half, level - 1, frustum,
+                          cameraPosition))
+      this->AddNode(childOrigin, half, level - 1, frustum);
+  }
+  return true;
+}
+
+void CDLODTerrain::AddNode(const glm::vec2 &origin, float size, unsigned level,
+                           const ViewFrustum &frustum) {
+  if (this->SelectedNodes.size() >= this->TerrainSettings.maxNodes)
+    return;
+
+  glm::vec3 min(origin, 0.f);
+  glm::vec3 max(origin + size, this->TerrainSettings.heightScale);
+  if (frustum.IntersectsBox(min, max))
+    this->SelectedNodes.emplace_back(origin, size, static_cast<float>(level));
+}
+
+bool CDLODTerrain::InRange(const glm::vec2 &origin, float size, float range,
+                           const glm::vec3 &cameraPosition) const {
+  // distance from the camera to the node's bounding box, over the full
+  // height range so that no vertex of the node can be closer
+  glm::vec3 min(origin, 0.f);
+  glm::vec3 max(origin + size, this->TerrainSettings.heightScale);
+  glm::vec3 closest = glm::clamp(cameraPosition, min, max);
+  glm::vec3 offset = cameraPosition - closest;
+  return glm::dot(offset, offset) <= range * range;
+}
@@ -0,0 +1,74 @@
+#ifndef CDLODTERRAIN_H
+#define CDLODTERRAIN_H
+
+#include "Shader.h"
+#include "VertexArray.h"
+#include "VertexBuffer.h"
+#include "ViewFrustum.h"
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <memory>
+#include <vector>
+
+// Continuous distance-dependent LOD terrain (Strugar, "Continuous
+// Distance-Dependent Level of Detail for Rendering Heightmaps").
+//
+// One UnitGrid patch is uploaded once and drawn instanced over the nodes of a
+// quadtree covering the terrain. Nodes are selected every frame from the
+// camera distance and the view frustum, heights come from a heightmap texture
+// sampled in the vertex shader, and vertices geomorph between levels. The
+// vertex budget depends on the view, not on the terrain size.
+class CDLODTerrain {
+public:
+  struct Settings {
+    float size = 4096.f;           // world extent along x and y, centred on 0
+    float heightScale = 300.f;     // world height of a heightmap value of 1
+    unsigned levels = 8;           // quadtree depth, at most 32
+    unsigned patchResolution = 32; // grid cells along a patch edge (even)
+    float visibilityDistance = 4096.f; // LOD range of the coarsest level
+    float morphStartRatio = 0.7f;  // where in its range a level starts morphing
+    unsigned maxNodes = 4096;      // instance buffer capacity
+    GLuint heightmapUnit = 2;      // texture unit of the heightmap
+  };
+
+public:
+  CDLODTerrain();
+  explicit CDLODTerrain(const Settings &settings);
+
+  // Selects the nodes for this view and draws them in one instanced call.
+  void Draw(const glm::mat4 &viewProjection, const glm::vec3 &cameraPosition);
+
+  // Fills the selected node list without drawing. Draw() calls this.
+  void SelectNodes(const ViewFrustum &frustum, const glm::vec3 &cameraPosition);
+
+  std::size_t GetSelectedNodeCount() const { return this->SelectedNodes.size(); }
+  const std::shared_ptr<Shader> &GetShader() const { return this->TerrainShader; }
+  const Settings &GetSettings() const { return this->TerrainSettings; }
+
+  void SetLightDirection(const glm::vec3 &direction);
+  void SetBaseColor(const glm::vec3 &color);
+
+private:
+  // Returns false when the node is out of its level's range, in which case
+  // the parent has to cover it.
+  bool SelectNode(const glm::vec2 &origin, float size, unsigned level,
+                  const ViewFrustum &frustum, const glm::vec3 &cameraPosition);
+  void AddNode(const glm::vec2 &origin, float size, unsigned level,
+               const ViewFrustum &frustum);
+  bool InRange(const glm::vec2 &origin, float size, float range,
+               const glm::vec3 &cameraPosition) const;
+
+private:
+  Settings TerrainSettings;
+  std::vector<float> LodRanges;
+  // (x, y, size, level) per selected node, uploaded as instance data
+  std::vector<glm::vec4> SelectedNodes;
+
+  std::shared_ptr<VertexArray> PatchArray;
+  std::shared_ptr<VertexBuffer> NodeBuffer;
+  std::shared_ptr<Shader> TerrainShader;
+};
+
+#endif
@@ -0,0 +1,92 @@
+#ifndef TERRAINSHADERS_H
+#define TERRAINSHADERS_H
+
+#include <string>
+
+// Every instance is one quadtree node drawn with the shared patch grid.
+// i_node = (world x, world y, size, lod level). Grid vertices are morphed
+// towards the next coarser level as the camera distance approaches the end
+// of the node's LOD range, so neighbouring levels meet without cracks.
+const std::string terrainVertexShader = R"(
+	#version 430 core
+
+	layout(location = 0) in vec3 i_position;
+	layout(location = 1) in vec2 i_tcoords;
+	layout(location = 2) in vec3 i_normal;
+	layout(location = 3) in vec4 i_node;
+
+	out vec2 vs_heightmapCoords;
+
+	uniform mat4 u_ViewProjection;
+	uniform vec3 u_cameraPosition;
+
+	uniform sampler2D u_heightmap;
+	uniform vec2 u_terrainOrigin;
+	uniform float u_terrainSize;
+	uniform float u_heightScale;
+	uniform float u_patchResolution;
+	uniform vec2 u_morphRanges[32];
+
+	float SampleHeight(vec2 worldPosition){
+		vec2 coords = (worldPosition - u_terrainOrigin) / u_terrainSize;
+		return textureLod(u_heightmap, coords, 0.0).r * u_heightScale;
+	}
+
+	void main(){
+		vec2 nodeOrigin = i_node.xy;
+		float nodeSize = i_node.z;
+		int level = int(i_node.w);
+
+		vec2 worldPosition = nodeOrigin + i_tcoords * nodeSize;
+		float distanceToCamera = distance(u_cameraPosition,
+		                                  vec3(worldPosition, SampleHeight(worldPosition)));
+
+		vec2 range = u_morphRanges[level];
+		float morph = clamp((distanceToCamera - range.x) / (range.y - range.x), 0.0, 1.0);
+
+		// snap odd grid vertices onto the coarser level's grid
+		vec2 gridPosition = i_tcoords * u_patchResolution;
+		vec2 oddOffset = fract(gridPosition * 0.5) * 2.0;
+		vec2 morphedCoords = (gridPosition - oddOffset * morph) / u_patchResolution;
+
+		worldPosition = nodeOrigin + morphedCoords * nodeSize;
+		vec3 position = vec3(worldPosition, SampleHeight(worldPosition));
+
+		gl_Position = u_ViewProjection * vec4(position, 1.0);
+
+		vs_heightmapCoords = (worldPosition - u_terrainOrigin) / u_terrainSize;
+	}
+)";
+
+const std::string terrainFragmentShader = R"(
+	#version 430 core
+
+	in vec2 vs_heightmapCoords;
+
+	out vec4 color;
+
+	uniform sampler2D u_heightmap;
+	uniform float u_terrainSize;
+	uniform float u_heightScale;
+	uniform vec3 u_lightDirection;
+	uniform vec3 u_baseColor;
+
+	void main(){
+		// normal from the heightmap's central differences
+		vec2 texel = 1.0 / vec2(textureSize(u_heightmap, 0));
+		float left  = texture(u_heightmap, vs_heightmapCoords - vec2(texel.x, 0.0)).r;
+		float right = texture(u_heightmap, vs_heightmapCoords + vec2(texel.x, 0.0)).r;
+		float down  = texture(u_heightmap, vs_heightmapCoords - vec2(0.0, texel.y)).r;
+		float up    = texture(u_heightmap, vs_heightmapCoords + vec2(0.0, texel.y)).r;
+
+		vec2 texelSize = texel * u_terrainSize;
+		vec3 normal = normalize(vec3((left - right) * u_heightScale / (2.0 * texelSize.x),
+		                             (down - up) * u_heightScale / (2.0 * texelSize.y),
+		                             1.0));
+
+		float diffuse = max(dot(normal, normalize(-u_lightDirection)), 0.0);
+		color = vec4(u_baseColor * (0.2 + 0.8 * diffuse), 1.0);
+	}
+)";
+
+#endif
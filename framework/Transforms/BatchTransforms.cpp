@@ -0,0 +1,466 @@
+#include "BatchTransforms.h"
+
+#include <cstring>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__SSE2__)
+#define BATCHTRANSFORMS_X86
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+// The AVX kernels are compiled for AVX regardless of the compiler flags and
+// only called when the CPU has it. MSVC accepts AVX intrinsics anywhere.
+#if defined(__GNUC__) || defined(__clang__)
+#define AVX_KERNEL __attribute__((target("avx")))
+#else
+#define AVX_KERNEL
+#endif
+
+namespace BatchTransforms {
+namespace {
+
+// ==== Scalar ====
+
+// Rows of translate * rotate * scale for object i; see ComposeRowsSSE().
+void ComposeRows(const transformArrays &t, std::size_t i, float rows[3][4]) {
+  float x = t.rotationX[i], y = t.rotationY[i], z = t.rotationZ[i],
+        w = t.rotationW[i];
+  float x2 = x + x, y2 = y + y, z2 = z + z;
+  float xx = x * x2, yy = y * y2, zz = z * z2;
+  float xy = x * y2, xz = x * z2, yz = y * z2;
+  float wx = w * x2, wy = w * y2, wz = w * z2;
+  float sx = t.scaleX[i], sy = t.scaleY[i], sz = t.scaleZ[i];
+
+  rows[0][0] = (1.f - (yy + zz)) * sx;
+  rows[0][1] = (xy - wz) * sy;
+  rows[0][2] = (xz + wy) * sz;
+  rows[0][3] = t.positionX[i];
+  rows[1][0] = (xy + wz) * sx;
+  rows[1][1] = (1.f - (xx + zz)) * sy;
+  rows[1][2] = (yz - wx) * sz;
+  rows[1][3] = t.positionY[i];
+  rows[2][0] = (xz - wy) * sx;
+  rows[2][1] = (yz + wx) * sy;
+  rows[2][2] = (1.f - (xx + yy)) * sz;
+  rows[2][3] = t.positionZ[i];
+}
+
+void ComposeMatricesScalar(const transformArrays &t, std::size_t begin,
+                           std::size_t end, glm::mat4 *out) {
+  for (std::size_t i = begin; i < end; i++) {
+    float rows[3][4];
+    ComposeRows(t, i, rows);
+    for (int c = 0; c < 4; c++)
+      out[i][c] = glm::vec4(rows[0][c], rows[1][c], rows[2][c], c == 3 ? 1.f : 0.f);
+  }
+}
+
+void ComposeAffineScalar(const transformArrays &t, std::size_t begin,
+                         std::size_t end, affineMatrix *out) {
+  for (std::size_t i = begin; i < end; i++) {
+    float rows[3][4];
+    ComposeRows(t, i, rows);
+    for (int r = 0; r < 3; r++)
+      out[i].rows[r] = glm::vec4(rows[r][0], rows[r][1], rows[r][2], rows[r][3]);
+  }
+}
+
+void MultiplyScalar(const glm::mat4 *left, std::size_t leftStep,
+                    const glm::mat4 *right, std::size_t count, glm::mat4 *out) {
+  for (std::size_t i = 0; i < count; i++)
+    out[i] = left[i * leftStep] * right[i];
+}
+
+void TransformPointsScalar(const glm::mat4 &m, const float *x, const float *y,
+                           const float *z, std::size_t begin, std::size_t end,
+                           float *outX, float *outY, float *outZ) {
+  for (std::size_t i = begin; i < end; i++) {
+    glm::vec4 p = m * glm::vec4(x[i], y[i], z[i], 1.f);
+    outX[i] = p.x;
+    outY[i] = p.y;
+    outZ[i] = p.z;
+  }
+}
+
+#ifdef BATCHTRANSFORMS_X86
+
+// ==== SSE, 4 objects per step ====
+
+// r[row][column] holds that matrix entry for 4 objects, one per lane.
+void ComposeRowsSSE(const transformArrays &t, std::size_t i, __m128 r[3][4]) {
+  __m128 x = _mm_loadu_ps(t.rotationX + i), y = _mm_loadu_ps(t.rotationY + i),
+         z = _mm_loadu_ps(t.rotationZ + i), w = _mm_loadu_ps(t.rotationW + i);
+  __m128 x2 = _mm_add_ps(x, x), y2 = _mm_add_ps(y, y), z2 = _mm_add_ps(z, z);
+  __m128 xx = _mm_mul_ps(x, x2), yy = _mm_mul_ps(y, y2), zz = _mm_mul_ps(z, z2);
+  __m128 xy = _mm_mul_ps(x, y2), xz = _mm_mul_ps(x, z2), yz = _mm_mul_ps(y, z2);
+  __m128 wx = _mm_mul_ps(w, x2), wy = _mm_mul_ps(w, y2), wz = _mm_mul_ps(w, z2);
+  __m128 sx = _mm_loadu_ps(t.scaleX + i), sy = _mm_loadu_ps(t.scaleY + i),
+         sz = _mm_loadu_ps(t.scaleZ + i);
+  __m128 one = _mm_set1_ps(1.f);
+
+  r[0][0] = _mm_mul_ps(_mm_sub_ps(one, _mm_add_ps(yy, zz)), sx);
+  r[0][1] = _mm_mul_ps(_mm_sub_ps(xy, wz), sy);
+  r[0][2] = _mm_mul_ps(_mm_add_ps(xz, wy), sz);
+  r[0][3] = _mm_loadu_ps(t.positionX + i);
+  r[1][0] = _mm_mul_ps(_mm_add_ps(xy, wz), sx);
+  r[1][1] = _mm_mul_ps(_mm_sub_ps(one, _mm_add_ps(xx, zz)), sy);
+  r[1][2] = _mm_mul_ps(_mm_sub_ps(yz, wx), sz);
+  r[1][3] = _mm_loadu_ps(t.positionY + i);
+  r[2][0] = _mm_mul_ps(_mm_sub_ps(xz, wy), sx);
+  r[2][1] = _mm_mul_ps(_mm_add_ps(yz, wx), sy);
+  r[2][2] = _mm_mul_ps(_mm_sub_ps(one, _mm_add_ps(xx, yy)), sz);
+  r[2][3] = _mm_loadu_ps(t.positionZ + i);
+}
+
+// Turns four lanes-per-object vectors into four per-object vectors.
+void StoreTransposed(__m128 a, __m128 b, __m128 c, __m128 d, float *out0,
+                     float *out1, float *out2, float *out3) {
+  _MM_TRANSPOSE4_PS(a, b, c, d);
+  _mm_storeu_ps(out0, a);
+  _mm_storeu_ps(out1, b);
+  _mm_storeu_ps(out2, c);
+  _mm_storeu_ps(out3, d);
+}
+
+float *Column(glm::mat4 *out, std::size_t i, int c) { return &out[i][c][0]; }
+float *Row(affineMatrix *out, std::size_t i, int r) { return &out[i].rows[r][0]; }
+
+std::size_t ComposeMatricesSSE(const transformArrays &t, std::size_t count,
+                               glm::mat4 *out) {
+  const __m128 zero = _mm_setzero_ps(), one = _mm_set1_ps(1.f);
+  std::size_t i = 0;
+  for (; i + 4 <= count; i += 4) {
+    __m128 r[3][4];
+    ComposeRowsSSE(t, i, r);
+    for (int c = 0; c < 4; c++)
+      StoreTransposed(r[0][c], r[1][c], r[2][c], c == 3 ? one : zero,
+                      Column(out, i, c), Column(out, i + 1, c),
+                      Column(out, i + 2, c), Column(out, i + 3, c));
+  }
+  return i;
+}
+
+std::size_t ComposeAffineSSE(const transformArrays &t, std::size_t count,
+                             affineMatrix *out) {
+  std::size_t i = 0;
+  for (; i + 4 <= count; i += 4) {
+    __m128 r[3][4];
+    ComposeRowsSSE(t, i, r);
+    for (int row = 0; row < 3; row++)
+      StoreTransposed(r[row][0], r[row][1], r[row][2], r[row][3],
+                      Row(out, i, row), Row(out, i + 1, row),
+                      Row(out, i + 2, row), Row(out, i + 3, row));
+  }
+  return i;
+}
+
+// out = a * b for one matrix, with a's columns already loaded. Every column
+// of b is read before the matching column of out is written, so out may
+// be either input.
+void MultiplySSE(const __m128 a[4], const float *b, float *out) {
+  for (int c = 0; c < 4; c++) {
+    __m128 column = _mm_loadu_ps(b + 4 * c);
+    __m128 result =
+        _mm_mul_ps(a[0], _mm_shuffle_ps(column, column, _MM_SHUFFLE(0, 0, 0, 0)));
+    result = _mm_add_ps(result, _mm_mul_ps(a[1], _mm_shuffle_ps(column, column,
+                                                                _MM_SHUFFLE(1, 1, 1, 1))));
+    result = _mm_add_ps(result, _mm_mul_ps(a[2], _mm_shuffle_ps(column, column,
+                                                                _MM_SHUFFLE(2, 2, 2, 2))));
+    result = _mm_add_ps(result, _mm_mul_ps(a[3], _mm_shuffle_ps(column, column,
+                                                                _MM_SHUFFLE(3, 3, 3, 3))));
+    _mm_storeu_ps(out + 4 * c, result);
+  }
+}
+
+void MultiplyMatricesSSE(const glm::mat4 *left, std::size_t leftStep,
+                         const glm::mat4 *right, std::size_t count, glm::mat4 *out) {
+  __m128 a[4];
+  for (std::size_t i = 0; i < count; i++) {
+    if (i == 0 || leftStep != 0)
+      for (int c = 0; c < 4; c++)
+        a[c] = _mm_loadu_ps(&left[i * leftStep][c][0]);
+    MultiplySSE(a, &right[i][0][0], &out[i][0][0]);
+  }
+}
+
+std::size_t TransformPointsSSE(const glm::mat4 &m, const float *x, const float *y,
+                               const float *z, std::size_t count, float *outX,
+                               float *outY, float *outZ) {
+  __m128 e[4][3];
+  for (int c = 0; c < 4; c++)
+    for (int r = 0; r < 3; r++)
+      e[c][r] = _mm_set1_ps(m[c][r]);
+
+  std::size_t i = 0;
+  for (; i + 4 <= count; i += 4) {
+    __m128 px = _mm_loadu_ps(x + i), py = _mm_loadu_ps(y + i),
+           pz = _mm_loadu_ps(z + i);
+    __m128 result[3];
+    for (int r = 0; r < 3; r++)
+      result[r] = _mm_add_ps(
+          _mm_add_ps(_mm_mul_ps(e[0][r], px), _mm_mul_ps(e[1][r], py)),
+          _mm_add_ps(_mm_mul_ps(e[2][r], pz), e[3][r]));
+    _mm_storeu_ps(outX + i, result[0]);
+    _mm_storeu_ps(outY + i, result[1]);
+    _mm_storeu_ps(outZ + i, result[2]);
+  }
+  return i;
+}
+
+void TransformPointsPerMatrixSSE(const glm::mat4 *matrices, const glm::vec3 *points,
+                                 std::size_t count, glm::vec3 *out) {
+  for (std::size_t i = 0; i < count; i++) {
+    const float *m = &matrices[i][0][0];
+    __m128 result = _mm_add_ps(
+        _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(m), _mm_set1_ps(points[i].x)),
+                   _mm_mul_ps(_mm_loadu_ps(m + 4), _mm_set1_ps(points[i].y))),
+        _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(m + 8), _mm_set1_ps(points[i].z)),
+                   _mm_loadu_ps(m + 12)));
+    // a vec3 is 12 bytes, so a full 16 byte store could run past the end
+    float stored[4];
+    _mm_storeu_ps(stored, result);
+    std::memcpy(&out[i], stored, sizeof(glm::vec3));
+  }
+}
+
+// ==== AVX, 8 objects per step ====
+
+AVX_KERNEL void ComposeRowsAVX(const transformArrays &t, std::size_t i,
+                               __m256 r[3][4]) {
+  __m256 x = _mm256_loadu_ps(t.rotationX + i), y = _mm256_loadu_ps(t.rotationY + i),
+         z = _mm256_loadu_ps(t.rotationZ + i), w = _mm256_loadu_ps(t.rotationW + i);
+  __m256 x2 = _mm256_add_ps(x, x), y2 = _mm256_add_ps(y, y),
+         z2 = _mm256_add_ps(z, z);
+  __m256 xx = _mm256_mul_ps(x, x2), yy = _mm256_mul_ps(y, y2),
+         zz = _mm256_mul_ps(z, z2);
+  __m256 xy = _mm256_mul_ps(x, y2), xz = _mm256_mul_ps(x, z2),
+         yz = _mm256_mul_ps(y, z2);
+  __m256 wx = _mm256_mul_ps(w, x2), wy = _mm256_mul_ps(w, y2),
+         wz = _mm256_mul_ps(w, z2);
+  __m256 sx = _mm256_loadu_ps(t.scaleX + i), sy = _mm256_loadu_ps(t.scaleY + i),
+         sz = _mm256_loadu_ps(t.scaleZ + i);
+  __m256 one = _mm256_set1_ps(1.f);
+
+  r[0][0] = _mm256_mul_ps(_mm256_sub_ps(one, _mm256_add_ps(yy, zz)), sx);
+  r[0][1] = _mm256_mul_ps(_mm256_sub_ps(xy, wz), sy);
+  r[0][2] = _mm256_mul_ps(_mm256_add_ps(xz, wy), sz);
+  r[0][3] = _mm256_loadu_ps(t.positionX + i);
+  r[1][0] = _mm256_mul_ps(_mm256_add_ps(xy, wz), sx);
+  r[1][1] = _mm256_mul_ps(_mm256_sub_ps(one, _mm256_add_ps(xx, zz)), sy);
+  r[1][2] = _mm256_mul_ps(_mm256_sub_ps(yz, wx), sz);
+  r[1][3] = _mm256_loadu_ps(t.positionY + i);
+  r[2][0] = _mm256_mul_ps(_mm256_sub_ps(xz, wy), sx);
+  r[2][1] = _mm256_mul_ps(_mm256_add_ps(yz, wx), sy);
+  r[2][2] = _mm256_mul_ps(_mm256_sub_ps(one, _mm256_add_ps(xx, yy)), sz);
+  r[2][3] = _mm256_loadu_ps(t.positionZ + i);
+}
+
+// Transposes four lanes-per-object vectors of 8 objects: out[k] is the
+// vector of object k.
+AVX_KERNEL void TransposeAVX(__m256 a, __m256 b, __m256 c, __m256 d,
+                             __m128 out[8]) {
+  __m128 lo[4] = {_mm256_castps256_ps128(a), _mm256_castps256_ps128(b),
+                  _mm256_castps256_ps128(c), _mm256_castps256_ps128(d)};
+  __m128 hi[4] = {_mm256_extractf128_ps(a, 1), _mm256_extractf128_ps(b, 1),
+                  _mm256_extractf128_ps(c, 1), _mm256_extractf128_ps(d, 1)};
+  _MM_TRANSPOSE4_PS(lo[0], lo[1], lo[2], lo[3]);
+  _MM_TRANSPOSE4_PS(hi[0], hi[1], hi[2], hi[3]);
+  for (int k = 0; k < 4; k++) {
+    out[k] = lo[k];
+    out[k + 4] = hi[k];
+  }
+}
+
+AVX_KERNEL __m256 Pair(__m128 low, __m128 high) {
+  return _mm256_insertf128_ps(_mm256_castps128_ps256(low), high, 1);
+}
+
+AVX_KERNEL std::size_t ComposeMatricesAVX(const transformArrays &t,
+                                          std::size_t count, glm::mat4 *out) {
+  const __m256 zero = _mm256_setzero_ps(), one = _mm256_set1_ps(1.f);
+  std::size_t i = 0;
+  for (; i + 8 <= count; i += 8) {
+    __m256 r[3][4];
+    ComposeRowsAVX(t, i, r);
+    __m128 columns[4][8];
+    for (int c = 0; c < 4; c++)
+      TransposeAVX(r[0][c], r[1][c], r[2][c], c == 3 ? one : zero, columns[c]);
+    // whole matrices, two columns per store
+    for (int k = 0; k < 8; k++) {
+      _mm256_storeu_ps(Column(out, i + k, 0), Pair(columns[0][k], columns[1][k]));
+      _mm256_storeu_ps(Column(out, i + k, 2), Pair(columns[2][k], columns[3][k]));
+    }
+  }
+  return i;
+}
+
+AVX_KERNEL std::size_t ComposeAffineAVX(const transformArrays &t,
+                                        std::size_t count, affineMatrix *out) {
+  std::size_t i = 0;
+  for (; i + 8 <= count; i += 8) {
+    __m256 r[3][4];
+    ComposeRowsAVX(t, i, r);
+    __m128 rows[3][8];
+    for (int row = 0; row < 3; row++)
+      TransposeAVX(r[row][0], r[row][1], r[row][2], r[row][3], rows[row]);
+    for (int k = 0; k < 8; k++) {
+      _mm256_storeu_ps(Row(out, i + k, 0), Pair(rows[0][k], rows[1][k]));
+      _mm_storeu_ps(Row(out, i + k, 2), rows[2][k]);
+    }
+  }
+  return i;
+}
+
+// Two columns of the result per step: a's columns are repeated in both
+// halves and multiplied with the entries of two columns of b.
+AVX_KERNEL void MultiplyMatricesAVX(const glm::mat4 *left, std::size_t leftStep,
+                                    const glm::mat4 *right, std::size_t count,
+                                    glm::mat4 *out) {
+  __m256 a[4];
+  for (std::size_t i = 0; i < count; i++) {
+    if (i == 0 || leftStep != 0)
+      for (int c = 0; c < 4; c++)
+        a[c] = _mm256_broadcast_ps(
+            reinterpret_cast<const __m128 *>(&left[i * leftStep][c][0]));
+    const float *b = &right[i][0][0];
+    float *result = &out[i][0][0];
+    for (int c = 0; c < 4; c += 2) {
+      __m256 columns = _mm256_loadu_ps(b + 4 * c);
+      __m256 sum = _mm256_mul_ps(a[0], _mm256_permute_ps(columns, 0x00));
+      sum = _mm256_add_ps(sum, _mm256_mul_ps(a[1], _mm256_permute_ps(columns, 0x55)));
+      sum = _mm256_add_ps(sum, _mm256_mul_ps(a[2], _mm256_permute_ps(columns, 0xAA)));
+      sum = _mm256_add_ps(sum, _mm256_mul_ps(a[3], _mm256_permute_ps(columns, 0xFF)));
+      _mm256_storeu_ps(result + 4 * c, sum);
+    }
+  }
+}
+
+AVX_KERNEL std::size_t TransformPointsAVX(const glm::mat4 &m, const float *x,
+                                          const float *y, const float *z,
+                                          std::size_t count, float *outX,
+                                          float *outY, float *outZ) {
+  __m256 e[4][3];
+  for (int c = 0; c < 4; c++)
+    for (int r = 0; r < 3; r++)
+      e[c][r] = _mm256_set1_ps(m[c][r]);
+
+  std::size_t i = 0;
+  for (; i + 8 <= count; i += 8) {
+    __m256 px = _mm256_loadu_ps(x + i), py = _mm256_loadu_ps(y + i),
+           pz = _mm256_loadu_ps(z + i);
+    __m256 result[3];
+    for (int r = 0; r < 3; r++)
+      result[r] = _mm256_add_ps(
+          _mm256_add_ps(_mm256_mul_ps(e[0][r], px), _mm256_mul_ps(e[1][r], py)),
+          _mm256_add_ps(_mm256_mul_ps(e[2][r], pz), e[3][r]));
+    _mm256_storeu_ps(outX + i, result[0]);
+    _mm256_storeu_ps(outY + i, result[1]);
+    _mm256_storeu_ps(outZ + i, result[2]);
+  }
+  return i;
+}
+
+#endif // BATCHTRANSFORMS_X86
+
+instructionSet DetectInstructionSet() {
+#if defined(BATCHTRANSFORMS_X86) && (defined(__GNUC__) || defined(__clang__))
+  __builtin_cpu_init();
+  return __builtin_cpu_supports("avx") ? instructionSet::AVX : instructionSet::SSE;
+#elif defined(BATCHTRANSFORMS_X86) && defined(_MSC_VER)
+  int info[4];
+  __cpuid(info, 1);
+  bool osSavesYmm = (info[2] & (1 << 27)) && (_xgetbv(0) & 6) == 6;
+  return osSavesYmm && (info[2] & (1 << 28)) ? instructionSet::AVX
+                                              : instructionSet::SSE;
+#else
+  return instructionSet::Scalar;
+#endif
+}
+
+const instructionSet Supported = DetectInstructionSet();
+instructionSet Current = Supported;
+
+} // namespace
+
+instructionSet GetInstructionSet() { return Current; }
+
+instructionSet SetInstructionSet(instructionSet set) {
+  Current = set > Supported ? Supported : set;
+  return Current;
+}
+
+void ComposeMatrices(const transformArrays &transforms, std::size_t count,
+                     glm::mat4 *out) {
+  std::size_t done = 0;
+#ifdef BATCHTRANSFORMS_X86
+  if (Current == instructionSet::AVX)
+    done = ComposeMatricesAVX(transforms, count, out);
+  else if (Current == instructionSet::SSE)
+    done = ComposeMatricesSSE(transforms, count, out);
+#endif
+  ComposeMatricesScalar(transforms, done, count, out);
+}
+
+void ComposeAffine(const transformArrays &transforms, std::size_t count,
+                   affineMatrix *out) {
+  std::size_t done = 0;
+#ifdef BATCHTRANSFORMS_X86
+  if (Current == instructionSet::AVX)
+    done = ComposeAffineAVX(transforms, count, out);
+  else if (Current == instructionSet::SSE)
+    done = ComposeAffineSSE(transforms, count, out);
+#endif
+  ComposeAffineScalar(transforms, done, count, out);
+}
+
+void MultiplyMatrices(const glm::mat4 *left, const glm::mat4 *right,
+                      std::size_t count, glm::mat4 *out) {
+#ifdef BATCHTRANSFORMS_X86
+  if (Current == instructionSet::AVX)
+    return MultiplyMatricesAVX(left, 1, right, count, out);
+  if (Current == instructionSet::SSE)
+    return MultiplyMatricesSSE(left, 1, right, count, out);
+#endif
+  MultiplyScalar(left, 1, right, count, out);
+}
+
+void MultiplyMatrices(const glm::mat4 &left, const glm::mat4 *right,
+                      std::size_t count, glm::mat4 *out) {
+  // a copy, in case `left` is one of the outputs
+  const glm::mat4 shared = left;
+#ifdef BATCHTRANSFORMS_X86
+  if (Current == instructionSet::AVX)
+    return MultiplyMatricesAVX(&shared, 0, right, count, out);
+  if (Current == instructionSet::SSE)
+    return MultiplyMatricesSSE(&shared, 0, right, count, out);
+#endif
+  MultiplyScalar(&shared, 0, right, count, out);
+}
+
+void TransformPoints(const glm::mat4 &matrix, const float *x, const float *y,
+                     const float *z, std::size_t count, float *outX, float *outY,
+                     float *outZ) {
+  std::size_t done = 0;
+#ifdef BATCHTRANSFORMS_X86
+  if (Current == instructionSet::AVX)
+    done = TransformPointsAVX(matrix, x, y, z, count, outX, outY, outZ);
+  else if (Current == instructionSet::SSE)
+    done = TransformPointsSSE(matrix, x, y, z, count, outX, outY, outZ);
+#endif
+  TransformPointsScalar(matrix, x, y, z, done, count, outX, outY, outZ);
+}
+
+void TransformPoints(const glm::mat4 *matrices, const glm::vec3 *points,
+                     std::size_t count, glm::vec3 *out) {
+#ifdef BATCHTRANSFORMS_X86
+  // one point per matrix leaves nothing for wider vectors to share
+  if (Current != instructionSet::Scalar)
+    return TransformPointsPerMatrixSSE(matrices, points, count, out);
+#endif
+  for (std::size_t i = 0; i < count; i++)
+    out[i] = glm::vec3(matrices[i] * glm::vec4(points[i], 1.f));
+}
+
+} // namespace BatchTransforms
@@ -0,0 +1,65 @@
+#ifndef BATCHTRANSFORMS_H
+#define BATCHTRANSFORMS_H
+
+#include <glm/glm.hpp>
+
+#include <cstddef>
+
+// Transforms for many objects at once. Instead of composing glm matrices
+// one object at a time, the inputs are laid out as structure-of-arrays so
+// that SSE and AVX kernels handle 4 or 8 objects per instruction. The
+// kernel is chosen once at runtime from what the CPU supports; other CPUs
+// get a scalar loop with the same results.
+//
+// All functions are pure over their index range, so large batches can be
+// split across threads by calling them on slices.
+namespace BatchTransforms {
+
+// Position, rotation and scale of `count` objects, one array per
+// component. Rotations are unit quaternions.
+struct transformArrays {
+  const float *positionX, *positionY, *positionZ;
+  const float *rotationX, *rotationY, *rotationZ, *rotationW;
+  const float *scaleX, *scaleY, *scaleZ;
+};
+
+// The top three rows of an affine model matrix, row by row; the bottom
+// row is (0, 0, 0, 1). 48 instead of 64 bytes per instance, which is what
+// instanced rendering wants to upload.
+struct affineMatrix {
+  glm::vec4 rows[3];
+};
+
+enum class instructionSet { Scalar, SSE, AVX };
+
+// The kernels in use; the best the CPU supports unless overridden.
+extern instructionSet GetInstructionSet();
+// For comparisons and tests. Falls back to the best supported set if the
+// CPU lacks the requested one, and returns what is used. Not thread safe.
+extern instructionSet SetInstructionSet(instructionSet set);
+
+// out[i] = translate(position) * mat4_cast(rotation) * scale(scale)
+extern void ComposeMatrices(const transformArrays &transforms,
+                            std::size_t count, glm::mat4 *out);
+extern void ComposeAffine(const transformArrays &transforms, std::size_t count,
+                          affineMatrix *out);
+
+// out[i] = left[i] * right[i]
+extern void MultiplyMatrices(const glm::mat4 *left, const glm::mat4 *right,
+                             std::size_t count, glm::mat4 *out);
+// out[i] = left * right[i], e.g. a parent or view-projection matrix
+extern void MultiplyMatrices(const glm::mat4 &left, const glm::mat4 *right,
+                             std::size_t count, glm::mat4 *out);
+
+// (outX, outY, outZ)[i] = matrix * (x, y, z, 1)[i], without the divide by
+// w. The output arrays may be the input arrays.
+extern void TransformPoints(const glm::mat4 &matrix, const float *x,
+                            const float *y, const float *z, std::size_t count,
+                            float *outX, float *outY, float *outZ);
+// out[i] = matrices[i] * (points[i], 1)
+extern void TransformPoints(const glm::mat4 *matrices, const glm::vec3 *points,
+                            std::size_t count, glm::vec3 *out);
+
+} // namespace BatchTransforms
+
+#endif
@@ -0,0 +1,363 @@
+#include "TransformHierarchy.h"
+#include "ArenaAllocator.h"
+#include "BatchTransforms.h"
+
+#include <algorithm>
+#include <iostream>
+
+namespace {
+
+// Reorders `values` so that values[k] becomes the old values[order[k]].
+template <typename T, typename Order>
+void Permute(std::vector<T> &values, const Order &order) {
+  ScratchScope scratch;
+  ScratchVector<T> old(values.begin(), values.end());
+  for (std::size_t k = 0; k < order.size(); k++)
+    values[k] = old[order[k]];
+}
+
+} // namespace
+
+TransformHierarchy::NodeId
+TransformHierarchy::AddNode(NodeId parent, const glm::vec3 &position,
+                            const glm::quat &rotation, const glm::vec3 &scale) {
+  if (parent != NoNode && !this->Contains(parent)) {
+    std::cerr << "Transform node " << parent << " does not exist" << std::endl;
+    return NoNode;
+  }
+
+  NodeId id;
+  if (!this->FreeIds.empty()) {
+    id = this->FreeIds.back();
+    this->FreeIds.pop_back();
+  } else {
+    id = static_cast<NodeId>(this->Indices.size());
+    this->Indices.push_back(NoIndex);
+  }
+
+  Index index = static_cast<Index>(this->Ids.size());
+  Index parentIndex = parent == NoNode ? NoIndex : this->Indices[parent];
+  this->Indices[id] = index;
+  for (int c = 0; c < 3; c++) {
+    this->Position[c].push_back(position[c]);
+    this->Scale[c].push_back(scale[c]);
+  }
+  this->Rotation[0].push_back(rotation.x);
+  this->Rotation[1].push_back(rotation.y);
+  this->Rotation[2].push_back(rotation.z);
+  this->Rotation[3].push_back(rotation.w);
+  this->Parents.push_back(parentIndex);
+  this->SubtreeSizes.push_back(1);
+  this->Dirty.push_back(0);
+  this->Ids.push_back(id);
+  this->Local.emplace_back(1.0f);
+  this->World.emplace_back(1.0f);
+
+  if (this->Sorted && parentIndex != NoIndex) {
+    // still in order if the parent's subtree ends here, and then so do
+    // the subtrees of all its ancestors
+    if (parentIndex + this->SubtreeSizes[parentIndex] == index) {
+      for (Index a = parentIndex; a != NoIndex; a = this->Parents[a])
+        this->SubtreeSizes[a]++;
+    } else {
+      this->Sorted = false;
+    }
+  }
+
+  this->MarkDirty(index);
+  return id;
+}
+
+void TransformHierarchy::RemoveNode(NodeId node) {
+  if (!this->Contains(node)) {
+    std::cerr << "Transform node " << node << " does not exist" << std::endl;
+    return;
+  }
+  if (!this->Sorted)
+    this->Sort();
+
+  Index begin = this->Indices[node];
+  Index count = this->SubtreeSizes[begin];
+  Index end = begin + count;
+
+  for (Index a = this->Parents[begin]; a != NoIndex; a = this->Parents[a])
+    this->SubtreeSizes[a] -= count;
+  for (Index i = begin; i < end; i++) {
+    this->Indices[this->Ids[i]] = NoIndex;
+    this->FreeIds.push_back(this->Ids[i]);
+  }
+
+  auto erase = [begin, end](auto &values) {
+    values.erase(values.begin() + begin, values.begin() + end);
+  };
+  for (int c = 0; c < 3; c++) {
+    erase(this->Position[c]);
+    erase(this->Scale[c]);
+  }
+  for (int c = 0; c < 4; c++)
+    erase(this->Rotation[c]);
+  erase(this->Parents);
+  erase(this->SubtreeSizes);
+  erase(this->Dirty);
+  erase(this->Ids);
+  erase(this->Local);
+  erase(this->World);
+
+  // everything after the subtree moved down by its size
+  for (Index i = begin; i < this->Ids.size(); i++) {
+    if (this->Parents[i] != NoIndex && this->Parents[i] >= end)
+      this->Parents[i] -= count;
+    this->Indices[this->Ids[i]] = i;
+  }
+  this->DirtyNodes.clear();
+  for (Index i = 0; i < this->Ids.size(); i++)
+    if (this->Dirty[i])
+      this->DirtyNodes.push_back(i);
+}
+
+bool TransformHierarchy::SetParent(NodeId node, NodeId parent) {
+  if (!this->Contains(node) || (parent != NoNode && !this->Contains(parent))) {
+    std::cerr << "Transform node " << node << " or " << parent
+              << " does not exist" << std::endl;
+    return false;
+  }
+
+  Index index = this->Indices[node];
+  Index parentIndex = parent == NoNode ? NoIndex : this->Indices[parent];
+  if (this->Parents[index] == parentIndex)
+    return true;
+  for (Index a = parentIndex; a != NoIndex; a = this->Parents[a]) {
+    if (a == index) {
+      std::cerr << "Transform node " << parent << " is below node " << node
+                << ", cannot become its parent" << std::endl;
+      return false;
+    }
+  }
+
+  this->Parents[index] = parentIndex;
+  this->Sorted = false;
+  this->MarkDirty(index);
+  return true;
+}
+
+TransformHierarchy::NodeId TransformHierarchy::GetParent(NodeId node) const {
+  Index parent = this->Parents[this->Indices[node]];
+  return parent == NoIndex ? NoNode : this->Ids[parent];
+}
+
+bool TransformHierarchy::Contains(NodeId node) const {
+  return node < this->Indices.size() && this->Indices[node] != NoIndex;
+}
+
+void TransformHierarchy::SetPosition(NodeId node, const glm::vec3 &position) {
+  Index index = this->Indices[node];
+  for (int c = 0; c < 3; c++)
+    this->Position[c][index] = position[c];
+  this->MarkDirty(index);
+}
+
+void TransformHierarchy::SetRotation(NodeId node, const glm::quat &rotation) {
+  Index index = this->Indices[node];
+  this->Rotation[0][index] = rotation.x;
+  this->Rotation[1][index] = rotation.y;
+  this->Rotation[2][index] = rotation.z;
+  this->Rotation[3][index] = rotation.w;
+  this->MarkDirty(index);
+}
+
+void TransformHierarchy::SetScale(NodeId node, const glm::vec3 &scale) {
+  Index index = this->Indices[node];
+  for (int c = 0; c < 3; c++)
+    this->Scale[c][index] = scale[c];
+  this->MarkDirty(index);
+}
+
+void TransformHierarchy::SetLocalTransform(NodeId node,
+                                           const glm::vec3 &position,
+                                           const glm::quat &rotation,
+                                           const glm::vec3 &scale) {
+  this->SetPosition(node, position);
+  this->SetRotation(node, rotation);
+  this->SetScale(node, scale);
+}
+
+glm::vec3 TransformHierarchy::GetPosition(NodeId node) const {
+  Index index = this->Indices[node];
+  return {this->Position[0][index], this->Position[1][index],
+          this->Position[2][index]};
+}
+
+glm::quat TransformHierarchy::GetRotation(NodeId node) const {
+  Index index = this->Indices[node];
+  return glm::quat(this->Rotation[3][index], this->Rotation[0][index],
+                   this->Rotation[1][index], this->Rotation[2][index]);
+}
+
+glm::vec3 TransformHierarchy::GetScale(NodeId node) const {
+  Index index = this->Indices[node];
+  return {this->Scale[0][index], this->Scale[1][index], this->Scale[2][index]};
+}
+
+const glm::mat4 &TransformHierarchy::GetWorldMatrix(NodeId node) const {
+  return this->World[this->Indices[node]];
+}
+
+const glm::mat4 &TransformHierarchy::GetLocalMatrix(NodeId node) const {
+  return this->Local[this->Indices[node]];
+}
+
+void TransformHierarchy::MarkDirty(Index index) {
+  if (!this->Dirty[index]) {
+    this->Dirty[index] = 1;
+    this->DirtyNodes.push_back(index);
+  }
+}
+
+void TransformHierarchy::Sort() {
+  Index count = static_cast<Index>(this->Ids.size());
+  ScratchScope scratch;
+
+  // children grouped by parent, in their current order
+  ScratchVector<Index> offsets(count + 1, 0);
+  for (Index i = 0; i < count; i++)
+    if (this->Parents[i] != NoIndex)
+      offsets[this->Parents[i] + 1]++;
+  for (Index i = 0; i < count; i++)
+    offsets[i + 1] += offsets[i];
+  ScratchVector<Index> children(count);
+  ScratchVector<Index> next(offsets.begin(), offsets.end() - 1);
+  ScratchVector<Index> roots;
+  for (Index i = 0; i < count; i++) {
+    if (this->Parents[i] == NoIndex)
+      roots.push_back(i);
+    else
+      children[next[this->Parents[i]]++] = i;
+  }
+
+  ScratchVector<Index> order;
+  order.reserve(count);
+  ScratchVector<Index> stack;
+  for (Index root : roots) {
+    stack.push_back(root);
+    while (!stack.empty()) {
+      Index i = stack.back();
+      stack.pop_back();
+      order.push_back(i);
+      for (Index c = offsets[i + 1]; c > offsets[i]; c--)
+        stack.push_back(children[c - 1]);
+    }
+  }
+
+  ScratchVector<Index> newIndices(count);
+  for (Index k = 0; k < count; k++)
+    newIndices[order[k]] = k;
+
+  for (int c = 0; c < 3; c++) {
+    Permute(this->Position[c], order);
+    Permute(this->Scale[c], order);
+  }
+  for (int c = 0; c < 4; c++)
+    Permute(this->Rotation[c], order);
+  Permute(this->Parents, order);
+  Permute(this->Dirty, order);
+  Permute(this->Ids, order);
+  Permute(this->Local, order);
+  Permute(this->World, order);
+
+  this->DirtyNodes.clear();
+  std::fill(this->SubtreeSizes.begin(), this->SubtreeSizes.end(), 1);
+  for (Index k = 0; k < count; k++) {
+    if (this->Parents[k] != NoIndex)
+      this->Parents[k] = newIndices[this->Parents[k]];
+    this->Indices[this->Ids[k]] = k;
+    if (this->Dirty[k])
+      this->DirtyNodes.push_back(k);
+  }
+  // children come after their parent, so going backwards every subtree
+  // is complete before it is added to its parent
+  for (Index k = count; k-- > 0;)
+    if (this->Parents[k] != NoIndex)
+      this->SubtreeSizes[this->Parents[k]] += this->SubtreeSizes[k];
+
+  this->Sorted = true;
+}
+
+void TransformHierarchy::Update() {
+  if (!this->Sorted)
+    this->Sort();
+
+  this->UpdatedCount = 0;
+  if (this->DirtyNodes.empty())
+    return;
+  // once a good part of the nodes moved, going over the flags is cheaper
+  // than sorting
+  if (this->DirtyNodes.size() > this->Ids.size() / 16) {
+    this->DirtyNodes.clear();
+    for (Index i = 0; i < this->Ids.size(); i++)
+      if (this->Dirty[i])
+        this->DirtyNodes.push_back(i);
+  } else {
+    std::sort(this->DirtyNodes.begin(), this->DirtyNodes.end());
+  }
+
+  this->UpdateLocalMatrices();
+
+  // Dirty subtrees are either nested or apart; a dirty node inside a
+  // subtree that was just updated is already done.
+  Index updatedEnd = 0;
+  for (Index index : this->DirtyNodes) {
+    if (index < updatedEnd)
+      continue;
+    updatedEnd = index + this->SubtreeSizes[index];
+    this->UpdateWorldMatrices(index, updatedEnd);
+    this->UpdatedCount += updatedEnd - index;
+  }
+
+  for (Index index : this->DirtyNodes)
+    this->Dirty[index] = 0;
+  this->DirtyNodes.clear();
+}
+
+void TransformHierarchy::UpdateLocalMatrices() {
+  // one batch per run of consecutive dirty nodes
+  std::size_t count = this->DirtyNodes.size();
+  for (std::size_t r = 0; r < count;) {
+    Index begin = this->DirtyNodes[r++];
+    Index end = begin + 1;
+    while (r < count && this->DirtyNodes[r] == end) {
+      end++;
+      r++;
+    }
+
+    BatchTransforms::transformArrays transforms = {
+        this->Position[0].data() + begin, this->Position[1].data() + begin,
+        this->Position[2].data() + begin, this->Rotation[0].data() + begin,
+        this->Rotation[1].data() + begin, this->Rotation[2].data() + begin,
+        this->Rotation[3].data() + begin, this->Scale[0].data() + begin,
+        this->Scale[1].data() + begin,    this->Scale[2].data() + begin};
+    BatchTransforms::ComposeMatrices(transforms, end - begin,
+                                     this->Local.data() + begin);
+  }
+}
+
+void TransformHierarchy::UpdateWorldMatrices(Index begin, Index end) {
+  for (Index i = begin; i < end;) {
+    Index parent = this->Parents[i];
+    if (parent == NoIndex) {
+      this->World[i] = this->Local[i];
+      i++;
+      continue;
+    }
+    // Nodes that follow each other with the same parent are leaves (bar
+    // the last), so none of them depends on another and they share the
+    // parent matrix: one batch for all of them. The parent comes first
+    // and is up to date.
+    Index last = i + 1;
+    while (last < end && this->Parents[last] == parent)
+      last++;
+    BatchTransforms::MultiplyMatrices(this->World[parent],
+                                      this->Local.data() + i, last - i,
+                                      this->World.data() + i);
+    i = last;
+  }
+}
@@ -0,0 +1,102 @@
+#ifndef TRANSFORMHIERARCHY_H
+#define TRANSFORMHIERARCHY_H
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// A scene graph of transforms, stored as flat arrays rather than as linked
+// nodes. Position, rotation and scale are one array per component, and the
+// local and world matrices are one contiguous array each, all in the same
+// order: depth first, so every parent comes before its children and every
+// subtree is one contiguous range.
+//
+// Setters only mark a node dirty. Update() recomposes the local matrices of
+// the dirty nodes with BatchTransforms and recomputes the world matrices of
+// their subtrees, walking each range front to back. Static branches are
+// not touched at all, however large the hierarchy.
+//
+// Nodes are referred to by ids that stay valid while the node exists; the
+// position of a node in the arrays changes when the hierarchy does.
+class TransformHierarchy {
+public:
+  using NodeId = std::uint32_t;
+  static constexpr NodeId NoNode = UINT32_MAX;
+
+public:
+  // Adding a node below the most recently added subtree, as when building a
+  // hierarchy depth first, keeps the order; anything else reorders the
+  // arrays on the next Update().
+  NodeId AddNode(NodeId parent = NoNode,
+                 const glm::vec3 &position = glm::vec3(0.0f),
+                 const glm::quat &rotation = glm::quat(1.0f, 0.0f, 0.0f, 0.0f),
+                 const glm::vec3 &scale = glm::vec3(1.0f));
+  // Removes the node together with all of its descendants.
+  void RemoveNode(NodeId node);
+  // NoNode makes it a root. False, and nothing changes, if `parent` is the
+  // node itself or one of its descendants.
+  bool SetParent(NodeId node, NodeId parent);
+  NodeId GetParent(NodeId node) const;
+  bool Contains(NodeId node) const;
+
+  // Local transform relative to the parent; the rotation should be unit
+  // length.
+  void SetPosition(NodeId node, const glm::vec3 &position);
+  void SetRotation(NodeId node, const glm::quat &rotation);
+  void SetScale(NodeId node, const glm::vec3 &scale);
+  void SetLocalTransform(NodeId node, const glm::vec3 &position,
+                         const glm::quat &rotation, const glm::vec3 &scale);
+  glm::vec3 GetPosition(NodeId node) const;
+  glm::quat GetRotation(NodeId node) const;
+  glm::vec3 GetScale(NodeId node) const;
+
+  // Brings the world matrices up to date.
+  void Update();
+
+  // As of the last Update().
+  const glm::mat4 &GetWorldMatrix(NodeId node) const;
+  const glm::mat4 &GetLocalMatrix(NodeId node) const;
+  // All world matrices, e.g. to upload them at once; GetIndex() tells
+  // where a node is.
+  const glm::mat4 *GetWorldMatrices() const { return this->World.data(); }
+  std::size_t GetIndex(NodeId node) const { return this->Indices[node]; }
+  std::size_t GetNodeCount() const { return this->Ids.size(); }
+  // How many world matrices the last Update() recomputed.
+  std::size_t GetUpdatedCount() const { return this->UpdatedCount; }
+
+private:
+  using Index = std::uint32_t;
+  static constexpr Index NoIndex = UINT32_MAX;
+
+private:
+  void MarkDirty(Index index);
+  // Restores depth first order and the subtree sizes.
+  void Sort();
+  void UpdateLocalMatrices();
+  void UpdateWorldMatrices(Index begin, Index end);
+
+private:
+  // by index, in depth first order
+  std::vector<float> Position[3];
+  std::vector<float> Rotation[4]; // x, y, z, w
+  std::vector<float> Scale[3];
+  std::vector<Index> Parents;
+  std::vector<Index> SubtreeSizes; // the node included
+  std::vector<std::uint8_t> Dirty;
+  std::vector<NodeId> Ids;
+  std::vector<glm::mat4> Local;
+  std::vector<glm::mat4> World;
+
+  // by id
+  std::vector<Index> Indices;
+  std::vector<NodeId> FreeIds;
+
+  std::vector<Index> DirtyNodes;
+  bool Sorted = true;
+  std::size_t UpdatedCount = 0;
+};
+
+#endif
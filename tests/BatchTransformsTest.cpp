@@ -0,0 +1,206 @@
+// Runs the batch transforms with every instruction set the CPU has and
+// compares them with the scalar kernels, for counts that leave a remainder
+// after the vector loops and with outputs that overwrite their inputs.
+#include "BatchTransforms.h"
+#include "Check.h"
+
+#include <glm/gtc/quaternion.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <iterator>
+#include <random>
+#include <vector>
+
+using Check::Expect;
+using namespace BatchTransforms;
+
+namespace {
+
+const char *SetNames[] = {"Scalar", "SSE", "AVX"};
+
+// 0, 1 and every remainder of 8 and 4, below and above one vector
+const std::size_t Counts[] = {0, 1, 2, 3, 4, 5, 7, 8, 9, 12, 15, 16, 17, 31};
+const std::size_t MaxCount = 31;
+
+bool Near(float a, float b) {
+  return std::abs(a - b) <= 1e-4f * std::max(1.f, std::abs(b));
+}
+
+bool Near(const glm::mat4 &a, const glm::mat4 &b) {
+  for (int c = 0; c < 4; c++)
+    for (int r = 0; r < 4; r++)
+      if (!Near(a[c][r], b[c][r]))
+        return false;
+  return true;
+}
+
+bool Near(const glm::vec3 &a, const glm::vec3 &b) {
+  return Near(a.x, b.x) && Near(a.y, b.y) && Near(a.z, b.z);
+}
+
+struct inputs {
+  std::vector<float> position[3], rotation[4], scale[3];
+  std::vector<glm::mat4> left, right;
+  std::vector<glm::vec3> points;
+
+  transformArrays Arrays() const {
+    return {position[0].data(), position[1].data(), position[2].data(),
+            rotation[0].data(), rotation[1].data(), rotation[2].data(),
+            rotation[3].data(), scale[0].data(),    scale[1].data(),
+            scale[2].data()};
+  }
+};
+
+inputs MakeInputs(std::mt19937 &random) {
+  std::uniform_real_distribution<float> value(-10.f, 10.f);
+  inputs in;
+  for (std::size_t i = 0; i < MaxCount; i++) {
+    glm::quat rotation = glm::normalize(
+        glm::quat(value(random), value(random), value(random), value(random)));
+    for (int k = 0; k < 3; k++) {
+      in.position[k].push_back(value(random));
+      in.scale[k].push_back(value(random));
+    }
+    for (int k = 0; k < 4; k++)
+      in.rotation[k].push_back(rotation[k]);
+
+    glm::mat4 left, right;
+    for (int c = 0; c < 4; c++)
+      for (int r = 0; r < 4; r++) {
+        left[c][r] = value(random);
+        right[c][r] = value(random);
+      }
+    in.left.push_back(left);
+    in.right.push_back(right);
+    in.points.emplace_back(value(random), value(random), value(random));
+  }
+  return in;
+}
+
+// Everything one instruction set computes from the inputs.
+struct results {
+  std::vector<glm::mat4> composed, products, sharedProducts;
+  std::vector<affineMatrix> affine;
+  std::vector<float> pointsX, pointsY, pointsZ;
+  std::vector<glm::vec3> perMatrixPoints;
+};
+
+results Compute(const inputs &in, std::size_t count) {
+  results out;
+  out.composed.resize(count);
+  out.affine.resize(count);
+  out.products.resize(count);
+  out.sharedProducts.resize(count);
+  out.pointsX.resize(count);
+  out.pointsY.resize(count);
+  out.pointsZ.resize(count);
+  out.perMatrixPoints.resize(count);
+
+  ComposeMatrices(in.Arrays(), count, out.composed.data());
+  ComposeAffine(in.Arrays(), count, out.affine.data());
+  MultiplyMatrices(in.left.data(), in.right.data(), count,
+                   out.products.data());
+  MultiplyMatrices(in.left[0], in.right.data(), count,
+                   out.sharedProducts.data());
+
+  std::vector<float> x(count), y(count), z(count);
+  for (std::size_t i = 0; i < count; i++) {
+    x[i] = in.points[i].x;
+    y[i] = in.points[i].y;
+    z[i] = in.points[i].z;
+  }
+  TransformPoints(in.left[0], x.data(), y.data(), z.data(), count,
+                  out.pointsX.data(), out.pointsY.data(), out.pointsZ.data());
+  TransformPoints(in.left.data(), in.points.data(), count,
+                  out.perMatrixPoints.data());
+  return out;
+}
+
+void Compare(const results &a, const results &b, std::size_t count,
+             const char *set) {
+  for (std::size_t i = 0; i < count; i++) {
+    Expect(Near(a.composed[i], b.composed[i]), "ComposeMatrices with", set,
+           "count", count, "index", i);
+    bool affine = true;
+    for (int r = 0; r < 3; r++)
+      for (int c = 0; c < 4; c++)
+        affine = affine && Near(a.affine[i].rows[r][c], b.affine[i].rows[r][c]);
+    Expect(affine, "ComposeAffine with", set, "count", count, "index", i);
+    Expect(Near(a.products[i], b.products[i]), "MultiplyMatrices with", set,
+           "count", count, "index", i);
+    Expect(Near(a.sharedProducts[i], b.sharedProducts[i]),
+           "MultiplyMatrices by one matrix with", set, "count", count, "index",
+           i);
+    Expect(Near(a.pointsX[i], b.pointsX[i]) &&
+               Near(a.pointsY[i], b.pointsY[i]) &&
+               Near(a.pointsZ[i], b.pointsZ[i]),
+           "TransformPoints with", set, "count", count, "index", i);
+    Expect(Near(a.perMatrixPoints[i], b.perMatrixPoints[i]),
+           "TransformPoints per matrix with", set, "count", count, "index", i);
+  }
+}
+
+// Outputs that are also inputs must give what separate outputs give.
+void CheckInPlace(const inputs &in, const results &expected,
+                  std::size_t count, const char *set) {
+  std::vector<glm::mat4> right = in.right;
+  MultiplyMatrices(in.left.data(), right.data(), count, right.data());
+  std::vector<glm::mat4> left = in.left;
+  MultiplyMatrices(left.data(), in.right.data(), count, left.data());
+  std::vector<glm::mat4> shared = in.right;
+  MultiplyMatrices(in.left[0], shared.data(), count, shared.data());
+
+  std::vector<float> x(count), y(count), z(count);
+  std::vector<glm::vec3> points(in.points.begin(), in.points.begin() + count);
+  for (std::size_t i = 0; i < count; i++) {
+    x[i] = in.points[i].x;
+    y[i] = in.points[i].y;
+    z[i] = in.points[i].z;
+  }
+  TransformPoints(in.left[0], x.data(), y.data(), z.data(), count, x.data(),
+                  y.data(), z.data());
+  TransformPoints(in.left.data(), points.data(), count, points.data());
+
+  for (std::size_t i = 0; i < count; i++) {
+    Expect(Near(right[i], expected.products[i]) &&
+               Near(left[i], expected.products[i]),
+           "MultiplyMatrices in place with", set, "count", count, "index", i);
+    Expect(Near(shared[i], expected.sharedProducts[i]),
+           "MultiplyMatrices by one matrix in place with", set, "count", count,
+           "index", i);
+    Expect(Near(x[i], expected.pointsX[i]) && Near(y[i], expected.pointsY[i]) &&
+               Near(z[i], expected.pointsZ[i]),
+           "TransformPoints in place with", set, "count", count, "index", i);
+    Expect(Near(points[i], expected.perMatrixPoints[i]),
+           "TransformPoints per matrix in place with", set, "count", count,
+           "index", i);
+  }
+}
+
+} // namespace
+
+int main() {
+  std::mt19937 random(7);
+  inputs in = MakeInputs(random);
+
+  std::vector<results> scalar;
+  SetInstructionSet(instructionSet::Scalar);
+  for (std::size_t count : Counts)
+    scalar.push_back(Compute(in, count));
+
+  for (auto set : {instructionSet::Scalar, instructionSet::SSE,
+                   instructionSet::AVX}) {
+    // not on this CPU
+    if (SetInstructionSet(set) != set)
+      continue;
+    const char *name = SetNames[int(set)];
+    for (std::size_t k = 0; k < std::size(Counts); k++) {
+      Compare(Compute(in, Counts[k]), scalar[k], Counts[k], name);
+      CheckInPlace(in, scalar[k], Counts[k], name);
+    }
+  }
+
+  return Check::Report();
+}
@@ -0,0 +1,98 @@
+// Checks Bitboard against a std::set of tiles on boards of one and of
+// several words, where shifts have to carry bits across word boundaries.
+#include "Bitboard.h"
+#include "Check.h"
+
+#include <random>
+#include <set>
+#include <utility>
+
+using Check::Expect;
+
+namespace {
+
+using tileSet = std::set<std::pair<int, int>>;
+
+template <int Width, int Height> void CheckBoard(std::mt19937 &random) {
+  using board = Bitboard<Width, Height>;
+  for (int round = 0; round < 300; round++) {
+    board tiles;
+    tileSet expected;
+    for (int i = 0; i < Width * Height / 3; i++) {
+      int x = int(random() % Width), y = int(random() % Height);
+      tiles.Set({x, y});
+      expected.insert({x, y});
+    }
+    int size = int(expected.size());
+
+    Expect(tiles.Count() == size, "Count", "on", Width, 'x', Height);
+    Expect((~tiles).Count() == Width * Height - size, "operator~", "on", Width,
+           'x', Height);
+    int visited = 0;
+    tiles.Each([&](glm::ivec2 tile) {
+      visited++;
+      Expect(expected.count({tile.x, tile.y}) == 1, "Each", "on", Width, 'x',
+             Height);
+    });
+    Expect(visited == size, "Each count", "on", Width, 'x', Height);
+
+    for (int dx = -1; dx <= 1; dx++) {
+      for (int dy = -1; dy <= 1; dy++) {
+        board shifted;
+        for (auto [x, y] : expected)
+          if (board::Contains({x + dx, y + dy}))
+            shifted.Set({x + dx, y + dy});
+        Expect(tiles.Shifted({dx, dy}) == shifted, "Shifted", "on", Width, 'x',
+               Height);
+      }
+    }
+
+    board neighbours;
+    for (auto [x, y] : expected)
+      for (int dx = -1; dx <= 1; dx++)
+        for (int dy = -1; dy <= 1; dy++)
+          if (board::Contains({x + dx, y + dy}) &&
+              !expected.count({x + dx, y + dy}))
+            neighbours.Set({x + dx, y + dy});
+    Expect(tiles.Neighbours() == neighbours, "Neighbours", "on", Width, 'x',
+           Height);
+
+    int inRegion = 0;
+    for (auto [x, y] : expected)
+      inRegion += x >= 2 && x < 5 && y >= 1 && y < 5;
+    Expect((tiles & board::Region({2, 1}, {3, 4})).Count() == inRegion,
+           "Region", "on", Width, 'x', Height);
+  }
+}
+
+void CheckBoardState() {
+  BoardState<8> state;
+  state.Place(0, {0, 0});
+  state.Place(1, {1, 0});
+  Expect(state.GetTeamAt({0, 0}) == 0 && state.GetTeamAt({1, 0}) == 1 &&
+             state.GetTeamAt({2, 0}) == -1,
+         "GetTeamAt");
+  Expect(state.IsLegalMove(0, {0, 0}, {3, 3}), "move to an empty tile");
+  Expect(!state.IsLegalMove(0, {0, 0}, {1, 0}), "move to an occupied tile");
+  Expect(!state.IsLegalMove(1, {0, 0}, {3, 3}), "move of the other team");
+  Expect(!state.IsLegalMove(0, {0, 0}, {8, 0}), "move off the board");
+
+  state.Move(0, {0, 0}, {3, 3});
+  Expect(state.GetTeamAt({3, 3}) == 0 && state.GetTeamAt({0, 0}) == -1 &&
+             state.GetOccupied().Count() == 2,
+         "Move");
+}
+
+} // namespace
+
+int main() {
+  std::mt19937 random(1);
+  CheckBoard<8, 8>(random);
+  CheckBoard<5, 3>(random);
+  CheckBoard<10, 10>(random);
+  CheckBoard<19, 19>(random);
+  CheckBoard<64, 2>(random);
+  CheckBoardState();
+
+  return Check::Report();
+}
@@ -0,0 +1,31 @@
+#ifndef CHECK_H
+#define CHECK_H
+
+#include <iostream>
+
+// For the test programs: Expect() prints a failed check, followed by the
+// context it was given, and counts it; main() returns Report().
+namespace Check {
+
+inline int Failures = 0;
+
+template <typename... Context>
+void Expect(bool condition, const char *what, const Context &...context) {
+  if (condition)
+    return;
+  std::cerr << what;
+  ((std::cerr << ' ' << context), ...);
+  std::cerr << std::endl;
+  Failures++;
+}
+
+// The exit code of the test: 1 if any check failed.
+inline int Report() {
+  if (Failures)
+    std::cerr << Failures << " checks failed" << std::endl;
+  return Failures ? 1 : 0;
+}
+
+} // namespace Check
+
+#endif
@@ -0,0 +1,39 @@
+#ifndef COUNTINGALLOCATIONS_H
+#define COUNTINGALLOCATIONS_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+
+// Replaces the global operator new with one that counts the calls, for
+// tests that check code stays off the heap. Include it in one source file
+// of the test program only.
+inline std::atomic<long> HeapAllocations{0};
+
+void *operator new(std::size_t size) {
+  HeapAllocations++;
+  if (void *memory = std::malloc(size ? size : 1))
+    return memory;
+  throw std::bad_alloc();
+}
+void *operator new(std::size_t size, std::align_val_t alignment) {
+  HeapAllocations++;
+  std::size_t align = std::size_t(alignment);
+  std::size_t rounded = (size + align - 1) / align * align;
+  if (void *memory = std::aligned_alloc(align, rounded))
+    return memory;
+  throw std::bad_alloc();
+}
+void operator delete(void *memory) noexcept { std::free(memory); }
+void operator delete(void *memory, std::size_t) noexcept {
+  std::free(memory);
+}
+void operator delete(void *memory, std::align_val_t) noexcept {
+  std::free(memory);
+}
+void operator delete(void *memory, std::size_t, std::align_val_t) noexcept {
+  std::free(memory);
+}
+
+#endif
@@ -0,0 +1,151 @@
+// Applies random structural changes to an EntityWorld and to a plain map of
+// what each entity should have, and compares the two every so often.
+#include "Check.h"
+#include "EntityWorld.h"
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <random>
+#include <string>
+
+using Check::Expect;
+
+namespace {
+
+struct position {
+  float x;
+};
+struct name {
+  std::string text;
+};
+// owns memory, so moves between archetypes have to move it properly
+struct owned {
+  std::unique_ptr<int> value;
+};
+struct alignas(32) wide {
+  float values[8];
+};
+
+struct expectedEntity {
+  Entity entity;
+  bool hasPosition = false;
+  float x = 0.0f;
+  bool hasName = false;
+  std::string text;
+  bool hasOwned = false;
+  int value = 0;
+  bool hasWide = false;
+};
+
+void Compare(EntityWorld &world, std::map<std::uint32_t, expectedEntity> &all,
+             int step) {
+  Expect(world.GetEntityCount() == all.size(), "entity count", "at step", step);
+  std::size_t positions = 0;
+  for (auto &[index, expected] : all) {
+    Entity entity = expected.entity;
+    Expect(world.IsAlive(entity), "alive", "at step", step);
+
+    const position *p = world.GetComponent<position>(entity);
+    Expect(bool(p) == expected.hasPosition && (!p || p->x == expected.x),
+           "position", "at step", step);
+    const name *n = world.GetComponent<name>(entity);
+    Expect(bool(n) == expected.hasName && (!n || n->text == expected.text),
+           "name", "at step", step);
+    const owned *o = world.GetComponent<owned>(entity);
+    Expect(bool(o) == expected.hasOwned && (!o || *o->value == expected.value),
+           "owned", "at step", step);
+    const wide *w = world.GetComponent<wide>(entity);
+    Expect(bool(w) == expected.hasWide &&
+               reinterpret_cast<std::uintptr_t>(w) % alignof(wide) == 0,
+           "wide", "at step", step);
+    positions += expected.hasPosition;
+  }
+
+  std::size_t visited = 0;
+  world.Each<const position>([&](Entity entity, const position &p) {
+    visited++;
+    auto expected = all.find(entity.index);
+    Expect(expected != all.end() && expected->second.x == p.x, "Each",
+           "at step", step);
+  });
+  Expect(visited == positions && world.Count<position>() == positions,
+         "query count", "at step", step);
+}
+
+} // namespace
+
+int main() {
+  EntityWorld world;
+  std::map<std::uint32_t, expectedEntity> all;
+  std::mt19937 random(3);
+
+  for (int step = 0; step < 50000; step++) {
+    int operation = int(random() % 11);
+    if (operation > 7 || all.empty()) {
+      expectedEntity expected;
+      if (random() % 2) {
+        expected.entity = world.CreateEntity(position{float(step)},
+                                             name{std::to_string(step)});
+        expected.hasPosition = expected.hasName = true;
+        expected.x = float(step);
+        expected.text = std::to_string(step);
+      } else {
+        expected.entity = world.CreateEntity();
+      }
+      all[expected.entity.index] = expected;
+      continue;
+    }
+
+    auto it = all.begin();
+    std::advance(it, random() % all.size());
+    expectedEntity &expected = it->second;
+    Entity entity = expected.entity;
+    switch (operation) {
+    case 0:
+      world.DestroyEntity(entity);
+      Expect(!world.IsAlive(entity), "destroyed", "at step", step);
+      Expect(world.GetComponent<position>(entity) == nullptr,
+             "component of a destroyed entity", "at step", step);
+      all.erase(it);
+      break;
+    case 1:
+      world.AddComponent(entity, position{float(step)});
+      expected.hasPosition = true;
+      expected.x = float(step);
+      break;
+    case 2:
+      world.RemoveComponent<position>(entity);
+      expected.hasPosition = false;
+      break;
+    case 3:
+      world.AddComponent(entity, owned{std::make_unique<int>(step)});
+      expected.hasOwned = true;
+      expected.value = step;
+      break;
+    case 4:
+      world.RemoveComponent<owned>(entity);
+      expected.hasOwned = false;
+      break;
+    case 5:
+      world.AddComponent(entity, wide{});
+      expected.hasWide = true;
+      break;
+    case 6:
+      world.RemoveComponent<wide>(entity);
+      expected.hasWide = false;
+      break;
+    case 7:
+      world.AddComponent(entity, name{"renamed " + std::to_string(step)});
+      expected.hasName = true;
+      expected.text = "renamed " + std::to_string(step);
+      break;
+    }
+
+    if (step % 997 == 0)
+      Compare(world, all, step);
+  }
+  Compare(world, all, -1);
+
+  return Check::Report();
+}
@@ -0,0 +1,56 @@
+// Counts heap allocations to check that frame and scratch containers stop
+// going to the heap once the arenas have grown to fit a frame.
+#include "ArenaAllocator.h"
+#include "Check.h"
+#include "CountingAllocations.h"
+
+#include <cstdint>
+
+using Check::Expect;
+
+namespace {
+
+// What a frame might do: a draw list, a name, scratch space for a sort.
+void SimulateFrame(int frame) {
+  FrameVector<int> drawList;
+  for (int i = 0; i < 5000; i++)
+    drawList.push_back(i);
+  Expect(drawList[4999] == 4999, "FrameVector contents", "in frame", frame);
+
+  FrameString title("frame ");
+  for (int i = 0; i < 100; i++)
+    title += char('a' + i % 26);
+  Expect(title.size() == 106, "FrameString contents", "in frame", frame);
+
+  void *aligned = FrameArena::GetInstance()->Allocate(24, 64);
+  Expect(reinterpret_cast<std::uintptr_t>(aligned) % 64 == 0, "alignment",
+         "in frame", frame);
+
+  ScratchScope scratch;
+  ScratchVector<double> values(20000, 1.0);
+  {
+    ScratchScope inner;
+    ScratchVector<char> bytes(300000, 'x');
+    Expect(bytes[299999] == 'x', "nested ScratchVector contents", "in frame",
+           frame);
+  }
+  Expect(values[19999] == 1.0, "ScratchVector contents", "in frame", frame);
+}
+
+} // namespace
+
+int main() {
+  FrameArena *arena = FrameArena::GetInstance();
+  for (int frame = 0; frame < 10; frame++) {
+    long before = HeapAllocations;
+    SimulateFrame(frame);
+    arena->Reset();
+    // the first frames grow the arenas
+    if (frame >= 3)
+      Expect(HeapAllocations == before, "heap allocation in a steady frame",
+             "in frame", frame);
+  }
+  Expect(arena->GetOverflowCount() == 0, "overflow after Reset");
+
+  return Check::Report();
+}
@@ -0,0 +1,187 @@
+// Loads small generated .glb files: valid ones with every index type, and
+// malformed ones whose indices have the wrong type or name a vertex past
+// the end. There is no GL context, so the GL calls that uploading makes go
+// to stubs, which keep the last index buffer for the checks.
+#include "Check.h"
+#include "GltfLoader.h"
+
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+using Check::Expect;
+
+namespace {
+
+constexpr int UnsignedByte = 5121;
+constexpr int Short = 5122;
+constexpr int UnsignedShort = 5123;
+constexpr int UnsignedInt = 5125;
+constexpr int Float = 5126;
+
+// ==== GL stubs ====
+
+GLuint NextName = 1;
+std::vector<GLuint> UploadedIndices;
+
+void APIENTRY GenNames(GLsizei n, GLuint *names) {
+  for (GLsizei i = 0; i < n; i++)
+    names[i] = NextName++;
+}
+void APIENTRY DeleteNames(GLsizei, const GLuint *) {}
+void APIENTRY BindBuffer(GLenum, GLuint) {}
+void APIENTRY BufferData(GLenum target, GLsizeiptr size, const void *data,
+                         GLenum) {
+  if (target == GL_ELEMENT_ARRAY_BUFFER && data) {
+    UploadedIndices.resize(std::size_t(size) / sizeof(GLuint));
+    std::memcpy(UploadedIndices.data(), data, std::size_t(size));
+  }
+}
+void APIENTRY BufferSubData(GLenum, GLintptr, GLsizeiptr, const void *) {}
+void APIENTRY BindVertexArray(GLuint) {}
+void APIENTRY EnableAttribute(GLuint) {}
+void APIENTRY AttributePointer(GLuint, GLint, GLenum, GLboolean, GLsizei,
+                               const void *) {}
+void APIENTRY AttributeDivisor(GLuint, GLuint) {}
+GLenum APIENTRY GetError() { return GL_NO_ERROR; }
+GLboolean APIENTRY IsBuffer(GLuint) { return GL_TRUE; }
+
+void StubGl() {
+  glad_glGenBuffers = GenNames;
+  glad_glDeleteBuffers = DeleteNames;
+  glad_glBindBuffer = BindBuffer;
+  glad_glBufferData = BufferData;
+  glad_glBufferSubData = BufferSubData;
+  glad_glGenVertexArrays = GenNames;
+  glad_glDeleteVertexArrays = DeleteNames;
+  glad_glBindVertexArray = BindVertexArray;
+  glad_glEnableVertexAttribArray = EnableAttribute;
+  glad_glVertexAttribPointer = AttributePointer;
+  glad_glVertexAttribDivisor = AttributeDivisor;
+  glad_glGetError = GetError;
+  glad_glIsBuffer = IsBuffer;
+}
+
+// ==== .glb files ====
+
+template <typename T> void Append(std::vector<unsigned char> &bytes, T value) {
+  auto p = reinterpret_cast<const unsigned char *>(&value);
+  bytes.insert(bytes.end(), p, p + sizeof(T));
+}
+
+void Pad(std::vector<unsigned char> &bytes, unsigned char fill) {
+  while (bytes.size() % 4)
+    bytes.push_back(fill);
+}
+
+// One mesh of `vertexCount` positions and the given indices, stored with
+// `componentType`.
+std::string WriteGlb(const std::string &name, std::uint32_t vertexCount,
+                     int componentType,
+                     const std::vector<std::uint32_t> &indices) {
+  std::vector<unsigned char> bin;
+  for (std::uint32_t i = 0; i < vertexCount; i++) {
+    Append(bin, float(i % 2));
+    Append(bin, float(i / 2));
+    Append(bin, 0.f);
+  }
+  std::size_t positionBytes = bin.size();
+  for (std::uint32_t index : indices) {
+    if (componentType == UnsignedByte)
+      Append(bin, std::uint8_t(index));
+    else if (componentType == UnsignedShort || componentType == Short)
+      Append(bin, std::uint16_t(index));
+    else if (componentType == Float)
+      Append(bin, float(index));
+    else
+      Append(bin, index);
+  }
+  std::size_t indexBytes = bin.size() - positionBytes;
+  Pad(bin, 0);
+
+  std::string json =
+      R"({"asset":{"version":"2.0"},"buffers":[{"byteLength":)" +
+      std::to_string(bin.size()) +
+      R"(}],"bufferViews":[{"buffer":0,"byteOffset":0,"byteLength":)" +
+      std::to_string(positionBytes) + R"(},{"buffer":0,"byteOffset":)" +
+      std::to_string(positionBytes) + R"(,"byteLength":)" +
+      std::to_string(indexBytes) +
+      R"(}],"accessors":[{"bufferView":0,"componentType":5126,"count":)" +
+      std::to_string(vertexCount) +
+      R"(,"type":"VEC3"},{"bufferView":1,"componentType":)" +
+      std::to_string(componentType) + R"(,"count":)" +
+      std::to_string(indices.size()) +
+      R"(,"type":"SCALAR"}],"meshes":[{"primitives":[{"attributes":)"
+      R"({"POSITION":0},"indices":1}]}]})";
+  std::vector<unsigned char> chunk(json.begin(), json.end());
+  Pad(chunk, ' ');
+
+  std::vector<unsigned char> file;
+  Append(file, std::uint32_t(0x46546C67)); // "glTF"
+  Append(file, std::uint32_t(2));
+  Append(file, std::uint32_t(12 + 8 + chunk.size() + 8 + bin.size()));
+  Append(file, std::uint32_t(chunk.size()));
+  Append(file, std::uint32_t(0x4E4F534A)); // "JSON"
+  file.insert(file.end(), chunk.begin(), chunk.end());
+  Append(file, std::uint32_t(bin.size()));
+  Append(file, std::uint32_t(0x004E4942)); // "BIN\0"
+  file.insert(file.end(), bin.begin(), bin.end());
+
+  std::string path = (std::filesystem::temp_directory_path() / name).string();
+  std::ofstream(path, std::ios::binary)
+      .write(reinterpret_cast<const char *>(file.data()), file.size());
+  return path;
+}
+
+void CheckValid(const char *what, int componentType) {
+  std::vector<std::uint32_t> indices = {0, 1, 2, 2, 1, 3};
+  std::string path = WriteGlb(std::string("valid_") + what + ".glb", 4,
+                              componentType, indices);
+  MeshLoader::gltfScene scene;
+  std::string error;
+  UploadedIndices.clear();
+  bool loaded = MeshLoader::LoadGlb(path, scene, error);
+  Expect(loaded, "valid file not loaded:", what, error);
+  if (loaded) {
+    Expect(scene.meshes.size() == 1 && scene.meshes[0].primitives.size() == 1,
+           "primitive count of", what);
+    Expect(UploadedIndices ==
+               std::vector<GLuint>(indices.begin(), indices.end()),
+           "uploaded indices of", what);
+  }
+  std::filesystem::remove(path);
+}
+
+void CheckMalformed(const char *what, int componentType,
+                    const std::vector<std::uint32_t> &indices) {
+  std::string path = WriteGlb(std::string("malformed_") + what + ".glb", 4,
+                              componentType, indices);
+  MeshLoader::gltfScene scene;
+  std::string error;
+  Expect(!MeshLoader::LoadGlb(path, scene, error) && !error.empty(),
+         "malformed file loaded:", what);
+  std::filesystem::remove(path);
+}
+
+} // namespace
+
+int main() {
+  StubGl();
+
+  CheckValid("u8", UnsignedByte);
+  CheckValid("u16", UnsignedShort);
+  // 32 bit indices are uploaded straight from the file
+  CheckValid("u32", UnsignedInt);
+
+  CheckMalformed("u8_past_end", UnsignedByte, {0, 1, 4});
+  CheckMalformed("u16_past_end", UnsignedShort, {0, 1, 2, 2, 1, 60000});
+  CheckMalformed("u32_past_end", UnsignedInt, {0, 1, 2, 2, 1, 4});
+  CheckMalformed("u32_huge", UnsignedInt, {0, 0xFFFFFFFFu, 1});
+  CheckMalformed("float", Float, {0, 1, 2});
+  CheckMalformed("signed", Short, {0, 1, 2});
+
+  return Check::Report();
+}
@@ -0,0 +1,112 @@
+// Submits chains of dependent jobs, nested parallel loops and main-thread
+// jobs from several threads at once, and checks that every job ran once
+// and only after what it depended on.
+#include "Check.h"
+#include "JobSystem.h"
+
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <thread>
+#include <vector>
+
+using Check::Expect;
+
+namespace {
+
+constexpr int Stages = 6;
+constexpr int JobsPerStage = 50;
+constexpr int Rounds = 100;
+constexpr int Threads = 4;
+
+// Stage k of the chain waits for stage k - 1; every job checks that the
+// whole previous stage has run.
+void CheckChain(JobSystem &jobs, int thread) {
+  std::atomic<int> done[Stages] = {};
+  std::atomic<int> early{0};
+  std::unique_ptr<JobCounter[]> counters(new JobCounter[Stages]);
+  for (int stage = 0; stage < Stages; stage++) {
+    JobCounter *dependency = stage > 0 ? &counters[stage - 1] : nullptr;
+    for (int i = 0; i < JobsPerStage; i++)
+      jobs.Submit(
+          [&done, &early, stage]() {
+            if (stage > 0 && done[stage - 1].load() != JobsPerStage)
+              early++;
+            done[stage]++;
+          },
+          &counters[stage], dependency);
+  }
+  jobs.Wait(counters[Stages - 1]);
+
+  Expect(early == 0, "jobs ran before their dependency on thread", thread);
+  for (int stage = 0; stage < Stages; stage++)
+    Expect(done[stage] == JobsPerStage && counters[stage].IsDone(),
+           "stage", stage, "incomplete on thread", thread);
+}
+
+// Every index once, also from loops inside the loop.
+void CheckParallelFor(JobSystem &jobs, int thread, std::size_t count,
+                      std::size_t grain) {
+  std::vector<std::atomic<int>> visits(count * 4);
+  jobs.ParallelFor(count, grain, [&](std::size_t begin, std::size_t end) {
+    for (std::size_t i = begin; i < end; i++)
+      jobs.ParallelFor(4, 1, [&, i](std::size_t inner, std::size_t) {
+        visits[i * 4 + inner]++;
+      });
+  });
+
+  int wrong = 0;
+  for (auto &visit : visits)
+    wrong += visit != 1;
+  Expect(wrong == 0, "ParallelFor of", count, "grain", grain,
+         "visited indices other than once on thread", thread);
+}
+
+void Stress(JobSystem &jobs, int thread) {
+  for (int round = 0; round < Rounds; round++) {
+    CheckChain(jobs, thread);
+    CheckParallelFor(jobs, thread, 1 + round * 7, 0);
+    CheckParallelFor(jobs, thread, 100, 1 + round % 9);
+  }
+}
+
+// Main-thread jobs behind worker jobs run on the main thread, afterwards.
+void CheckMainThreadJobs(JobSystem &jobs) {
+  for (int round = 0; round < Rounds; round++) {
+    JobCounter workers, main;
+    std::atomic<int> done{0}, early{0}, elsewhere{0}, ran{0};
+    for (int i = 0; i < JobsPerStage; i++)
+      jobs.Submit([&done]() { done++; }, &workers);
+    for (int i = 0; i < JobsPerStage; i++)
+      jobs.Submit(
+          [&]() {
+            early += done.load() != JobsPerStage;
+            elsewhere += !jobs.IsMainThread();
+            ran++;
+          },
+          &main, &workers, JobSystem::Affinity::MainThread);
+    jobs.Wait(main);
+    Expect(ran == JobsPerStage && early == 0 && elsewhere == 0,
+           "main-thread jobs in round", round);
+  }
+}
+
+} // namespace
+
+int main() {
+  // this thread becomes the main thread
+  JobSystem &jobs = *JobSystem::GetInstance();
+
+  std::vector<std::thread> threads;
+  for (int thread = 1; thread <= Threads; thread++)
+    threads.emplace_back(Stress, std::ref(jobs), thread);
+  Stress(jobs, 0);
+  CheckMainThreadJobs(jobs);
+  for (auto &thread : threads)
+    thread.join();
+
+  Expect(jobs.RunMainThreadJobs() == 0, "main-thread jobs left over");
+
+  return Check::Report();
+}
@@ -0,0 +1,84 @@
+// Creates and destroys pooled objects at random and checks that handles to
+// destroyed objects stay dead, that the live ones keep their values, and
+// that a pool at a steady size and EntityWorld chunks reuse their memory.
+#include "Check.h"
+#include "CountingAllocations.h"
+#include "EntityWorld.h"
+#include "ObjectPool.h"
+
+#include <random>
+#include <string>
+#include <vector>
+
+using Check::Expect;
+
+namespace {
+
+struct unit {
+  float x, y;
+  int health;
+};
+
+void CheckHandles() {
+  ObjectPool<std::string, 8> strings;
+  std::vector<PoolHandle<std::string>> handles;
+  std::vector<PoolHandle<std::string>> destroyed;
+  std::mt19937 random(3);
+  for (int i = 0; i < 100000; i++) {
+    if (handles.empty() || random() % 3) {
+      handles.push_back(strings.Create(std::string(40, char('a' + i % 26))));
+      continue;
+    }
+    std::size_t k = random() % handles.size();
+    Expect(strings.Destroy(handles[k]), "Destroy of a live object");
+    destroyed.push_back(handles[k]);
+    handles[k] = handles.back();
+    handles.pop_back();
+  }
+
+  for (auto handle : destroyed) {
+    Expect(!strings.IsAlive(handle) && !strings.Get(handle),
+           "handle to a destroyed object");
+    Expect(!strings.Destroy(handle), "second Destroy");
+  }
+  for (auto handle : handles) {
+    const std::string *value = strings.Get(handle);
+    Expect(value && value->size() == 40, "live object");
+  }
+  std::size_t visited = 0;
+  strings.Each([&](std::string &) { visited++; });
+  Expect(visited == handles.size() && strings.GetStats().live == visited,
+         "Each and live count");
+}
+
+void CheckReuse() {
+  ObjectPool<unit> units;
+  std::vector<PoolHandle<unit>> handles;
+  EntityWorld world;
+  std::vector<Entity> entities;
+  for (int round = 0; round < 6; round++) {
+    long before = HeapAllocations;
+    for (int i = 0; i < 5000; i++) {
+      handles.push_back(units.Create(unit{1, 2, 3}));
+      entities.push_back(world.CreateEntity(unit{1, 2, 3}));
+    }
+    for (auto handle : handles)
+      units.Destroy(handle);
+    for (auto entity : entities)
+      world.DestroyEntity(entity);
+    handles.clear();
+    entities.clear();
+    // the first round sizes the pools and the vectors above
+    if (round > 0)
+      Expect(HeapAllocations == before, "heap allocation in a steady round");
+  }
+}
+
+} // namespace
+
+int main() {
+  CheckHandles();
+  CheckReuse();
+
+  return Check::Report();
+}
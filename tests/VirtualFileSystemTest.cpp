@@ -0,0 +1,146 @@
+// Round trips data through the LZ4 codec, and reads a pack written by
+// ResourcePacker and the directory it was packed from through the
+// VirtualFileSystem, which must give the same bytes and refuse paths that
+// climb out of the mounts with "..".
+//
+//   VirtualFileSystemTest <pack> <directory it was packed from>
+#include "Check.h"
+#include "Lz4.h"
+#include "VirtualFileSystem.h"
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <random>
+#include <string>
+#include <vector>
+
+using Check::Expect;
+
+namespace fs = std::filesystem;
+
+namespace {
+
+void CheckRoundTrip(const std::vector<unsigned char> &data, const char *what) {
+  std::vector<unsigned char> compressed(Lz4::CompressBound(data.size()));
+  std::size_t size = Lz4::Compress(data.data(), data.size(),
+                                   compressed.data(), compressed.size());
+  Expect(size > 0 || data.empty(), "Compress of", what, data.size());
+
+  std::vector<unsigned char> decompressed(data.size());
+  Expect(Lz4::Decompress(compressed.data(), size, decompressed.data(),
+                         decompressed.size()) &&
+             decompressed == data,
+         "round trip of", what, data.size());
+  if (size > 1)
+    Expect(!Lz4::Decompress(compressed.data(), size - 1, decompressed.data(),
+                            decompressed.size()),
+           "truncated block of", what, data.size(), "decompressed");
+  if (!data.empty()) {
+    std::vector<unsigned char> larger(data.size() + 1);
+    Expect(!Lz4::Decompress(compressed.data(), size, larger.data(),
+                            larger.size()),
+           "block of", what, data.size(), "decompressed to the wrong size");
+  }
+}
+
+void CheckLz4() {
+  std::mt19937 random(5);
+  for (std::size_t size : {0, 1, 15, 64, 1000, 65536, 300000}) {
+    // incompressible, repetitive with the odd change, and long runs
+    std::vector<unsigned char> noise(size), text(size), runs(size);
+    const char words[] = "mesh texture shader pack ";
+    for (std::size_t i = 0; i < size; i++) {
+      noise[i] = static_cast<unsigned char>(random());
+      text[i] = random() % 16 ? words[i % (sizeof(words) - 1)] : noise[i];
+      runs[i] = static_cast<unsigned char>(i / 300);
+    }
+    CheckRoundTrip(noise, "noise");
+    CheckRoundTrip(text, "text");
+    CheckRoundTrip(runs, "runs");
+  }
+}
+
+std::vector<unsigned char> ReadFile(const fs::path &path) {
+  std::ifstream stream(path, std::ios::binary);
+  return std::vector<unsigned char>(std::istreambuf_iterator<char>(stream),
+                                    std::istreambuf_iterator<char>());
+}
+
+bool Matches(const VirtualFile &file, const std::vector<unsigned char> &bytes) {
+  return file && file.GetSize() == bytes.size() &&
+         std::equal(bytes.begin(), bytes.end(), file.GetData());
+}
+
+void CheckPack(const std::string &packPath, const fs::path &directory) {
+  VirtualFileSystem *fileSystem = VirtualFileSystem::GetInstance();
+  Expect(fileSystem->MountPack(packPath), "MountPack", packPath);
+
+  std::size_t files = 0, compressed = 0;
+  for (const auto &item : fs::recursive_directory_iterator(directory)) {
+    if (!item.is_regular_file())
+      continue;
+    std::string path = fs::relative(item.path(), directory).generic_string();
+    VirtualFileSystem::FileInfo info;
+    Expect(fileSystem->Stat(path, info) && info.packed, "packed entry", path);
+    Expect(Matches(fileSystem->Open(path), ReadFile(item.path())),
+           "pack contents", path);
+    Expect(Matches(fileSystem->Open("./x/../" + path), ReadFile(item.path())),
+           "path with \"..\" inside the root", path);
+    files++;
+    compressed += info.compressed;
+  }
+  Expect(files > 0, "no files in", directory);
+  Expect(compressed > 0, "no compressed entries in", packPath);
+  Expect(!fileSystem->Open("missing.txt"), "Open of a missing file");
+  fileSystem->UnmountAll();
+}
+
+void CheckEscapes(const fs::path &directory) {
+  Expect(VirtualFileSystem::NormalizePath("a/./b\\c/") == "a/b/c",
+         "NormalizePath");
+  Expect(VirtualFileSystem::NormalizePath("a/b/../c") == "a/c",
+         "NormalizePath with ..");
+  Expect(VirtualFileSystem::NormalizePath("a/../..").empty(),
+         "NormalizePath above the root");
+  Expect(VirtualFileSystem::NormalizePath("../a").empty(),
+         "NormalizePath above the root");
+
+  // a subdirectory mounted alone: its files are reachable by their names,
+  // but not by paths that leave it and come back in from its parent
+  fs::path inner, file;
+  for (const auto &item : fs::recursive_directory_iterator(directory))
+    if (item.is_regular_file() && item.path().parent_path() != directory) {
+      inner = item.path().parent_path();
+      file = item.path();
+      break;
+    }
+  Expect(!inner.empty(), "no subdirectory with files in", directory);
+  if (inner.empty())
+    return;
+
+  VirtualFileSystem *fileSystem = VirtualFileSystem::GetInstance();
+  fileSystem->MountDirectory(inner.string());
+  std::string name = file.filename().string();
+  std::string escape = "../" + inner.filename().string() + "/" + name;
+  Expect(bool(fileSystem->Open(name)), "file in a mounted directory", name);
+  Expect(!fileSystem->Open(escape) && !fileSystem->Exists(escape),
+         "file outside the mounted directory", escape);
+  Expect(!fileSystem->Open("../../" + name), "file far outside the mount");
+  fileSystem->UnmountAll();
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  CheckLz4();
+  if (argc < 3) {
+    Expect(false, "usage: VirtualFileSystemTest <pack> <directory>");
+    return Check::Report();
+  }
+  CheckPack(argv[1], argv[2]);
+  CheckEscapes(argv[2]);
+
+  return Check::Report();
+}
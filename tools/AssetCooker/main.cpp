@@ -0,0 +1,332 @@
+// AssetCooker: converts source assets into the engine's cooked formats (see
+// CookedAssets.h), so loading them at runtime is a memory map and an upload.
+//
+//   AssetCooker <output dir> <source files...>
+//
+// Images (.png .jpg .jpeg .tga .bmp) become .ctex files with every mip level
+// prebuilt. OBJ models become .cmesh files with deduplicated, indexed
+// vertices in the position(3) tcoords(2) normal(3) layout. A source is only
+// cooked again when its content hash, which for OBJ models includes their
+// material libraries, differs from the one recorded in its cooked file.
+#include "CookedAssets.h"
+#include "MeshLoader.h"
+#include "ShaderDataTypes.h"
+
+#include <glad/glad.h>
+#include <stb_image.h>
+#include <stb_image_resize.h>
+
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+constexpr std::uint64_t HashSeed =
+    14695981039346656037ull ^ CookedAssets::Version;
+
+// FNV-1a, seeded with the format version so format changes re-cook. Pass
+// the previous result as `hash` to hash several files together.
+std::uint64_t HashContent(const std::vector<unsigned char> &content,
+                          std::uint64_t hash = HashSeed) {
+  for (unsigned char byte : content) {
+    hash ^= byte;
+    hash *= 1099511628211ull;
+  }
+  return hash;
+}
+
+bool ReadFile(const fs::path &path, std::vector<unsigned char> &content) {
+  std::ifstream stream(path, std::ios::binary);
+  if (!stream)
+    return false;
+  content.assign(std::istreambuf_iterator<char>(stream),
+                 std::istreambuf_iterator<char>());
+  return true;
+}
+
+// The material libraries an OBJ names on its mtllib lines, relative to it.
+// They decide how the mesh is split into parts, so they are hashed with it.
+std::vector<fs::path> GetMaterialLibraries(
+    const fs::path &sourcePath, const std::vector<unsigned char> &content) {
+  std::vector<fs::path> libraries;
+  std::istringstream stream(std::string(content.begin(), content.end()));
+  std::string line;
+  while (std::getline(stream, line)) {
+    std::size_t start = line.find_first_not_of(" \t");
+    if (start == std::string::npos || line.compare(start, 6, "mtllib") ||
+        line.find_first_of(" \t", start + 6) != start + 6)
+      continue;
+    std::size_t begin = line.find_first_not_of(" \t", start + 6);
+    std::size_t end = line.find_last_not_of(" \t\r");
+    if (begin != std::string::npos && end >= begin)
+      libraries.push_back(sourcePath.parent_path() /
+                          line.substr(begin, end - begin + 1));
+  }
+  return libraries;
+}
+
+bool IsUpToDate(const fs::path &outputPath, std::uint64_t sourceHash) {
+  MappedFile cooked(outputPath.string());
+  if (!cooked.IsOpen() || cooked.GetSize() < sizeof(CookedAssets::FileHeader))
+    return false;
+  auto header =
+      reinterpret_cast<const CookedAssets::FileHeader *>(cooked.GetData());
+  return header->magic == CookedAssets::Magic &&
+         header->version == CookedAssets::Version &&
+         header->sourceHash == sourceHash;
+}
+
+// Cooked file under construction: headers and tables first, then payload
+// blocks, each starting on a PayloadAlignment boundary.
+class cookedWriter {
+public:
+  template <typename T> void Append(const T &value) {
+    auto bytes = reinterpret_cast<const unsigned char *>(&value);
+    this->Bytes.insert(this->Bytes.end(), bytes, bytes + sizeof(T));
+  }
+
+  // Returns the payload's offset from the start of the file.
+  std::uint64_t AppendPayload(const void *data, std::size_t size) {
+    this->Bytes.resize((this->Bytes.size() + CookedAssets::PayloadAlignment -
+                        1) /
+                       CookedAssets::PayloadAlignment *
+                       CookedAssets::PayloadAlignment);
+    std::uint64_t offset = this->Bytes.size();
+    auto bytes = static_cast<const unsigned char *>(data);
+    this->Bytes.insert(this->Bytes.end(), bytes, bytes + size);
+    return offset;
+  }
+
+  template <typename T> T *At(std::uint64_t offset) {
+    return reinterpret_cast<T *>(this->Bytes.data() + offset);
+  }
+
+  std::uint64_t GetSize() const { return this->Bytes.size(); }
+
+  bool Write(const fs::path &path) const {
+    std::ofstream stream(path, std::ios::binary);
+    stream.write(reinterpret_cast<const char *>(this->Bytes.data()),
+                 this->Bytes.size());
+    return bool(stream);
+  }
+
+private:
+  std::vector<unsigned char> Bytes;
+};
+
+void AppendFileHeader(cookedWriter &writer, CookedAssets::AssetType type,
+                      std::uint64_t sourceHash) {
+  CookedAssets::FileHeader header = {};
+  header.magic = CookedAssets::Magic;
+  header.version = CookedAssets::Version;
+  header.type = type;
+  header.sourceHash = sourceHash;
+  writer.Append(header);
+}
+
+// ==== textures ====
+
+bool CookTexture(const std::vector<unsigned char> &content,
+                 std::uint64_t sourceHash, const fs::path &outputPath) {
+  int width, height, bpp;
+  unsigned char *data =
+      stbi_load_from_memory(content.data(), int(content.size()), &width,
+                            &height, &bpp, STBI_rgb_alpha);
+  if (!data) {
+    std::cerr << "  " << stbi_failure_reason() << std::endl;
+    return false;
+  }
+
+  // every level down to 1x1, each filtered from the one above it
+  struct level {
+    int width, height;
+    std::vector<unsigned char> pixels;
+  };
+  std::vector<level> levels(1);
+  levels[0] = {width, height,
+               std::vector<unsigned char>(data, data + width * height * 4)};
+  stbi_image_free(data);
+  while (levels.back().width > 1 || levels.back().height > 1) {
+    const level &previous = levels.back();
+    level next;
+    next.width = std::max(previous.width / 2, 1);
+    next.height = std::max(previous.height / 2, 1);
+    next.pixels.resize(std::size_t(next.width) * next.height * 4);
+    stbir_resize_uint8(previous.pixels.data(), previous.width,
+                       previous.height, 0, next.pixels.data(), next.width,
+                       next.height, 0, 4);
+    levels.push_back(std::move(next));
+  }
+
+  cookedWriter writer;
+  AppendFileHeader(writer, CookedAssets::AssetType::Texture, sourceHash);
+  CookedAssets::TextureHeader header = {};
+  header.internalFormat = GL_RGBA8;
+  header.format = GL_RGBA;
+  header.type = GL_UNSIGNED_BYTE;
+  header.width = width;
+  header.height = height;
+  header.levelCount = std::uint32_t(levels.size());
+  writer.Append(header);
+
+  std::uint64_t tableOffset = writer.GetSize();
+  for (std::size_t i = 0; i < levels.size(); i++)
+    writer.Append(CookedAssets::TextureLevel());
+  for (std::size_t i = 0; i < levels.size(); i++) {
+    std::uint64_t offset = writer.AppendPayload(levels[i].pixels.data(),
+                                                levels[i].pixels.size());
+    auto entry = writer.At<CookedAssets::TextureLevel>(
+        tableOffset + i * sizeof(CookedAssets::TextureLevel));
+    entry->offset = offset;
+    entry->size = levels[i].pixels.size();
+    entry->width = levels[i].width;
+    entry->height = levels[i].height;
+  }
+
+  std::cout << "  " << width << "x" << height << ", " << levels.size()
+            << " levels" << std::endl;
+  return writer.Write(outputPath);
+}
+
+// ==== meshes ====
+
+bool CookMesh(const fs::path &sourcePath, std::uint64_t sourceHash,
+              const fs::path &outputPath) {
+  // parsed, deduplicated and given normals where the file has none
+  std::vector<MeshLoader::meshPart> parts;
+  std::string error;
+  if (!MeshLoader::LoadObjParts(sourcePath.string(), parts, error)) {
+    std::cerr << "  " << error << std::endl;
+    return false;
+  }
+
+  // the cooked mesh has no materials, so the parts are appended to each
+  // other; position(3) tcoords(2) normal(3)
+  const std::size_t stride = GeometricTools::GridVertexStride;
+  std::vector<GLfloat> vertices;
+  std::vector<GLuint> indices;
+  for (const auto &part : parts) {
+    GLuint base = GLuint(vertices.size() / stride);
+    vertices.insert(vertices.end(), part.shape.vertices.begin(),
+                    part.shape.vertices.end());
+    for (GLuint index : part.shape.indices)
+      indices.push_back(base + index);
+  }
+
+  cookedWriter writer;
+  AppendFileHeader(writer, CookedAssets::AssetType::Mesh, sourceHash);
+
+  const struct {
+    ShaderDataType type;
+    const char *name;
+  } layout[] = {{ShaderDataType::Float3, "position"},
+                {ShaderDataType::Float2, "tcoords"},
+                {ShaderDataType::Float3, "normal"}};
+
+  std::uint64_t headerOffset = writer.GetSize();
+  CookedAssets::MeshHeader header = {};
+  header.vertexCount = GLuint(vertices.size() / stride);
+  header.indexCount = GLuint(indices.size());
+  header.stride = GLuint(stride * sizeof(GLfloat));
+  header.attributeCount = std::uint32_t(std::size(layout));
+  writer.Append(header);
+  for (const auto &entry : layout) {
+    CookedAssets::MeshAttribute attribute = {};
+    attribute.type = std::uint32_t(entry.type);
+    std::strncpy(attribute.name, entry.name, sizeof(attribute.name) - 1);
+    writer.Append(attribute);
+  }
+
+  std::uint64_t vertexOffset = writer.AppendPayload(
+      vertices.data(), vertices.size() * sizeof(GLfloat));
+  std::uint64_t indexOffset =
+      writer.AppendPayload(indices.data(), indices.size() * sizeof(GLuint));
+  writer.At<CookedAssets::MeshHeader>(headerOffset)->vertexOffset =
+      vertexOffset;
+  writer.At<CookedAssets::MeshHeader>(headerOffset)->indexOffset = indexOffset;
+
+  std::cout << "  " << header.vertexCount << " vertices, "
+            << header.indexCount / 3 << " triangles" << std::endl;
+  return writer.Write(outputPath);
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  if (argc < 3) {
+    std::cerr << "usage: " << argv[0] << " <output dir> <source files...>"
+              << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  fs::path outputDir = argv[1];
+  std::error_code errorCode;
+  fs::create_directories(outputDir, errorCode);
+
+  int failures = 0, cooked = 0, skipped = 0;
+  for (int i = 2; i < argc; i++) {
+    fs::path sourcePath = argv[i];
+    std::string extension = sourcePath.extension().string();
+    std::transform(extension.begin(), extension.end(), extension.begin(),
+                   [](unsigned char c) { return char(std::tolower(c)); });
+
+    bool isMesh = extension == ".obj";
+    bool isTexture = extension == ".png" || extension == ".jpg" ||
+                     extension == ".jpeg" || extension == ".tga" ||
+                     extension == ".bmp";
+    if (!isMesh && !isTexture) {
+      std::cerr << sourcePath << ": unknown asset type" << std::endl;
+      failures++;
+      continue;
+    }
+
+    std::vector<unsigned char> content;
+    if (!ReadFile(sourcePath, content)) {
+      std::cerr << sourcePath << ": cannot read file" << std::endl;
+      failures++;
+      continue;
+    }
+
+    std::uint64_t sourceHash = HashContent(content);
+    if (isMesh) {
+      // a missing library hashes as empty, so adding it later re-cooks
+      for (const auto &library : GetMaterialLibraries(sourcePath, content)) {
+        std::vector<unsigned char> libraryContent;
+        ReadFile(library, libraryContent);
+        sourceHash = HashContent(libraryContent, sourceHash);
+      }
+    }
+    fs::path outputPath = outputDir / sourcePath.stem();
+    outputPath += isMesh ? ".cmesh" : ".ctex";
+    if (IsUpToDate(outputPath, sourceHash)) {
+      skipped++;
+      continue;
+    }
+
+    std::cout << "Cooking " << sourcePath.string() << " -> "
+              << outputPath.string() << std::endl;
+    bool success = isMesh ? CookMesh(sourcePath, sourceHash, outputPath)
+                          : CookTexture(content, sourceHash, outputPath);
+    if (success)
+      cooked++;
+    else {
+      std::cerr << sourcePath << ": cooking failed" << std::endl;
+      failures++;
+    }
+  }
+
+  std::cout << cooked << " cooked, " << skipped << " up to date, " << failures
+            << " failed" << std::endl;
+  return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,207 @@
+// ResourcePacker: packs a directory tree into one pack file (see
+// framework/Rendering/PackFile.h) for the VirtualFileSystem.
+//
+//   ResourcePacker <output.pak> <directory> [--store <.ext,...>] [--no-compression]
+//
+// Paths inside the pack are relative to <directory>. Entries are LZ4
+// compressed when that saves at least an eighth of their size. Files with
+// an extension in the store list are always kept uncompressed and aligned,
+// since they are read straight from the mapping; by default these are the
+// cooked and block compressed formats (.ctex .cmesh .dds .ktx2).
+#include "Lz4.h"
+#include "PackFile.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+struct packedFile {
+  std::string path; // inside the pack
+  fs::path source;
+  std::vector<unsigned char> stored;
+  std::uint64_t size = 0;
+  PackFile::Compression compression = PackFile::Compression::None;
+  bool failed = false;
+};
+
+std::string Lowercase(std::string text) {
+  std::transform(text.begin(), text.end(), text.begin(),
+                 [](unsigned char c) { return char(std::tolower(c)); });
+  return text;
+}
+
+// Reads and, unless stored, compresses one file.
+void PackEntry(packedFile &file, const std::vector<std::string> &storeList,
+               bool compress) {
+  std::ifstream stream(file.source, std::ios::binary);
+  if (!stream) {
+    file.failed = true;
+    return;
+  }
+  std::vector<unsigned char> content((std::istreambuf_iterator<char>(stream)),
+                                     std::istreambuf_iterator<char>());
+  file.size = content.size();
+
+  std::string extension = Lowercase(file.source.extension().string());
+  bool store = !compress || content.empty() ||
+               std::find(storeList.begin(), storeList.end(), extension) !=
+                   storeList.end();
+  if (!store) {
+    std::vector<unsigned char> compressed(Lz4::CompressBound(content.size()));
+    std::size_t size = Lz4::Compress(content.data(), content.size(),
+                                     compressed.data(), compressed.size());
+    if (size > 0 && size <= content.size() - content.size() / 8) {
+      compressed.resize(size);
+      file.stored = std::move(compressed);
+      file.compression = PackFile::Compression::Lz4;
+      return;
+    }
+  }
+  file.stored = std::move(content);
+}
+
+template <typename T> void Append(std::vector<unsigned char> &out, const T &value) {
+  const unsigned char *bytes = reinterpret_cast<const unsigned char *>(&value);
+  out.insert(out.end(), bytes, bytes + sizeof(T));
+}
+
+void Align(std::vector<unsigned char> &out, std::uint64_t alignment) {
+  out.resize((out.size() + alignment - 1) / alignment * alignment, 0);
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  if (argc < 3) {
+    std::cerr << "usage: " << argv[0]
+              << " <output.pak> <directory> [--store <.ext,...>] [--no-compression]"
+              << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  fs::path outputPath = argv[1], root = argv[2];
+  std::vector<std::string> storeList = {".ctex", ".cmesh", ".dds", ".ktx2"};
+  bool compress = true;
+  for (int i = 3; i < argc; i++) {
+    std::string argument = argv[i];
+    if (argument == "--store" && i + 1 < argc) {
+      storeList.clear();
+      std::stringstream list(argv[++i]);
+      for (std::string extension; std::getline(list, extension, ',');)
+        storeList.push_back(Lowercase(extension));
+    } else if (argument == "--no-compression") {
+      compress = false;
+    } else {
+      std::cerr << "Unknown argument " << argument << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+
+  std::error_code error;
+  if (!fs::is_directory(root, error)) {
+    std::cerr << root.string() << " is not a directory" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  // in path order, so files of one directory end up next to each other
+  std::vector<packedFile> files;
+  for (const auto &item : fs::recursive_directory_iterator(root)) {
+    if (!item.is_regular_file())
+      continue;
+    if (item.path().filename().string()[0] == '.')
+      continue; // .gitkeep and friends
+    std::string path = fs::relative(item.path(), root).generic_string();
+    files.push_back({path, item.path(), {}, 0, PackFile::Compression::None, false});
+  }
+  std::sort(files.begin(), files.end(),
+            [](const packedFile &a, const packedFile &b) { return a.path < b.path; });
+
+  std::atomic<std::size_t> next{0};
+  std::vector<std::thread> workers;
+  unsigned threads = std::max(1u, std::thread::hardware_concurrency());
+  for (unsigned t = 0; t < threads; t++)
+    workers.emplace_back([&]() {
+      for (std::size_t i; (i = next++) < files.size();)
+        PackEntry(files[i], storeList, compress);
+    });
+  for (auto &worker : workers)
+    worker.join();
+
+  std::vector<unsigned char> out(sizeof(PackFile::Header), 0);
+  std::vector<PackFile::Entry> entries;
+  std::string paths;
+  std::uint64_t totalSize = 0;
+  for (const auto &file : files) {
+    if (file.failed) {
+      std::cerr << "Failed to read " << file.source.string() << std::endl;
+      return EXIT_FAILURE;
+    }
+    if (file.compression == PackFile::Compression::None)
+      Align(out, file.size >= PackFile::LargeEntrySize
+                     ? PackFile::LargeStoredAlignment
+                     : PackFile::StoredAlignment);
+
+    PackFile::Entry entry = {};
+    entry.pathHash = PackFile::HashPath(file.path);
+    entry.offset = out.size();
+    entry.size = file.size;
+    entry.storedSize = file.stored.size();
+    entry.pathOffset = static_cast<std::uint32_t>(paths.size());
+    entry.pathLength = static_cast<std::uint32_t>(file.path.size());
+    entry.compression = file.compression;
+    entries.push_back(entry);
+
+    paths += file.path;
+    out.insert(out.end(), file.stored.begin(), file.stored.end());
+    totalSize += file.size;
+  }
+
+  // index sorted for binary search by hash, ties by path
+  std::sort(entries.begin(), entries.end(),
+            [&](const PackFile::Entry &a, const PackFile::Entry &b) {
+              if (a.pathHash != b.pathHash)
+                return a.pathHash < b.pathHash;
+              return paths.compare(a.pathOffset, a.pathLength, paths,
+                                   b.pathOffset, b.pathLength) < 0;
+            });
+
+  Align(out, alignof(PackFile::Entry));
+  PackFile::Header header = {};
+  header.magic = PackFile::Magic;
+  header.version = PackFile::Version;
+  header.entryCount = static_cast<std::uint32_t>(entries.size());
+  header.indexOffset = out.size();
+  for (const auto &entry : entries)
+    Append(out, entry);
+  header.pathsOffset = out.size();
+  header.pathsSize = paths.size();
+  out.insert(out.end(), paths.begin(), paths.end());
+  std::memcpy(out.data(), &header, sizeof(header));
+
+  if (outputPath.has_parent_path())
+    fs::create_directories(outputPath.parent_path(), error);
+  std::ofstream stream(outputPath, std::ios::binary);
+  stream.write(reinterpret_cast<const char *>(out.data()), out.size());
+  if (!stream) {
+    std::cerr << "Failed to write " << outputPath.string() << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  std::cout << outputPath.string() << ": " << entries.size() << " files, "
+            << totalSize << " bytes packed into " << out.size() << std::endl;
+  return EXIT_SUCCESS;
+}
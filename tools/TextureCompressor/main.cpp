@@ -0,0 +1,230 @@
+// TextureCompressor: encodes an image into a BC1, BC3 or BC5 DDS file with a
+// full box-filtered mip chain.
+//
+//   TextureCompressor <input image> <output.dds> [bc1|bc3|bc5] [--srgb] [--no-mips]
+//
+// BC1 suits opaque colour maps, BC3 colour with alpha and BC5 two channel
+// data such as normal maps (red and green are kept). BC7 and ETC2 files are
+// produced with external encoders; the runtime loads them from DDS or KTX2.
+#define STB_IMAGE_IMPLEMENTATION
+#include <stb_image.h>
+#define STB_DXT_IMPLEMENTATION
+#include <stb_dxt.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace {
+
+enum class BlockFormat { BC1, BC3, BC5 };
+
+struct image {
+  int width, height;
+  std::vector<float> texels; // RGBA, linear when the source is sRGB
+};
+
+float SrgbToLinear(float c) {
+  return c <= 0.04045f ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f);
+}
+
+float LinearToSrgb(float c) {
+  return c <= 0.0031308f ? c * 12.92f
+                         : 1.055f * std::pow(c, 1.f / 2.4f) - 0.055f;
+}
+
+// Halves the image with a 2x2 box filter; odd edges fold into the last texel.
+image Downsample(const image &source) {
+  image result;
+  result.width = std::max(source.width / 2, 1);
+  result.height = std::max(source.height / 2, 1);
+  result.texels.resize(std::size_t(result.width) * result.height * 4);
+
+  for (int y = 0; y < result.height; y++)
+    for (int x = 0; x < result.width; x++)
+      for (int c = 0; c < 4; c++) {
+        float sum = 0.f;
+        for (int dy = 0; dy < 2; dy++)
+          for (int dx = 0; dx < 2; dx++) {
+            int sx = std::min(2 * x + dx, source.width - 1);
+            int sy = std::min(2 * y + dy, source.height - 1);
+            sum += source.texels[(std::size_t(sy) * source.width + sx) * 4 + c];
+          }
+        result.texels[(std::size_t(y) * result.width + x) * 4 + c] = sum / 4.f;
+      }
+  return result;
+}
+
+unsigned char ToByte(float value, bool srgb) {
+  if (srgb)
+    value = LinearToSrgb(value);
+  return static_cast<unsigned char>(
+      std::lround(std::clamp(value, 0.f, 1.f) * 255.f));
+}
+
+// Compresses one mip level; blocks past the image edge repeat the edge.
+void EncodeLevel(const image &level, BlockFormat format, bool srgb,
+                 std::vector<unsigned char> &out) {
+  const int blockBytes = format == BlockFormat::BC1 ? 8 : 16;
+  for (int by = 0; by < level.height; by += 4)
+    for (int bx = 0; bx < level.width; bx += 4) {
+      unsigned char rgba[16 * 4];
+      unsigned char rg[16 * 2];
+      for (int y = 0; y < 4; y++)
+        for (int x = 0; x < 4; x++) {
+          int sx = std::min(bx + x, level.width - 1);
+          int sy = std::min(by + y, level.height - 1);
+          const float *texel =
+              &level.texels[(std::size_t(sy) * level.width + sx) * 4];
+          int i = y * 4 + x;
+          for (int c = 0; c < 3; c++)
+            rgba[i * 4 + c] = ToByte(texel[c], srgb);
+          rgba[i * 4 + 3] = ToByte(texel[3], false);
+          rg[i * 2] = rgba[i * 4];
+          rg[i * 2 + 1] = rgba[i * 4 + 1];
+        }
+
+      unsigned char block[16];
+      if (format == BlockFormat::BC5)
+        stb_compress_bc5_block(block, rg);
+      else
+        stb_compress_dxt_block(block, rgba, format == BlockFormat::BC3,
+                               STB_DXT_HIGHQUAL);
+      out.insert(out.end(), block, block + blockBytes);
+    }
+}
+
+void WriteU32(std::vector<unsigned char> &out, std::uint32_t value) {
+  for (int i = 0; i < 4; i++)
+    out.push_back(static_cast<unsigned char>(value >> (8 * i)));
+}
+
+// "DDS ", DDS_HEADER and DDS_HEADER_DXT10. The DX10 header is used for every
+// format since it is the only way to mark the data as sRGB.
+std::vector<unsigned char> DDSHeader(int width, int height, int levels,
+                                     std::uint32_t dxgiFormat,
+                                     std::uint32_t topLevelSize) {
+  std::vector<unsigned char> out = {'D', 'D', 'S', ' '};
+  WriteU32(out, 124);      // dwSize
+  WriteU32(out, 0xA1007);  // CAPS | HEIGHT | WIDTH | PIXELFORMAT | MIPMAPCOUNT | LINEARSIZE
+  WriteU32(out, height);
+  WriteU32(out, width);
+  WriteU32(out, topLevelSize);
+  WriteU32(out, 0);        // dwDepth
+  WriteU32(out, levels);
+  for (int i = 0; i < 11; i++)
+    WriteU32(out, 0);      // dwReserved1
+
+  WriteU32(out, 32);       // DDS_PIXELFORMAT.dwSize
+  WriteU32(out, 0x4);      // DDPF_FOURCC
+  out.insert(out.end(), {'D', 'X', '1', '0'});
+  for (int i = 0; i < 5; i++)
+    WriteU32(out, 0);      // bit count and masks
+
+  WriteU32(out, levels > 1 ? 0x401008 : 0x1000); // TEXTURE (| MIPMAP | COMPLEX)
+  for (int i = 0; i < 4; i++)
+    WriteU32(out, 0);      // dwCaps2..4, dwReserved2
+
+  WriteU32(out, dxgiFormat);
+  WriteU32(out, 3);        // D3D10_RESOURCE_DIMENSION_TEXTURE2D
+  WriteU32(out, 0);        // miscFlag
+  WriteU32(out, 1);        // arraySize
+  WriteU32(out, 0);        // miscFlags2
+  return out;
+}
+
+std::uint32_t DXGIFormat(BlockFormat format, bool srgb) {
+  switch (format) {
+  case BlockFormat::BC1: return srgb ? 72 : 71;
+  case BlockFormat::BC3: return srgb ? 78 : 77;
+  case BlockFormat::BC5: return 83;
+  }
+  return 0;
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  if (argc < 3) {
+    std::cerr << "usage: " << argv[0]
+              << " <input image> <output.dds> [bc1|bc3|bc5] [--srgb] [--no-mips]"
+              << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  std::string inputPath = argv[1], outputPath = argv[2];
+  BlockFormat format = BlockFormat::BC1;
+  bool srgb = false, mipMaps = true;
+  for (int i = 3; i < argc; i++) {
+    std::string argument = argv[i];
+    if (argument == "bc1")
+      format = BlockFormat::BC1;
+    else if (argument == "bc3")
+      format = BlockFormat::BC3;
+    else if (argument == "bc5")
+      format = BlockFormat::BC5;
+    else if (argument == "--srgb")
+      srgb = true;
+    else if (argument == "--no-mips")
+      mipMaps = false;
+    else {
+      std::cerr << "Unknown argument " << argument << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+  // two channel data is never colour
+  if (format == BlockFormat::BC5)
+    srgb = false;
+
+  int width, height, bpp;
+  unsigned char *data =
+      stbi_load(inputPath.c_str(), &width, &height, &bpp, STBI_rgb_alpha);
+  if (!data) {
+    std::cerr << "Failed to load " << inputPath << ": "
+              << stbi_failure_reason() << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  image level;
+  level.width = width;
+  level.height = height;
+  level.texels.resize(std::size_t(width) * height * 4);
+  for (std::size_t i = 0; i < level.texels.size(); i++) {
+    float value = data[i] / 255.f;
+    // filter colour in linear space, alpha is always linear
+    level.texels[i] = srgb && i % 4 != 3 ? SrgbToLinear(value) : value;
+  }
+  stbi_image_free(data);
+
+  std::vector<unsigned char> blocks;
+  std::uint32_t topLevelSize = 0;
+  int levels = 0;
+  for (;;) {
+    EncodeLevel(level, format, srgb, blocks);
+    if (levels++ == 0)
+      topLevelSize = static_cast<std::uint32_t>(blocks.size());
+    if (!mipMaps || (level.width == 1 && level.height == 1))
+      break;
+    level = Downsample(level);
+  }
+
+  std::vector<unsigned char> file =
+      DDSHeader(width, height, levels, DXGIFormat(format, srgb), topLevelSize);
+  file.insert(file.end(), blocks.begin(), blocks.end());
+
+  std::ofstream stream(outputPath, std::ios::binary);
+  stream.write(reinterpret_cast<const char *>(file.data()), file.size());
+  if (!stream) {
+    std::cerr << "Failed to write " << outputPath << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  std::cout << outputPath << ": " << width << "x" << height << ", " << levels
+            << " levels, " << file.size() << " bytes" << std::endl;
+  return EXIT_SUCCESS;
+}